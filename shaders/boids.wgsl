@@ -30,6 +30,8 @@ struct Params {
     hues: vec4f,
     saturations: vec4f,
     typeRatios: vec4f,         // cumulative thresholds for type distribution
+    seed: vec4u,               // x=seed lo, y=seed hi (64-bit run seed)
+    fade: vec4f,               // render: x=previous output weight, y=fresh weight
 };
 
 // Group 0: textures + uniforms
@@ -42,16 +44,27 @@ struct Params {
 // Group 1: agent buffer
 @group(1) @binding(0) var<storage, read_write> agents: array<BoidAgent>;
 
-// Group 2: spatial hash grid
+// Group 2: spatial hash grid + deposit claims (one per trail pixel, 0 = unclaimed)
 @group(2) @binding(0) var<storage, read_write> cellCount: array<atomic<u32>>;
-@group(2) @binding(1) var<storage, read_write> cellAgents: array<u32>;
+@group(2) @binding(1) var<storage, read_write> cellAgents: array<atomic<u32>>; // ascending, EMPTY_SLOT after
+@group(2) @binding(2) var<storage, read_write> claims: array<atomic<u32>>;
+
+const EMPTY_SLOT: u32 = 0xffffffffu;
 
 // ---- Helpers ----
 
-fn random2(p: vec2f) -> vec2f {
-    var a = fract(vec3f(p.x, p.y, p.x) * vec3f(123.34, 234.34, 345.65));
-    a = a + dot(a, a + 34.45);
-    return fract(vec2f(a.x * a.y, a.y * a.z));
+// Integer hash (PCG): bit-identical on every adapter, unlike sin/fract hashes
+fn pcg_hash(v: u32) -> u32 {
+    let state = v * 747796405u + 2891336453u;
+    let word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Two uniform floats in [0,1) per (index, step, stream), keyed by the 64-bit seed
+fn rand2(index: u32, step: u32, stream: u32) -> vec2f {
+    let h0 = pcg_hash(index ^ pcg_hash(step ^ pcg_hash(stream ^ params.seed.x)));
+    let h1 = pcg_hash(h0 ^ params.seed.y);
+    return vec2f(f32(h0 >> 8u), f32(h1 >> 8u)) * (1.0 / 16777216.0);
 }
 
 fn hsb2rgb(c: vec3f, a: f32) -> vec4f {
@@ -97,6 +110,13 @@ fn rotate_vec2(v: vec2f, angle: f32) -> vec2f {
     return vec2f(v.x * c - v.y * s, v.x * s + v.y * c);
 }
 
+// Trail pixel an agent deposits to; false if outside the texture
+fn deposit_pixel(pos: vec2f, px: ptr<function, vec2u>) -> bool {
+    let rez = get_rez();
+    *px = vec2u(u32(round(pos.x)), u32(round(pos.y)));
+    return (*px).x < rez.x && (*px).y < rez.y;
+}
+
 fn sample_trail(pos: vec2i, rez: vec2u) -> vec4f {
     let wrapped = vec2i(
         (pos.x + i32(rez.x)) % i32(rez.x),
@@ -105,6 +125,27 @@ fn sample_trail(pos: vec2i, rez: vec2u) -> vec4f {
     return textureLoad(trailRead, vec2u(u32(wrapped.x), u32(wrapped.y)), 0);
 }
 
+// 3x3 box blur scaled by the per-channel diffuse rate: the value diffuse_texture
+// stores at pos. write_trails recomputes it from trailRead at each agent instead
+// of reading it back, so no copy of trailWrite -> trailRead is needed.
+fn diffused_trail(pos: vec2i, rez: vec2u) -> vec4f {
+    var avg = vec4f(0.0);
+    for (var dx = -1; dx <= 1; dx++) {
+        for (var dy = -1; dy <= 1; dy++) {
+            avg += sample_trail(vec2i(pos.x + dx, pos.y + dy), rez);
+        }
+    }
+    avg = avg / 9.0;
+
+    let oc = vec4f(
+        avg.x * params.diffuseRates.x,
+        avg.y * params.diffuseRates.y,
+        avg.z * params.diffuseRates.z,
+        avg.w * params.diffuseRates.w
+    );
+    return clamp(oc, vec4f(0.0), vec4f(1.0));
+}
+
 fn toroidal_diff(a: vec2f, b: vec2f, rez: vec2f) -> vec2f {
     var d = a - b;
     if (abs(d.x) > rez.x * 0.5) { d.x -= sign(d.x) * rez.x; }
@@ -127,10 +168,10 @@ fn reset_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (gid.x >= count) { return; }
     let rez = get_rez();
     let rezF = vec2f(f32(rez.x), f32(rez.y));
-    let t = f32(get_time());
+    let t = get_time();
 
     // Ring distribution
-    let c = random2(vec2f(f32(gid.x)) * 0.0001 + t * 0.001);
+    let c = rand2(gid.x, t, 0u);
     let ang = c.x * 6.28318530718;
     let outerRadius = min(rezF.x, rezF.y) * 0.25;
     let ringThickness = rezF.x / 10.0;
@@ -140,7 +181,7 @@ fn reset_agents(@builtin(global_invocation_id) gid: vec3u) {
     let pos = center + vec2f(cos(ang), sin(ang)) * rad;
 
     // Random velocity
-    let r2 = random2(vec2f(f32(gid.x), f32(gid.x)) * 0.001 + sin(t));
+    let r2 = rand2(gid.x, t, 1u);
     let vel = normalize(2.0 * (r2 - 0.5)) * 0.5;
 
     // Type by cumulative ratio thresholds
@@ -161,9 +202,18 @@ fn clear_grid(@builtin(global_invocation_id) gid: vec3u) {
     let totalCells = gridW * gridH;
     if (gid.x >= totalCells) { return; }
     atomicStore(&cellCount[gid.x], 0u);
+    let maxPerCell = u32(params.grid_params.w);
+    for (var k = 0u; k < maxPerCell; k++) {
+        atomicStore(&cellAgents[gid.x * maxPerCell + k], EMPTY_SLOT);
+    }
 }
 
 // ---- Kernel 4: Assign Cells ----
+// Each cell keeps its maxPerCell lowest agent indices in ascending order,
+// whatever order agents arrive in: every slot keeps the smaller of what it
+// holds and what arrives (atomicMin) and the larger moves on to the next. So
+// neighbours are summed in a fixed order, and a full cell always drops the
+// same agents.
 @compute @workgroup_size(256)
 fn assign_cells(@builtin(global_invocation_id) gid: vec3u) {
     let count = get_agents_count();
@@ -179,16 +229,21 @@ fn assign_cells(@builtin(global_invocation_id) gid: vec3u) {
     let cy = min(u32(max(floor(b.position.y / cellSz), 0.0)), gridH - 1u);
     let cellIdx = cx + cy * gridW;
 
-    let localIdx = atomicAdd(&cellCount[cellIdx], 1u);
-    if (localIdx < maxPerCell) {
-        cellAgents[cellIdx * maxPerCell + localIdx] = gid.x;
+    atomicAdd(&cellCount[cellIdx], 1u);
+    var carry = gid.x;
+    for (var k = 0u; k < maxPerCell; k++) {
+        let prev = atomicMin(&cellAgents[cellIdx * maxPerCell + k], carry);
+        if (prev == EMPTY_SLOT) { break; }
+        carry = max(prev, carry);
     }
 
     b.cell_id = cellIdx;
     agents[gid.x] = b;
 }
 
-// ---- Kernel 5: Move Agents ----
+// ---- Kernel 5: Move Agents (steering) ----
+// Forces only: neighbours are read while this dispatch runs, so positions and
+// velocities change in integrate_agents, after every agent has steered.
 @compute @workgroup_size(256)
 fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     let count = get_agents_count();
@@ -232,15 +287,18 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
             let cnt = min(atomicLoad(&cellCount[nIdx]), maxPerCell);
 
             for (var k = 0u; k < cnt; k++) {
-                let otherIdx = cellAgents[nIdx * maxPerCell + k];
+                let otherIdx = atomicLoad(&cellAgents[nIdx * maxPerCell + k]);
                 if (otherIdx == gid.x) { continue; }
 
-                let other = agents[otherIdx];
-                let d = toroidal_diff(b.position, other.position, rezF);
+                // Only fields no agent writes in this dispatch
+                let otherPos = agents[otherIdx].position;
+                let otherVel = agents[otherIdx].velocity;
+                let otherType = agents[otherIdx].type_id;
+                let d = toroidal_diff(b.position, otherPos, rezF);
                 let sqDist = dot(d, d);
 
                 // Type separation (same type)
-                if (other.type_id == b.type_id && sqDist < typeSepRange && sqDist > 0.0) {
+                if (otherType == b.type_id && sqDist < typeSepRange && sqDist > 0.0) {
                     typeSepSum += d / sqDist;
                     typeSepCnt += 1.0;
                 }
@@ -252,13 +310,13 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
                 }
 
                 // Alignment (same type)
-                if (other.type_id == b.type_id && sqDist < alignRng && sqDist > 0.0) {
-                    alignSum += other.velocity;
+                if (otherType == b.type_id && sqDist < alignRng && sqDist > 0.0) {
+                    alignSum += otherVel;
                     alignCnt += 1.0;
                 }
 
                 // Cohesion (same type) — accumulate direction toward neighbor
-                if (other.type_id == b.type_id && sqDist < attractRng && sqDist > 0.0) {
+                if (otherType == b.type_id && sqDist < attractRng && sqDist > 0.0) {
                     cohesionDir += -d;
                     cohesionCnt += 1.0;
                 }
@@ -318,6 +376,23 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
         b.acceleration += foodForce;
     }
 
+    agents[gid.x].acceleration = b.acceleration;
+    agents[gid.x].separateCount = typeSepCnt;
+    agents[gid.x].alignCount = alignCnt;
+    agents[gid.x].cohesionCount = cohesionCnt;
+}
+
+// ---- Kernel 6: Integrate Agents ----
+@compute @workgroup_size(256)
+fn integrate_agents(@builtin(global_invocation_id) gid: vec3u) {
+    let count = get_agents_count();
+    if (gid.x >= count) { return; }
+
+    var b = agents[gid.x];
+    let rez = get_rez();
+    let rezF = vec2f(f32(rez.x), f32(rez.y));
+    let maxSpd = select_channel(params.maxSpeeds, i32(b.type_id));
+
     // Update velocity and position
     b.velocity = limit_vec(b.velocity + b.acceleration, maxSpd);
     b.position += b.velocity;
@@ -331,14 +406,17 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (b.position.y < 0.0) { b.position.y += rezF.y; }
     if (b.position.y >= rezF.y) { b.position.y -= rezF.y; }
 
-    b.separateCount = typeSepCnt;
-    b.alignCount = alignCnt;
-    b.cohesionCount = cohesionCnt;
-
     agents[gid.x] = b;
+
+    // Claim the deposit pixel: the highest agent index wins, so agents sharing
+    // a pixel resolve the same way whatever order they run in
+    var px: vec2u;
+    if (deposit_pixel(b.position, &px)) {
+        atomicMax(&claims[px.y * rez.x + px.x], gid.x + 1u);
+    }
 }
 
-// ---- Kernel 6: Write Trails ----
+// ---- Kernel 7: Write Trails ----
 @compute @workgroup_size(256)
 fn write_trails(@builtin(global_invocation_id) gid: vec3u) {
     let count = get_agents_count();
@@ -346,11 +424,17 @@ fn write_trails(@builtin(global_invocation_id) gid: vec3u) {
 
     let a = agents[gid.x];
     let agentType = i32(a.type_id);
-    let px = vec2u(u32(round(a.position.x)), u32(round(a.position.y)));
     let rez = get_rez();
-    if (px.x >= rez.x || px.y >= rez.y) { return; }
+    var px: vec2u;
+    if (!deposit_pixel(a.position, &px)) { return; }
+
+    // Only the claiming agent writes; it also clears the claim for the next step
+    let claim = px.y * rez.x + px.x;
+    if (atomicLoad(&claims[claim]) != gid.x + 1u) { return; }
+    atomicStore(&claims[claim], 0u);
 
-    var env = textureLoad(trailRead, px, 0);
+    // Deposit on the diffused value, rounded like diffuse_texture's rgba16float store
+    var env = quantizeToF16(diffused_trail(vec2i(px), rez));
     let deposit = select_channel(params.depositAmounts, agentType);
     let eat = select_channel(params.eatAmounts, agentType);
 
@@ -379,32 +463,16 @@ fn write_trails(@builtin(global_invocation_id) gid: vec3u) {
     textureStore(trailWrite, px, env);
 }
 
-// ---- Kernel 7: Diffuse Texture ----
+// ---- Kernel 8: Diffuse Texture ----
 @compute @workgroup_size(8, 8)
 fn diffuse_texture(@builtin(global_invocation_id) gid: vec3u) {
     let rez = get_rez();
     if (gid.x >= rez.x || gid.y >= rez.y) { return; }
 
-    var avg = vec4f(0.0);
-    for (var dx = -1; dx <= 1; dx++) {
-        for (var dy = -1; dy <= 1; dy++) {
-            avg += sample_trail(vec2i(i32(gid.x) + dx, i32(gid.y) + dy), rez);
-        }
-    }
-    avg = avg / 9.0;
-
-    var oc = vec4f(
-        avg.x * params.diffuseRates.x,
-        avg.y * params.diffuseRates.y,
-        avg.z * params.diffuseRates.z,
-        avg.w * params.diffuseRates.w
-    );
-    oc = clamp(oc, vec4f(0.0), vec4f(1.0));
-
-    textureStore(trailWrite, gid.xy, oc);
+    textureStore(trailWrite, gid.xy, diffused_trail(vec2i(gid.xy), rez));
 }
 
-// ---- Kernel 8: Render ----
+// ---- Kernel 9: Render ----
 @compute @workgroup_size(8, 8)
 fn render(@builtin(global_invocation_id) gid: vec3u) {
     let rez = get_rez();
@@ -418,8 +486,8 @@ fn render(@builtin(global_invocation_id) gid: vec3u) {
     let c4 = hsb2rgb(vec3f(params.hues.w, params.saturations.w, 0.8 * trail.w), trail.w);
 
     var currentColor = textureLoad(outRead, gid.xy, 0);
-    currentColor = currentColor + c1 * 0.25 + c2 * 0.25 + c3 * 0.25 + c4 * 0.25;
-    currentColor = currentColor * 0.65;
+    let fresh = c1 * 0.25 + c2 * 0.25 + c3 * 0.25 + c4 * 0.25;
+    currentColor = currentColor * params.fade.x + fresh * params.fade.y; // (prev + fresh) * 0.65 per substep rendered
 
     textureStore(outWrite, gid.xy, currentColor);
 }
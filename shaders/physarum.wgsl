@@ -18,6 +18,8 @@ struct Params {
     hues: vec4f,
     saturations: vec4f,
     typeRatios: vec4f,         // cumulative thresholds for type distribution
+    seed: vec4u,               // x=seed lo, y=seed hi (64-bit run seed)
+    fade: vec4f,               // render: x=previous output weight, y=fresh weight
 };
 
 // Group 0: textures + uniforms
@@ -27,15 +29,24 @@ struct Params {
 @group(0) @binding(3) var outRead: texture_2d<f32>;
 @group(0) @binding(4) var outWrite: texture_storage_2d<rgba8unorm, write>;
 
-// Group 1: agent buffer
+// Group 1: agent buffer + deposit claims (one per trail pixel, 0 = unclaimed)
 @group(1) @binding(0) var<storage, read_write> agents: array<Agent>;
+@group(1) @binding(1) var<storage, read_write> claims: array<atomic<u32>>;
 
 // ---- Helpers ----
 
-fn random2(p: vec2f) -> vec2f {
-    var a = fract(vec3f(p.x, p.y, p.x) * vec3f(123.34, 234.34, 345.65));
-    a = a + dot(a, a + 34.45);
-    return fract(vec2f(a.x * a.y, a.y * a.z));
+// Integer hash (PCG): bit-identical on every adapter, unlike sin/fract hashes
+fn pcg_hash(v: u32) -> u32 {
+    let state = v * 747796405u + 2891336453u;
+    let word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Two uniform floats in [0,1) per (index, step, stream), keyed by the 64-bit seed
+fn rand2(index: u32, step: u32, stream: u32) -> vec2f {
+    let h0 = pcg_hash(index ^ pcg_hash(step ^ pcg_hash(stream ^ params.seed.x)));
+    let h1 = pcg_hash(h0 ^ params.seed.y);
+    return vec2f(f32(h0 >> 8u), f32(h1 >> 8u)) * (1.0 / 16777216.0);
 }
 
 fn rotate_vec2(v: vec2f, angle: f32) -> vec2f {
@@ -81,6 +92,13 @@ fn select_channel(v: vec4f, ch: i32) -> f32 {
     return v.w;
 }
 
+// Trail pixel an agent deposits to; false if outside the texture
+fn deposit_pixel(pos: vec2f, px: ptr<function, vec2u>) -> bool {
+    let rez = get_rez();
+    *px = vec2u(u32(round(pos.x)), u32(round(pos.y)));
+    return (*px).x < rez.x && (*px).y < rez.y;
+}
+
 fn sample_trail(pos: vec2i, rez: vec2u) -> vec4f {
     let wrapped = vec2i(
         (pos.x + i32(rez.x)) % i32(rez.x),
@@ -89,6 +107,27 @@ fn sample_trail(pos: vec2i, rez: vec2u) -> vec4f {
     return textureLoad(trailRead, vec2u(u32(wrapped.x), u32(wrapped.y)), 0);
 }
 
+// 3x3 box blur scaled by the per-channel diffuse rate: the value diffuse_texture
+// stores at pos. write_trails recomputes it from trailRead at each agent instead
+// of reading it back, so no copy of trailWrite -> trailRead is needed.
+fn diffused_trail(pos: vec2i, rez: vec2u) -> vec4f {
+    var avg = vec4f(0.0);
+    for (var dx = -1; dx <= 1; dx++) {
+        for (var dy = -1; dy <= 1; dy++) {
+            avg += sample_trail(vec2i(pos.x + dx, pos.y + dy), rez);
+        }
+    }
+    avg = avg / 9.0;
+
+    let oc = vec4f(
+        avg.x * params.diffuseRates.x,
+        avg.y * params.diffuseRates.y,
+        avg.z * params.diffuseRates.z,
+        avg.w * params.diffuseRates.w
+    );
+    return clamp(oc, vec4f(0.0), vec4f(1.0));
+}
+
 // ---- Kernel 1: Reset Texture ----
 @compute @workgroup_size(8, 8)
 fn reset_texture(@builtin(global_invocation_id) gid: vec3u) {
@@ -104,10 +143,10 @@ fn reset_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (gid.x >= count) { return; }
     let rez = get_rez();
     let rezF = vec2f(f32(rez.x), f32(rez.y));
-    let t = f32(get_time());
+    let t = get_time();
 
     // Ring distribution
-    let c = random2(vec2f(f32(gid.x)) * 0.0001 + t * 0.001);
+    let c = rand2(gid.x, t, 0u);
     let ang = c.x * 6.28318530718;
     let outerRadius = min(rezF.x, rezF.y) * 0.25;
     let ringThickness = rezF.x / 10.0;
@@ -117,7 +156,7 @@ fn reset_agents(@builtin(global_invocation_id) gid: vec3u) {
     let pos = center + vec2f(cos(ang), sin(ang)) * rad;
 
     // Random direction
-    let r2 = random2(vec2f(f32(gid.x), f32(gid.x)) * 0.001 + sin(t));
+    let r2 = rand2(gid.x, t, 1u);
     let dir = normalize(2.0 * (r2 - 0.5));
 
     agents[gid.x] = Agent(pos, dir);
@@ -130,7 +169,7 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (gid.x >= count) { return; }
     let rez = get_rez();
     let rezF = vec2f(f32(rez.x), f32(rez.y));
-    let t = f32(get_time());
+    let t = get_time();
 
     var a = agents[gid.x];
     let agentType = get_agent_type(gid.x, count);
@@ -175,7 +214,7 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (middleLevel > leftLevel && middleLevel > rightLevel) {
         d = middleSensor;
     } else if (middleLevel < leftLevel && middleLevel < rightLevel) {
-        let rnd = random2(vec2f(f32(gid.x), f32(gid.x)) * 0.01 + sin(t) * 0.01);
+        let rnd = rand2(gid.x, t, 2u);
         var sign = 1.0;
         if (rnd.x > 0.5) { sign = -1.0; }
         d = rotate_vec2(d, sign * turnAngle);
@@ -201,6 +240,13 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     a.position.y = a.position.y % f32(rez.y);
 
     agents[gid.x] = a;
+
+    // Claim the deposit pixel: the highest agent index wins, so agents sharing
+    // a pixel resolve the same way whatever order they run in
+    var px: vec2u;
+    if (deposit_pixel(a.position, &px)) {
+        atomicMax(&claims[px.y * rez.x + px.x], gid.x + 1u);
+    }
 }
 
 // ---- Kernel 4: Write Trails ----
@@ -211,10 +257,16 @@ fn write_trails(@builtin(global_invocation_id) gid: vec3u) {
 
     let a = agents[gid.x];
     let agentType = get_agent_type(gid.x, count);
-    let px = vec2u(u32(round(a.position.x)), u32(round(a.position.y)));
+    var px: vec2u;
+    if (!deposit_pixel(a.position, &px)) { return; }
 
-    // Read current trail value from trailRead (diffused data)
-    var env = textureLoad(trailRead, px, 0);
+    // Only the claiming agent writes; it also clears the claim for the next step
+    let claim = px.y * get_rez().x + px.x;
+    if (atomicLoad(&claims[claim]) != gid.x + 1u) { return; }
+    atomicStore(&claims[claim], 0u);
+
+    // Deposit on the diffused value, rounded like diffuse_texture's rgba16float store
+    var env = quantizeToF16(diffused_trail(vec2i(px), get_rez()));
 
     let deposit = select_channel(params.depositAmounts, agentType);
     let eat = select_channel(params.eatAmounts, agentType);
@@ -251,23 +303,7 @@ fn diffuse_texture(@builtin(global_invocation_id) gid: vec3u) {
     let rez = get_rez();
     if (gid.x >= rez.x || gid.y >= rez.y) { return; }
 
-    var avg = vec4f(0.0);
-    for (var dx = -1; dx <= 1; dx++) {
-        for (var dy = -1; dy <= 1; dy++) {
-            avg += sample_trail(vec2i(i32(gid.x) + dx, i32(gid.y) + dy), rez);
-        }
-    }
-    avg = avg / 9.0;
-
-    var oc = vec4f(
-        avg.x * params.diffuseRates.x,
-        avg.y * params.diffuseRates.y,
-        avg.z * params.diffuseRates.z,
-        avg.w * params.diffuseRates.w
-    );
-    oc = clamp(oc, vec4f(0.0), vec4f(1.0));
-
-    textureStore(trailWrite, gid.xy, oc);
+    textureStore(trailWrite, gid.xy, diffused_trail(vec2i(gid.xy), rez));
 }
 
 // ---- Kernel 6: Render ----
@@ -286,7 +322,7 @@ fn render(@builtin(global_invocation_id) gid: vec3u) {
     let fresh = c1 + c2 + c3 + c4;
 
     var prev = textureLoad(outRead, gid.xy, 0).rgb;
-    prev = prev * 0.65 + fresh * 0.35;
+    prev = prev * params.fade.x + fresh * params.fade.y; // 0.65 / 0.35 per substep rendered
 
     textureStore(outWrite, gid.xy, vec4f(prev, 1.0));
 }
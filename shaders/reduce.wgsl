@@ -0,0 +1,122 @@
+// Parallel reductions for live simulation statistics (SimStats).
+// reduce_texture / reduce_agents: a fixed grid of REDUCE_GROUPS workgroups
+// grid-strides over the input and writes one Stat per workgroup to partials.
+// reduce_partials: one workgroup folds the partials into results[params.slot],
+// accumulating so large agent buffers can be reduced in chunks.
+//
+// Stat meaning per source:
+//   texture: sum = channel sums, peak = channel maxima, count.x = occupied texels
+//   agents:  sum = speed sum per type, peak = max speed per type, count = population per type
+
+struct Params {
+    count: u32,          // texture: width; agents: agents in this chunk
+    height: u32,         // texture only
+    base: u32,           // agents: index of the chunk's first agent
+    slot: u32,           // reduce_partials: result index
+    strideWords: u32,    // agents: u32 words per agent
+    velocityWord: u32,   // agents: word offset of a vec2f velocity, NONE = no speed
+    typeWord: u32,       // agents: word offset of a u32 type id, NONE = from typeRatios
+    total: u32,          // agents: total agent count (for typeRatios)
+    typeRatios: vec4f,   // cumulative type thresholds by agent index
+    threshold: f32,      // texture: a texel is occupied if any of r,g,b exceeds this
+};
+
+struct Stat {
+    sum: vec4f,
+    peak: vec4f,
+    count: vec4u,
+};
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read_write> partials: array<Stat>;
+@group(0) @binding(2) var<storage, read_write> results: array<Stat>;  // reduce_partials
+@group(0) @binding(3) var<storage, read> words: array<u32>;           // reduce_agents
+@group(0) @binding(4) var tex: texture_2d<f32>;                       // reduce_texture
+
+const WG_SIZE: u32 = 256u;
+const REDUCE_GROUPS: u32 = 256u;
+const THREADS: u32 = 65536u; // REDUCE_GROUPS * WG_SIZE
+const NONE: u32 = 0xffffffffu;
+
+var<workgroup> wgSum: array<vec4f, 256>;
+var<workgroup> wgPeak: array<vec4f, 256>;
+var<workgroup> wgCount: array<vec4u, 256>;
+
+// Tree reduction in shared memory; the result ends up in slot 0
+fn workgroup_reduce(lid: u32, s: Stat) {
+    wgSum[lid] = s.sum;
+    wgPeak[lid] = s.peak;
+    wgCount[lid] = s.count;
+    workgroupBarrier();
+    for (var stride = WG_SIZE / 2u; stride > 0u; stride >>= 1u) {
+        if (lid < stride) {
+            wgSum[lid] += wgSum[lid + stride];
+            wgPeak[lid] = max(wgPeak[lid], wgPeak[lid + stride]);
+            wgCount[lid] += wgCount[lid + stride];
+        }
+        workgroupBarrier();
+    }
+}
+
+fn workgroup_stat() -> Stat {
+    return Stat(wgSum[0], wgPeak[0], wgCount[0]);
+}
+
+@compute @workgroup_size(256)
+fn reduce_texture(@builtin(global_invocation_id) gid: vec3u,
+                  @builtin(local_invocation_index) lid: u32,
+                  @builtin(workgroup_id) wid: vec3u) {
+    var s = Stat(vec4f(0.0), vec4f(0.0), vec4u(0u));
+    let w = params.count;
+    let n = w * params.height;
+    for (var i = gid.x; i < n; i += THREADS) {
+        let v = textureLoad(tex, vec2u(i % w, i / w), 0);
+        s.sum += v;
+        s.peak = max(s.peak, v);
+        if (any(v.rgb > vec3f(params.threshold))) { s.count.x += 1u; }
+    }
+    workgroup_reduce(lid, s);
+    if (lid == 0u) { partials[wid.x] = workgroup_stat(); }
+}
+
+fn agent_type(index: u32) -> u32 {
+    if (params.typeWord != NONE) {
+        return min(words[(index - params.base) * params.strideWords + params.typeWord], 3u);
+    }
+    let frac = f32(index) / f32(params.total);
+    if (frac < params.typeRatios.x) { return 0u; }
+    if (frac < params.typeRatios.y) { return 1u; }
+    if (frac < params.typeRatios.z) { return 2u; }
+    return 3u;
+}
+
+@compute @workgroup_size(256)
+fn reduce_agents(@builtin(global_invocation_id) gid: vec3u,
+                 @builtin(local_invocation_index) lid: u32,
+                 @builtin(workgroup_id) wid: vec3u) {
+    var s = Stat(vec4f(0.0), vec4f(0.0), vec4u(0u));
+    for (var i = gid.x; i < params.count; i += THREADS) {
+        let t = agent_type(params.base + i);
+        let mask = select(vec4f(0.0), vec4f(1.0), vec4u(t) == vec4u(0u, 1u, 2u, 3u));
+        s.count += vec4u(mask);
+        if (params.velocityWord != NONE) {
+            let w = i * params.strideWords + params.velocityWord;
+            let speed = length(vec2f(bitcast<f32>(words[w]), bitcast<f32>(words[w + 1u])));
+            s.sum += mask * speed;
+            s.peak = max(s.peak, mask * speed);
+        }
+    }
+    workgroup_reduce(lid, s);
+    if (lid == 0u) { partials[wid.x] = workgroup_stat(); }
+}
+
+// Single workgroup: one partial per invocation (REDUCE_GROUPS == WG_SIZE)
+@compute @workgroup_size(256)
+fn reduce_partials(@builtin(local_invocation_index) lid: u32) {
+    workgroup_reduce(lid, partials[lid]);
+    if (lid == 0u) {
+        let prev = results[params.slot];
+        let s = workgroup_stat();
+        results[params.slot] = Stat(prev.sum + s.sum, max(prev.peak, s.peak), prev.count + s.count);
+    }
+}
@@ -0,0 +1,62 @@
+// RGB -> planar YUV 4:2:0 (BT.601, limited range) for the Y4M recorder.
+// Output is one tightly packed frame: Y (w*h bytes), then U and V
+// ((w/2)*(h/2) bytes each), 4 samples per u32. Width must be a multiple of 8,
+// height even.
+
+struct Params {
+    width: u32,
+    height: u32,
+};
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var inputTex: texture_2d<f32>;
+@group(0) @binding(2) var<storage, read_write> planes: array<u32>;
+
+fn luma(c: vec3f) -> f32 { return 16.0 + dot(c, vec3f(65.481, 128.553, 24.966)); }
+fn chromaU(c: vec3f) -> f32 { return 128.0 + dot(c, vec3f(-37.797, -74.203, 112.0)); }
+fn chromaV(c: vec3f) -> f32 { return 128.0 + dot(c, vec3f(112.0, -93.786, -18.214)); }
+
+fn pack(v: vec4f) -> u32 {
+    let b = vec4u(clamp(round(v), vec4f(0.0), vec4f(255.0)));
+    return b.x | (b.y << 8u) | (b.z << 16u) | (b.w << 24u);
+}
+
+fn load(x: u32, y: u32) -> vec3f {
+    return textureLoad(inputTex, vec2u(x, y), 0).rgb;
+}
+
+// One invocation per 4 horizontal luma samples
+@compute @workgroup_size(8, 8)
+fn luma_main(@builtin(global_invocation_id) gid: vec3u) {
+    let words = params.width / 4u;
+    if (gid.x >= words || gid.y >= params.height) { return; }
+
+    var y = vec4f(0.0);
+    for (var i = 0u; i < 4u; i++) {
+        y[i] = luma(load(gid.x * 4u + i, gid.y));
+    }
+    planes[gid.y * words + gid.x] = pack(y);
+}
+
+// One invocation per 4 horizontal chroma samples (an 8x2 pixel block)
+@compute @workgroup_size(8, 8)
+fn chroma_main(@builtin(global_invocation_id) gid: vec3u) {
+    let cw = params.width / 2u;
+    let ch = params.height / 2u;
+    let words = cw / 4u;
+    if (gid.x >= words || gid.y >= ch) { return; }
+
+    var u = vec4f(0.0);
+    var v = vec4f(0.0);
+    for (var i = 0u; i < 4u; i++) {
+        let x = (gid.x * 4u + i) * 2u;
+        let y = gid.y * 2u;
+        let c = (load(x, y) + load(x + 1u, y) + load(x, y + 1u) + load(x + 1u, y + 1u)) * 0.25;
+        u[i] = chromaU(c);
+        v[i] = chromaV(c);
+    }
+    let lumaWords = params.width * params.height / 4u;
+    let chromaWords = cw * ch / 4u;
+    planes[lumaWords + gid.y * words + gid.x] = pack(u);
+    planes[lumaWords + chromaWords + gid.y * words + gid.x] = pack(v);
+}
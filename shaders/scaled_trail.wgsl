@@ -0,0 +1,97 @@
+// Export-size trail field of an agent sim (ScaledTrail): the sim trail
+// upsampled, with every agent stamped over it as an antialiased disc one sim
+// pixel across, carrying the unfiltered trail value of its own pixel in its
+// own channel. Stamps are atomicMax'ed per channel into a fixed-point buffer
+// holding one band of rows, then resolved, so overlapping discs give the same
+// field in any order.
+
+struct Params {
+    rez: vec2u,          // export size
+    band: vec2u,         // x = first row of this band, y = rows
+    agents: u32,
+    stride: u32,         // u32 words per agent; position is the first vec2f
+    type_word: i32,      // word of a u32 type id, -1 = by index via type_ratios
+    scale: f32,
+    type_ratios: vec4f,  // cumulative thresholds for type distribution
+};
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var trail: texture_2d<f32>; // sim size
+@group(0) @binding(2) var<storage, read> agents: array<u32>;
+@group(0) @binding(3) var<storage, read_write> stamps: array<atomic<u32>>; // 4 per band pixel
+@group(0) @binding(4) var field: texture_storage_2d<rgba16float, write>;
+
+const STAMP_ONE: f32 = 65535.0; // fixed point of the stamps
+
+fn sample_trail(pos: vec2i) -> vec4f {
+    let rez = vec2i(textureDimensions(trail));
+    return textureLoad(trail, (pos % rez + rez) % rez, 0);
+}
+
+// Sim trail at p in sim pixels (texel centers on integers), bilinear and wrapped
+fn trail_bilinear(p: vec2f) -> vec4f {
+    let i = vec2i(floor(p));
+    let t = p - floor(p);
+    let a = mix(sample_trail(i), sample_trail(i + vec2i(1, 0)), t.x);
+    let b = mix(sample_trail(i + vec2i(0, 1)), sample_trail(i + vec2i(1, 1)), t.x);
+    return mix(a, b, t.y);
+}
+
+fn agent_type(id: u32) -> u32 {
+    if (params.type_word >= 0) { return min(agents[id * params.stride + u32(params.type_word)], 3u); }
+    let frac = f32(id) / f32(params.agents);
+    if (frac < params.type_ratios.x) { return 0u; }
+    if (frac < params.type_ratios.y) { return 1u; }
+    if (frac < params.type_ratios.z) { return 2u; }
+    return 3u;
+}
+
+@compute @workgroup_size(8, 8)
+fn clear_stamps(@builtin(global_invocation_id) gid: vec3u) {
+    if (gid.x >= params.rez.x || gid.y >= params.band.y) { return; }
+    let i = (gid.y * params.rez.x + gid.x) * 4u;
+    for (var c = 0u; c < 4u; c++) { atomicStore(&stamps[i + c], 0u); }
+}
+
+@compute @workgroup_size(256)
+fn stamp_agents(@builtin(global_invocation_id) gid: vec3u) {
+    if (gid.x >= params.agents) { return; }
+
+    let base = gid.x * params.stride;
+    let pos = vec2f(bitcast<f32>(agents[base]), bitcast<f32>(agents[base + 1u]));
+    let ch = agent_type(gid.x);
+    let peak = sample_trail(vec2i(round(pos)))[ch];
+    if (peak <= 0.0) { return; }
+
+    let rez = vec2i(params.rez);
+    let bandLo = i32(params.band.x);
+    let bandHi = bandLo + i32(params.band.y);
+    let center = (pos + 0.5) * params.scale; // export pixels, texel centers on +0.5
+    let r = 0.5 * params.scale;
+    let lo = vec2i(floor(center - r)) - 1;
+    let hi = vec2i(ceil(center + r));
+
+    for (var y = lo.y; y <= hi.y; y++) {
+        let qy = (y % rez.y + rez.y) % rez.y;
+        if (qy < bandLo || qy >= bandHi) { continue; }
+        for (var x = lo.x; x <= hi.x; x++) {
+            let cover = clamp(r + 0.5 - distance(vec2f(f32(x), f32(y)) + 0.5, center), 0.0, 1.0);
+            if (cover <= 0.0) { continue; }
+            let qx = (x % rez.x + rez.x) % rez.x;
+            let i = (u32(qy - bandLo) * params.rez.x + u32(qx)) * 4u + ch;
+            atomicMax(&stamps[i], u32(round(peak * cover * STAMP_ONE)));
+        }
+    }
+}
+
+@compute @workgroup_size(8, 8)
+fn resolve(@builtin(global_invocation_id) gid: vec3u) {
+    if (gid.x >= params.rez.x || gid.y >= params.band.y) { return; }
+    let i = (gid.y * params.rez.x + gid.x) * 4u;
+    let s = vec4f(f32(atomicLoad(&stamps[i])), f32(atomicLoad(&stamps[i + 1u])),
+                  f32(atomicLoad(&stamps[i + 2u])), f32(atomicLoad(&stamps[i + 3u]))) / STAMP_ONE;
+
+    let q = vec2u(gid.x, gid.y + params.band.x);
+    let p = (vec2f(q) + 0.5) / params.scale - 0.5;
+    textureStore(field, q, max(trail_bilinear(p), s));
+}
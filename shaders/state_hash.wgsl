@@ -0,0 +1,80 @@
+// Order-independent 64-bit state hash.
+// Every element is hashed together with its index and the per-element hashes
+// are summed (mod 2^32) into two u32 lanes. Addition commutes, so the result
+// does not depend on dispatch or atomic ordering — only on the data.
+
+struct Params {
+    count: u32,      // hash_buffer: words in this chunk; hash_texture: width
+    height: u32,     // hash_texture only
+    base: u32,       // index of the first word in this chunk (buffers hashed in chunks)
+    lane: u32,       // result lanes [lane, lane + 1]
+};
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read_write> result: array<atomic<u32>>;
+@group(0) @binding(2) var<storage, read> words: array<u32>;   // hash_buffer
+@group(0) @binding(3) var tex: texture_2d<f32>;               // hash_texture
+
+var<workgroup> wgSum: array<atomic<u32>, 2>;
+
+// Number of invocations in a hash_buffer dispatch (1024 workgroups x 256)
+const BUFFER_THREADS: u32 = 262144u;
+
+fn pcg_hash(v: u32) -> u32 {
+    let state = v * 747796405u + 2891336453u;
+    let word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Reduce within the workgroup first, then one global atomic per lane
+fn accumulate(lid: u32, h0: u32, h1: u32) {
+    atomicAdd(&wgSum[0], h0);
+    atomicAdd(&wgSum[1], h1);
+    workgroupBarrier();
+    if (lid == 0u) {
+        atomicAdd(&result[params.lane], atomicLoad(&wgSum[0]));
+        atomicAdd(&result[params.lane + 1u], atomicLoad(&wgSum[1]));
+    }
+}
+
+@compute @workgroup_size(256)
+fn hash_buffer(@builtin(global_invocation_id) gid: vec3u,
+               @builtin(local_invocation_index) lid: u32) {
+    if (lid == 0u) {
+        atomicStore(&wgSum[0], 0u);
+        atomicStore(&wgSum[1], 0u);
+    }
+    workgroupBarrier();
+
+    // Grid-stride loop: fixed dispatch size regardless of buffer length
+    var h0 = 0u;
+    var h1 = 0u;
+    for (var i = gid.x; i < params.count; i += BUFFER_THREADS) {
+        let h = pcg_hash(words[i] ^ pcg_hash(params.base + i));
+        h0 += h;
+        h1 += pcg_hash(h ^ 0x9e3779b9u);
+    }
+    accumulate(lid, h0, h1);
+}
+
+@compute @workgroup_size(8, 8)
+fn hash_texture(@builtin(global_invocation_id) gid: vec3u,
+                @builtin(local_invocation_index) lid: u32) {
+    if (lid == 0u) {
+        atomicStore(&wgSum[0], 0u);
+        atomicStore(&wgSum[1], 0u);
+    }
+    workgroupBarrier();
+
+    var h0 = 0u;
+    var h1 = 0u;
+    if (gid.x < params.count && gid.y < params.height) {
+        // Raw bits of each channel (f16 -> f32 and unorm -> f32 are exact)
+        let bits = bitcast<vec4u>(textureLoad(tex, gid.xy, 0));
+        let idx = gid.y * params.count + gid.x;
+        let h = pcg_hash(bits.x ^ pcg_hash(bits.y ^ pcg_hash(bits.z ^ pcg_hash(bits.w ^ pcg_hash(idx)))));
+        h0 = h;
+        h1 = pcg_hash(h ^ 0x9e3779b9u);
+    }
+    accumulate(lid, h0, h1);
+}
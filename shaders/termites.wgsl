@@ -19,6 +19,7 @@ struct Params {
     hues: vec4f,
     saturations: vec4f,
     typeRatios: vec4f,         // cumulative thresholds for type distribution
+    seed: vec4u,               // x=seed lo, y=seed hi (64-bit run seed)
 };
 
 // Group 0: textures + uniforms
@@ -30,15 +31,24 @@ struct Params {
 @group(0) @binding(5) var outRead: texture_2d<f32>;
 @group(0) @binding(6) var outWrite: texture_storage_2d<rgba8unorm, write>;
 
-// Group 1: agent buffer
+// Group 1: agent buffer + deposit claims (trail, mound per pixel; 0 = unclaimed)
 @group(1) @binding(0) var<storage, read_write> agents: array<Agent>;
+@group(1) @binding(1) var<storage, read_write> claims: array<atomic<u32>>;
 
 // ---- Helpers ----
 
-fn random2(p: vec2f) -> vec2f {
-    var a = fract(vec3f(p.x, p.y, p.x) * vec3f(123.34, 234.34, 345.65));
-    a = a + dot(a, a + 34.45);
-    return fract(vec2f(a.x * a.y, a.y * a.z));
+// Integer hash (PCG): bit-identical on every adapter, unlike sin/fract hashes
+fn pcg_hash(v: u32) -> u32 {
+    let state = v * 747796405u + 2891336453u;
+    let word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Two uniform floats in [0,1) per (index, step, stream), keyed by the 64-bit seed
+fn rand2(index: u32, step: u32, stream: u32) -> vec2f {
+    let h0 = pcg_hash(index ^ pcg_hash(step ^ pcg_hash(stream ^ params.seed.x)));
+    let h1 = pcg_hash(h0 ^ params.seed.y);
+    return vec2f(f32(h0 >> 8u), f32(h1 >> 8u)) * (1.0 / 16777216.0);
 }
 
 fn rotate_vec2(v: vec2f, angle: f32) -> vec2f {
@@ -84,6 +94,18 @@ fn select_channel(v: vec4f, ch: i32) -> f32 {
     return v.w;
 }
 
+// Trail/mound pixel an agent deposits to; false if outside the texture
+fn deposit_pixel(pos: vec2f, px: ptr<function, vec2u>) -> bool {
+    let rez = get_rez();
+    *px = vec2u(u32(round(pos.x)), u32(round(pos.y)));
+    return (*px).x < rez.x && (*px).y < rez.y;
+}
+
+// Whether the agent's probabilistic mound deposit fires this step
+fn deposits_mound(id: u32, agentType: i32) -> bool {
+    return rand2(id, get_time(), 3u).x < select_channel(params.depositRates, agentType);
+}
+
 fn sample_trail(pos: vec2i, rez: vec2u) -> vec4f {
     let wrapped = vec2i(
         (pos.x + i32(rez.x)) % i32(rez.x),
@@ -108,10 +130,10 @@ fn reset_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (gid.x >= count) { return; }
     let rez = get_rez();
     let rezF = vec2f(f32(rez.x), f32(rez.y));
-    let t = f32(get_time());
+    let t = get_time();
 
     // Ring distribution
-    let c = random2(vec2f(f32(gid.x)) * 0.0001 + t * 0.001);
+    let c = rand2(gid.x, t, 0u);
     let ang = c.x * 6.28318530718;
     let outerRadius = min(rezF.x, rezF.y) * 0.25;
     let ringThickness = rezF.x / 10.0;
@@ -121,7 +143,7 @@ fn reset_agents(@builtin(global_invocation_id) gid: vec3u) {
     let pos = center + vec2f(cos(ang), sin(ang)) * rad;
 
     // Random direction
-    let r2 = random2(vec2f(f32(gid.x), f32(gid.x)) * 0.001 + sin(t));
+    let r2 = rand2(gid.x, t, 1u);
     let dir = normalize(2.0 * (r2 - 0.5));
 
     agents[gid.x] = Agent(pos, dir);
@@ -134,7 +156,7 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (gid.x >= count) { return; }
     let rez = get_rez();
     let rezF = vec2f(f32(rez.x), f32(rez.y));
-    let t = f32(get_time());
+    let t = get_time();
 
     var a = agents[gid.x];
     let agentType = get_agent_type(gid.x, count);
@@ -181,7 +203,7 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     } else if (rightLevel > leftLevel) {
         d = rotate_vec2(d, turnAngle);
     } else {
-        let rnd = random2(vec2f(f32(gid.x), f32(gid.x)) * 0.01 + sin(t) * 0.01);
+        let rnd = rand2(gid.x, t, 2u);
         var sign = 1.0;
         if (rnd.x > 0.5) { sign = -1.0; }
         d = rotate_vec2(d, sign * turnAngle);
@@ -198,6 +220,30 @@ fn move_agents(@builtin(global_invocation_id) gid: vec3u) {
     if (a.position.y >= rezF.y) { a.position.y -= rezF.y; }
 
     agents[gid.x] = a;
+
+    // Claim the deposit pixel (and its mound, if the deposit fires): the highest
+    // agent index wins, so agents sharing a pixel resolve the same way whatever
+    // order they run in
+    var px: vec2u;
+    if (deposit_pixel(a.position, &px)) {
+        let claim = (px.y * rez.x + px.x) * 2u;
+        atomicMax(&claims[claim], gid.x + 1u);
+        if (deposits_mound(gid.x, agentType)) { atomicMax(&claims[claim + 1u], gid.x + 1u); }
+    }
+}
+
+// Exponentially decayed trail: the value decay_texture stores at px.
+// write_trails recomputes it from trailRead instead of reading it back, so no
+// copy of trailWrite -> trailRead is needed.
+fn decayed_trail(px: vec2u) -> vec4f {
+    let val = textureLoad(trailRead, px, 0);
+    let decayed = vec4f(
+        val.x * params.decayRates.x,
+        val.y * params.decayRates.y,
+        val.z * params.decayRates.z,
+        val.w * params.decayRates.w
+    );
+    return clamp(decayed, vec4f(0.0), vec4f(1.0));
 }
 
 // ---- Kernel 4: Decay + Copy (trail decays, mound persists) ----
@@ -207,14 +253,7 @@ fn decay_texture(@builtin(global_invocation_id) gid: vec3u) {
     if (gid.x >= rez.x || gid.y >= rez.y) { return; }
 
     // Trail: exponential decay
-    let val = textureLoad(trailRead, gid.xy, 0);
-    let decayed = vec4f(
-        val.x * params.decayRates.x,
-        val.y * params.decayRates.y,
-        val.z * params.decayRates.z,
-        val.w * params.decayRates.w
-    );
-    textureStore(trailWrite, gid.xy, clamp(decayed, vec4f(0.0), vec4f(1.0)));
+    textureStore(trailWrite, gid.xy, decayed_trail(gid.xy));
 
     // Mound: identity copy (no decay — persists until reset)
     let mound = textureLoad(moundRead, gid.xy, 0);
@@ -226,30 +265,40 @@ fn decay_texture(@builtin(global_invocation_id) gid: vec3u) {
 fn write_trails(@builtin(global_invocation_id) gid: vec3u) {
     let count = get_agents_count();
     if (gid.x >= count) { return; }
-    let t = f32(get_time());
 
     let a = agents[gid.x];
     let agentType = get_agent_type(gid.x, count);
-    let px = vec2u(u32(round(a.position.x)), u32(round(a.position.y)));
+    var px: vec2u;
+    if (!deposit_pixel(a.position, &px)) { return; }
     let deposit = select_channel(params.depositAmounts, agentType);
 
-    // Always deposit pheromone trail (for navigation)
-    var trail = textureLoad(trailRead, px, 0);
-    if (agentType == 0) {
-        trail.x = clamp(trail.x + deposit, 0.0, 1.0);
-    } else if (agentType == 1) {
-        trail.y = clamp(trail.y + deposit, 0.0, 1.0);
-    } else if (agentType == 2) {
-        trail.z = clamp(trail.z + deposit, 0.0, 1.0);
-    } else {
-        trail.w = clamp(trail.w + deposit, 0.0, 1.0);
+    // Only the claiming agents write; they also clear their claims for the next step
+    let claim = (px.y * get_rez().x + px.x) * 2u;
+    let ownsTrail = atomicLoad(&claims[claim]) == gid.x + 1u;
+    let ownsMound = atomicLoad(&claims[claim + 1u]) == gid.x + 1u;
+    if (ownsTrail) { atomicStore(&claims[claim], 0u); }
+    if (ownsMound) { atomicStore(&claims[claim + 1u], 0u); }
+    if (!ownsTrail && !ownsMound) { return; }
+
+    // Always deposit pheromone trail (for navigation), on the decayed value
+    // rounded like decay_texture's rgba16float store
+    if (ownsTrail) {
+        var trail = quantizeToF16(decayed_trail(px));
+        if (agentType == 0) {
+            trail.x = clamp(trail.x + deposit, 0.0, 1.0);
+        } else if (agentType == 1) {
+            trail.y = clamp(trail.y + deposit, 0.0, 1.0);
+        } else if (agentType == 2) {
+            trail.z = clamp(trail.z + deposit, 0.0, 1.0);
+        } else {
+            trail.w = clamp(trail.w + deposit, 0.0, 1.0);
+        }
+        textureStore(trailWrite, px, trail);
     }
-    textureStore(trailWrite, px, trail);
 
-    // Probabilistic mound deposit (persistent material)
-    let rnd = random2(vec2f(f32(gid.x) * 0.0137, t * 0.0031));
-    let depositRate = select_channel(params.depositRates, agentType);
-    if (rnd.x < depositRate) {
+    // Probabilistic mound deposit (persistent material); only claimed if it fired
+    if (ownsMound) {
+        // decay_texture copies the mound unchanged, so moundRead already holds it
         var mound = textureLoad(moundRead, px, 0);
         if (agentType == 0) {
             mound.x = clamp(mound.x + deposit, 0.0, 1.0);
@@ -3,6 +3,11 @@ struct Params {
     src_h: u32,
     dst_w: u32,
     dst_h: u32,
+    // Region of the dst_w x dst_h image this dispatch writes; outputTex holds just the region
+    tile_x: u32,
+    tile_y: u32,
+    tile_w: u32,
+    tile_h: u32,
 };
 
 @group(0) @binding(0) var<uniform> params: Params;
@@ -12,9 +17,10 @@ struct Params {
 
 @compute @workgroup_size(8, 8)
 fn main(@builtin(global_invocation_id) gid: vec3u) {
-    if (gid.x >= params.dst_w || gid.y >= params.dst_h) { return; }
+    if (gid.x >= params.tile_w || gid.y >= params.tile_h) { return; }
 
-    let uv = (vec2f(f32(gid.x), f32(gid.y)) + 0.5) / vec2f(f32(params.dst_w), f32(params.dst_h));
+    let p = vec2f(f32(gid.x + params.tile_x), f32(gid.y + params.tile_y));
+    let uv = (p + 0.5) / vec2f(f32(params.dst_w), f32(params.dst_h));
     let color = textureSampleLevel(inputTex, inputSampler, uv, 0.0);
     textureStore(outputTex, gid.xy, color);
 }
@@ -1,4 +1,8 @@
 #include "boids.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "../gpu_profiler.h"
+#include "../cpu_trace.h"
 #include "../preset.h"
 #include <imgui.h>
 #include <cmath>
@@ -6,68 +10,50 @@
 #include <cstdio>
 #include <random>
 
+static constexpr float FADE_KEEP = 0.65f, FADE_FRESH = 0.65f; // render: (out + fresh) * 0.65
+
 void BoidsSim::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h) {
     m_device = device;
     m_queue = queue;
     params.width = w;
     params.height = h;
 
-    m_trailTextures.init(device, w, h, WGPUTextureFormat_RGBA16Float);
-    m_outputTextures.init(device, w, h, WGPUTextureFormat_RGBA8Unorm);
+    m_trailTextures.init(w, h, WGPUTextureFormat_RGBA16Float, "Boids");
+    m_outputTextures.init(w, h, WGPUTextureFormat_RGBA8Unorm, "Boids");
 
     createBuffers();
     createPipelines();
+    createGroup0s();
+    m_scaledTrail.init(device, queue);
     m_needsReset = true;
 }
 
 void BoidsSim::createBuffers() {
     // Agent buffer: 48 bytes per agent
     {
-        WGPUBufferDescriptor desc = {};
-        desc.size = (uint64_t)m_agentCount * 48;
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "boids_agents";
-        m_agentBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-    }
-    // Uniform buffer: 256 bytes
-    {
-        WGPUBufferDescriptor desc = {};
-        desc.size = sizeof(GpuParams);
-        desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-        desc.label = "boids_params";
-        m_uniformBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
+        m_agentBufferSize = (uint64_t)m_agentCount * 48;
+        m_agentBuffer = gpuPool().acquireBuffer(m_agentBufferSize, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                "boids_agents", "Boids");
     }
+    // Uniform ring: one GpuParams block per substep (Steps/Frame slider max, grows on demand)
+    m_uniforms.init(m_device, m_queue, sizeof(GpuParams), 20, "Boids");
     // Grid buffers
     m_gridW = (uint32_t)ceilf((float)params.width / m_cellSize);
     m_gridH = (uint32_t)ceilf((float)params.height / m_cellSize);
     uint32_t totalCells = m_gridW * m_gridH;
-    {
-        WGPUBufferDescriptor desc = {};
-        desc.size = totalCells * sizeof(uint32_t);
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "boids_cellCount";
-        m_cellCountBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-    }
-    {
-        WGPUBufferDescriptor desc = {};
-        desc.size = (uint64_t)MAX_PER_CELL * totalCells * sizeof(uint32_t);
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "boids_cellAgents";
-        m_cellAgentsBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-    }
+    m_cellCountBuffer = gpuPool().acquireBuffer(totalCells * sizeof(uint32_t),
+                                                WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                "boids_cellCount", "Boids");
+    m_cellAgentsBuffer = gpuPool().acquireBuffer((uint64_t)MAX_PER_CELL * totalCells * sizeof(uint32_t),
+                                                 WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                 "boids_cellAgents", "Boids");
+    // Deposit claims: zeroed on reset, and again by each pixel's winner every step
+    m_claimBuffer = gpuPool().acquireBuffer((uint64_t)params.width * params.height * 4,
+                                            WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                            "boids_claims", "Boids");
 }
 
 void BoidsSim::createPipelines() {
-    std::string code = loadShaderFile("shaders/boids.wgsl");
-    if (code.empty()) return;
-
-    WGPUShaderModuleWGSLDescriptor wgslDesc = {};
-    wgslDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
-    wgslDesc.code = code.c_str();
-    WGPUShaderModuleDescriptor smDesc = {};
-    smDesc.nextInChain = &wgslDesc.chain;
-    m_shaderModule = wgpuDeviceCreateShaderModule(m_device, &smDesc);
-
     // Group 0 layout: uniform, trailRead, trailWrite, outRead, outWrite (same as Physarum)
     {
         WGPUBindGroupLayoutEntry entries[5] = {};
@@ -75,6 +61,7 @@ void BoidsSim::createPipelines() {
         entries[0].binding = 0;
         entries[0].visibility = WGPUShaderStage_Compute;
         entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+        entries[0].buffer.hasDynamicOffset = true;
         entries[0].buffer.minBindingSize = sizeof(GpuParams);
 
         entries[1].binding = 1;
@@ -102,7 +89,7 @@ void BoidsSim::createPipelines() {
         WGPUBindGroupLayoutDescriptor desc = {};
         desc.entryCount = 5;
         desc.entries = entries;
-        m_group0Layout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        m_group0Layout = gpuCreateBindGroupLayout(m_device, &desc, "Boids");
     }
 
     // Group 1 layout: agents storage buffer
@@ -116,12 +103,12 @@ void BoidsSim::createPipelines() {
         WGPUBindGroupLayoutDescriptor desc = {};
         desc.entryCount = 1;
         desc.entries = &entry;
-        m_group1Layout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        m_group1Layout = gpuCreateBindGroupLayout(m_device, &desc, "Boids");
     }
 
-    // Group 2 layout: cellCount + cellAgents storage buffers
+    // Group 2 layout: cellCount + cellAgents + claims storage buffers
     {
-        WGPUBindGroupLayoutEntry entries[2] = {};
+        WGPUBindGroupLayoutEntry entries[3] = {};
 
         entries[0].binding = 0;
         entries[0].visibility = WGPUShaderStage_Compute;
@@ -133,10 +120,15 @@ void BoidsSim::createPipelines() {
         entries[1].buffer.type = WGPUBufferBindingType_Storage;
         entries[1].buffer.minBindingSize = 4;
 
+        entries[2].binding = 2;
+        entries[2].visibility = WGPUShaderStage_Compute;
+        entries[2].buffer.type = WGPUBufferBindingType_Storage;
+        entries[2].buffer.minBindingSize = 4;
+
         WGPUBindGroupLayoutDescriptor desc = {};
-        desc.entryCount = 2;
+        desc.entryCount = 3;
         desc.entries = entries;
-        m_group2Layout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        m_group2Layout = gpuCreateBindGroupLayout(m_device, &desc, "Boids");
     }
 
     // Pipeline layout with 3 bind groups
@@ -148,23 +140,21 @@ void BoidsSim::createPipelines() {
         m_pipelineLayout = wgpuDeviceCreatePipelineLayout(m_device, &desc);
     }
 
-    // Create all 8 pipelines
-    auto makePipeline = [&](const char* entry) -> WGPUComputePipeline {
-        WGPUComputePipelineDescriptor desc = {};
-        desc.layout = m_pipelineLayout;
-        desc.compute.module = m_shaderModule;
-        desc.compute.entryPoint = entry;
-        return wgpuDeviceCreateComputePipeline(m_device, &desc);
+    // Create all 9 pipelines, compiled on the worker threads
+    auto shader = m_pipelines.shader("shaders/boids.wgsl");
+    auto makePipeline = [&](const char* entry, WGPUComputePipeline* out) {
+        m_pipelines.add(m_device, shader, entry, m_pipelineLayout, out, "Boids");
     };
 
-    m_resetTexturePipeline   = makePipeline("reset_texture");
-    m_resetAgentsPipeline    = makePipeline("reset_agents");
-    m_clearGridPipeline      = makePipeline("clear_grid");
-    m_assignCellsPipeline    = makePipeline("assign_cells");
-    m_moveAgentsPipeline     = makePipeline("move_agents");
-    m_writeTrailsPipeline    = makePipeline("write_trails");
-    m_diffuseTexturePipeline = makePipeline("diffuse_texture");
-    m_renderPipeline         = makePipeline("render");
+    makePipeline("reset_texture",   &m_resetTexturePipeline);
+    makePipeline("reset_agents",    &m_resetAgentsPipeline);
+    makePipeline("clear_grid",      &m_clearGridPipeline);
+    makePipeline("assign_cells",    &m_assignCellsPipeline);
+    makePipeline("move_agents",     &m_moveAgentsPipeline);
+    makePipeline("integrate_agents", &m_integrateAgentsPipeline);
+    makePipeline("write_trails",    &m_writeTrailsPipeline);
+    makePipeline("diffuse_texture", &m_diffuseTexturePipeline);
+    makePipeline("render",          &m_renderPipeline);
 
     // Group 1 bind group (agents buffer)
     {
@@ -177,62 +167,99 @@ void BoidsSim::createPipelines() {
         desc.layout = m_group1Layout;
         desc.entryCount = 1;
         desc.entries = &entry;
-        m_group1 = wgpuDeviceCreateBindGroup(m_device, &desc);
+        m_group1 = gpuCreateBindGroup(m_device, &desc, "Boids");
     }
 
-    // Group 2 bind group (grid buffers)
-    {
-        uint32_t totalCells = m_gridW * m_gridH;
-        WGPUBindGroupEntry entries[2] = {};
+    createGroup2();
+}
 
-        entries[0].binding = 0;
-        entries[0].buffer = m_cellCountBuffer;
-        entries[0].size = totalCells * sizeof(uint32_t);
+void BoidsSim::createGroup2() {
+    if (m_group2) gpuRelease(m_group2);
+    uint32_t totalCells = m_gridW * m_gridH;
+    WGPUBindGroupEntry entries[3] = {};
 
-        entries[1].binding = 1;
-        entries[1].buffer = m_cellAgentsBuffer;
-        entries[1].size = (uint64_t)MAX_PER_CELL * totalCells * sizeof(uint32_t);
+    entries[0].binding = 0;
+    entries[0].buffer = m_cellCountBuffer;
+    entries[0].size = totalCells * sizeof(uint32_t);
 
-        WGPUBindGroupDescriptor desc = {};
-        desc.layout = m_group2Layout;
-        desc.entryCount = 2;
-        desc.entries = entries;
-        m_group2 = wgpuDeviceCreateBindGroup(m_device, &desc);
-    }
+    entries[1].binding = 1;
+    entries[1].buffer = m_cellAgentsBuffer;
+    entries[1].size = (uint64_t)MAX_PER_CELL * totalCells * sizeof(uint32_t);
+
+    entries[2].binding = 2;
+    entries[2].buffer = m_claimBuffer;
+    entries[2].size = (uint64_t)params.width * params.height * 4;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout = m_group2Layout;
+    desc.entryCount = 3;
+    desc.entries = entries;
+    m_group2 = gpuCreateBindGroup(m_device, &desc, "Boids");
+}
+
+WGPUBindGroup BoidsSim::buildGroup0(int trail, int output) {
+    return buildGroup0(m_trailTextures.readView(trail), m_trailTextures.writeView(trail),
+                       m_outputTextures.readView(output), m_outputTextures.writeView(output));
 }
 
-WGPUBindGroup BoidsSim::buildGroup0() {
+WGPUBindGroup BoidsSim::buildGroup0(WGPUTextureView trailRead, WGPUTextureView trailWrite,
+                                    WGPUTextureView outRead, WGPUTextureView outWrite) {
+    TRACE_SCOPE("BoidsSim::buildGroup0");
     WGPUBindGroupEntry entries[5] = {};
 
     entries[0].binding = 0;
-    entries[0].buffer = m_uniformBuffer;
+    entries[0].buffer = m_uniforms.buffer();
     entries[0].size = sizeof(GpuParams);
 
     entries[1].binding = 1;
-    entries[1].textureView = m_trailTextures.readView();
+    entries[1].textureView = trailRead;
 
     entries[2].binding = 2;
-    entries[2].textureView = m_trailTextures.writeView();
+    entries[2].textureView = trailWrite;
 
     entries[3].binding = 3;
-    entries[3].textureView = m_outputTextures.readView();
+    entries[3].textureView = outRead;
 
     entries[4].binding = 4;
-    entries[4].textureView = m_outputTextures.writeView();
+    entries[4].textureView = outWrite;
 
     WGPUBindGroupDescriptor desc = {};
     desc.layout = m_group0Layout;
     desc.entryCount = 5;
     desc.entries = entries;
-    return wgpuDeviceCreateBindGroup(m_device, &desc);
+    return gpuCreateBindGroup(m_device, &desc, "Boids");
+}
+
+void BoidsSim::createGroup0s() {
+    releaseGroup0s();
+    if (!m_group0Layout || !m_uniforms.buffer()) return;
+    for (int t = 0; t < 2; t++)
+        for (int o = 0; o < 2; o++)
+            m_group0[t][o] = buildGroup0(t, o);
+}
+
+void BoidsSim::releaseGroup0s() {
+    for (auto& row : m_group0)
+        for (WGPUBindGroup& bg : row)
+            if (bg) { gpuRelease(bg); bg = nullptr; }
 }
 
-void BoidsSim::uploadParams() {
+uint32_t BoidsSim::pushParams(uint32_t scale) {
+    TRACE_SCOPE("BoidsSim::pushParams");
     GpuParams gp = {};
-    gp.rezX = params.width;
-    gp.rezY = params.height;
+    gp.rezX = params.width * scale;
+    gp.rezY = params.height * scale;
     gp.agentsCount = m_agentCount;
     gp.time = m_frameCounter;
+    gp.seedLo = (uint32_t)params.seed;
+    gp.seedHi = (uint32_t)(params.seed >> 32);
+    gp.fade[0] = m_fade[0];
+    gp.fade[1] = m_fade[1];
+    if (scale > 1) {
+        // renderScaled: one render from nothing, at the brightness the fade converges to
+        gp.fade[0] = 0.0f;
+        gp.fade[1] = FADE_FRESH / (1.0f - FADE_KEEP);
+    }
 
     gp.cellSize = m_cellSize;
     gp.gridWf = (float)m_gridW;
@@ -256,16 +283,9 @@ void BoidsSim::uploadParams() {
         gp.saturations[i]         = m_saturation[i];
     }
 
-    float totalWeight = m_typeWeight[0] + m_typeWeight[1] + m_typeWeight[2] + m_typeWeight[3];
-    if (totalWeight < 0.001f) totalWeight = 1.0f;
-    float cumul = 0.0f;
-    for (int i = 0; i < 4; i++) {
-        cumul += m_typeWeight[i] / totalWeight;
-        gp.typeRatios[i] = cumul;
-    }
-    gp.typeRatios[3] = 1.0f;
+    cumulativeTypeRatios(m_typeWeight, gp.typeRatios);
 
-    wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, 0, &gp, sizeof(gp));
+    return m_uniforms.push(&gp);
 }
 
 void BoidsSim::clearTextures() {
@@ -303,25 +323,23 @@ void BoidsSim::clearTextures() {
 }
 
 void BoidsSim::dispatchReset(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("BoidsSim::dispatchReset");
     m_trailTextures.current = 0;
     m_outputTextures.current = 0;
     m_frameCounter = 0;
 
     // Recreate agent buffer if size changed
     uint64_t requiredAgentSize = (uint64_t)m_agentCount * 48;
-    uint64_t currentAgentSize = m_agentBuffer ? wgpuBufferGetSize(m_agentBuffer) : 0;
+    uint64_t currentAgentSize = m_agentBuffer ? m_agentBufferSize : 0;
     bool rebuildGroup1 = (currentAgentSize != requiredAgentSize);
 
     if (rebuildGroup1) {
-        if (m_agentBuffer) { wgpuBufferDestroy(m_agentBuffer); wgpuBufferRelease(m_agentBuffer); }
-
-        WGPUBufferDescriptor desc = {};
-        desc.size = requiredAgentSize;
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "boids_agents";
-        m_agentBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
+        gpuPool().recycle(m_agentBuffer); // pooled buffers may be larger; bind with requiredAgentSize
+        m_agentBufferSize = requiredAgentSize;
+        m_agentBuffer = gpuPool().acquireBuffer(requiredAgentSize, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                "boids_agents", "Boids");
 
-        if (m_group1) wgpuBindGroupRelease(m_group1);
+        if (m_group1) gpuRelease(m_group1);
         WGPUBindGroupEntry entry = {};
         entry.binding = 0;
         entry.buffer = m_agentBuffer;
@@ -330,7 +348,7 @@ void BoidsSim::dispatchReset(WGPUCommandEncoder encoder) {
         bgDesc.layout = m_group1Layout;
         bgDesc.entryCount = 1;
         bgDesc.entries = &entry;
-        m_group1 = wgpuDeviceCreateBindGroup(m_device, &bgDesc);
+        m_group1 = gpuCreateBindGroup(m_device, &bgDesc, "Boids");
     }
 
     // Recalculate grid, recreate if dimensions changed
@@ -343,57 +361,38 @@ void BoidsSim::dispatchReset(WGPUCommandEncoder encoder) {
         m_gridH = newGridH;
         uint32_t totalCells = m_gridW * m_gridH;
 
-        if (m_cellCountBuffer) { wgpuBufferDestroy(m_cellCountBuffer); wgpuBufferRelease(m_cellCountBuffer); }
-        if (m_cellAgentsBuffer) { wgpuBufferDestroy(m_cellAgentsBuffer); wgpuBufferRelease(m_cellAgentsBuffer); }
-
-        {
-            WGPUBufferDescriptor desc = {};
-            desc.size = totalCells * sizeof(uint32_t);
-            desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-            desc.label = "boids_cellCount";
-            m_cellCountBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-        }
-        {
-            WGPUBufferDescriptor desc = {};
-            desc.size = (uint64_t)MAX_PER_CELL * totalCells * sizeof(uint32_t);
-            desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-            desc.label = "boids_cellAgents";
-            m_cellAgentsBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-        }
-
-        if (m_group2) wgpuBindGroupRelease(m_group2);
-        WGPUBindGroupEntry entries[2] = {};
-        entries[0].binding = 0;
-        entries[0].buffer = m_cellCountBuffer;
-        entries[0].size = totalCells * sizeof(uint32_t);
-        entries[1].binding = 1;
-        entries[1].buffer = m_cellAgentsBuffer;
-        entries[1].size = (uint64_t)MAX_PER_CELL * totalCells * sizeof(uint32_t);
-        WGPUBindGroupDescriptor bgDesc = {};
-        bgDesc.layout = m_group2Layout;
-        bgDesc.entryCount = 2;
-        bgDesc.entries = entries;
-        m_group2 = wgpuDeviceCreateBindGroup(m_device, &bgDesc);
+        gpuPool().recycle(m_cellCountBuffer);
+        gpuPool().recycle(m_cellAgentsBuffer);
+        m_cellCountBuffer = gpuPool().acquireBuffer(totalCells * sizeof(uint32_t),
+                                                    WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                    "boids_cellCount", "Boids");
+        m_cellAgentsBuffer = gpuPool().acquireBuffer((uint64_t)MAX_PER_CELL * totalCells * sizeof(uint32_t),
+                                                     WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                     "boids_cellAgents", "Boids");
+        createGroup2();
     }
 
     clearTextures();
-    uploadParams();
+    // Pooled, so it may hold anything; from here on every step leaves it zeroed
+    wgpuCommandEncoderClearBuffer(encoder, m_claimBuffer, 0, (uint64_t)params.width * params.height * 4);
+    uint32_t offset = pushParams();
+    m_uniforms.upload();
 
-    WGPUBindGroup bg0 = buildGroup0();
+    WGPUBindGroup bg0 = group0();
 
-    WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, "Boids/reset_agents");
     wgpuComputePassEncoderSetPipeline(pass, m_resetAgentsPipeline);
-    wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 1, &offset);
     wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
     wgpuComputePassEncoderSetBindGroup(pass, 2, m_group2, 0, nullptr);
     wgpuComputePassEncoderDispatchWorkgroups(pass, (m_agentCount + 255) / 256, 1, 1);
     wgpuComputePassEncoderEnd(pass);
     wgpuComputePassEncoderRelease(pass);
-
-    wgpuBindGroupRelease(bg0);
 }
 
 void BoidsSim::step(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("BoidsSim::step");
+    m_pipelines.wait(); // no-op once compiled; callers that can't block check ready() first
     if (m_needsReset) {
         m_needsReset = false;
         dispatchReset(encoder);
@@ -409,108 +408,51 @@ void BoidsSim::step(WGPUCommandEncoder encoder) {
     uint32_t totalCells = m_gridW * m_gridH;
     uint32_t wgGrid = (totalCells + 255) / 256;
 
+    ProfiledCpuScope cpuTime("Boids/encode");
+    if (m_uniforms.reserve((uint32_t)m_stepsPerFrame)) createGroup0s();
+    // Temporal fade of one render, or of all substeps folded into one
+    substepFade(FADE_KEEP, FADE_FRESH, m_renderEverySubstep ? 1 : m_stepsPerFrame, m_fade);
+    // No texture copies between kernels, so every substep shares one pass
+    ComputeBatch batch(encoder, "Boids/step");
+    batch.setBindGroup(1, m_group1);
+    batch.setBindGroup(2, m_group2);
     for (int s = 0; s < m_stepsPerFrame; s++) {
         m_frameCounter++;
-        uploadParams();
+        uint32_t offset = pushParams();
 
-        WGPUBindGroup bg0 = buildGroup0();
+        batch.setBindGroup(0, group0(), 1, &offset);
 
         // 1. Clear grid
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_clearGridPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 2, m_group2, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgGrid, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        batch.dispatch("Boids/clear_grid", m_clearGridPipeline, wgGrid);
 
         // 2. Assign cells
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_assignCellsPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 2, m_group2, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgAgent, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        batch.dispatch("Boids/assign_cells", m_assignCellsPipeline, wgAgent);
 
-        // 3. Move agents (reads trailRead for food sensing)
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_moveAgentsPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 2, m_group2, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgAgent, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 3. Move agents: steering forces from the neighbours (and trailRead for food),
+        // then velocity + position once every agent has read its neighbours
+        batch.dispatch("Boids/move_agents", m_moveAgentsPipeline, wgAgent);
+        batch.dispatch("Boids/integrate_agents", m_integrateAgentsPipeline, wgAgent);
 
         // 4. Diffuse texture (trailRead -> trailWrite)
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_diffuseTexturePipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 2, m_group2, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgTex, hgTex, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
-
-        // 5. Copy trailWrite -> trailRead
-        {
-            WGPUImageCopyTexture src = {};
-            src.texture = m_trailTextures.current == 0 ? m_trailTextures.texB : m_trailTextures.texA;
-            WGPUImageCopyTexture dst = {};
-            dst.texture = m_trailTextures.current == 0 ? m_trailTextures.texA : m_trailTextures.texB;
-            WGPUExtent3D size = { params.width, params.height, 1 };
-            wgpuCommandEncoderCopyTextureToTexture(encoder, &src, &dst, &size);
-        }
+        batch.dispatch("Boids/diffuse_texture", m_diffuseTexturePipeline, wgTex, hgTex);
 
-        wgpuBindGroupRelease(bg0);
-
-        // 6. Write trails (deposit/eat on diffused data)
-        bg0 = buildGroup0();
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_writeTrailsPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 2, m_group2, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgAgent, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 5. Write trails (deposit/eat on the diffused value, recomputed from
+        // trailRead); same ping-pong state
+        batch.dispatch("Boids/write_trails", m_writeTrailsPipeline, wgAgent);
 
-        // 7. Swap trail ping-pong
+        // 6. Swap trail ping-pong
         m_trailTextures.swap();
 
-        wgpuBindGroupRelease(bg0);
-
-        // 8. Render (trail -> output)
-        bg0 = buildGroup0();
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_renderPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 2, m_group2, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgTex, hgTex, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 7. Render (trail -> output); by default only the displayed last substep
+        if (!m_renderEverySubstep && s + 1 < m_stepsPerFrame) continue;
+        batch.setBindGroup(0, group0(), 1, &offset);
+        batch.dispatch("Boids/render", m_renderPipeline, wgTex, hgTex);
 
-        // 9. Swap output ping-pong
+        // 8. Swap output ping-pong
         m_outputTextures.swap();
-
-        wgpuBindGroupRelease(bg0);
     }
+    batch.end();
+    m_uniforms.upload(); // every substep's params in one write
 }
 
 void BoidsSim::reset() {
@@ -525,6 +467,107 @@ WGPUTexture BoidsSim::getOutputTexture() {
     return m_outputTextures.current == 0 ? m_outputTextures.texA : m_outputTextures.texB;
 }
 
+void BoidsSim::renderScaled(WGPUCommandEncoder encoder, uint32_t scale, WGPUTextureView field,
+                            WGPUTextureView output) {
+    TRACE_SCOPE("BoidsSim::renderScaled");
+    m_pipelines.wait();
+    m_scaledTrail.encode(encoder, stateViews(), m_trailTextures.readView(), scale, field);
+
+    if (m_uniforms.reserve(1)) createGroup0s();
+    uint32_t offset = pushParams(scale);
+    m_uniforms.upload();
+
+    // Colorize the field; the idle trail half fills the unused trailWrite binding
+    int t = m_trailTextures.current, o = m_outputTextures.current;
+    WGPUBindGroup bg = buildGroup0(field, m_trailTextures.writeView(t), m_outputTextures.readView(o), output);
+
+    ComputeBatch batch(encoder, "Boids/export");
+    batch.setBindGroup(1, m_group1);
+    batch.setBindGroup(2, m_group2); // unused, but part of the shared layout
+    batch.setBindGroup(0, bg, 1, &offset);
+    batch.dispatch("Boids/render", m_renderPipeline, (params.width * scale + 7) / 8,
+                   (params.height * scale + 7) / 8);
+    batch.end();
+    gpuRelease(bg);
+}
+
+SimStateViews BoidsSim::stateViews() {
+    SimStateViews v;
+    v.agents = m_agentBuffer;
+    v.agentBytes = (uint64_t)m_agentCount * 48;
+    v.agentStride = 48;
+    v.velocityOffset = 8;
+    v.typeOffset = 24;
+    v.textures[0] = m_trailTextures.readView();
+    v.textures[1] = m_outputTextures.readView();
+    v.textureNames[0] = "trail";
+    v.textureNames[1] = "output";
+    v.textureCount = 2;
+    v.width = params.width;
+    v.height = params.height;
+    v.step = m_frameCounter;
+    return v;
+}
+
+PresetData BoidsSim::capturePreset() const {
+    PresetData data;
+    data["agentCount"] = {(float)m_agentCount};
+    data["cellSize"] = {m_cellSize};
+    data["linkTypes"] = {m_linkTypes ? 1.0f : 0.0f};
+    data["maxSpeed"]          = {m_maxSpeed[0], m_maxSpeed[1], m_maxSpeed[2], m_maxSpeed[3]};
+    data["maxForce"]          = {m_maxForce[0], m_maxForce[1], m_maxForce[2], m_maxForce[3]};
+    data["typeSeparateRange"] = {m_typeSeparateRange[0], m_typeSeparateRange[1], m_typeSeparateRange[2], m_typeSeparateRange[3]};
+    data["globalSeparateRange"]= {m_globalSeparateRange[0], m_globalSeparateRange[1], m_globalSeparateRange[2], m_globalSeparateRange[3]};
+    data["alignRange"]        = {m_alignRange[0], m_alignRange[1], m_alignRange[2], m_alignRange[3]};
+    data["attractRange"]      = {m_attractRange[0], m_attractRange[1], m_attractRange[2], m_attractRange[3]};
+    data["foodSensorDist"]    = {m_foodSensorDist[0], m_foodSensorDist[1], m_foodSensorDist[2], m_foodSensorDist[3]};
+    data["sensorAngle"]       = {m_sensorAngle[0], m_sensorAngle[1], m_sensorAngle[2], m_sensorAngle[3]};
+    data["foodStrength"]      = {m_foodStrength[0], m_foodStrength[1], m_foodStrength[2], m_foodStrength[3]};
+    data["deposit"]           = {m_deposit[0], m_deposit[1], m_deposit[2], m_deposit[3]};
+    data["eat"]               = {m_eat[0], m_eat[1], m_eat[2], m_eat[3]};
+    data["diffuseRate"]       = {m_diffuseRate[0], m_diffuseRate[1], m_diffuseRate[2], m_diffuseRate[3]};
+    data["hue"]               = {m_hue[0], m_hue[1], m_hue[2], m_hue[3]};
+    data["saturation"]        = {m_saturation[0], m_saturation[1], m_saturation[2], m_saturation[3]};
+    data["typeWeight"]        = {m_typeWeight[0], m_typeWeight[1], m_typeWeight[2], m_typeWeight[3]};
+    data["stepsPerFrame"] = {(float)m_stepsPerFrame};
+    data["renderEverySubstep"] = {m_renderEverySubstep ? 1.0f : 0.0f};
+    return data;
+}
+
+void BoidsSim::applyPreset(const PresetData& data) {
+    auto load4 = [&](const char* key, float* dst) { presetGet(data, key, dst, 4); };
+    float v = 0.0f;
+    if (presetGet(data, "agentCount", &v, 1)) {
+        m_agentCount = (uint32_t)v;
+        m_needsReset = true;
+    }
+    if (presetGet(data, "cellSize", &v, 1)) {
+        m_cellSize = v;
+        m_needsReset = true;
+    }
+    if (presetGet(data, "linkTypes", &v, 1))
+        m_linkTypes = v > 0.5f;
+    load4("maxSpeed", m_maxSpeed);
+    load4("maxForce", m_maxForce);
+    load4("typeSeparateRange", m_typeSeparateRange);
+    load4("globalSeparateRange", m_globalSeparateRange);
+    load4("alignRange", m_alignRange);
+    load4("attractRange", m_attractRange);
+    load4("foodSensorDist", m_foodSensorDist);
+    load4("sensorAngle", m_sensorAngle);
+    load4("foodStrength", m_foodStrength);
+    load4("deposit", m_deposit);
+    load4("eat", m_eat);
+    load4("diffuseRate", m_diffuseRate);
+    load4("hue", m_hue);
+    load4("saturation", m_saturation);
+    load4("typeWeight", m_typeWeight);
+    if (presetGet(data, "stepsPerFrame", &v, 1))
+        m_stepsPerFrame = (int)v;
+    if (presetGet(data, "renderEverySubstep", &v, 1))
+        m_renderEverySubstep = v > 0.5f;
+}
+
 void BoidsSim::onGui() {
     ImGui::Text("Boids");
     ImGui::Separator();
@@ -543,6 +586,9 @@ void BoidsSim::onGui() {
     }
 
     ImGui::SliderInt("Steps/Frame", &m_stepsPerFrame, 0, 20);
+    ImGui::Checkbox("Render Every Substep", &m_renderEverySubstep);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Colorize after every substep instead of once per frame (same fade rate)");
 
     {
         int ac = (int)m_agentCount;
@@ -605,61 +651,12 @@ void BoidsSim::onGui() {
     ImGui::InputText("Preset Name", presetName, sizeof(presetName));
 
     if (ImGui::Button("Save Preset")) {
-        std::map<std::string, std::vector<float>> data;
-        data["agentCount"] = {(float)m_agentCount};
-        data["cellSize"] = {m_cellSize};
-        data["linkTypes"] = {m_linkTypes ? 1.0f : 0.0f};
-        data["maxSpeed"]          = {m_maxSpeed[0], m_maxSpeed[1], m_maxSpeed[2], m_maxSpeed[3]};
-        data["maxForce"]          = {m_maxForce[0], m_maxForce[1], m_maxForce[2], m_maxForce[3]};
-        data["typeSeparateRange"] = {m_typeSeparateRange[0], m_typeSeparateRange[1], m_typeSeparateRange[2], m_typeSeparateRange[3]};
-        data["globalSeparateRange"]= {m_globalSeparateRange[0], m_globalSeparateRange[1], m_globalSeparateRange[2], m_globalSeparateRange[3]};
-        data["alignRange"]        = {m_alignRange[0], m_alignRange[1], m_alignRange[2], m_alignRange[3]};
-        data["attractRange"]      = {m_attractRange[0], m_attractRange[1], m_attractRange[2], m_attractRange[3]};
-        data["foodSensorDist"]    = {m_foodSensorDist[0], m_foodSensorDist[1], m_foodSensorDist[2], m_foodSensorDist[3]};
-        data["sensorAngle"]       = {m_sensorAngle[0], m_sensorAngle[1], m_sensorAngle[2], m_sensorAngle[3]};
-        data["foodStrength"]      = {m_foodStrength[0], m_foodStrength[1], m_foodStrength[2], m_foodStrength[3]};
-        data["deposit"]           = {m_deposit[0], m_deposit[1], m_deposit[2], m_deposit[3]};
-        data["eat"]               = {m_eat[0], m_eat[1], m_eat[2], m_eat[3]};
-        data["diffuseRate"]       = {m_diffuseRate[0], m_diffuseRate[1], m_diffuseRate[2], m_diffuseRate[3]};
-        data["hue"]               = {m_hue[0], m_hue[1], m_hue[2], m_hue[3]};
-        data["saturation"]        = {m_saturation[0], m_saturation[1], m_saturation[2], m_saturation[3]};
-        data["typeWeight"]        = {m_typeWeight[0], m_typeWeight[1], m_typeWeight[2], m_typeWeight[3]};
-        savePreset(std::string("boids_") + presetName, data);
+        savePreset(std::string("boids_") + presetName, capturePreset());
     }
     ImGui::SameLine();
     if (ImGui::Button("Load Preset")) {
         auto data = loadPreset(std::string("boids_") + presetName);
-        if (!data.empty()) {
-            auto load4 = [&](const char* key, float* dst) {
-                auto it = data.find(key);
-                if (it != data.end()) for (size_t i = 0; i < 4 && i < it->second.size(); i++) dst[i] = it->second[i];
-            };
-            if (data.count("agentCount") && !data["agentCount"].empty()) {
-                m_agentCount = (uint32_t)data["agentCount"][0];
-                m_needsReset = true;
-            }
-            if (data.count("cellSize") && !data["cellSize"].empty()) {
-                m_cellSize = data["cellSize"][0];
-                m_needsReset = true;
-            }
-            if (data.count("linkTypes") && !data["linkTypes"].empty())
-                m_linkTypes = data["linkTypes"][0] > 0.5f;
-            load4("maxSpeed", m_maxSpeed);
-            load4("maxForce", m_maxForce);
-            load4("typeSeparateRange", m_typeSeparateRange);
-            load4("globalSeparateRange", m_globalSeparateRange);
-            load4("alignRange", m_alignRange);
-            load4("attractRange", m_attractRange);
-            load4("foodSensorDist", m_foodSensorDist);
-            load4("sensorAngle", m_sensorAngle);
-            load4("foodStrength", m_foodStrength);
-            load4("deposit", m_deposit);
-            load4("eat", m_eat);
-            load4("diffuseRate", m_diffuseRate);
-            load4("hue", m_hue);
-            load4("saturation", m_saturation);
-            load4("typeWeight", m_typeWeight);
-        }
+        if (!data.empty()) applyPreset(data);
     }
 
     ImGui::Checkbox("Link All Types", &m_linkTypes);
@@ -748,27 +745,31 @@ void BoidsSim::onGui() {
 }
 
 void BoidsSim::shutdown() {
-    if (m_group1) wgpuBindGroupRelease(m_group1);
-    if (m_group2) wgpuBindGroupRelease(m_group2);
-    if (m_group0Layout) wgpuBindGroupLayoutRelease(m_group0Layout);
-    if (m_group1Layout) wgpuBindGroupLayoutRelease(m_group1Layout);
-    if (m_group2Layout) wgpuBindGroupLayoutRelease(m_group2Layout);
+    m_pipelines.wait(); // jobs still use the module and layout
+    releaseGroup0s();
+    if (m_group1) gpuRelease(m_group1);
+    if (m_group2) gpuRelease(m_group2);
+    if (m_group0Layout) gpuRelease(m_group0Layout);
+    if (m_group1Layout) gpuRelease(m_group1Layout);
+    if (m_group2Layout) gpuRelease(m_group2Layout);
     if (m_pipelineLayout) wgpuPipelineLayoutRelease(m_pipelineLayout);
 
-    if (m_resetTexturePipeline)   wgpuComputePipelineRelease(m_resetTexturePipeline);
-    if (m_resetAgentsPipeline)    wgpuComputePipelineRelease(m_resetAgentsPipeline);
-    if (m_clearGridPipeline)      wgpuComputePipelineRelease(m_clearGridPipeline);
-    if (m_assignCellsPipeline)    wgpuComputePipelineRelease(m_assignCellsPipeline);
-    if (m_moveAgentsPipeline)     wgpuComputePipelineRelease(m_moveAgentsPipeline);
-    if (m_writeTrailsPipeline)    wgpuComputePipelineRelease(m_writeTrailsPipeline);
-    if (m_diffuseTexturePipeline) wgpuComputePipelineRelease(m_diffuseTexturePipeline);
-    if (m_renderPipeline)         wgpuComputePipelineRelease(m_renderPipeline);
-
-    if (m_shaderModule) wgpuShaderModuleRelease(m_shaderModule);
-    if (m_agentBuffer) { wgpuBufferDestroy(m_agentBuffer); wgpuBufferRelease(m_agentBuffer); }
-    if (m_uniformBuffer) { wgpuBufferDestroy(m_uniformBuffer); wgpuBufferRelease(m_uniformBuffer); }
-    if (m_cellCountBuffer) { wgpuBufferDestroy(m_cellCountBuffer); wgpuBufferRelease(m_cellCountBuffer); }
-    if (m_cellAgentsBuffer) { wgpuBufferDestroy(m_cellAgentsBuffer); wgpuBufferRelease(m_cellAgentsBuffer); }
+    if (m_resetTexturePipeline)   gpuRelease(m_resetTexturePipeline);
+    if (m_resetAgentsPipeline)    gpuRelease(m_resetAgentsPipeline);
+    if (m_clearGridPipeline)      gpuRelease(m_clearGridPipeline);
+    if (m_assignCellsPipeline)    gpuRelease(m_assignCellsPipeline);
+    if (m_moveAgentsPipeline)     gpuRelease(m_moveAgentsPipeline);
+    if (m_integrateAgentsPipeline) gpuRelease(m_integrateAgentsPipeline);
+    if (m_writeTrailsPipeline)    gpuRelease(m_writeTrailsPipeline);
+    if (m_diffuseTexturePipeline) gpuRelease(m_diffuseTexturePipeline);
+    if (m_renderPipeline)         gpuRelease(m_renderPipeline);
+
+    m_scaledTrail.shutdown();
+    gpuPool().recycle(m_agentBuffer);
+    m_uniforms.destroy();
+    gpuPool().recycle(m_cellCountBuffer);
+    gpuPool().recycle(m_cellAgentsBuffer);
+    gpuPool().recycle(m_claimBuffer);
 
     m_trailTextures.destroy();
     m_outputTextures.destroy();
@@ -778,9 +779,8 @@ void BoidsSim::shutdown() {
     m_pipelineLayout = nullptr;
     m_resetTexturePipeline = m_resetAgentsPipeline = nullptr;
     m_clearGridPipeline = m_assignCellsPipeline = nullptr;
-    m_moveAgentsPipeline = m_writeTrailsPipeline = nullptr;
+    m_moveAgentsPipeline = m_integrateAgentsPipeline = m_writeTrailsPipeline = nullptr;
     m_diffuseTexturePipeline = m_renderPipeline = nullptr;
-    m_shaderModule = nullptr;
-    m_agentBuffer = m_uniformBuffer = nullptr;
-    m_cellCountBuffer = m_cellAgentsBuffer = nullptr;
+    m_agentBuffer = nullptr;
+    m_cellCountBuffer = m_cellAgentsBuffer = m_claimBuffer = nullptr;
 }
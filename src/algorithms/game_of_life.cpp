@@ -1,8 +1,10 @@
 #include "game_of_life.h"
+#include "gpu_tracker.h"
+#include "gpu_profiler.h"
+#include "cpu_trace.h"
 #include <imgui.h>
-#include <cstdlib>
-#include <ctime>
 #include <cstring>
+#include <random>
 
 void GameOfLife::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h) {
     m_device = device;
@@ -10,33 +12,38 @@ void GameOfLife::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h
     params.width = w;
     params.height = h;
 
-    m_textures.init(device, w, h);
+    m_textures.init(w, h, WGPUTextureFormat_RGBA8Unorm, "Game of Life");
 
     // Bind group layout: texture_2d (read) + storage texture (write)
-    m_bindGroupLayout = createPingPongBindGroupLayout(device, false);
+    m_bindGroupLayout = createPingPongBindGroupLayout(device, false, "Game of Life");
 
     // Pipeline
-    m_pipeline = createComputePipeline(device, "shaders/game_of_life.wgsl", "main", m_bindGroupLayout);
+    compileComputePipeline(device, "shaders/game_of_life.wgsl", "main", m_bindGroupLayout, m_pipelines, &m_pipeline,
+                           "Game of Life");
 
     rebuildBindGroups();
     seedRandom();
 }
 
 void GameOfLife::rebuildBindGroups() {
-    if (m_bindGroupA) wgpuBindGroupRelease(m_bindGroupA);
-    if (m_bindGroupB) wgpuBindGroupRelease(m_bindGroupB);
+    if (m_bindGroupA) gpuRelease(m_bindGroupA);
+    if (m_bindGroupB) gpuRelease(m_bindGroupB);
     m_bindGroupA = createPingPongBindGroup(m_device, m_bindGroupLayout,
-        m_textures.viewA, m_textures.viewB);
+        m_textures.viewA, m_textures.viewB, nullptr, 0, "Game of Life");
     m_bindGroupB = createPingPongBindGroup(m_device, m_bindGroupLayout,
-        m_textures.viewB, m_textures.viewA);
+        m_textures.viewB, m_textures.viewA, nullptr, 0, "Game of Life");
 }
 
 void GameOfLife::seedRandom() {
-    srand((unsigned)time(nullptr));
+    TRACE_SCOPE("GameOfLife::seedRandom");
+    // mt19937_64 output is fully specified, the <random> distributions are
+    // not: take the top 24 bits directly so every build seeds the same board
+    std::mt19937_64 rng(params.seed);
     uint32_t w = params.width, h = params.height;
     m_cpuState.resize(w * h * 4);
+    m_generation = 0;
     for (uint32_t i = 0; i < w * h; i++) {
-        uint8_t alive = ((float)rand() / RAND_MAX) < m_fillDensity ? 255 : 0;
+        uint8_t alive = (float)(rng() >> 40) * 0x1p-24f < m_fillDensity ? 255 : 0;
         m_cpuState[i * 4 + 0] = alive;
         m_cpuState[i * 4 + 1] = alive;
         m_cpuState[i * 4 + 2] = alive;
@@ -71,22 +78,20 @@ void GameOfLife::uploadState() {
 }
 
 void GameOfLife::step(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("GameOfLife::step");
+    m_pipelines.wait(); // no-op once compiled; callers that can't block check ready() first
     if (params.paused) return;
 
+    ProfiledCpuScope cpuTime("Game of Life/encode");
+    uint32_t wgX = (params.width + 7) / 8;
+    uint32_t wgY = (params.height + 7) / 8;
+    ComputeBatch batch(encoder, "Game of Life/steps"); // no copies: every generation in one pass
     for (int i = 0; i < m_stepsPerFrame; i++) {
-        WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-        wgpuComputePassEncoderSetPipeline(pass, m_pipeline);
-
-        WGPUBindGroup bg = m_textures.current == 0 ? m_bindGroupA : m_bindGroupB;
-        wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
-
-        uint32_t wgX = (params.width + 7) / 8;
-        uint32_t wgY = (params.height + 7) / 8;
-        wgpuComputePassEncoderDispatchWorkgroups(pass, wgX, wgY, 1);
-        wgpuComputePassEncoderEnd(pass);
-        wgpuComputePassEncoderRelease(pass);
+        batch.setBindGroup(0, m_textures.current == 0 ? m_bindGroupA : m_bindGroupB);
+        batch.dispatch("Game of Life/step", m_pipeline, wgX, wgY);
 
         m_textures.swap();
+        m_generation++;
     }
 }
 
@@ -103,6 +108,31 @@ WGPUTexture GameOfLife::getOutputTexture() {
     return m_textures.current == 0 ? m_textures.texA : m_textures.texB;
 }
 
+SimStateViews GameOfLife::stateViews() {
+    SimStateViews v;
+    v.textures[0] = m_textures.readView();
+    v.textureNames[0] = "cells";
+    v.textureCount = 1;
+    v.width = params.width;
+    v.height = params.height;
+    v.step = m_generation;
+    return v;
+}
+
+PresetData GameOfLife::capturePreset() const {
+    PresetData data;
+    data["fillDensity"] = {m_fillDensity};
+    data["stepsPerFrame"] = {(float)m_stepsPerFrame};
+    return data;
+}
+
+void GameOfLife::applyPreset(const PresetData& data) {
+    float v = 0.0f;
+    presetGet(data, "fillDensity", &m_fillDensity, 1);
+    if (presetGet(data, "stepsPerFrame", &v, 1))
+        m_stepsPerFrame = (int)v;
+}
+
 void GameOfLife::onGui() {
     ImGui::Text("Game of Life");
     ImGui::Separator();
@@ -136,14 +166,16 @@ void GameOfLife::onGui() {
         seedGlider(30, 30);
         seedGlider(50, 20);
         uploadState();
+        m_generation = 0;
     }
 }
 
 void GameOfLife::shutdown() {
-    if (m_bindGroupA) wgpuBindGroupRelease(m_bindGroupA);
-    if (m_bindGroupB) wgpuBindGroupRelease(m_bindGroupB);
-    if (m_bindGroupLayout) wgpuBindGroupLayoutRelease(m_bindGroupLayout);
-    if (m_pipeline) wgpuComputePipelineRelease(m_pipeline);
+    m_pipelines.wait();
+    if (m_bindGroupA) gpuRelease(m_bindGroupA);
+    if (m_bindGroupB) gpuRelease(m_bindGroupB);
+    if (m_bindGroupLayout) gpuRelease(m_bindGroupLayout);
+    if (m_pipeline) gpuRelease(m_pipeline);
     m_textures.destroy();
 
     m_bindGroupA = m_bindGroupB = nullptr;
@@ -13,7 +13,11 @@ public:
     WGPUTextureView getOutputView() override;
     WGPUTexture getOutputTexture() override;
     void onGui() override;
+    void applyPreset(const PresetData& data) override;
+    PresetData capturePreset() const override;
+    SimStateViews stateViews() override;
     void shutdown() override;
+    bool ready() override { return m_pipelines.ready(); }
 
 private:
     void seedRandom();
@@ -25,6 +29,7 @@ private:
     WGPUQueue m_queue = nullptr;
     PingPongTextures m_textures;
     WGPUComputePipeline m_pipeline = nullptr;
+    PipelineBatch m_pipelines;
     WGPUBindGroupLayout m_bindGroupLayout = nullptr;
     WGPUBindGroup m_bindGroupA = nullptr; // read A, write B
     WGPUBindGroup m_bindGroupB = nullptr; // read B, write A
@@ -34,4 +39,5 @@ private:
 
     float m_fillDensity = 0.3f;
     int m_stepsPerFrame = 1;
+    uint64_t m_generation = 0; // steps since the last reseed
 };
@@ -1,4 +1,8 @@
 #include "physarum.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "../gpu_profiler.h"
+#include "../cpu_trace.h"
 #include "../preset.h"
 #include <imgui.h>
 #include <cmath>
@@ -7,6 +11,7 @@
 #include <random>
 
 static constexpr float DEG2RAD = 3.14159265359f / 180.0f;
+static constexpr float FADE_KEEP = 0.65f, FADE_FRESH = 0.35f; // render: out * keep + fresh * fresh
 
 void PhysarumSim::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h) {
     m_device = device;
@@ -14,45 +19,32 @@ void PhysarumSim::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t
     params.width = w;
     params.height = h;
 
-    m_trailTextures.init(device, w, h, WGPUTextureFormat_RGBA16Float);
-    m_outputTextures.init(device, w, h, WGPUTextureFormat_RGBA8Unorm);
+    m_trailTextures.init(w, h, WGPUTextureFormat_RGBA16Float, "Physarum");
+    m_outputTextures.init(w, h, WGPUTextureFormat_RGBA8Unorm, "Physarum");
 
     createBuffers();
     createPipelines();
+    createGroup0s();
+    m_scaledTrail.init(device, queue);
     m_needsReset = true;
 }
 
 void PhysarumSim::createBuffers() {
     // Agent buffer: 16 bytes per agent (vec2f position + vec2f direction)
     {
-        WGPUBufferDescriptor desc = {};
-        desc.size = (uint64_t)m_agentCount * 16;
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "physarum_agents";
-        m_agentBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-    }
-    // Uniform buffer: 160 bytes
-    {
-        WGPUBufferDescriptor desc = {};
-        desc.size = sizeof(GpuParams);
-        desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-        desc.label = "physarum_params";
-        m_uniformBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
+        m_agentBufferSize = (uint64_t)m_agentCount * 16;
+        m_agentBuffer = gpuPool().acquireBuffer(m_agentBufferSize, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                "physarum_agents", "Physarum");
     }
+    // Deposit claims: zeroed on reset, and again by each pixel's winner every step
+    m_claimBuffer = gpuPool().acquireBuffer((uint64_t)params.width * params.height * 4,
+                                            WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                            "physarum_claims", "Physarum");
+    // Uniform ring: one GpuParams block per substep (Steps/Frame slider max, grows on demand)
+    m_uniforms.init(m_device, m_queue, sizeof(GpuParams), 20, "Physarum");
 }
 
 void PhysarumSim::createPipelines() {
-    // Load shader
-    std::string code = loadShaderFile("shaders/physarum.wgsl");
-    if (code.empty()) return;
-
-    WGPUShaderModuleWGSLDescriptor wgslDesc = {};
-    wgslDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
-    wgslDesc.code = code.c_str();
-    WGPUShaderModuleDescriptor smDesc = {};
-    smDesc.nextInChain = &wgslDesc.chain;
-    m_shaderModule = wgpuDeviceCreateShaderModule(m_device, &smDesc);
-
     // Group 0 layout: uniform, trailRead, trailWrite, outRead, outWrite
     {
         WGPUBindGroupLayoutEntry entries[5] = {};
@@ -61,6 +53,7 @@ void PhysarumSim::createPipelines() {
         entries[0].binding = 0;
         entries[0].visibility = WGPUShaderStage_Compute;
         entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+        entries[0].buffer.hasDynamicOffset = true;
         entries[0].buffer.minBindingSize = sizeof(GpuParams);
 
         // b1: trailRead (texture_2d<f32>)
@@ -92,21 +85,26 @@ void PhysarumSim::createPipelines() {
         WGPUBindGroupLayoutDescriptor desc = {};
         desc.entryCount = 5;
         desc.entries = entries;
-        m_group0Layout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        m_group0Layout = gpuCreateBindGroupLayout(m_device, &desc, "Physarum");
     }
 
-    // Group 1 layout: agents storage buffer
+    // Group 1 layout: agents + deposit claims storage buffers
     {
-        WGPUBindGroupLayoutEntry entry = {};
-        entry.binding = 0;
-        entry.visibility = WGPUShaderStage_Compute;
-        entry.buffer.type = WGPUBufferBindingType_Storage;
-        entry.buffer.minBindingSize = 16; // at least 1 agent
+        WGPUBindGroupLayoutEntry entries[2] = {};
+        entries[0].binding = 0;
+        entries[0].visibility = WGPUShaderStage_Compute;
+        entries[0].buffer.type = WGPUBufferBindingType_Storage;
+        entries[0].buffer.minBindingSize = 16; // at least 1 agent
+
+        entries[1].binding = 1;
+        entries[1].visibility = WGPUShaderStage_Compute;
+        entries[1].buffer.type = WGPUBufferBindingType_Storage;
+        entries[1].buffer.minBindingSize = 4;
 
         WGPUBindGroupLayoutDescriptor desc = {};
-        desc.entryCount = 1;
-        desc.entries = &entry;
-        m_group1Layout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        desc.entryCount = 2;
+        desc.entries = entries;
+        m_group1Layout = gpuCreateBindGroupLayout(m_device, &desc, "Physarum");
     }
 
     // Pipeline layout with 2 bind groups
@@ -118,69 +116,102 @@ void PhysarumSim::createPipelines() {
         m_pipelineLayout = wgpuDeviceCreatePipelineLayout(m_device, &desc);
     }
 
-    // Create all 6 pipelines sharing shader module and layout
-    auto makePipeline = [&](const char* entry) -> WGPUComputePipeline {
-        WGPUComputePipelineDescriptor desc = {};
-        desc.layout = m_pipelineLayout;
-        desc.compute.module = m_shaderModule;
-        desc.compute.entryPoint = entry;
-        return wgpuDeviceCreateComputePipeline(m_device, &desc);
+    // Create all 6 pipelines sharing shader module and layout, compiled on the worker threads
+    auto shader = m_pipelines.shader("shaders/physarum.wgsl");
+    auto makePipeline = [&](const char* entry, WGPUComputePipeline* out) {
+        m_pipelines.add(m_device, shader, entry, m_pipelineLayout, out, "Physarum");
     };
 
-    m_resetTexturePipeline  = makePipeline("reset_texture");
-    m_resetAgentsPipeline   = makePipeline("reset_agents");
-    m_moveAgentsPipeline    = makePipeline("move_agents");
-    m_writeTrailsPipeline   = makePipeline("write_trails");
-    m_diffuseTexturePipeline = makePipeline("diffuse_texture");
-    m_renderPipeline        = makePipeline("render");
+    makePipeline("reset_texture",   &m_resetTexturePipeline);
+    makePipeline("reset_agents",    &m_resetAgentsPipeline);
+    makePipeline("move_agents",     &m_moveAgentsPipeline);
+    makePipeline("write_trails",    &m_writeTrailsPipeline);
+    makePipeline("diffuse_texture", &m_diffuseTexturePipeline);
+    makePipeline("render",          &m_renderPipeline);
 
-    // Group 1 bind group (agents buffer — doesn't change unless agent count changes)
-    {
-        WGPUBindGroupEntry entry = {};
-        entry.binding = 0;
-        entry.buffer = m_agentBuffer;
-        entry.size = (uint64_t)m_agentCount * 16;
-
-        WGPUBindGroupDescriptor desc = {};
-        desc.layout = m_group1Layout;
-        desc.entryCount = 1;
-        desc.entries = &entry;
-        m_group1 = wgpuDeviceCreateBindGroup(m_device, &desc);
-    }
+    createGroup1();
 }
 
-WGPUBindGroup PhysarumSim::buildGroup0() {
+void PhysarumSim::createGroup1() {
+    if (m_group1) gpuRelease(m_group1);
+    WGPUBindGroupEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].buffer = m_agentBuffer;
+    entries[0].size = m_agentBufferSize;
+    entries[1].binding = 1;
+    entries[1].buffer = m_claimBuffer;
+    entries[1].size = (uint64_t)params.width * params.height * 4;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout = m_group1Layout;
+    desc.entryCount = 2;
+    desc.entries = entries;
+    m_group1 = gpuCreateBindGroup(m_device, &desc, "Physarum");
+}
+
+WGPUBindGroup PhysarumSim::buildGroup0(int trail, int output) {
+    return buildGroup0(m_trailTextures.readView(trail), m_trailTextures.writeView(trail),
+                       m_outputTextures.readView(output), m_outputTextures.writeView(output));
+}
+
+WGPUBindGroup PhysarumSim::buildGroup0(WGPUTextureView trailRead, WGPUTextureView trailWrite,
+                                       WGPUTextureView outRead, WGPUTextureView outWrite) {
+    TRACE_SCOPE("PhysarumSim::buildGroup0");
     WGPUBindGroupEntry entries[5] = {};
 
     entries[0].binding = 0;
-    entries[0].buffer = m_uniformBuffer;
+    entries[0].buffer = m_uniforms.buffer();
     entries[0].size = sizeof(GpuParams);
 
     entries[1].binding = 1;
-    entries[1].textureView = m_trailTextures.readView();
+    entries[1].textureView = trailRead;
 
     entries[2].binding = 2;
-    entries[2].textureView = m_trailTextures.writeView();
+    entries[2].textureView = trailWrite;
 
     entries[3].binding = 3;
-    entries[3].textureView = m_outputTextures.readView();
+    entries[3].textureView = outRead;
 
     entries[4].binding = 4;
-    entries[4].textureView = m_outputTextures.writeView();
+    entries[4].textureView = outWrite;
 
     WGPUBindGroupDescriptor desc = {};
     desc.layout = m_group0Layout;
     desc.entryCount = 5;
     desc.entries = entries;
-    return wgpuDeviceCreateBindGroup(m_device, &desc);
+    return gpuCreateBindGroup(m_device, &desc, "Physarum");
+}
+
+void PhysarumSim::createGroup0s() {
+    releaseGroup0s();
+    if (!m_group0Layout || !m_uniforms.buffer()) return;
+    for (int t = 0; t < 2; t++)
+        for (int o = 0; o < 2; o++)
+            m_group0[t][o] = buildGroup0(t, o);
+}
+
+void PhysarumSim::releaseGroup0s() {
+    for (auto& row : m_group0)
+        for (WGPUBindGroup& bg : row)
+            if (bg) { gpuRelease(bg); bg = nullptr; }
 }
 
-void PhysarumSim::uploadParams() {
+uint32_t PhysarumSim::pushParams(uint32_t scale) {
+    TRACE_SCOPE("PhysarumSim::pushParams");
     GpuParams gp = {};
-    gp.rezX = params.width;
-    gp.rezY = params.height;
+    gp.rezX = params.width * scale;
+    gp.rezY = params.height * scale;
     gp.agentsCount = m_agentCount;
     gp.time = m_frameCounter;
+    gp.seedLo = (uint32_t)params.seed;
+    gp.seedHi = (uint32_t)(params.seed >> 32);
+    gp.fade[0] = m_fade[0];
+    gp.fade[1] = m_fade[1];
+    if (scale > 1) {
+        // renderScaled: one render from nothing, at the brightness the fade converges to
+        gp.fade[0] = 0.0f;
+        gp.fade[1] = FADE_FRESH / (1.0f - FADE_KEEP);
+    }
 
     for (int i = 0; i < 4; i++) {
         gp.senseAngles[i]    = m_senseAngle[i] * DEG2RAD;
@@ -194,17 +225,9 @@ void PhysarumSim::uploadParams() {
         gp.saturations[i]    = m_saturation[i];
     }
 
-    // Compute cumulative type ratios from weights
-    float totalWeight = m_typeWeight[0] + m_typeWeight[1] + m_typeWeight[2] + m_typeWeight[3];
-    if (totalWeight < 0.001f) totalWeight = 1.0f;
-    float cumul = 0.0f;
-    for (int i = 0; i < 4; i++) {
-        cumul += m_typeWeight[i] / totalWeight;
-        gp.typeRatios[i] = cumul;
-    }
-    gp.typeRatios[3] = 1.0f; // ensure no rounding gaps
+    cumulativeTypeRatios(m_typeWeight, gp.typeRatios);
 
-    wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, 0, &gp, sizeof(gp));
+    return m_uniforms.push(&gp);
 }
 
 void PhysarumSim::clearTextures() {
@@ -243,53 +266,44 @@ void PhysarumSim::clearTextures() {
 }
 
 void PhysarumSim::dispatchReset(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("PhysarumSim::dispatchReset");
     m_trailTextures.current = 0;
     m_outputTextures.current = 0;
     m_frameCounter = 0;
 
     // Recreate agent buffer if size changed
     uint64_t requiredSize = (uint64_t)m_agentCount * 16;
-    uint64_t currentSize = m_agentBuffer ? wgpuBufferGetSize(m_agentBuffer) : 0;
+    uint64_t currentSize = m_agentBuffer ? m_agentBufferSize : 0;
 
     if (currentSize != requiredSize) {
-        if (m_agentBuffer) { wgpuBufferDestroy(m_agentBuffer); wgpuBufferRelease(m_agentBuffer); }
-        if (m_group1) wgpuBindGroupRelease(m_group1);
-
-        WGPUBufferDescriptor desc = {};
-        desc.size = requiredSize;
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "physarum_agents";
-        m_agentBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-
-        WGPUBindGroupEntry entry = {};
-        entry.binding = 0;
-        entry.buffer = m_agentBuffer;
-        entry.size = requiredSize;
-        WGPUBindGroupDescriptor bgDesc = {};
-        bgDesc.layout = m_group1Layout;
-        bgDesc.entryCount = 1;
-        bgDesc.entries = &entry;
-        m_group1 = wgpuDeviceCreateBindGroup(m_device, &bgDesc);
+        gpuPool().recycle(m_agentBuffer); // pooled buffers may be larger; bind with requiredSize
+        m_agentBufferSize = requiredSize;
+        m_agentBuffer = gpuPool().acquireBuffer(requiredSize, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                "physarum_agents", "Physarum");
+        createGroup1();
     }
 
     clearTextures();
-    uploadParams();
+    // Pooled, so it may hold anything; from here on every step leaves it zeroed
+    wgpuCommandEncoderClearBuffer(encoder, m_claimBuffer, 0, (uint64_t)params.width * params.height * 4);
+    uint32_t offset = pushParams();
+    m_uniforms.upload();
 
-    WGPUBindGroup bg0 = buildGroup0();
+    WGPUBindGroup bg0 = group0();
 
     // Reset agents kernel
-    WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, "Physarum/reset_agents");
     wgpuComputePassEncoderSetPipeline(pass, m_resetAgentsPipeline);
-    wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 1, &offset);
     wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
     wgpuComputePassEncoderDispatchWorkgroups(pass, (m_agentCount + 255) / 256, 1, 1);
     wgpuComputePassEncoderEnd(pass);
     wgpuComputePassEncoderRelease(pass);
-
-    wgpuBindGroupRelease(bg0);
 }
 
 void PhysarumSim::step(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("PhysarumSim::step");
+    m_pipelines.wait(); // no-op once compiled; callers that can't block check ready() first
     if (m_needsReset) {
         m_needsReset = false;
         dispatchReset(encoder);
@@ -303,82 +317,45 @@ void PhysarumSim::step(WGPUCommandEncoder encoder) {
     uint32_t hgTex = (params.height + 7) / 8;
     uint32_t wgAgent = (m_agentCount + 255) / 256;
 
+    ProfiledCpuScope cpuTime("Physarum/encode");
+    if (m_uniforms.reserve((uint32_t)m_stepsPerFrame)) createGroup0s();
+    // Temporal fade of one render, or of all substeps folded into one
+    substepFade(FADE_KEEP, FADE_FRESH, m_renderEverySubstep ? 1 : m_stepsPerFrame, m_fade);
+    // No texture copies between kernels, so every substep shares one pass
+    ComputeBatch batch(encoder, "Physarum/step");
+    batch.setBindGroup(1, m_group1);
     for (int s = 0; s < m_stepsPerFrame; s++) {
         m_frameCounter++;
-        uploadParams();
-
-        // 1. Build group 0 for current ping-pong state
-        WGPUBindGroup bg0 = buildGroup0();
-
-        // 2. MoveAgents — reads trailRead, updates agents
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_moveAgentsPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgAgent, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        uint32_t offset = pushParams();
 
-        // 3. DiffuseTexture — trailRead -> trailWrite (blur)
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_diffuseTexturePipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgTex, hgTex, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 1. Prebuilt group 0 for the current ping-pong state
+        batch.setBindGroup(0, group0(), 1, &offset);
 
-        // 4. Copy trailWrite -> trailRead so WriteTrails can read diffused data
-        {
-            WGPUImageCopyTexture src = {};
-            src.texture = m_trailTextures.current == 0 ? m_trailTextures.texB : m_trailTextures.texA;
-            WGPUImageCopyTexture dst = {};
-            dst.texture = m_trailTextures.current == 0 ? m_trailTextures.texA : m_trailTextures.texB;
-            WGPUExtent3D size = { params.width, params.height, 1 };
-            wgpuCommandEncoderCopyTextureToTexture(encoder, &src, &dst, &size);
-        }
+        // 2. MoveAgents — reads trailRead, updates agents, claims each agent's deposit pixel
+        batch.dispatch("Physarum/move_agents", m_moveAgentsPipeline, wgAgent);
 
-        wgpuBindGroupRelease(bg0);
-
-        // 5. WriteTrails — reads trailRead (now has diffused data), writes trailWrite
-        // Need new bind group since we just copied (trailRead has diffused data, trailWrite same)
-        bg0 = buildGroup0();
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_writeTrailsPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgAgent, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 3. DiffuseTexture — trailRead -> trailWrite (blur)
+        batch.dispatch("Physarum/diffuse_texture", m_diffuseTexturePipeline, wgTex, hgTex);
 
-        // 6. Swap trail ping-pong
+        // 4. WriteTrails — recomputes the diffused value at each agent from trailRead
+        // (unchanged), deposits and writes trailWrite; same ping-pong state. Only
+        // the claiming agent of a pixel writes it, so shared pixels are deterministic
+        batch.dispatch("Physarum/write_trails", m_writeTrailsPipeline, wgAgent);
+
+        // 5. Swap trail ping-pong
         m_trailTextures.swap();
 
-        wgpuBindGroupRelease(bg0);
-
-        // 7. Render — reads trailRead + outRead, writes outWrite
-        bg0 = buildGroup0();
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_renderPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgTex, hgTex, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 6. Render — reads trailRead + outRead, writes outWrite (trail swapped).
+        // Only the last substep's is displayed, so by default only it renders
+        if (!m_renderEverySubstep && s + 1 < m_stepsPerFrame) continue;
+        batch.setBindGroup(0, group0(), 1, &offset);
+        batch.dispatch("Physarum/render", m_renderPipeline, wgTex, hgTex);
 
-        // 8. Swap output ping-pong
+        // 7. Swap output ping-pong
         m_outputTextures.swap();
-
-        wgpuBindGroupRelease(bg0);
     }
+    batch.end();
+    m_uniforms.upload(); // every substep's params in one write
 }
 
 void PhysarumSim::reset() {
@@ -393,6 +370,90 @@ WGPUTexture PhysarumSim::getOutputTexture() {
     return m_outputTextures.current == 0 ? m_outputTextures.texA : m_outputTextures.texB;
 }
 
+void PhysarumSim::renderScaled(WGPUCommandEncoder encoder, uint32_t scale, WGPUTextureView field,
+                               WGPUTextureView output) {
+    TRACE_SCOPE("PhysarumSim::renderScaled");
+    m_pipelines.wait();
+    m_scaledTrail.encode(encoder, stateViews(), m_trailTextures.readView(), scale, field);
+
+    if (m_uniforms.reserve(1)) createGroup0s();
+    uint32_t offset = pushParams(scale);
+    m_uniforms.upload();
+
+    // Colorize the field; the idle trail half fills the unused trailWrite binding
+    int t = m_trailTextures.current, o = m_outputTextures.current;
+    WGPUBindGroup bg = buildGroup0(field, m_trailTextures.writeView(t), m_outputTextures.readView(o), output);
+
+    ComputeBatch batch(encoder, "Physarum/export");
+    batch.setBindGroup(1, m_group1);
+    batch.setBindGroup(0, bg, 1, &offset);
+    batch.dispatch("Physarum/render", m_renderPipeline, (params.width * scale + 7) / 8,
+                   (params.height * scale + 7) / 8);
+    batch.end();
+    gpuRelease(bg);
+}
+
+SimStateViews PhysarumSim::stateViews() {
+    SimStateViews v;
+    v.agents = m_agentBuffer;
+    v.agentBytes = (uint64_t)m_agentCount * 16;
+    v.agentStride = 16;
+    cumulativeTypeRatios(m_typeWeight, v.typeRatios);
+    v.textures[0] = m_trailTextures.readView();
+    v.textures[1] = m_outputTextures.readView();
+    v.textureNames[0] = "trail";
+    v.textureNames[1] = "output";
+    v.textureCount = 2;
+    v.width = params.width;
+    v.height = params.height;
+    v.step = m_frameCounter;
+    return v;
+}
+
+PresetData PhysarumSim::capturePreset() const {
+    PresetData data;
+    data["agentCount"] = {(float)m_agentCount};
+    data["linkTypes"] = {m_linkTypes ? 1.0f : 0.0f};
+    data["senseAngle"]   = {m_senseAngle[0], m_senseAngle[1], m_senseAngle[2], m_senseAngle[3]};
+    data["senseDistance"] = {m_senseDistance[0], m_senseDistance[1], m_senseDistance[2], m_senseDistance[3]};
+    data["turnAngle"]    = {m_turnAngle[0], m_turnAngle[1], m_turnAngle[2], m_turnAngle[3]};
+    data["moveSpeed"]    = {m_moveSpeed[0], m_moveSpeed[1], m_moveSpeed[2], m_moveSpeed[3]};
+    data["deposit"]      = {m_deposit[0], m_deposit[1], m_deposit[2], m_deposit[3]};
+    data["eat"]          = {m_eat[0], m_eat[1], m_eat[2], m_eat[3]};
+    data["diffuseRate"]  = {m_diffuseRate[0], m_diffuseRate[1], m_diffuseRate[2], m_diffuseRate[3]};
+    data["hue"]          = {m_hue[0], m_hue[1], m_hue[2], m_hue[3]};
+    data["saturation"]   = {m_saturation[0], m_saturation[1], m_saturation[2], m_saturation[3]};
+    data["typeWeight"]   = {m_typeWeight[0], m_typeWeight[1], m_typeWeight[2], m_typeWeight[3]};
+    data["stepsPerFrame"] = {(float)m_stepsPerFrame};
+    data["renderEverySubstep"] = {m_renderEverySubstep ? 1.0f : 0.0f};
+    return data;
+}
+
+void PhysarumSim::applyPreset(const PresetData& data) {
+    auto load4 = [&](const char* key, float* dst) { presetGet(data, key, dst, 4); };
+    float v = 0.0f;
+    if (presetGet(data, "agentCount", &v, 1)) {
+        m_agentCount = (uint32_t)v;
+        m_needsReset = true;
+    }
+    if (presetGet(data, "linkTypes", &v, 1))
+        m_linkTypes = v > 0.5f;
+    load4("senseAngle", m_senseAngle);
+    load4("senseDistance", m_senseDistance);
+    load4("turnAngle", m_turnAngle);
+    load4("moveSpeed", m_moveSpeed);
+    load4("deposit", m_deposit);
+    load4("eat", m_eat);
+    load4("diffuseRate", m_diffuseRate);
+    load4("hue", m_hue);
+    load4("saturation", m_saturation);
+    load4("typeWeight", m_typeWeight);
+    if (presetGet(data, "stepsPerFrame", &v, 1))
+        m_stepsPerFrame = (int)v;
+    if (presetGet(data, "renderEverySubstep", &v, 1))
+        m_renderEverySubstep = v > 0.5f;
+}
+
 void PhysarumSim::onGui() {
     ImGui::Text("Physarum");
     ImGui::Separator();
@@ -411,6 +472,9 @@ void PhysarumSim::onGui() {
     }
 
     ImGui::SliderInt("Steps/Frame", &m_stepsPerFrame, 0, 20);
+    ImGui::Checkbox("Render Every Substep", &m_renderEverySubstep);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Colorize after every substep instead of once per frame (same fade rate)");
 
     {
         int ac = (int)m_agentCount;
@@ -458,46 +522,12 @@ void PhysarumSim::onGui() {
     ImGui::InputText("Preset Name", presetName, sizeof(presetName));
 
     if (ImGui::Button("Save Preset")) {
-        std::map<std::string, std::vector<float>> data;
-        data["agentCount"] = {(float)m_agentCount};
-        data["linkTypes"] = {m_linkTypes ? 1.0f : 0.0f};
-        data["senseAngle"]   = {m_senseAngle[0], m_senseAngle[1], m_senseAngle[2], m_senseAngle[3]};
-        data["senseDistance"] = {m_senseDistance[0], m_senseDistance[1], m_senseDistance[2], m_senseDistance[3]};
-        data["turnAngle"]    = {m_turnAngle[0], m_turnAngle[1], m_turnAngle[2], m_turnAngle[3]};
-        data["moveSpeed"]    = {m_moveSpeed[0], m_moveSpeed[1], m_moveSpeed[2], m_moveSpeed[3]};
-        data["deposit"]      = {m_deposit[0], m_deposit[1], m_deposit[2], m_deposit[3]};
-        data["eat"]          = {m_eat[0], m_eat[1], m_eat[2], m_eat[3]};
-        data["diffuseRate"]  = {m_diffuseRate[0], m_diffuseRate[1], m_diffuseRate[2], m_diffuseRate[3]};
-        data["hue"]          = {m_hue[0], m_hue[1], m_hue[2], m_hue[3]};
-        data["saturation"]   = {m_saturation[0], m_saturation[1], m_saturation[2], m_saturation[3]};
-        data["typeWeight"]   = {m_typeWeight[0], m_typeWeight[1], m_typeWeight[2], m_typeWeight[3]};
-        savePreset(std::string("physarum_") + presetName, data);
+        savePreset(std::string("physarum_") + presetName, capturePreset());
     }
     ImGui::SameLine();
     if (ImGui::Button("Load Preset")) {
         auto data = loadPreset(std::string("physarum_") + presetName);
-        if (!data.empty()) {
-            auto load4 = [&](const char* key, float* dst) {
-                auto it = data.find(key);
-                if (it != data.end()) for (size_t i = 0; i < 4 && i < it->second.size(); i++) dst[i] = it->second[i];
-            };
-            if (data.count("agentCount") && !data["agentCount"].empty()) {
-                m_agentCount = (uint32_t)data["agentCount"][0];
-                m_needsReset = true;
-            }
-            if (data.count("linkTypes") && !data["linkTypes"].empty())
-                m_linkTypes = data["linkTypes"][0] > 0.5f;
-            load4("senseAngle", m_senseAngle);
-            load4("senseDistance", m_senseDistance);
-            load4("turnAngle", m_turnAngle);
-            load4("moveSpeed", m_moveSpeed);
-            load4("deposit", m_deposit);
-            load4("eat", m_eat);
-            load4("diffuseRate", m_diffuseRate);
-            load4("hue", m_hue);
-            load4("saturation", m_saturation);
-            load4("typeWeight", m_typeWeight);
-        }
+        if (!data.empty()) applyPreset(data);
     }
 
     ImGui::Checkbox("Link All Types", &m_linkTypes);
@@ -571,21 +601,24 @@ void PhysarumSim::onGui() {
 }
 
 void PhysarumSim::shutdown() {
-    if (m_group1) wgpuBindGroupRelease(m_group1);
-    if (m_group0Layout) wgpuBindGroupLayoutRelease(m_group0Layout);
-    if (m_group1Layout) wgpuBindGroupLayoutRelease(m_group1Layout);
+    m_pipelines.wait(); // jobs still use the module and layout
+    releaseGroup0s();
+    if (m_group1) gpuRelease(m_group1);
+    if (m_group0Layout) gpuRelease(m_group0Layout);
+    if (m_group1Layout) gpuRelease(m_group1Layout);
     if (m_pipelineLayout) wgpuPipelineLayoutRelease(m_pipelineLayout);
 
-    if (m_resetTexturePipeline)   wgpuComputePipelineRelease(m_resetTexturePipeline);
-    if (m_resetAgentsPipeline)    wgpuComputePipelineRelease(m_resetAgentsPipeline);
-    if (m_moveAgentsPipeline)     wgpuComputePipelineRelease(m_moveAgentsPipeline);
-    if (m_writeTrailsPipeline)    wgpuComputePipelineRelease(m_writeTrailsPipeline);
-    if (m_diffuseTexturePipeline) wgpuComputePipelineRelease(m_diffuseTexturePipeline);
-    if (m_renderPipeline)         wgpuComputePipelineRelease(m_renderPipeline);
+    if (m_resetTexturePipeline)   gpuRelease(m_resetTexturePipeline);
+    if (m_resetAgentsPipeline)    gpuRelease(m_resetAgentsPipeline);
+    if (m_moveAgentsPipeline)     gpuRelease(m_moveAgentsPipeline);
+    if (m_writeTrailsPipeline)    gpuRelease(m_writeTrailsPipeline);
+    if (m_diffuseTexturePipeline) gpuRelease(m_diffuseTexturePipeline);
+    if (m_renderPipeline)         gpuRelease(m_renderPipeline);
 
-    if (m_shaderModule) wgpuShaderModuleRelease(m_shaderModule);
-    if (m_agentBuffer) { wgpuBufferDestroy(m_agentBuffer); wgpuBufferRelease(m_agentBuffer); }
-    if (m_uniformBuffer) { wgpuBufferDestroy(m_uniformBuffer); wgpuBufferRelease(m_uniformBuffer); }
+    m_scaledTrail.shutdown();
+    gpuPool().recycle(m_agentBuffer);
+    gpuPool().recycle(m_claimBuffer);
+    m_uniforms.destroy();
 
     m_trailTextures.destroy();
     m_outputTextures.destroy();
@@ -596,6 +629,6 @@ void PhysarumSim::shutdown() {
     m_resetTexturePipeline = m_resetAgentsPipeline = nullptr;
     m_moveAgentsPipeline = m_writeTrailsPipeline = nullptr;
     m_diffuseTexturePipeline = m_renderPipeline = nullptr;
-    m_shaderModule = nullptr;
-    m_agentBuffer = m_uniformBuffer = nullptr;
+    m_agentBuffer = nullptr;
+    m_claimBuffer = nullptr;
 }
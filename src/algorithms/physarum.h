@@ -1,6 +1,8 @@
 #pragma once
 #include "../simulation.h"
 #include "../compute_pass.h"
+#include "../uniform_ring.h"
+#include "../scaled_trail.h"
 #include <vector>
 #include <cstdint>
 
@@ -13,15 +15,28 @@ public:
     WGPUTextureView getOutputView() override;
     WGPUTexture getOutputTexture() override;
     void onGui() override;
+    void applyPreset(const PresetData& data) override;
+    PresetData capturePreset() const override;
+    SimStateViews stateViews() override;
+    bool canRenderScaled() const override { return true; }
+    void renderScaled(WGPUCommandEncoder encoder, uint32_t scale, WGPUTextureView field,
+                      WGPUTextureView output) override;
     void shutdown() override;
+    bool ready() override { return m_pipelines.ready(); }
 
 private:
     void createPipelines();
     void createBuffers();
     void clearTextures();
     void dispatchReset(WGPUCommandEncoder encoder);
-    void uploadParams();
-    WGPUBindGroup buildGroup0();
+    uint32_t pushParams(uint32_t scale = 1); // returns the block's dynamic offset; scale: renderScaled
+    WGPUBindGroup buildGroup0(int trail, int output);
+    WGPUBindGroup buildGroup0(WGPUTextureView trailRead, WGPUTextureView trailWrite,
+                              WGPUTextureView outRead, WGPUTextureView outWrite);
+    void createGroup0s(); // every ping-pong permutation; rebuilt only with the textures
+    void createGroup1();  // agents + claims; rebuilt when the agent count changes
+    void releaseGroup0s();
+    WGPUBindGroup group0() const { return m_group0[m_trailTextures.current][m_outputTextures.current]; }
 
     WGPUDevice m_device = nullptr;
     WGPUQueue m_queue = nullptr;
@@ -31,11 +46,12 @@ private:
     PingPongTextures m_outputTextures;  // rgba8unorm
 
     // Buffers
-    WGPUBuffer m_agentBuffer = nullptr;
-    WGPUBuffer m_uniformBuffer = nullptr;
+    WGPUBuffer m_agentBuffer = nullptr; // pooled, may be larger than needed
+    uint64_t m_agentBufferSize = 0;
+    WGPUBuffer m_claimBuffer = nullptr; // u32 per trail pixel: agent that deposits there (pooled)
+    UniformRing m_uniforms; // GpuParams, one block per substep (dynamic offset)
 
     // Pipelines (all share same layout)
-    WGPUShaderModule m_shaderModule = nullptr;
     WGPUPipelineLayout m_pipelineLayout = nullptr;
     WGPUBindGroupLayout m_group0Layout = nullptr;
     WGPUBindGroupLayout m_group1Layout = nullptr;
@@ -46,8 +62,11 @@ private:
     WGPUComputePipeline m_writeTrailsPipeline = nullptr;
     WGPUComputePipeline m_diffuseTexturePipeline = nullptr;
     WGPUComputePipeline m_renderPipeline = nullptr;
+    PipelineBatch m_pipelines; // the pipelines above, until ready()
+    ScaledTrail m_scaledTrail; // export-size trail field for renderScaled()
 
-    WGPUBindGroup m_group1 = nullptr; // agents buffer — stable
+    WGPUBindGroup m_group0[2][2] = {}; // [trail][output] ping-pong state
+    WGPUBindGroup m_group1 = nullptr; // agents + claims — stable
 
     // Params
     uint32_t m_agentCount = 100000;
@@ -55,6 +74,8 @@ private:
     int m_stepsPerFrame = 1;
     bool m_needsReset = true;
     bool m_doStep = false;
+    bool m_renderEverySubstep = false; // else render once per frame
+    float m_fade[2] = {};              // substepFade() for this frame's render
     bool m_linkTypes = true;
 
     // Per-type params (indices 0-3)
@@ -82,6 +103,8 @@ private:
         float hues[4];
         float saturations[4];
         float typeRatios[4];
+        uint32_t seedLo, seedHi, _seedPad[2];
+        float fade[4]; // render: previous output weight, fresh weight
     };
-    static_assert(sizeof(GpuParams) == 176, "GpuParams must be 176 bytes");
+    static_assert(sizeof(GpuParams) == 208, "GpuParams must be 208 bytes");
 };
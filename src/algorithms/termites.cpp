@@ -1,4 +1,8 @@
 #include "termites.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "../gpu_profiler.h"
+#include "../cpu_trace.h"
 #include "../preset.h"
 #include <imgui.h>
 #include <cmath>
@@ -14,43 +18,31 @@ void TermitesSim::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t
     params.width = w;
     params.height = h;
 
-    m_trailTextures.init(device, w, h, WGPUTextureFormat_RGBA16Float);
-    m_moundTextures.init(device, w, h, WGPUTextureFormat_RGBA16Float);
-    m_outputTextures.init(device, w, h, WGPUTextureFormat_RGBA8Unorm);
+    m_trailTextures.init(w, h, WGPUTextureFormat_RGBA16Float, "Termites");
+    m_moundTextures.init(w, h, WGPUTextureFormat_RGBA16Float, "Termites");
+    m_outputTextures.init(w, h, WGPUTextureFormat_RGBA8Unorm, "Termites");
 
     createBuffers();
     createPipelines();
+    createGroup0s();
     m_needsReset = true;
 }
 
 void TermitesSim::createBuffers() {
     {
-        WGPUBufferDescriptor desc = {};
-        desc.size = (uint64_t)m_agentCount * 16;
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "termites_agents";
-        m_agentBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-    }
-    {
-        WGPUBufferDescriptor desc = {};
-        desc.size = sizeof(GpuParams);
-        desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-        desc.label = "termites_params";
-        m_uniformBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
+        m_agentBufferSize = (uint64_t)m_agentCount * 16;
+        m_agentBuffer = gpuPool().acquireBuffer(m_agentBufferSize, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                "termites_agents", "Termites");
     }
+    // Deposit claims: zeroed on reset, and again by each pixel's winner every step
+    m_claimBuffer = gpuPool().acquireBuffer((uint64_t)params.width * params.height * 8,
+                                            WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                            "termites_claims", "Termites");
+    // Uniform ring: one GpuParams block per substep (Steps/Frame slider max, grows on demand)
+    m_uniforms.init(m_device, m_queue, sizeof(GpuParams), 20, "Termites");
 }
 
 void TermitesSim::createPipelines() {
-    std::string code = loadShaderFile("shaders/termites.wgsl");
-    if (code.empty()) return;
-
-    WGPUShaderModuleWGSLDescriptor wgslDesc = {};
-    wgslDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
-    wgslDesc.code = code.c_str();
-    WGPUShaderModuleDescriptor smDesc = {};
-    smDesc.nextInChain = &wgslDesc.chain;
-    m_shaderModule = wgpuDeviceCreateShaderModule(m_device, &smDesc);
-
     // Group 0: uniform, trailR/W, moundR/W, outR/W (7 bindings)
     {
         WGPUBindGroupLayoutEntry entries[7] = {};
@@ -59,6 +51,7 @@ void TermitesSim::createPipelines() {
         entries[0].binding = 0;
         entries[0].visibility = WGPUShaderStage_Compute;
         entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+        entries[0].buffer.hasDynamicOffset = true;
         entries[0].buffer.minBindingSize = sizeof(GpuParams);
 
         // b1: trailRead (texture_2d)
@@ -103,21 +96,26 @@ void TermitesSim::createPipelines() {
         WGPUBindGroupLayoutDescriptor desc = {};
         desc.entryCount = 7;
         desc.entries = entries;
-        m_group0Layout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        m_group0Layout = gpuCreateBindGroupLayout(m_device, &desc, "Termites");
     }
 
-    // Group 1: agents storage buffer
+    // Group 1: agents + deposit claims storage buffers
     {
-        WGPUBindGroupLayoutEntry entry = {};
-        entry.binding = 0;
-        entry.visibility = WGPUShaderStage_Compute;
-        entry.buffer.type = WGPUBufferBindingType_Storage;
-        entry.buffer.minBindingSize = 16;
+        WGPUBindGroupLayoutEntry entries[2] = {};
+        entries[0].binding = 0;
+        entries[0].visibility = WGPUShaderStage_Compute;
+        entries[0].buffer.type = WGPUBufferBindingType_Storage;
+        entries[0].buffer.minBindingSize = 16;
+
+        entries[1].binding = 1;
+        entries[1].visibility = WGPUShaderStage_Compute;
+        entries[1].buffer.type = WGPUBufferBindingType_Storage;
+        entries[1].buffer.minBindingSize = 8;
 
         WGPUBindGroupLayoutDescriptor desc = {};
-        desc.entryCount = 1;
-        desc.entries = &entry;
-        m_group1Layout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        desc.entryCount = 2;
+        desc.entries = entries;
+        m_group1Layout = gpuCreateBindGroupLayout(m_device, &desc, "Termites");
     }
 
     {
@@ -128,73 +126,97 @@ void TermitesSim::createPipelines() {
         m_pipelineLayout = wgpuDeviceCreatePipelineLayout(m_device, &desc);
     }
 
-    auto makePipeline = [&](const char* entry) -> WGPUComputePipeline {
-        WGPUComputePipelineDescriptor desc = {};
-        desc.layout = m_pipelineLayout;
-        desc.compute.module = m_shaderModule;
-        desc.compute.entryPoint = entry;
-        return wgpuDeviceCreateComputePipeline(m_device, &desc);
+    // All 6 pipelines compiled on the worker threads
+    auto shader = m_pipelines.shader("shaders/termites.wgsl");
+    auto makePipeline = [&](const char* entry, WGPUComputePipeline* out) {
+        m_pipelines.add(m_device, shader, entry, m_pipelineLayout, out, "Termites");
     };
 
-    m_resetTexturePipeline  = makePipeline("reset_texture");
-    m_resetAgentsPipeline   = makePipeline("reset_agents");
-    m_moveAgentsPipeline    = makePipeline("move_agents");
-    m_decayTexturePipeline  = makePipeline("decay_texture");
-    m_writeTrailsPipeline   = makePipeline("write_trails");
-    m_renderPipeline        = makePipeline("render");
+    makePipeline("reset_texture", &m_resetTexturePipeline);
+    makePipeline("reset_agents",  &m_resetAgentsPipeline);
+    makePipeline("move_agents",   &m_moveAgentsPipeline);
+    makePipeline("decay_texture", &m_decayTexturePipeline);
+    makePipeline("write_trails",  &m_writeTrailsPipeline);
+    makePipeline("render",        &m_renderPipeline);
 
-    {
-        WGPUBindGroupEntry entry = {};
-        entry.binding = 0;
-        entry.buffer = m_agentBuffer;
-        entry.size = (uint64_t)m_agentCount * 16;
-
-        WGPUBindGroupDescriptor desc = {};
-        desc.layout = m_group1Layout;
-        desc.entryCount = 1;
-        desc.entries = &entry;
-        m_group1 = wgpuDeviceCreateBindGroup(m_device, &desc);
-    }
+    createGroup1();
 }
 
-WGPUBindGroup TermitesSim::buildGroup0() {
+void TermitesSim::createGroup1() {
+    if (m_group1) gpuRelease(m_group1);
+    WGPUBindGroupEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].buffer = m_agentBuffer;
+    entries[0].size = m_agentBufferSize;
+    entries[1].binding = 1;
+    entries[1].buffer = m_claimBuffer;
+    entries[1].size = (uint64_t)params.width * params.height * 8;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout = m_group1Layout;
+    desc.entryCount = 2;
+    desc.entries = entries;
+    m_group1 = gpuCreateBindGroup(m_device, &desc, "Termites");
+}
+
+WGPUBindGroup TermitesSim::buildGroup0(int trail, int mound, int output) {
+    TRACE_SCOPE("TermitesSim::buildGroup0");
     WGPUBindGroupEntry entries[7] = {};
 
     entries[0].binding = 0;
-    entries[0].buffer = m_uniformBuffer;
+    entries[0].buffer = m_uniforms.buffer();
     entries[0].size = sizeof(GpuParams);
 
     entries[1].binding = 1;
-    entries[1].textureView = m_trailTextures.readView();
+    entries[1].textureView = m_trailTextures.readView(trail);
 
     entries[2].binding = 2;
-    entries[2].textureView = m_trailTextures.writeView();
+    entries[2].textureView = m_trailTextures.writeView(trail);
 
     entries[3].binding = 3;
-    entries[3].textureView = m_moundTextures.readView();
+    entries[3].textureView = m_moundTextures.readView(mound);
 
     entries[4].binding = 4;
-    entries[4].textureView = m_moundTextures.writeView();
+    entries[4].textureView = m_moundTextures.writeView(mound);
 
     entries[5].binding = 5;
-    entries[5].textureView = m_outputTextures.readView();
+    entries[5].textureView = m_outputTextures.readView(output);
 
     entries[6].binding = 6;
-    entries[6].textureView = m_outputTextures.writeView();
+    entries[6].textureView = m_outputTextures.writeView(output);
 
     WGPUBindGroupDescriptor desc = {};
     desc.layout = m_group0Layout;
     desc.entryCount = 7;
     desc.entries = entries;
-    return wgpuDeviceCreateBindGroup(m_device, &desc);
+    return gpuCreateBindGroup(m_device, &desc, "Termites");
+}
+
+void TermitesSim::createGroup0s() {
+    releaseGroup0s();
+    if (!m_group0Layout || !m_uniforms.buffer()) return;
+    for (int t = 0; t < 2; t++)
+        for (int m = 0; m < 2; m++)
+            for (int o = 0; o < 2; o++)
+                m_group0[t][m][o] = buildGroup0(t, m, o);
+}
+
+void TermitesSim::releaseGroup0s() {
+    for (auto& plane : m_group0)
+        for (auto& row : plane)
+            for (WGPUBindGroup& bg : row)
+                if (bg) { gpuRelease(bg); bg = nullptr; }
 }
 
-void TermitesSim::uploadParams() {
+uint32_t TermitesSim::pushParams() {
+    TRACE_SCOPE("TermitesSim::pushParams");
     GpuParams gp = {};
     gp.rezX = params.width;
     gp.rezY = params.height;
     gp.agentsCount = m_agentCount;
     gp.time = m_frameCounter;
+    gp.seedLo = (uint32_t)params.seed;
+    gp.seedHi = (uint32_t)(params.seed >> 32);
 
     for (int i = 0; i < 4; i++) {
         gp.senseAngles[i]    = m_senseAngle[i] * DEG2RAD;
@@ -208,16 +230,9 @@ void TermitesSim::uploadParams() {
         gp.saturations[i]    = m_saturation[i];
     }
 
-    float totalWeight = m_typeWeight[0] + m_typeWeight[1] + m_typeWeight[2] + m_typeWeight[3];
-    if (totalWeight < 0.001f) totalWeight = 1.0f;
-    float cumul = 0.0f;
-    for (int i = 0; i < 4; i++) {
-        cumul += m_typeWeight[i] / totalWeight;
-        gp.typeRatios[i] = cumul;
-    }
-    gp.typeRatios[3] = 1.0f;
+    cumulativeTypeRatios(m_typeWeight, gp.typeRatios);
 
-    wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, 0, &gp, sizeof(gp));
+    return m_uniforms.push(&gp);
 }
 
 void TermitesSim::clearTextures() {
@@ -260,52 +275,43 @@ void TermitesSim::clearTextures() {
 }
 
 void TermitesSim::dispatchReset(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("TermitesSim::dispatchReset");
     m_trailTextures.current = 0;
     m_moundTextures.current = 0;
     m_outputTextures.current = 0;
     m_frameCounter = 0;
 
     uint64_t requiredSize = (uint64_t)m_agentCount * 16;
-    uint64_t currentSize = m_agentBuffer ? wgpuBufferGetSize(m_agentBuffer) : 0;
+    uint64_t currentSize = m_agentBuffer ? m_agentBufferSize : 0;
 
     if (currentSize != requiredSize) {
-        if (m_agentBuffer) { wgpuBufferDestroy(m_agentBuffer); wgpuBufferRelease(m_agentBuffer); }
-        if (m_group1) wgpuBindGroupRelease(m_group1);
-
-        WGPUBufferDescriptor desc = {};
-        desc.size = requiredSize;
-        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst;
-        desc.label = "termites_agents";
-        m_agentBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-
-        WGPUBindGroupEntry entry = {};
-        entry.binding = 0;
-        entry.buffer = m_agentBuffer;
-        entry.size = requiredSize;
-        WGPUBindGroupDescriptor bgDesc = {};
-        bgDesc.layout = m_group1Layout;
-        bgDesc.entryCount = 1;
-        bgDesc.entries = &entry;
-        m_group1 = wgpuDeviceCreateBindGroup(m_device, &bgDesc);
+        gpuPool().recycle(m_agentBuffer); // pooled buffers may be larger; bind with requiredSize
+        m_agentBufferSize = requiredSize;
+        m_agentBuffer = gpuPool().acquireBuffer(requiredSize, WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+                                                "termites_agents", "Termites");
+        createGroup1();
     }
 
     clearTextures();
-    uploadParams();
+    // Pooled, so it may hold anything; from here on every step leaves it zeroed
+    wgpuCommandEncoderClearBuffer(encoder, m_claimBuffer, 0, (uint64_t)params.width * params.height * 8);
+    uint32_t offset = pushParams();
+    m_uniforms.upload();
 
-    WGPUBindGroup bg0 = buildGroup0();
+    WGPUBindGroup bg0 = group0();
 
-    WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, "Termites/reset_agents");
     wgpuComputePassEncoderSetPipeline(pass, m_resetAgentsPipeline);
-    wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 1, &offset);
     wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
     wgpuComputePassEncoderDispatchWorkgroups(pass, (m_agentCount + 255) / 256, 1, 1);
     wgpuComputePassEncoderEnd(pass);
     wgpuComputePassEncoderRelease(pass);
-
-    wgpuBindGroupRelease(bg0);
 }
 
 void TermitesSim::step(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("TermitesSim::step");
+    m_pipelines.wait(); // no-op once compiled; callers that can't block check ready() first
     if (m_needsReset) {
         m_needsReset = false;
         dispatchReset(encoder);
@@ -319,84 +325,42 @@ void TermitesSim::step(WGPUCommandEncoder encoder) {
     uint32_t hgTex = (params.height + 7) / 8;
     uint32_t wgAgent = (m_agentCount + 255) / 256;
 
+    ProfiledCpuScope cpuTime("Termites/encode");
+    if (m_uniforms.reserve((uint32_t)m_stepsPerFrame)) createGroup0s();
+    // No texture copies between kernels, so every substep shares one pass
+    ComputeBatch batch(encoder, "Termites/step");
+    batch.setBindGroup(1, m_group1);
     for (int s = 0; s < m_stepsPerFrame; s++) {
         m_frameCounter++;
-        uploadParams();
-
-        // 1. MoveAgents — reads trailRead for sensing
-        WGPUBindGroup bg0 = buildGroup0();
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_moveAgentsPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgAgent, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
-
-        // 2. DecayTexture — trail decays, mound identity-copied
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_decayTexturePipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgTex, hgTex, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
-
-        // 3. Copy trailWrite -> trailRead, moundWrite -> moundRead
-        {
-            WGPUImageCopyTexture src = {}, dst = {};
-            WGPUExtent3D size = { params.width, params.height, 1 };
+        uint32_t offset = pushParams();
 
-            src.texture = m_trailTextures.current == 0 ? m_trailTextures.texB : m_trailTextures.texA;
-            dst.texture = m_trailTextures.current == 0 ? m_trailTextures.texA : m_trailTextures.texB;
-            wgpuCommandEncoderCopyTextureToTexture(encoder, &src, &dst, &size);
+        // 1. MoveAgents — reads trailRead for sensing, claims each agent's deposit pixel
+        batch.setBindGroup(0, group0(), 1, &offset);
+        batch.dispatch("Termites/move_agents", m_moveAgentsPipeline, wgAgent);
 
-            src.texture = m_moundTextures.current == 0 ? m_moundTextures.texB : m_moundTextures.texA;
-            dst.texture = m_moundTextures.current == 0 ? m_moundTextures.texA : m_moundTextures.texB;
-            wgpuCommandEncoderCopyTextureToTexture(encoder, &src, &dst, &size);
-        }
+        // 2. DecayTexture — trail decays, mound identity-copied
+        batch.dispatch("Termites/decay_texture", m_decayTexturePipeline, wgTex, hgTex);
 
-        wgpuBindGroupRelease(bg0);
-
-        // 4. WriteTrails — pheromone deposit (always) + mound deposit (probabilistic)
-        bg0 = buildGroup0();
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_writeTrailsPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgAgent, 1, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 3. WriteTrails — pheromone deposit (always) + mound deposit (probabilistic); same ping-pong state.
+        // Recomputes the decayed trail from trailRead; moundRead equals the identity-copied mound.
+        // Only the claiming agent of a pixel writes it, so shared pixels are deterministic
+        batch.dispatch("Termites/write_trails", m_writeTrailsPipeline, wgAgent);
 
-        // 5. Swap trail + mound ping-pong
+        // 4. Swap trail + mound ping-pong
         m_trailTextures.swap();
         m_moundTextures.swap();
 
-        wgpuBindGroupRelease(bg0);
-
-        // 6. Render — composite trail + mound -> outWrite
-        bg0 = buildGroup0();
-        {
-            WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-            wgpuComputePassEncoderSetPipeline(pass, m_renderPipeline);
-            wgpuComputePassEncoderSetBindGroup(pass, 0, bg0, 0, nullptr);
-            wgpuComputePassEncoderSetBindGroup(pass, 1, m_group1, 0, nullptr);
-            wgpuComputePassEncoderDispatchWorkgroups(pass, wgTex, hgTex, 1);
-            wgpuComputePassEncoderEnd(pass);
-            wgpuComputePassEncoderRelease(pass);
-        }
+        // 5. Render — composite trail + mound -> outWrite. Stateless (no fade),
+        // so rendering only the displayed last substep is exact
+        if (!m_renderEverySubstep && s + 1 < m_stepsPerFrame) continue;
+        batch.setBindGroup(0, group0(), 1, &offset);
+        batch.dispatch("Termites/render", m_renderPipeline, wgTex, hgTex);
 
-        // 7. Swap output ping-pong
+        // 6. Swap output ping-pong
         m_outputTextures.swap();
-
-        wgpuBindGroupRelease(bg0);
     }
+    batch.end();
+    m_uniforms.upload(); // every substep's params in one write
 }
 
 void TermitesSim::reset() {
@@ -411,6 +375,69 @@ WGPUTexture TermitesSim::getOutputTexture() {
     return m_outputTextures.current == 0 ? m_outputTextures.texA : m_outputTextures.texB;
 }
 
+SimStateViews TermitesSim::stateViews() {
+    SimStateViews v;
+    v.agents = m_agentBuffer;
+    v.agentBytes = (uint64_t)m_agentCount * 16;
+    v.agentStride = 16;
+    cumulativeTypeRatios(m_typeWeight, v.typeRatios);
+    v.textures[0] = m_trailTextures.readView();
+    v.textures[1] = m_moundTextures.readView();
+    v.textures[2] = m_outputTextures.readView();
+    v.textureNames[0] = "trail";
+    v.textureNames[1] = "mound";
+    v.textureNames[2] = "output";
+    v.textureCount = 3;
+    v.width = params.width;
+    v.height = params.height;
+    v.step = m_frameCounter;
+    return v;
+}
+
+PresetData TermitesSim::capturePreset() const {
+    PresetData data;
+    data["agentCount"] = {(float)m_agentCount};
+    data["linkTypes"] = {m_linkTypes ? 1.0f : 0.0f};
+    data["senseAngle"]   = {m_senseAngle[0], m_senseAngle[1], m_senseAngle[2], m_senseAngle[3]};
+    data["senseDistance"] = {m_senseDistance[0], m_senseDistance[1], m_senseDistance[2], m_senseDistance[3]};
+    data["turnAngle"]    = {m_turnAngle[0], m_turnAngle[1], m_turnAngle[2], m_turnAngle[3]};
+    data["moveSpeed"]    = {m_moveSpeed[0], m_moveSpeed[1], m_moveSpeed[2], m_moveSpeed[3]};
+    data["deposit"]      = {m_deposit[0], m_deposit[1], m_deposit[2], m_deposit[3]};
+    data["depositRate"]  = {m_depositRate[0], m_depositRate[1], m_depositRate[2], m_depositRate[3]};
+    data["decayRate"]    = {m_decayRate[0], m_decayRate[1], m_decayRate[2], m_decayRate[3]};
+    data["hue"]          = {m_hue[0], m_hue[1], m_hue[2], m_hue[3]};
+    data["saturation"]   = {m_saturation[0], m_saturation[1], m_saturation[2], m_saturation[3]};
+    data["typeWeight"]   = {m_typeWeight[0], m_typeWeight[1], m_typeWeight[2], m_typeWeight[3]};
+    data["stepsPerFrame"] = {(float)m_stepsPerFrame};
+    data["renderEverySubstep"] = {m_renderEverySubstep ? 1.0f : 0.0f};
+    return data;
+}
+
+void TermitesSim::applyPreset(const PresetData& data) {
+    auto load4 = [&](const char* key, float* dst) { presetGet(data, key, dst, 4); };
+    float v = 0.0f;
+    if (presetGet(data, "agentCount", &v, 1)) {
+        m_agentCount = (uint32_t)v;
+        m_needsReset = true;
+    }
+    if (presetGet(data, "linkTypes", &v, 1))
+        m_linkTypes = v > 0.5f;
+    load4("senseAngle", m_senseAngle);
+    load4("senseDistance", m_senseDistance);
+    load4("turnAngle", m_turnAngle);
+    load4("moveSpeed", m_moveSpeed);
+    load4("deposit", m_deposit);
+    load4("depositRate", m_depositRate);
+    load4("decayRate", m_decayRate);
+    load4("hue", m_hue);
+    load4("saturation", m_saturation);
+    load4("typeWeight", m_typeWeight);
+    if (presetGet(data, "stepsPerFrame", &v, 1))
+        m_stepsPerFrame = (int)v;
+    if (presetGet(data, "renderEverySubstep", &v, 1))
+        m_renderEverySubstep = v > 0.5f;
+}
+
 void TermitesSim::onGui() {
     ImGui::Text("Termites");
     ImGui::Separator();
@@ -429,6 +456,9 @@ void TermitesSim::onGui() {
     }
 
     ImGui::SliderInt("Steps/Frame", &m_stepsPerFrame, 0, 20);
+    ImGui::Checkbox("Render Every Substep", &m_renderEverySubstep);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Colorize after every substep instead of once per frame (same fade rate)");
 
     {
         int ac = (int)m_agentCount;
@@ -476,46 +506,12 @@ void TermitesSim::onGui() {
     ImGui::InputText("Preset Name", presetName, sizeof(presetName));
 
     if (ImGui::Button("Save Preset")) {
-        std::map<std::string, std::vector<float>> data;
-        data["agentCount"] = {(float)m_agentCount};
-        data["linkTypes"] = {m_linkTypes ? 1.0f : 0.0f};
-        data["senseAngle"]   = {m_senseAngle[0], m_senseAngle[1], m_senseAngle[2], m_senseAngle[3]};
-        data["senseDistance"] = {m_senseDistance[0], m_senseDistance[1], m_senseDistance[2], m_senseDistance[3]};
-        data["turnAngle"]    = {m_turnAngle[0], m_turnAngle[1], m_turnAngle[2], m_turnAngle[3]};
-        data["moveSpeed"]    = {m_moveSpeed[0], m_moveSpeed[1], m_moveSpeed[2], m_moveSpeed[3]};
-        data["deposit"]      = {m_deposit[0], m_deposit[1], m_deposit[2], m_deposit[3]};
-        data["depositRate"]  = {m_depositRate[0], m_depositRate[1], m_depositRate[2], m_depositRate[3]};
-        data["decayRate"]    = {m_decayRate[0], m_decayRate[1], m_decayRate[2], m_decayRate[3]};
-        data["hue"]          = {m_hue[0], m_hue[1], m_hue[2], m_hue[3]};
-        data["saturation"]   = {m_saturation[0], m_saturation[1], m_saturation[2], m_saturation[3]};
-        data["typeWeight"]   = {m_typeWeight[0], m_typeWeight[1], m_typeWeight[2], m_typeWeight[3]};
-        savePreset(std::string("termites_") + presetName, data);
+        savePreset(std::string("termites_") + presetName, capturePreset());
     }
     ImGui::SameLine();
     if (ImGui::Button("Load Preset")) {
         auto data = loadPreset(std::string("termites_") + presetName);
-        if (!data.empty()) {
-            auto load4 = [&](const char* key, float* dst) {
-                auto it = data.find(key);
-                if (it != data.end()) for (size_t i = 0; i < 4 && i < it->second.size(); i++) dst[i] = it->second[i];
-            };
-            if (data.count("agentCount") && !data["agentCount"].empty()) {
-                m_agentCount = (uint32_t)data["agentCount"][0];
-                m_needsReset = true;
-            }
-            if (data.count("linkTypes") && !data["linkTypes"].empty())
-                m_linkTypes = data["linkTypes"][0] > 0.5f;
-            load4("senseAngle", m_senseAngle);
-            load4("senseDistance", m_senseDistance);
-            load4("turnAngle", m_turnAngle);
-            load4("moveSpeed", m_moveSpeed);
-            load4("deposit", m_deposit);
-            load4("depositRate", m_depositRate);
-            load4("decayRate", m_decayRate);
-            load4("hue", m_hue);
-            load4("saturation", m_saturation);
-            load4("typeWeight", m_typeWeight);
-        }
+        if (!data.empty()) applyPreset(data);
     }
 
     ImGui::Checkbox("Link All Types", &m_linkTypes);
@@ -589,21 +585,23 @@ void TermitesSim::onGui() {
 }
 
 void TermitesSim::shutdown() {
-    if (m_group1) wgpuBindGroupRelease(m_group1);
-    if (m_group0Layout) wgpuBindGroupLayoutRelease(m_group0Layout);
-    if (m_group1Layout) wgpuBindGroupLayoutRelease(m_group1Layout);
+    m_pipelines.wait(); // jobs still use the module and layout
+    releaseGroup0s();
+    if (m_group1) gpuRelease(m_group1);
+    if (m_group0Layout) gpuRelease(m_group0Layout);
+    if (m_group1Layout) gpuRelease(m_group1Layout);
     if (m_pipelineLayout) wgpuPipelineLayoutRelease(m_pipelineLayout);
 
-    if (m_resetTexturePipeline)  wgpuComputePipelineRelease(m_resetTexturePipeline);
-    if (m_resetAgentsPipeline)   wgpuComputePipelineRelease(m_resetAgentsPipeline);
-    if (m_moveAgentsPipeline)    wgpuComputePipelineRelease(m_moveAgentsPipeline);
-    if (m_decayTexturePipeline)  wgpuComputePipelineRelease(m_decayTexturePipeline);
-    if (m_writeTrailsPipeline)   wgpuComputePipelineRelease(m_writeTrailsPipeline);
-    if (m_renderPipeline)        wgpuComputePipelineRelease(m_renderPipeline);
+    if (m_resetTexturePipeline)  gpuRelease(m_resetTexturePipeline);
+    if (m_resetAgentsPipeline)   gpuRelease(m_resetAgentsPipeline);
+    if (m_moveAgentsPipeline)    gpuRelease(m_moveAgentsPipeline);
+    if (m_decayTexturePipeline)  gpuRelease(m_decayTexturePipeline);
+    if (m_writeTrailsPipeline)   gpuRelease(m_writeTrailsPipeline);
+    if (m_renderPipeline)        gpuRelease(m_renderPipeline);
 
-    if (m_shaderModule) wgpuShaderModuleRelease(m_shaderModule);
-    if (m_agentBuffer) { wgpuBufferDestroy(m_agentBuffer); wgpuBufferRelease(m_agentBuffer); }
-    if (m_uniformBuffer) { wgpuBufferDestroy(m_uniformBuffer); wgpuBufferRelease(m_uniformBuffer); }
+    gpuPool().recycle(m_agentBuffer);
+    gpuPool().recycle(m_claimBuffer);
+    m_uniforms.destroy();
 
     m_trailTextures.destroy();
     m_moundTextures.destroy();
@@ -615,6 +613,6 @@ void TermitesSim::shutdown() {
     m_resetTexturePipeline = m_resetAgentsPipeline = nullptr;
     m_moveAgentsPipeline = m_decayTexturePipeline = nullptr;
     m_writeTrailsPipeline = m_renderPipeline = nullptr;
-    m_shaderModule = nullptr;
-    m_agentBuffer = m_uniformBuffer = nullptr;
+    m_agentBuffer = nullptr;
+    m_claimBuffer = nullptr;
 }
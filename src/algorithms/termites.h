@@ -1,6 +1,7 @@
 #pragma once
 #include "../simulation.h"
 #include "../compute_pass.h"
+#include "../uniform_ring.h"
 #include <vector>
 #include <cstdint>
 
@@ -13,15 +14,23 @@ public:
     WGPUTextureView getOutputView() override;
     WGPUTexture getOutputTexture() override;
     void onGui() override;
+    void applyPreset(const PresetData& data) override;
+    PresetData capturePreset() const override;
+    SimStateViews stateViews() override;
     void shutdown() override;
+    bool ready() override { return m_pipelines.ready(); }
 
 private:
     void createPipelines();
     void createBuffers();
     void clearTextures();
     void dispatchReset(WGPUCommandEncoder encoder);
-    void uploadParams();
-    WGPUBindGroup buildGroup0();
+    uint32_t pushParams(); // returns the block's dynamic offset
+    WGPUBindGroup buildGroup0(int trail, int mound, int output);
+    void createGroup0s(); // every ping-pong permutation; rebuilt only with the textures
+    void createGroup1();  // agents + claims; rebuilt when the agent count changes
+    void releaseGroup0s();
+    WGPUBindGroup group0() const { return m_group0[m_trailTextures.current][m_moundTextures.current][m_outputTextures.current]; }
 
     WGPUDevice m_device = nullptr;
     WGPUQueue m_queue = nullptr;
@@ -30,10 +39,11 @@ private:
     PingPongTextures m_moundTextures;   // persistent deposits (no decay)
     PingPongTextures m_outputTextures;  // rgba8unorm render
 
-    WGPUBuffer m_agentBuffer = nullptr;
-    WGPUBuffer m_uniformBuffer = nullptr;
+    WGPUBuffer m_agentBuffer = nullptr; // pooled, may be larger than needed
+    uint64_t m_agentBufferSize = 0;
+    WGPUBuffer m_claimBuffer = nullptr; // 2 u32 per pixel: agents that deposit trail / mound there
+    UniformRing m_uniforms; // GpuParams, one block per substep (dynamic offset)
 
-    WGPUShaderModule m_shaderModule = nullptr;
     WGPUPipelineLayout m_pipelineLayout = nullptr;
     WGPUBindGroupLayout m_group0Layout = nullptr;
     WGPUBindGroupLayout m_group1Layout = nullptr;
@@ -44,7 +54,9 @@ private:
     WGPUComputePipeline m_decayTexturePipeline = nullptr;
     WGPUComputePipeline m_writeTrailsPipeline = nullptr;
     WGPUComputePipeline m_renderPipeline = nullptr;
+    PipelineBatch m_pipelines; // the pipelines above, until ready()
 
+    WGPUBindGroup m_group0[2][2][2] = {}; // [trail][mound][output] ping-pong state
     WGPUBindGroup m_group1 = nullptr;
 
     uint32_t m_agentCount = 100000;
@@ -52,6 +64,7 @@ private:
     int m_stepsPerFrame = 1;
     bool m_needsReset = true;
     bool m_doStep = false;
+    bool m_renderEverySubstep = false; // else render once per frame
     bool m_linkTypes = true;
 
     float m_senseAngle[4]    = {45.0f, 45.0f, 45.0f, 45.0f};
@@ -77,6 +90,7 @@ private:
         float hues[4];
         float saturations[4];
         float typeRatios[4];
+        uint32_t seedLo, seedHi, _seedPad[2];
     };
-    static_assert(sizeof(GpuParams) == 176, "GpuParams must be 176 bytes");
+    static_assert(sizeof(GpuParams) == 192, "GpuParams must be 192 bytes");
 };
@@ -1,6 +1,10 @@
 #include "compositor.h"
+#include "gpu_tracker.h"
+#include "gpu_profiler.h"
+#include "cpu_trace.h"
 #include "compute_pass.h"
 #include <imgui.h>
+#include <algorithm>
 #include <cstring>
 
 void Compositor::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h) {
@@ -9,66 +13,63 @@ void Compositor::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h
     m_width = w;
     m_height = h;
 
-    {
-        WGPUBufferDescriptor desc = {};
-        desc.size = sizeof(GpuParams);
-        desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-        desc.label = "compositor_params";
-        m_uniformBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
-    }
+    // One params block per blended layer (dynamic offset)
+    m_uniforms.init(m_device, m_queue, sizeof(GpuParams), 4, "Compositor");
 
-    createTextures();
     createPipelines();
 }
 
-void Compositor::createTextures() {
-    auto makeTex = [&](const char* label) -> WGPUTexture {
-        WGPUTextureDescriptor desc = {};
-        desc.size = { m_width, m_height, 1 };
-        desc.format = WGPUTextureFormat_RGBA8Unorm;
-        desc.usage = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopySrc;
-        desc.mipLevelCount = 1;
-        desc.sampleCount = 1;
-        desc.dimension = WGPUTextureDimension_2D;
-        desc.label = label;
-        return wgpuDeviceCreateTexture(m_device, &desc);
-    };
-
-    m_texA = makeTex("compositor_A");
-    m_texB = makeTex("compositor_B");
-    m_viewA = wgpuTextureCreateView(m_texA, nullptr);
-    m_viewB = wgpuTextureCreateView(m_texB, nullptr);
-    m_current = 0;
-}
-
-void Compositor::destroyTextures() {
-    if (m_viewA) wgpuTextureViewRelease(m_viewA);
-    if (m_viewB) wgpuTextureViewRelease(m_viewB);
-    if (m_texA) { wgpuTextureDestroy(m_texA); wgpuTextureRelease(m_texA); }
-    if (m_texB) { wgpuTextureDestroy(m_texB); wgpuTextureRelease(m_texB); }
-    m_viewA = m_viewB = nullptr;
-    m_texA = m_texB = nullptr;
-}
-
 void Compositor::resize(uint32_t w, uint32_t h) {
     if (w == m_width && h == m_height) return;
     m_width = w;
     m_height = h;
-    destroyTextures();
-    createTextures();
+    for (auto& layer : layers) {
+        if (!layer.live) continue;
+        releaseLayer(layer);
+        if (layer.enabled) initLayer(layer);
+    }
 }
 
-void Compositor::createPipelines() {
-    std::string code = loadShaderFile("shaders/compositor.wgsl");
-    if (code.empty()) return;
+void Compositor::initLayer(Layer& layer) {
+    TRACE_SCOPE("Compositor::initLayer");
+    layer.sim->init(m_device, m_queue, m_width, m_height);
+    layer.live = true;
+    layer.idleFrames = 0;
+}
 
-    WGPUShaderModuleWGSLDescriptor wgslDesc = {};
-    wgslDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
-    wgslDesc.code = code.c_str();
-    WGPUShaderModuleDescriptor smDesc = {};
-    smDesc.nextInChain = &wgslDesc.chain;
-    m_shaderModule = wgpuDeviceCreateShaderModule(m_device, &smDesc);
+void Compositor::releaseLayer(Layer& layer) {
+    TRACE_SCOPE("Compositor::releaseLayer");
+    layer.sim->shutdown();
+    layer.live = false;
+    layer.idleFrames = 0;
+}
+
+void Compositor::updateLayers() {
+    // Releasing needs the layer idle longer than any frame in flight
+    uint32_t after = releaseAfter > 0 ? std::max(releaseAfter, 8) : 0;
+    for (auto& layer : layers) {
+        if (!layer.sim) continue;
+        if (layer.enabled) {
+            if (!layer.live) initLayer(layer);
+            layer.idleFrames = 0;
+        } else if (layer.live && after > 0 && ++layer.idleFrames >= after) {
+            releaseLayer(layer);
+        }
+    }
+}
+
+bool Compositor::layersReady() {
+    for (auto& layer : layers)
+        if (layer.enabled && layer.sim && !(layer.live && layer.sim->ready())) return false;
+    return true;
+}
+
+void Compositor::releaseLayers() {
+    for (auto& layer : layers)
+        if (layer.live) releaseLayer(layer);
+}
 
+void Compositor::createPipelines() {
     // Bind group layout: uniform, layerTex(read), accumTex(read), outputTex(write)
     {
         WGPUBindGroupLayoutEntry entries[4] = {};
@@ -76,6 +77,7 @@ void Compositor::createPipelines() {
         entries[0].binding = 0;
         entries[0].visibility = WGPUShaderStage_Compute;
         entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+        entries[0].buffer.hasDynamicOffset = true;
         entries[0].buffer.minBindingSize = sizeof(GpuParams);
 
         entries[1].binding = 1;
@@ -97,106 +99,106 @@ void Compositor::createPipelines() {
         WGPUBindGroupLayoutDescriptor desc = {};
         desc.entryCount = 4;
         desc.entries = entries;
-        m_bindGroupLayout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        m_bindGroupLayout = gpuCreateBindGroupLayout(m_device, &desc, "Compositor");
     }
 
-    {
-        WGPUPipelineLayoutDescriptor desc = {};
-        desc.bindGroupLayoutCount = 1;
-        desc.bindGroupLayouts = &m_bindGroupLayout;
-        m_pipelineLayout = wgpuDeviceCreatePipelineLayout(m_device, &desc);
-    }
+    compileComputePipeline(m_device, "shaders/compositor.wgsl", "blend", m_bindGroupLayout, m_pipelines,
+                           &m_pipeline, "Compositor");
+}
 
-    WGPUComputePipelineDescriptor desc = {};
-    desc.layout = m_pipelineLayout;
-    desc.compute.module = m_shaderModule;
-    desc.compute.entryPoint = "blend";
-    m_pipeline = wgpuDeviceCreateComputePipeline(m_device, &desc);
+void Compositor::blend(WGPUCommandEncoder encoder, const char* name, WGPUTextureView layer,
+                       WGPUTextureView accum, WGPUTextureView output, uint32_t offset,
+                       uint32_t w, uint32_t h) {
+    WGPUBindGroupEntry entries[4] = {};
+    entries[0].binding = 0;
+    entries[0].buffer = m_uniforms.buffer();
+    entries[0].size = sizeof(GpuParams);
+    entries[1].binding = 1;
+    entries[1].textureView = layer;
+    entries[2].binding = 2;
+    entries[2].textureView = accum;
+    entries[3].binding = 3;
+    entries[3].textureView = output;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout = m_bindGroupLayout;
+    desc.entryCount = 4;
+    desc.entries = entries;
+    WGPUBindGroup bg = gpuCreateBindGroup(m_device, &desc, "Compositor");
+
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, name);
+    wgpuComputePassEncoderSetPipeline(pass, m_pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 1, &offset);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, (w + 7) / 8, (h + 7) / 8, 1);
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+    gpuRelease(bg);
 }
 
-void Compositor::composite(WGPUCommandEncoder encoder) {
-    uint32_t wg = (m_width + 7) / 8;
-    uint32_t hg = (m_height + 7) / 8;
-    m_current = 0;
+FrameGraph::Handle Compositor::addPasses(FrameGraph& fg) {
+    std::vector<FrameGraph::Handle> sources(layers.size(), -1);
+    for (size_t i = 0; i < layers.size(); i++) {
+        Layer& layer = layers[i];
+        if (!layer.enabled || !layer.sim || !layer.sim->ready()) continue; // still compiling: left out
+        sources[i] = fg.importTexture(layer.sim->name(), nullptr, layer.sim->getOutputView());
+    }
+    return addPasses(fg, sources, m_width, m_height);
+}
 
-    bool isFirst = true;
+FrameGraph::Handle Compositor::addPasses(FrameGraph& fg, const std::vector<FrameGraph::Handle>& sources,
+                                         uint32_t w, uint32_t h) {
+    TRACE_SCOPE("Compositor::addPasses");
+    m_pipelines.wait(); // no-op once compiled
+    FgTextureDesc texDesc;
+    texDesc.width = w;
+    texDesc.height = h;
 
-    auto buildBG = [&](WGPUTextureView layer, WGPUTextureView accum, WGPUTextureView output) -> WGPUBindGroup {
-        WGPUBindGroupEntry entries[4] = {};
-        entries[0].binding = 0;
-        entries[0].buffer = m_uniformBuffer;
-        entries[0].size = sizeof(GpuParams);
-        entries[1].binding = 1;
-        entries[1].textureView = layer;
-        entries[2].binding = 2;
-        entries[2].textureView = accum;
-        entries[3].binding = 3;
-        entries[3].textureView = output;
+    m_uniforms.reserve((uint32_t)layers.size() + 1);
+    FrameGraph::Handle accum = -1; // latest result; each blend writes a fresh transient
 
-        WGPUBindGroupDescriptor desc = {};
-        desc.layout = m_bindGroupLayout;
-        desc.entryCount = 4;
-        desc.entries = entries;
-        return wgpuDeviceCreateBindGroup(m_device, &desc);
-    };
-
-    for (auto& layer : layers) {
-        if (!layer.enabled || !layer.sim) continue;
+    for (size_t i = 0; i < layers.size() && i < sources.size(); i++) {
+        const Layer& layer = layers[i];
+        FrameGraph::Handle src = sources[i];
+        if (src < 0) continue;
 
         GpuParams gp = {};
-        gp.width = m_width;
-        gp.height = m_height;
+        gp.width = w;
+        gp.height = h;
         gp.blendMode = (uint32_t)layer.blendMode;
         gp.opacity = layer.opacity;
-        gp.isFirstLayer = isFirst ? 1 : 0;
-        wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, 0, &gp, sizeof(gp));
-
-        // Determine ping-pong: accum is current read, output is current write
-        WGPUTextureView accumView = (m_current == 0) ? m_viewA : m_viewB;
-        WGPUTextureView outView   = (m_current == 0) ? m_viewB : m_viewA;
+        gp.isFirstLayer = accum < 0 ? 1 : 0;
+        uint32_t offset = m_uniforms.push(&gp);
 
+        FrameGraph::Handle out = fg.createTexture((std::string("composite_") + layer.sim->name()).c_str(),
+                                                  texDesc);
         // For first layer, accum is unused but must be valid — use the layer itself
-        WGPUTextureView accumArg = isFirst ? layer.sim->getOutputView() : accumView;
-
-        WGPUBindGroup bg = buildBG(layer.sim->getOutputView(), accumArg, outView);
-        WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-        wgpuComputePassEncoderSetPipeline(pass, m_pipeline);
-        wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
-        wgpuComputePassEncoderDispatchWorkgroups(pass, wg, hg, 1);
-        wgpuComputePassEncoderEnd(pass);
-        wgpuComputePassEncoderRelease(pass);
-        wgpuBindGroupRelease(bg);
-
-        // Swap: output becomes the new accumulator
-        m_current = 1 - m_current;
-        isFirst = false;
+        FrameGraph::Handle acc = accum < 0 ? src : accum;
+        fg.addPass("Compositor/blend", { src, acc }, { out },
+                   [this, &fg, src, acc, out, offset, w, h](WGPUCommandEncoder encoder) {
+            blend(encoder, "Compositor/blend", fg.view(src), fg.view(acc), fg.view(out), offset, w, h);
+        });
+        accum = out;
     }
 
-    // If no layers were enabled, clear output to black
-    if (isFirst) {
+    // If no layers were enabled, clear output to black (opacity 0 over an unwritten input)
+    if (accum < 0) {
         GpuParams gp = {};
-        gp.width = m_width;
-        gp.height = m_height;
+        gp.width = w;
+        gp.height = h;
         gp.isFirstLayer = 1;
         gp.opacity = 0.0f;
-        wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, 0, &gp, sizeof(gp));
-
-        WGPUBindGroup bg = buildBG(m_viewA, m_viewA, m_viewB);
-        WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-        wgpuComputePassEncoderSetPipeline(pass, m_pipeline);
-        wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
-        wgpuComputePassEncoderDispatchWorkgroups(pass, wg, hg, 1);
-        wgpuComputePassEncoderEnd(pass);
-        wgpuComputePassEncoderRelease(pass);
-        wgpuBindGroupRelease(bg);
-        m_current = 1; // output is in B
+        uint32_t offset = m_uniforms.push(&gp);
+
+        FrameGraph::Handle src = fg.createTexture("composite_empty", texDesc);
+        FrameGraph::Handle out = fg.createTexture("composite", texDesc);
+        fg.addPass("Compositor/clear", { src }, { out },
+                   [this, &fg, src, out, offset, w, h](WGPUCommandEncoder encoder) {
+            blend(encoder, "Compositor/clear", fg.view(src), fg.view(src), fg.view(out), offset, w, h);
+        });
+        accum = out;
     }
-}
-
-WGPUTextureView Compositor::getOutputView() const {
-    // After composite(), the latest result is in the texture we just wrote to.
-    // m_current was swapped after the last write, so current read side has the result.
-    return (m_current == 0) ? m_viewA : m_viewB;
+    m_uniforms.upload();
+    return accum;
 }
 
 void Compositor::onGui() {
@@ -206,8 +208,14 @@ void Compositor::onGui() {
         auto& l = layers[i];
         ImGui::PushID(i);
 
-        ImGui::Checkbox(l.sim->name(), &l.enabled);
+        // Created right away so the sim's controls below work this frame
+        if (ImGui::Checkbox(l.sim->name(), &l.enabled) && l.enabled && !l.live) initLayer(l);
+        if (!l.live && ImGui::IsItemHovered()) ImGui::SetTooltip("Not loaded: GPU state is created when enabled");
         if (l.enabled) {
+            if (l.live && !l.sim->ready()) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("(compiling)");
+            }
             ImGui::SameLine();
             ImGui::SetNextItemWidth(80);
             int bm = (int)l.blendMode;
@@ -230,18 +238,18 @@ void Compositor::onGui() {
 
         ImGui::PopID();
     }
+
+    ImGui::SetNextItemWidth(120);
+    ImGui::DragInt("Release After", &releaseAfter, 10.0f, 0, 36000, releaseAfter > 0 ? "%d frames" : "never");
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Free a disabled layer's GPU state after this many frames (its sim restarts when re-enabled)");
 }
 
 void Compositor::shutdown() {
-    destroyTextures();
-    if (m_uniformBuffer) { wgpuBufferDestroy(m_uniformBuffer); wgpuBufferRelease(m_uniformBuffer); }
-    if (m_pipeline) wgpuComputePipelineRelease(m_pipeline);
-    if (m_bindGroupLayout) wgpuBindGroupLayoutRelease(m_bindGroupLayout);
-    if (m_pipelineLayout) wgpuPipelineLayoutRelease(m_pipelineLayout);
-    if (m_shaderModule) wgpuShaderModuleRelease(m_shaderModule);
-    m_uniformBuffer = nullptr;
+    m_pipelines.wait(); // jobs still use the layout
+    m_uniforms.destroy();
+    if (m_pipeline) gpuRelease(m_pipeline);
+    if (m_bindGroupLayout) gpuRelease(m_bindGroupLayout);
     m_pipeline = nullptr;
     m_bindGroupLayout = nullptr;
-    m_pipelineLayout = nullptr;
-    m_shaderModule = nullptr;
 }
@@ -1,6 +1,9 @@
 #pragma once
 #include <webgpu/webgpu.h>
 #include "simulation.h"
+#include "uniform_ring.h"
+#include "frame_graph.h"
+#include "pipeline_compiler.h"
 #include <vector>
 #include <string>
 #include <cstdint>
@@ -17,39 +20,51 @@ struct Layer {
     bool enabled = false;
     float opacity = 1.0f;
     BlendMode blendMode = BlendMode::Additive;
+    bool live = false;       // sim GPU state exists; created on first enable
+    uint32_t idleFrames = 0; // frames disabled while live
 };
 
 class Compositor {
 public:
     void init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h);
+    // Re-creates enabled layers' sims at the new size; disabled ones are released
     void resize(uint32_t w, uint32_t h);
-    void composite(WGPUCommandEncoder encoder);
-    WGPUTextureView getOutputView() const;
-    WGPUTexture getOutputTexture() const { return m_texA; }
+    // Creates GPU state for enabled layers that have none yet, and releases
+    // layers disabled for releaseAfter frames. Call once per frame before stepping.
+    void updateLayers();
+    void releaseLayers(); // shuts down every live sim
+    bool layersReady();   // every enabled layer is live and its pipelines are compiled
+    // False while the blend pipeline still compiles in the background; addPasses()
+    // blocks until it is done, so the app checks this first
+    bool ready() { return m_pipelines.ready(); }
+    // Adds one blend pass per enabled, compiled layer, each writing a new transient, and
+    // returns the handle holding the composite
+    FrameGraph::Handle addPasses(FrameGraph& fg);
+    // Same over given per-layer sources (-1 = left out) at w x h, e.g. layers
+    // re-rendered at the hi-res export size
+    FrameGraph::Handle addPasses(FrameGraph& fg, const std::vector<FrameGraph::Handle>& sources,
+                                 uint32_t w, uint32_t h);
     void onGui();
     void shutdown();
 
     std::vector<Layer> layers;
+    int releaseAfter = 0; // frames; 0 = keep disabled layers' GPU state (and sim state)
 
 private:
-    void createTextures();
-    void destroyTextures();
     void createPipelines();
+    void initLayer(Layer& layer);
+    void releaseLayer(Layer& layer);
+    void blend(WGPUCommandEncoder encoder, const char* name, WGPUTextureView layer,
+               WGPUTextureView accum, WGPUTextureView output, uint32_t offset, uint32_t w, uint32_t h);
 
     WGPUDevice m_device = nullptr;
     WGPUQueue m_queue = nullptr;
     uint32_t m_width = 0, m_height = 0;
 
-    // Ping-pong textures for iterative blending
-    WGPUTexture m_texA = nullptr, m_texB = nullptr;
-    WGPUTextureView m_viewA = nullptr, m_viewB = nullptr;
-    int m_current = 0; // tracks which tex has the latest result
-
-    WGPUShaderModule m_shaderModule = nullptr;
-    WGPUPipelineLayout m_pipelineLayout = nullptr;
     WGPUBindGroupLayout m_bindGroupLayout = nullptr;
     WGPUComputePipeline m_pipeline = nullptr;
-    WGPUBuffer m_uniformBuffer = nullptr;
+    PipelineBatch m_pipelines;
+    UniformRing m_uniforms; // GpuParams, one block per layer
 
     struct GpuParams {
         uint32_t width, height, blendMode;
@@ -1,9 +1,12 @@
 #include "compute_pass.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "gpu_profiler.h"
 #include <fstream>
 #include <sstream>
 #include <cstdio>
 
-void PingPongTextures::init(WGPUDevice device, uint32_t w, uint32_t h, WGPUTextureFormat format) {
+void PingPongTextures::init(uint32_t w, uint32_t h, WGPUTextureFormat format, const char* owner) {
     width = w;
     height = h;
     current = 0;
@@ -16,10 +19,11 @@ void PingPongTextures::init(WGPUDevice device, uint32_t w, uint32_t h, WGPUTextu
     desc.mipLevelCount = 1;
     desc.sampleCount = 1;
 
+    // Pooled, so re-init at a previous size (resize back, sim re-init) reuses textures
     desc.label = "pingpong_A";
-    texA = wgpuDeviceCreateTexture(device, &desc);
+    texA = gpuPool().acquireTexture(&desc, owner);
     desc.label = "pingpong_B";
-    texB = wgpuDeviceCreateTexture(device, &desc);
+    texB = gpuPool().acquireTexture(&desc, owner);
 
     WGPUTextureViewDescriptor viewDesc = {};
     viewDesc.format = format;
@@ -27,25 +31,71 @@ void PingPongTextures::init(WGPUDevice device, uint32_t w, uint32_t h, WGPUTextu
     viewDesc.mipLevelCount = 1;
     viewDesc.arrayLayerCount = 1;
 
-    viewA = wgpuTextureCreateView(texA, &viewDesc);
-    viewB = wgpuTextureCreateView(texB, &viewDesc);
+    viewA = gpuCreateTextureView(texA, &viewDesc, owner);
+    viewB = gpuCreateTextureView(texB, &viewDesc, owner);
 }
 
 void PingPongTextures::swap() { current = 1 - current; }
-WGPUTextureView PingPongTextures::readView() const { return current == 0 ? viewA : viewB; }
-WGPUTextureView PingPongTextures::writeView() const { return current == 0 ? viewB : viewA; }
+WGPUTextureView PingPongTextures::readView() const { return readView(current); }
+WGPUTextureView PingPongTextures::writeView() const { return writeView(current); }
+WGPUTextureView PingPongTextures::readView(int state) const { return state == 0 ? viewA : viewB; }
+WGPUTextureView PingPongTextures::writeView(int state) const { return state == 0 ? viewB : viewA; }
 
 void PingPongTextures::destroy() {
-    if (viewA) wgpuTextureViewRelease(viewA);
-    if (viewB) wgpuTextureViewRelease(viewB);
-    if (texA) wgpuTextureDestroy(texA);
-    if (texB) wgpuTextureDestroy(texB);
-    if (texA) wgpuTextureRelease(texA);
-    if (texB) wgpuTextureRelease(texB);
+    if (viewA) gpuRelease(viewA);
+    if (viewB) gpuRelease(viewB);
+    gpuPool().recycle(texA);
+    gpuPool().recycle(texB);
     viewA = viewB = nullptr;
     texA = texB = nullptr;
 }
 
+ComputeBatch::ComputeBatch(WGPUCommandEncoder encoder, const char* name)
+    : m_encoder(encoder), m_name(name), m_split(gpuProfiler().splitPasses) {}
+
+void ComputeBatch::setBindGroup(uint32_t index, WGPUBindGroup group,
+                                uint32_t offsetCount, const uint32_t* offsets) {
+    if (index >= MAX_GROUPS || offsetCount > MAX_OFFSETS) {
+        fprintf(stderr, "ComputeBatch: bind group %u with %u offsets out of range\n", index, offsetCount);
+        return;
+    }
+    Binding& b = m_groups[index];
+    bool same = b.group == group && b.offsetCount == offsetCount;
+    for (uint32_t i = 0; same && i < offsetCount; i++) same = b.offsets[i] == offsets[i];
+    if (same) return;
+    b.group = group;
+    b.offsetCount = offsetCount;
+    for (uint32_t i = 0; i < offsetCount; i++) b.offsets[i] = offsets[i];
+    b.dirty = true;
+}
+
+void ComputeBatch::dispatch(const char* kernel, WGPUComputePipeline pipeline, uint32_t x, uint32_t y, uint32_t z) {
+    if (m_split) end();
+    if (!m_pass) {
+        m_pass = profiledComputePass(m_encoder, m_split ? kernel : m_name);
+        m_pipeline = nullptr;
+        for (auto& b : m_groups) b.dirty = b.group != nullptr;
+    }
+    if (pipeline != m_pipeline) {
+        wgpuComputePassEncoderSetPipeline(m_pass, pipeline);
+        m_pipeline = pipeline;
+    }
+    for (uint32_t i = 0; i < MAX_GROUPS; i++) {
+        Binding& b = m_groups[i];
+        if (!b.dirty) continue;
+        wgpuComputePassEncoderSetBindGroup(m_pass, i, b.group, b.offsetCount, b.offsets);
+        b.dirty = false;
+    }
+    wgpuComputePassEncoderDispatchWorkgroups(m_pass, x, y, z);
+}
+
+void ComputeBatch::end() {
+    if (!m_pass) return;
+    wgpuComputePassEncoderEnd(m_pass);
+    wgpuComputePassEncoderRelease(m_pass);
+    m_pass = nullptr;
+}
+
 std::string loadShaderFile(const char* path) {
     std::ifstream f(path);
     if (!f.is_open()) {
@@ -58,7 +108,8 @@ std::string loadShaderFile(const char* path) {
 }
 
 WGPUComputePipeline createComputePipeline(
-    WGPUDevice device, const char* shaderPath, const char* entryPoint, WGPUBindGroupLayout layout)
+    WGPUDevice device, const char* shaderPath, const char* entryPoint, WGPUBindGroupLayout layout,
+    const char* owner)
 {
     std::string code = loadShaderFile(shaderPath);
     if (code.empty()) return nullptr;
@@ -80,14 +131,29 @@ WGPUComputePipeline createComputePipeline(
     cpDesc.layout = pipelineLayout;
     cpDesc.compute.module = module;
     cpDesc.compute.entryPoint = entryPoint;
-    WGPUComputePipeline pipeline = wgpuDeviceCreateComputePipeline(device, &cpDesc);
+    WGPUComputePipeline pipeline = gpuCreateComputePipeline(device, &cpDesc, owner);
 
     wgpuPipelineLayoutRelease(pipelineLayout);
     wgpuShaderModuleRelease(module);
     return pipeline;
 }
 
-WGPUBindGroupLayout createPingPongBindGroupLayout(WGPUDevice device, bool withUniform) {
+void compileComputePipeline(
+    WGPUDevice device, const char* shaderPath, const char* entryPoint, WGPUBindGroupLayout layout,
+    PipelineBatch& batch, WGPUComputePipeline* out, const char* owner)
+{
+    WGPUPipelineLayoutDescriptor plDesc = {};
+    plDesc.bindGroupLayoutCount = 1;
+    plDesc.bindGroupLayouts = &layout;
+    WGPUPipelineLayout pipelineLayout = wgpuDeviceCreatePipelineLayout(device, &plDesc);
+
+    // The shader is read and its module created on a worker; the batch
+    // releases both once the pipeline is compiled
+    batch.add(device, batch.shader(shaderPath), entryPoint, pipelineLayout, out, owner);
+    batch.own(pipelineLayout);
+}
+
+WGPUBindGroupLayout createPingPongBindGroupLayout(WGPUDevice device, bool withUniform, const char* owner) {
     WGPUBindGroupLayoutEntry entries[3] = {};
 
     // Binding 0: read texture (texture_2d<f32>)
@@ -117,13 +183,13 @@ WGPUBindGroupLayout createPingPongBindGroupLayout(WGPUDevice device, bool withUn
     WGPUBindGroupLayoutDescriptor desc = {};
     desc.entryCount = count;
     desc.entries = entries;
-    return wgpuDeviceCreateBindGroupLayout(device, &desc);
+    return gpuCreateBindGroupLayout(device, &desc, owner);
 }
 
 WGPUBindGroup createPingPongBindGroup(
     WGPUDevice device, WGPUBindGroupLayout layout,
     WGPUTextureView readView, WGPUTextureView writeView,
-    WGPUBuffer uniformBuffer, uint64_t uniformSize)
+    WGPUBuffer uniformBuffer, uint64_t uniformSize, const char* owner)
 {
     WGPUBindGroupEntry entries[3] = {};
 
@@ -145,5 +211,5 @@ WGPUBindGroup createPingPongBindGroup(
     desc.layout = layout;
     desc.entryCount = count;
     desc.entries = entries;
-    return wgpuDeviceCreateBindGroup(device, &desc);
+    return gpuCreateBindGroup(device, &desc, owner);
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <webgpu/webgpu.h>
+#include "pipeline_compiler.h"
 #include <string>
 
 // Manages a pair of ping-pong storage textures for compute shaders
@@ -12,26 +13,81 @@ struct PingPongTextures {
     uint32_t height = 0;
     int current = 0; // 0 = A is read, B is write; 1 = swapped
 
-    void init(WGPUDevice device, uint32_t w, uint32_t h,
-              WGPUTextureFormat format = WGPUTextureFormat_RGBA8Unorm);
+    void init(uint32_t w, uint32_t h,
+              WGPUTextureFormat format = WGPUTextureFormat_RGBA8Unorm,
+              const char* owner = "PingPong"); // owner: GpuTracker subsystem
     void swap();
     WGPUTextureView readView() const;
     WGPUTextureView writeView() const;
+    // Views for a given value of current (for bind groups built ahead of time)
+    WGPUTextureView readView(int state) const;
+    WGPUTextureView writeView(int state) const;
     void destroy();
 };
 
+// Records consecutive dispatches into one compute pass instead of one pass
+// per kernel; WebGPU still orders and synchronizes dispatches within a pass.
+// end() closes the pass (e.g. before a texture copy) and the next dispatch
+// opens a new one. Bind groups and the pipeline are only re-set when they
+// change. With gpuProfiler().splitPasses every dispatch gets its own pass
+// named after its kernel, for per-kernel GPU times.
+class ComputeBatch {
+public:
+    static constexpr uint32_t MAX_GROUPS = 4;
+    static constexpr uint32_t MAX_OFFSETS = 2;
+
+    ComputeBatch(WGPUCommandEncoder encoder, const char* name); // name: "<Owner>/<batch>"
+    ~ComputeBatch() { end(); }
+    ComputeBatch(const ComputeBatch&) = delete;
+    ComputeBatch& operator=(const ComputeBatch&) = delete;
+
+    // Sticky: stays bound for following dispatches, across end()
+    void setBindGroup(uint32_t index, WGPUBindGroup group,
+                      uint32_t offsetCount = 0, const uint32_t* offsets = nullptr);
+    // kernel is the full "<Owner>/<kernel>" name used in split mode
+    void dispatch(const char* kernel, WGPUComputePipeline pipeline, uint32_t x, uint32_t y = 1, uint32_t z = 1);
+    void end();
+
+private:
+    struct Binding {
+        WGPUBindGroup group = nullptr;
+        uint32_t offsetCount = 0;
+        uint32_t offsets[MAX_OFFSETS] = {};
+        bool dirty = false;
+    };
+
+    WGPUCommandEncoder m_encoder;
+    const char* m_name;
+    bool m_split;
+    WGPUComputePassEncoder m_pass = nullptr;
+    WGPUComputePipeline m_pipeline = nullptr;
+    Binding m_groups[MAX_GROUPS];
+};
+
 // Helper to create a compute pipeline from WGSL shader file
 WGPUComputePipeline createComputePipeline(
     WGPUDevice device,
     const char* shaderPath,
     const char* entryPoint,
-    WGPUBindGroupLayout layout);
+    WGPUBindGroupLayout layout,
+    const char* owner = "Pipelines");
+
+// Async variant: queues the pipeline on batch, which sets *out when compiled
+void compileComputePipeline(
+    WGPUDevice device,
+    const char* shaderPath,
+    const char* entryPoint,
+    WGPUBindGroupLayout layout,
+    PipelineBatch& batch,
+    WGPUComputePipeline* out,
+    const char* owner = "Pipelines");
 
 // Helper to load shader file as string
 std::string loadShaderFile(const char* path);
 
 // Helper to create a bind group layout for ping-pong compute
-WGPUBindGroupLayout createPingPongBindGroupLayout(WGPUDevice device, bool withUniform = true);
+WGPUBindGroupLayout createPingPongBindGroupLayout(WGPUDevice device, bool withUniform = true,
+                                                  const char* owner = "PingPong");
 
 // Create bind group for ping-pong textures + optional uniform buffer
 WGPUBindGroup createPingPongBindGroup(
@@ -40,4 +96,5 @@ WGPUBindGroup createPingPongBindGroup(
     WGPUTextureView readView,
     WGPUTextureView writeView,
     WGPUBuffer uniformBuffer = nullptr,
-    uint64_t uniformSize = 0);
+    uint64_t uniformSize = 0,
+    const char* owner = "PingPong");
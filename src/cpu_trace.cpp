@@ -0,0 +1,152 @@
+#include "cpu_trace.h"
+#include <cstdio>
+
+#if NATURE_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    unsigned long long startNs, durNs;
+};
+
+struct ThreadBuffer {
+    static constexpr size_t CAPACITY = 1 << 16; // events per thread
+
+    std::mutex mutex; // only contended while dumping
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(CAPACITY);
+    size_t head = 0;  // next write position
+    size_t count = 0;
+    unsigned tid = 0;
+    std::string name;
+};
+
+std::atomic<bool> g_enabled{true};
+std::mutex g_buffersMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> g_buffers; // outlive their threads
+const auto g_epoch = std::chrono::steady_clock::now();
+
+unsigned long long nowNs() {
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+ThreadBuffer& threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto b = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        b->tid = (unsigned)g_buffers.size() + 1;
+        b->name = "thread " + std::to_string(b->tid);
+        g_buffers.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+void writeEscaped(FILE* f, const char* s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+}
+
+void record(const char* name, unsigned long long startNs) {
+    unsigned long long end = nowNs();
+    ThreadBuffer& b = threadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.events[b.head] = { name, startNs, end - startNs };
+    b.head = (b.head + 1) % ThreadBuffer::CAPACITY;
+    if (b.count < ThreadBuffer::CAPACITY) b.count++;
+}
+
+// Open TRACE_BEGIN spans on this thread (name null when disabled at begin)
+thread_local std::vector<TraceEvent> t_openSpans;
+
+} // namespace
+
+TraceScope::TraceScope(const char* n) : name(n), startNs(0) {
+    if (g_enabled.load(std::memory_order_relaxed)) startNs = nowNs();
+    else name = nullptr;
+}
+
+TraceScope::~TraceScope() {
+    if (name) record(name, startNs);
+}
+
+void traceBegin(const char* name) {
+    bool on = g_enabled.load(std::memory_order_relaxed);
+    t_openSpans.push_back({ on ? name : nullptr, on ? nowNs() : 0, 0 });
+}
+
+void traceEnd() {
+    if (t_openSpans.empty()) return;
+    TraceEvent e = t_openSpans.back();
+    t_openSpans.pop_back();
+    if (e.name) record(e.name, e.startNs);
+}
+
+void traceSetEnabled(bool enabled) { g_enabled = enabled; }
+bool traceEnabled() { return g_enabled; }
+
+void traceSetThreadName(const char* name) {
+    ThreadBuffer& b = threadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.name = name;
+}
+
+bool traceDump(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) { fprintf(stderr, "Failed to open trace file: %s\n", path.c_str()); return false; }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(g_buffersMutex);
+        buffers = g_buffers;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    size_t total = 0;
+    for (auto& b : buffers) {
+        std::lock_guard<std::mutex> lock(b->mutex);
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                first ? "" : ",\n", b->tid);
+        writeEscaped(f, b->name.c_str());
+        fprintf(f, "\"}}");
+        first = false;
+
+        // Oldest first
+        size_t start = (b->head + ThreadBuffer::CAPACITY - b->count) % ThreadBuffer::CAPACITY;
+        for (size_t i = 0; i < b->count; i++) {
+            const TraceEvent& e = b->events[(start + i) % ThreadBuffer::CAPACITY];
+            fprintf(f, ",\n{\"name\":\"");
+            writeEscaped(f, e.name);
+            fprintf(f, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    b->tid, e.startNs / 1000.0, e.durNs / 1000.0);
+        }
+        total += b->count;
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    printf("Trace: %zu events -> %s\n", total, path.c_str());
+    return true;
+}
+
+#else
+
+void traceSetEnabled(bool) {}
+bool traceEnabled() { return false; }
+void traceSetThreadName(const char*) {}
+
+bool traceDump(const std::string& path) {
+    fprintf(stderr, "CPU tracing compiled out (NATURE_TRACE=OFF), not writing %s\n", path.c_str());
+    return false;
+}
+
+#endif
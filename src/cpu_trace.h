@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+
+// Lightweight CPU scope timers. Each thread records into its own ring buffer
+// (oldest events are overwritten); traceDump() writes everything currently
+// buffered as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+//   void Foo::step() {
+//       TRACE_SCOPE("Foo::step");
+//       ...
+//   }
+//
+// TRACE_BEGIN/TRACE_END mark a span that doesn't fit a C++ scope (must nest).
+//
+// Build with -DNATURE_TRACE=OFF to compile the scopes out entirely.
+
+void traceSetEnabled(bool enabled);
+bool traceEnabled();
+void traceSetThreadName(const char* name);
+bool traceDump(const std::string& path);
+
+#if NATURE_TRACE
+
+struct TraceScope {
+    explicit TraceScope(const char* name); // name must be a string literal
+    ~TraceScope();
+    const char* name;
+    unsigned long long startNs;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+void traceBegin(const char* name);
+void traceEnd();
+#define TRACE_BEGIN(name) traceBegin(name)
+#define TRACE_END() traceEnd()
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END() ((void)0)
+
+#endif
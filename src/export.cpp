@@ -1,22 +1,27 @@
 #include "export.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "cpu_trace.h"
 #include <webgpu/wgpu.h>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
+#include <chrono>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
-bool exportTextureToPNG(WGPUDevice device, WGPUQueue queue,
-                        WGPUTexture texture, uint32_t width, uint32_t height,
-                        const std::string& filename)
+bool readbackTexture(WGPUDevice device, WGPUQueue queue,
+                     WGPUTexture texture, uint32_t width, uint32_t height,
+                     std::vector<uint8_t>& pixels)
 {
+    TRACE_SCOPE("readbackTexture");
     uint32_t bytesPerRow = ((width * 4 + 255) / 256) * 256; // 256-byte aligned
-    uint64_t bufferSize = bytesPerRow * height;
+    uint64_t bufferSize = (uint64_t)bytesPerRow * height;
 
-    WGPUBufferDescriptor bufDesc = {};
-    bufDesc.size = bufferSize;
-    bufDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
-    WGPUBuffer readbackBuf = wgpuDeviceCreateBuffer(device, &bufDesc);
+    // Pooled: sequence frames and exports reuse the same staging buffer
+    WGPUBuffer readbackBuf = gpuPool().acquireBuffer(bufferSize, WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
+                                                     "readback", "Export");
 
     WGPUCommandEncoderDescriptor encDesc = {};
     WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(device, &encDesc);
@@ -48,35 +53,59 @@ bool exportTextureToPNG(WGPUDevice device, WGPUQueue queue,
             data->done = true;
         }, &mapData);
 
-    while (!mapData.done) {
-        wgpuDevicePoll(device, true, nullptr);
+    {
+        TRACE_SCOPE("readback wait");
+        while (!mapData.done) {
+            wgpuDevicePoll(device, true, nullptr);
+        }
     }
 
     bool ok = false;
     if (mapData.status == WGPUBufferMapAsyncStatus_Success) {
         const uint8_t* mapped = (const uint8_t*)wgpuBufferGetConstMappedRange(readbackBuf, 0, bufferSize);
 
-        std::vector<uint8_t> pixels(width * height * 4);
+        // Strip row padding
+        pixels.resize((size_t)width * height * 4);
         for (uint32_t y = 0; y < height; y++) {
-            memcpy(&pixels[y * width * 4], &mapped[y * bytesPerRow], width * 4);
+            memcpy(&pixels[(size_t)y * width * 4], &mapped[(size_t)y * bytesPerRow], width * 4);
         }
         wgpuBufferUnmap(readbackBuf);
-
-        ok = stbi_write_png(filename.c_str(), width, height, 4, pixels.data(), width * 4) != 0;
-        if (ok) printf("Exported: %s\n", filename.c_str());
-        else fprintf(stderr, "Failed to write PNG: %s\n", filename.c_str());
+        ok = true;
+    } else {
+        fprintf(stderr, "Readback map failed (status %d)\n", (int)mapData.status);
     }
 
-    wgpuBufferRelease(readbackBuf);
+    gpuPool().recycle(readbackBuf);
+    return ok;
+}
+
+bool exportTextureToPNG(WGPUDevice device, WGPUQueue queue,
+                        WGPUTexture texture, uint32_t width, uint32_t height,
+                        const std::string& filename)
+{
+    TRACE_SCOPE("exportTextureToPNG");
+    std::vector<uint8_t> pixels;
+    if (!readbackTexture(device, queue, texture, width, height, pixels)) return false;
+
+    TRACE_SCOPE("stbi_write_png");
+    bool ok = stbi_write_png(filename.c_str(), width, height, 4, pixels.data(), width * 4) != 0;
+    if (ok) printf("Exported: %s\n", filename.c_str());
+    else fprintf(stderr, "Failed to write PNG: %s\n", filename.c_str());
     return ok;
 }
 
 // --- AsyncExporter ---
 
-void AsyncExporter::start() {
+void AsyncExporter::start(int threads) {
     if (m_running) return;
+    if (threads <= 0) threads = std::clamp((int)std::thread::hardware_concurrency() / 2, 1, 8);
     m_running = true;
-    m_thread = std::thread(&AsyncExporter::workerLoop, this);
+    m_stride = 1;
+    m_dropped = 0;
+    m_fps = 0.0f;
+    m_windowWritten = 0;
+    m_windowStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; i++) m_threads.emplace_back(&AsyncExporter::workerLoop, this, i);
 }
 
 void AsyncExporter::stop() {
@@ -84,21 +113,118 @@ void AsyncExporter::stop() {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_running = false;
     }
-    m_cv.notify_one();
-    if (m_thread.joinable()) m_thread.join();
+    m_cv.notify_all();
+    for (auto& t : m_threads) t.join();
+    m_threads.clear();
 }
 
-void AsyncExporter::enqueue(std::vector<uint8_t>&& pixels, uint32_t w, uint32_t h,
-                             const std::string& filename) {
+bool AsyncExporter::admit(uint64_t bytes) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto fits = [&] { return m_queuedBytes + bytes <= maxQueuedBytes || m_pending == 0; };
+
+    if (policy == Policy::LowerRate) {
+        int stride = m_stride;
+        if (!fits()) stride = std::min(stride * 2, 64);
+        else if (m_queuedBytes * 2 < maxQueuedBytes) stride = std::max(stride / 2, 1);
+        m_stride = stride;
+    }
+    if (!fits()) {
+        if (policy == Policy::Drop) {
+            m_dropped++;
+            return false;
+        }
+        TRACE_SCOPE("AsyncExporter wait for room");
+        m_roomCv.wait(lock, fits);
+    }
+    m_queuedBytes += bytes;
+    m_pending++;
+    return true;
+}
+
+void AsyncExporter::push(std::vector<uint8_t>&& pixels, uint32_t w, uint32_t h, const std::string& filename) {
+    Job job;
+    job.bytes = pixels.size();
+    job.pixels = std::move(pixels);
+    job.width = w;
+    job.height = h;
+    job.filename = filename;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_jobs.push({std::move(pixels), w, h, filename});
-        m_pending++;
+        job.seq = m_nextSeq++;
+        m_jobs.push(std::move(job));
     }
     m_cv.notify_one();
 }
 
-void AsyncExporter::workerLoop() {
+bool AsyncExporter::enqueue(std::vector<uint8_t>&& pixels, uint32_t w, uint32_t h,
+                             const std::string& filename) {
+    if (!admit(pixels.size())) return false;
+    push(std::move(pixels), w, h, filename);
+    return true;
+}
+
+bool AsyncExporter::enqueue(const uint8_t* data, uint32_t w, uint32_t h, uint32_t stride,
+                             const std::string& filename, std::function<void()> done) {
+    size_t rowBytes = (size_t)w * 4;
+    bool admitted = admit((uint64_t)rowBytes * h);
+    std::vector<uint8_t> pixels;
+    if (admitted) {
+        TRACE_SCOPE("AsyncExporter copy");
+        pixels.resize(rowBytes * h);
+        for (uint32_t y = 0; y < h; y++) memcpy(&pixels[y * rowBytes], data + (size_t)y * stride, rowBytes);
+    }
+    if (done) done();
+    if (!admitted) return false;
+    push(std::move(pixels), w, h, filename);
+    return true;
+}
+
+float AsyncExporter::framesPerSecond() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    auto now = std::chrono::steady_clock::now();
+    float secs = std::chrono::duration<float>(now - m_windowStart).count();
+    if (secs >= 1.0f) {
+        m_fps = m_windowWritten / secs;
+        m_windowWritten = 0;
+        m_windowStart = now;
+    }
+    return m_fps;
+}
+
+void AsyncExporter::write(uint64_t seq, unsigned char* png, int len, std::string filename, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    Encoded& e = m_encoded[seq];
+    e.png = png;
+    e.len = len;
+    e.filename = std::move(filename);
+    e.bytes = bytes;
+
+    // Whoever finishes the next frame in order writes it and every finished successor
+    while (!m_encoded.empty() && m_encoded.begin()->first == m_nextWrite) {
+        Encoded& next = m_encoded.begin()->second;
+        TRACE_SCOPE("AsyncExporter::write");
+        FILE* f = next.png ? fopen(next.filename.c_str(), "wb") : nullptr;
+        bool ok = f && fwrite(next.png, 1, next.len, f) == (size_t)next.len;
+        if (f && fclose(f) != 0) ok = false;
+        if (ok) printf("Exported: %s\n", next.filename.c_str());
+        else fprintf(stderr, "Failed to write PNG: %s\n", next.filename.c_str());
+        if (next.png) STBIW_FREE(next.png);
+
+        {
+            std::lock_guard<std::mutex> qlock(m_mutex);
+            m_queuedBytes -= next.bytes;
+            m_pending--;
+        }
+        m_roomCv.notify_all();
+        m_windowWritten++;
+        m_encoded.erase(m_encoded.begin());
+        m_nextWrite++;
+    }
+}
+
+void AsyncExporter::workerLoop(int index) {
+    std::string name = "AsyncExporter " + std::to_string(index);
+    traceSetThreadName(name.c_str());
     while (true) {
         Job job;
         {
@@ -109,10 +235,171 @@ void AsyncExporter::workerLoop() {
             m_jobs.pop();
         }
 
-        bool ok = stbi_write_png(job.filename.c_str(), job.width, job.height, 4,
-                                  job.pixels.data(), job.width * 4) != 0;
-        if (ok) printf("Exported: %s\n", job.filename.c_str());
-        else fprintf(stderr, "Failed to write PNG: %s\n", job.filename.c_str());
-        m_pending--;
+        int len = 0;
+        unsigned char* png = nullptr;
+        {
+            TRACE_SCOPE("AsyncExporter::encode");
+            png = stbi_write_png_to_mem(job.pixels.data(), (int)job.width * 4, (int)job.width,
+                                        (int)job.height, 4, &len);
+        }
+        job.pixels.clear();
+        job.pixels.shrink_to_fit();
+        write(job.seq, png, len, std::move(job.filename), job.bytes);
     }
 }
+
+// --- ReadbackRing ---
+
+void ReadbackRing::init(WGPUDevice device, FrameSink* sink, uint32_t slotCount) {
+    m_device = device;
+    m_sink = sink;
+    m_slots.clear();
+    for (uint32_t i = 0; i < slotCount; i++) m_slots.push_back(std::make_unique<Slot>());
+}
+
+void ReadbackRing::setSlotCount(uint32_t slotCount) {
+    flush();
+    slotCount = std::max(slotCount, 1u);
+    while (m_slots.size() > slotCount) {
+        Slot& s = *m_slots.back();
+        if (s.buffer) { wgpuBufferDestroy(s.buffer); gpuRelease(s.buffer); }
+        m_slots.pop_back();
+    }
+    while (m_slots.size() < slotCount) m_slots.push_back(std::make_unique<Slot>());
+}
+
+ReadbackRing::Slot* ReadbackRing::freeSlot() {
+    for (auto& s : m_slots)
+        if (s->state == SlotState::Free) return s.get();
+    return nullptr;
+}
+
+ReadbackRing::Slot* ReadbackRing::acquire(uint64_t size) {
+    TRACE_SCOPE("ReadbackRing::acquire");
+    Slot* slot = freeSlot();
+    if (!slot) {
+        // The sink (or the GPU) fell N frames behind: wait for the oldest slot
+        TRACE_SCOPE("readback ring full");
+        while (!(slot = freeSlot())) {
+            wgpuDevicePoll(m_device, true, nullptr);
+            poll();
+            if (!freeSlot()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    if (slot->size != size) {
+        // First use, or the resolution changed while recording
+        if (slot->buffer) { wgpuBufferDestroy(slot->buffer); gpuRelease(slot->buffer); }
+        WGPUBufferDescriptor desc = {};
+        desc.size = size;
+        desc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
+        desc.label = "readback ring";
+        slot->buffer = gpuCreateBuffer(m_device, &desc, "Export");
+        slot->size = size;
+    }
+    slot->seq = m_nextSeq++;
+    slot->written = false;
+    slot->state = SlotState::Encoded;
+    return slot;
+}
+
+void ReadbackRing::encode(WGPUCommandEncoder encoder, WGPUTexture texture, uint32_t width, uint32_t height,
+                          const std::string& filename) {
+    uint32_t bytesPerRow = ((width * 4 + 255) / 256) * 256; // 256-byte aligned
+    Slot* slot = acquire((uint64_t)bytesPerRow * height);
+    slot->width = width;
+    slot->height = height;
+    slot->bytesPerRow = bytesPerRow;
+    slot->filename = filename;
+
+    WGPUImageCopyTexture src = {};
+    src.texture = texture;
+
+    WGPUImageCopyBuffer dst = {};
+    dst.buffer = slot->buffer;
+    dst.layout.bytesPerRow = bytesPerRow;
+    dst.layout.rowsPerImage = height;
+
+    WGPUExtent3D extent = { width, height, 1 };
+    wgpuCommandEncoderCopyTextureToBuffer(encoder, &src, &dst, &extent);
+}
+
+void ReadbackRing::encode(WGPUCommandEncoder encoder, WGPUBuffer buffer, uint64_t size,
+                          uint32_t width, uint32_t height, uint32_t stride, const std::string& filename) {
+    Slot* slot = acquire(size);
+    slot->width = width;
+    slot->height = height;
+    slot->bytesPerRow = stride;
+    slot->filename = filename;
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, buffer, 0, slot->buffer, 0, size);
+}
+
+void ReadbackRing::afterSubmit() {
+    for (auto& s : m_slots) {
+        if (s->state != SlotState::Encoded) continue;
+        s->state = SlotState::Pending;
+        wgpuBufferMapAsync(s->buffer, WGPUMapMode_Read, 0, s->size,
+            [](WGPUBufferMapAsyncStatus status, void* ud) {
+                auto* slot = (Slot*)ud;
+                slot->state = (status == WGPUBufferMapAsyncStatus_Success) ? SlotState::Mapped : SlotState::Failed;
+            }, s.get());
+    }
+}
+
+void ReadbackRing::poll() {
+    if (!m_device) return;
+    wgpuDevicePoll(m_device, false, nullptr);
+
+    for (auto& s : m_slots) {
+        if (s->state == SlotState::Exporting && s->written) {
+            wgpuBufferUnmap(s->buffer);
+            s->state = SlotState::Free;
+        }
+    }
+
+    // Hand off in capture order so the sink gets frames in sequence
+    while (true) {
+        Slot* next = nullptr;
+        for (auto& s : m_slots)
+            if (s->seq == m_nextExport && (s->state == SlotState::Mapped || s->state == SlotState::Failed))
+                next = s.get();
+        if (!next) break;
+        m_nextExport++;
+
+        if (next->state == SlotState::Failed) {
+            fprintf(stderr, "Readback map failed, dropped %s\n", next->filename.c_str());
+            next->state = SlotState::Free;
+            continue;
+        }
+        next->state = SlotState::Exporting;
+        const uint8_t* mapped = (const uint8_t*)wgpuBufferGetConstMappedRange(next->buffer, 0, next->size);
+        m_sink->enqueue(mapped, next->width, next->height, next->bytesPerRow, next->filename,
+                            [next] { next->written = true; });
+    }
+}
+
+void ReadbackRing::flush() {
+    if (!m_device) return;
+    TRACE_SCOPE("ReadbackRing::flush");
+    while (inFlight() > 0) {
+        wgpuDevicePoll(m_device, true, nullptr);
+        poll();
+        if (inFlight() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+int ReadbackRing::inFlight() const {
+    int n = 0;
+    for (auto& s : m_slots)
+        if (s->state != SlotState::Free) n++;
+    return n;
+}
+
+void ReadbackRing::shutdown() {
+    flush();
+    for (auto& s : m_slots)
+        if (s->buffer) { wgpuBufferDestroy(s->buffer); gpuRelease(s->buffer); }
+    m_slots.clear();
+    m_device = nullptr;
+    m_sink = nullptr;
+}
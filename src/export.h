@@ -7,37 +7,153 @@
 #include <condition_variable>
 #include <queue>
 #include <atomic>
+#include <chrono>
+#include <map>
+#include <functional>
+#include <memory>
+
+// Synchronous texture readback into tightly packed RGBA8 rows
+bool readbackTexture(WGPUDevice device, WGPUQueue queue,
+                     WGPUTexture texture, uint32_t width, uint32_t height,
+                     std::vector<uint8_t>& pixels);
 
 // Synchronous single-frame export
 bool exportTextureToPNG(WGPUDevice device, WGPUQueue queue,
                         WGPUTexture texture, uint32_t width, uint32_t height,
                         const std::string& filename);
 
-// Async exporter for sequence recording — PNG encoding happens on a worker thread
-class AsyncExporter {
+// Receives the frames a ReadbackRing maps, straight from the staging memory
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+    // data stays valid until done() is called (on any thread); false if the frame was dropped
+    virtual bool enqueue(const uint8_t* data, uint32_t w, uint32_t h, uint32_t stride,
+                         const std::string& filename, std::function<void()> done) = 0;
+};
+
+// Async exporter for sequence recording: a pool of encoder threads compresses
+// frames in parallel, and finished PNGs are written to disk in enqueue order.
+// Every queued frame is owned by the exporter, so queued frames are capped at
+// maxQueuedBytes whatever their source; what happens to a frame that doesn't
+// fit is the policy:
+//   Block     - enqueue() waits for room (the frame stalls, nothing is lost)
+//   Drop      - the frame is skipped (gaps in the numbering)
+//   LowerRate - captureStride() doubles while over the cap and halves again
+//               below half of it; callers capture every captureStride()-th
+//               frame. Falls back to Block if the queue is still full.
+class AsyncExporter : public FrameSink {
 public:
-    void start();
+    enum class Policy { Block, Drop, LowerRate };
+
+    void start(int threads = 0); // 0: half the hardware threads, 1..8
     void stop(); // blocks until queue is drained
 
-    // Enqueue pixel data for PNG encoding on worker thread
-    void enqueue(std::vector<uint8_t>&& pixels, uint32_t w, uint32_t h,
+    // Enqueue pixel data for PNG encoding on worker thread; false if dropped
+    bool enqueue(std::vector<uint8_t>&& pixels, uint32_t w, uint32_t h,
                  const std::string& filename);
+    // Copies the rows out of memory owned by the caller (e.g. a mapped staging
+    // buffer with padded rows) once the policy admits the frame, then calls
+    // done() before returning, so the caller's buffer is free again while the
+    // frame waits for an encoder
+    bool enqueue(const uint8_t* data, uint32_t w, uint32_t h, uint32_t stride,
+                 const std::string& filename, std::function<void()> done) override;
+
+    int pending() const { return m_pending.load(); } // queued, encoding or waiting to be written
+    uint64_t queuedBytes() const { return m_queuedBytes.load(); }
+    int dropped() const { return m_dropped.load(); }
+    int captureStride() const { return m_stride.load(); }
+    int threadCount() const { return (int)m_threads.size(); }
+    float framesPerSecond(); // files written, averaged over the last second or so
 
-    int pending() const { return m_pending.load(); }
+    Policy policy = Policy::Block;
+    uint64_t maxQueuedBytes = 512ull << 20;
 
 private:
-    void workerLoop();
+    void workerLoop(int index);
+    bool admit(uint64_t bytes); // applies the policy; true with the bytes reserved
+    void push(std::vector<uint8_t>&& pixels, uint32_t w, uint32_t h, const std::string& filename);
+    void write(uint64_t seq, unsigned char* png, int len, std::string filename, uint64_t bytes);
 
     struct Job {
-        std::vector<uint8_t> pixels;
-        uint32_t width, height;
+        std::vector<uint8_t> pixels; // tightly packed rows
+        uint32_t width = 0, height = 0;
         std::string filename;
+        uint64_t seq = 0;
+        uint64_t bytes = 0; // counted against maxQueuedBytes until written
+    };
+    struct Encoded {
+        unsigned char* png = nullptr; // stb allocation
+        int len = 0;
+        std::string filename;
+        uint64_t bytes = 0;
     };
 
-    std::thread m_thread;
+    std::vector<std::thread> m_threads;
     std::mutex m_mutex;
-    std::condition_variable m_cv;
+    std::condition_variable m_cv;      // workers: job queued or stopping
+    std::condition_variable m_roomCv;  // Block policy: bytes freed
     std::queue<Job> m_jobs;
-    std::atomic<bool> m_running{false};
+    uint64_t m_nextSeq = 0;
+    bool m_running = false;
+
+    // In-order writing: encoded frames wait here until their predecessors are on disk
+    std::mutex m_writeMutex;
+    std::map<uint64_t, Encoded> m_encoded;
+    uint64_t m_nextWrite = 0;
+    int m_windowWritten = 0;
+    std::chrono::steady_clock::time_point m_windowStart;
+    float m_fps = 0.0f;
+
     std::atomic<int> m_pending{0};
+    std::atomic<uint64_t> m_queuedBytes{0};
+    std::atomic<int> m_dropped{0};
+    std::atomic<int> m_stride{1};
+};
+
+// Sequence-recording readback without stalling the frame: the copy of each
+// captured frame is recorded into the frame's own encoder, targeting one of N
+// persistent staging buffers, and mapped asynchronously. A few frames later
+// the mapped buffer is handed to the sink (AsyncExporter, VideoWriter) as is,
+// and the slot is unmapped for reuse once the sink is done with it. Only when
+// every slot is still in flight does encode() wait.
+//
+// Per captured frame: encode() -> submit -> afterSubmit(); poll() each frame.
+class ReadbackRing {
+public:
+    void init(WGPUDevice device, FrameSink* sink, uint32_t slotCount = 4);
+    void shutdown(); // flush(), then destroys the staging buffers
+    void setSink(FrameSink* sink) { m_sink = sink; } // only between flush() and the next encode()
+    void setSlotCount(uint32_t slotCount); // likewise; e.g. one per encoder thread + GPU latency
+
+    // Copies a texture (rows padded to 256 bytes) or a prepared buffer (e.g. YUV planes)
+    void encode(WGPUCommandEncoder encoder, WGPUTexture texture, uint32_t width, uint32_t height,
+                const std::string& filename);
+    void encode(WGPUCommandEncoder encoder, WGPUBuffer buffer, uint64_t size,
+                uint32_t width, uint32_t height, uint32_t stride, const std::string& filename);
+    void afterSubmit();
+    void poll();  // hands mapped frames to the sink, in capture order
+    void flush(); // blocks until every captured frame reached the sink and was consumed
+
+    int inFlight() const; // captured frames not yet written
+
+private:
+    enum class SlotState { Free, Encoded, Pending, Mapped, Exporting, Failed };
+    struct Slot {
+        WGPUBuffer buffer = nullptr;
+        uint64_t size = 0;
+        uint32_t width = 0, height = 0, bytesPerRow = 0;
+        std::string filename;
+        uint64_t seq = 0;
+        SlotState state = SlotState::Free;
+        std::atomic<bool> written{false}; // set on the sink's thread
+    };
+
+    Slot* freeSlot();
+    Slot* acquire(uint64_t size); // waits for a free slot, sized for size bytes
+
+    WGPUDevice m_device = nullptr;
+    FrameSink* m_sink = nullptr;
+    std::vector<std::unique_ptr<Slot>> m_slots;
+    uint64_t m_nextSeq = 0;
+    uint64_t m_nextExport = 0; // seq of the next frame the sink gets
 };
@@ -0,0 +1,187 @@
+#include "frame_graph.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "cpu_trace.h"
+#include <imgui.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+
+void FrameGraph::init(WGPUDevice device) {
+    m_device = device;
+    m_executions = 0;
+}
+
+void FrameGraph::reset() {
+    m_resources.clear();
+    m_passes.clear();
+}
+
+FrameGraph::Handle FrameGraph::importTexture(const char* name, WGPUTexture texture, WGPUTextureView view) {
+    Resource r;
+    r.name = name;
+    r.imported = true;
+    r.texture = texture;
+    r.view = view;
+    m_resources.push_back(r);
+    return (Handle)m_resources.size() - 1;
+}
+
+FrameGraph::Handle FrameGraph::createTexture(const char* name, const FgTextureDesc& desc) {
+    Resource r;
+    r.name = name;
+    r.desc = desc;
+    m_resources.push_back(r);
+    return (Handle)m_resources.size() - 1;
+}
+
+void FrameGraph::addPass(const char* name, std::vector<Handle> reads, std::vector<Handle> writes, Execute fn) {
+    Pass p;
+    p.name = name;
+    p.reads = std::move(reads);
+    p.writes = std::move(writes);
+    p.fn = std::move(fn);
+    m_passes.push_back(std::move(p));
+}
+
+void FrameGraph::markOutput(Handle h) {
+    if (h >= 0 && h < (Handle)m_resources.size()) m_resources[h].output = true;
+}
+
+WGPUTextureView FrameGraph::view(Handle h) const {
+    return (h >= 0 && h < (Handle)m_resources.size()) ? m_resources[h].view : nullptr;
+}
+
+WGPUTexture FrameGraph::texture(Handle h) const {
+    return (h >= 0 && h < (Handle)m_resources.size()) ? m_resources[h].texture : nullptr;
+}
+
+// Walk back from the outputs: a pass is live if something needed reads what it
+// writes (or it writes nothing, i.e. only has side effects)
+void FrameGraph::cull() {
+    std::vector<bool> needed(m_resources.size());
+    for (size_t i = 0; i < m_resources.size(); i++)
+        needed[i] = m_resources[i].imported || m_resources[i].output;
+
+    m_culled.clear();
+    for (int i = (int)m_passes.size() - 1; i >= 0; i--) {
+        Pass& p = m_passes[i];
+        p.live = p.writes.empty();
+        for (Handle w : p.writes)
+            if (w >= 0 && needed[w]) p.live = true;
+        if (!p.live) { m_culled.push_back(p.name); continue; }
+        for (Handle r : p.reads)
+            if (r >= 0) needed[r] = true;
+    }
+}
+
+void FrameGraph::allocate() {
+    for (int i = 0; i < (int)m_passes.size(); i++) {
+        if (!m_passes[i].live) continue;
+        auto touch = [&](Handle h) {
+            if (h < 0) return;
+            Resource& r = m_resources[h];
+            if (r.first < 0) r.first = i;
+            r.last = i;
+        };
+        for (Handle h : m_passes[i].reads) touch(h);
+        for (Handle h : m_passes[i].writes) touch(h);
+    }
+
+    std::vector<int> order;
+    for (int i = 0; i < (int)m_resources.size(); i++) {
+        Resource& r = m_resources[i];
+        if (r.imported || r.first < 0) continue;
+        if (r.output) r.last = INT_MAX; // read after the graph ran
+        order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return m_resources[a].first < m_resources[b].first; });
+
+    for (auto& p : m_pool) p.freeFrom = 0;
+    m_transients = (int)order.size();
+    m_texturesUsed = 0;
+    for (int i : order) {
+        Resource& r = m_resources[i];
+        Pooled* slot = nullptr;
+        for (auto& p : m_pool)
+            if (p.desc == r.desc && p.freeFrom <= r.first) { slot = &p; break; }
+        if (!slot) {
+            WGPUTextureDescriptor desc = {};
+            desc.label = r.name.c_str();
+            desc.size = { r.desc.width, r.desc.height, 1 };
+            desc.format = r.desc.format;
+            desc.usage = r.desc.usage;
+            desc.mipLevelCount = 1;
+            desc.sampleCount = 1;
+            desc.dimension = WGPUTextureDimension_2D;
+            Pooled p;
+            p.desc = r.desc;
+            p.texture = gpuPool().acquireTexture(&desc, "FrameGraph");
+            p.view = gpuCreateTextureView(p.texture, nullptr, "FrameGraph");
+            m_pool.push_back(p);
+            slot = &m_pool.back();
+        }
+        if (slot->lastUsed != m_executions) m_texturesUsed++;
+        slot->freeFrom = (r.last == INT_MAX) ? INT_MAX : r.last + 1;
+        slot->lastUsed = m_executions;
+        r.texture = slot->texture;
+        r.view = slot->view;
+    }
+}
+
+void FrameGraph::trim() {
+    for (size_t i = 0; i < m_pool.size();) {
+        Pooled& p = m_pool[i];
+        if (m_executions - p.lastUsed <= TRIM_AFTER) { i++; continue; }
+        gpuRelease(p.view);
+        gpuPool().recycle(p.texture);
+        m_pool.erase(m_pool.begin() + i);
+    }
+}
+
+void FrameGraph::execute(WGPUCommandEncoder encoder) {
+    TRACE_SCOPE("FrameGraph::execute");
+    m_executions++;
+    cull();
+    allocate();
+    m_livePasses = 0;
+    for (auto& p : m_passes) {
+        if (!p.live) continue;
+        m_livePasses++;
+        p.fn(encoder);
+    }
+    trim();
+}
+
+uint64_t FrameGraph::bytes(const FgTextureDesc& desc) {
+    uint64_t texel = desc.format == WGPUTextureFormat_RGBA16Float ? 8 :
+                     desc.format == WGPUTextureFormat_RGBA32Float ? 16 : 4;
+    return (uint64_t)desc.width * desc.height * texel;
+}
+
+uint64_t FrameGraph::pooledBytes() const {
+    uint64_t total = 0;
+    for (auto& p : m_pool) total += bytes(p.desc);
+    return total;
+}
+
+void FrameGraph::onGui() {
+    ImGui::Text("Frame graph: %d passes (%zu culled), %d transients in %d textures, %.1f MB pooled",
+                m_livePasses, m_culled.size(), m_transients, m_texturesUsed,
+                pooledBytes() / (1024.0 * 1024.0));
+    if (m_culled.empty()) return;
+    std::string names;
+    for (auto& n : m_culled) names += (names.empty() ? "" : ", ") + n;
+    ImGui::TextDisabled("culled: %s", names.c_str());
+}
+
+void FrameGraph::shutdown() {
+    for (auto& p : m_pool) {
+        gpuRelease(p.view);
+        gpuPool().recycle(p.texture);
+    }
+    m_pool.clear();
+    reset();
+    m_device = nullptr;
+}
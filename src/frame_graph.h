@@ -0,0 +1,90 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct FgTextureDesc {
+    uint32_t width = 0, height = 0;
+    WGPUTextureFormat format = WGPUTextureFormat_RGBA8Unorm;
+    WGPUTextureUsageFlags usage = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_TextureBinding |
+                                  WGPUTextureUsage_CopySrc;
+
+    bool operator==(const FgTextureDesc& o) const {
+        return width == o.width && height == o.height && format == o.format && usage == o.usage;
+    }
+};
+
+// Minimal frame graph for the compositor, post effects and export. Passes
+// declare the textures they read and write; execute() then
+//  - culls passes whose results nobody reads (e.g. bloom at intensity 0),
+//  - backs transient textures with pooled ones, aliasing transients whose
+//    lifetimes (first..last live pass) don't overlap,
+//  - records the live passes in order.
+// Imported textures (state that outlives the frame) count as outputs; so does
+// any transient passed to markOutput(), whose texture stays valid until the
+// next reset(). Pooled textures unused for TRIM_AFTER executions are released.
+//
+// Per use: reset() -> import/create textures -> addPass()... -> execute(encoder).
+class FrameGraph {
+public:
+    using Handle = int; // -1 = none
+    using Execute = std::function<void(WGPUCommandEncoder encoder)>;
+    static constexpr uint64_t TRIM_AFTER = 120;
+
+    void init(WGPUDevice device);
+    void shutdown();
+
+    void reset();
+    Handle importTexture(const char* name, WGPUTexture texture, WGPUTextureView view);
+    Handle createTexture(const char* name, const FgTextureDesc& desc);
+    void addPass(const char* name, std::vector<Handle> reads, std::vector<Handle> writes, Execute fn);
+    void markOutput(Handle h);
+    void execute(WGPUCommandEncoder encoder);
+
+    // Valid inside pass callbacks, and for outputs until the next reset()
+    WGPUTextureView view(Handle h) const;
+    WGPUTexture texture(Handle h) const;
+
+    uint64_t pooledBytes() const;
+    void onGui(); // passes run/culled, transients vs pooled textures
+
+private:
+    struct Resource {
+        std::string name;
+        FgTextureDesc desc;
+        bool imported = false, output = false;
+        WGPUTexture texture = nullptr; // imported, or the pooled texture after execute()
+        WGPUTextureView view = nullptr;
+        int first = -1, last = -1; // live pass indices using it
+    };
+    struct Pass {
+        std::string name;
+        std::vector<Handle> reads, writes;
+        Execute fn;
+        bool live = false;
+    };
+    struct Pooled {
+        FgTextureDesc desc;
+        WGPUTexture texture = nullptr;
+        WGPUTextureView view = nullptr;
+        int freeFrom = 0;      // first pass index it is free again (this execution)
+        uint64_t lastUsed = 0; // execution counter
+    };
+
+    void cull();
+    void allocate();
+    void trim();
+    static uint64_t bytes(const FgTextureDesc& desc);
+
+    WGPUDevice m_device = nullptr;
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<Pooled> m_pool;
+    uint64_t m_executions = 0;
+
+    // Last execution, for onGui
+    std::vector<std::string> m_culled;
+    int m_livePasses = 0, m_transients = 0, m_texturesUsed = 0;
+};
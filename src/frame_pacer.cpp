@@ -0,0 +1,89 @@
+#include "frame_pacer.h"
+#include "gpu_tracker.h"
+#include "cpu_trace.h"
+#include <webgpu/wgpu.h>
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+
+void FramePacer::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+    m_queue = queue;
+    m_frame = 0;
+    m_slot = 0;
+}
+
+int FramePacer::inFlight() const {
+    int n = 0;
+    for (auto& f : m_frames)
+        if (f.pending) n++;
+    return n;
+}
+
+void FramePacer::wait(Frame& frame) {
+    // Blocks on this submission only; the work-done callback fires from the poll
+    WGPUWrappedSubmissionIndex index = { m_queue, (WGPUSubmissionIndex)frame.submission };
+    while (frame.pending) wgpuDevicePoll(m_device, true, &index);
+}
+
+void FramePacer::retire(Frame& frame) {
+    for (WGPUBindGroup bg : frame.transient) gpuRelease(bg);
+    frame.transient.clear();
+}
+
+int FramePacer::beginFrame() {
+    TRACE_SCOPE("FramePacer::beginFrame");
+    auto t0 = std::chrono::steady_clock::now();
+    m_slot = (int)(m_frame % MAX_FRAMES);
+    if (m_device) {
+        int limit = std::clamp(framesInFlight, 1, MAX_FRAMES);
+        wgpuDevicePoll(m_device, false, nullptr); // fire callbacks of finished frames
+        while (inFlight() >= limit) {
+            Frame* oldest = nullptr;
+            for (auto& f : m_frames)
+                if (f.pending && (!oldest || f.submission < oldest->submission)) oldest = &f;
+            wait(*oldest);
+        }
+        if (m_frames[m_slot].pending) wait(m_frames[m_slot]);
+    }
+    retire(m_frames[m_slot]);
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    m_waitMs += (ms - m_waitMs) * 0.05f;
+    return m_slot;
+}
+
+void FramePacer::submit(WGPUCommandBuffer commands) {
+    Frame& f = m_frames[m_slot];
+    f.submission = wgpuQueueSubmitForIndex(m_queue, 1, &commands);
+    f.pending = true;
+    wgpuQueueOnSubmittedWorkDone(m_queue,
+        [](WGPUQueueWorkDoneStatus, void* ud) {
+            ((Frame*)ud)->pending = false; // also on failure, so nothing waits forever
+        }, &f);
+    m_frame++;
+}
+
+void FramePacer::defer(WGPUBindGroup group) {
+    if (group) m_frames[m_slot].transient.push_back(group);
+}
+
+void FramePacer::waitIdle() {
+    if (!m_device) return;
+    for (auto& f : m_frames)
+        if (f.pending) wait(f);
+}
+
+void FramePacer::onGui() {
+    ImGui::Text("Frames in flight: %d/%d, CPU wait %.2f ms", inFlight(), framesInFlight, m_waitMs);
+}
+
+void FramePacer::shutdown() {
+    waitIdle();
+    for (auto& f : m_frames) {
+        retire(f);
+        f = Frame();
+    }
+    m_device = nullptr;
+    m_queue = nullptr;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <cstdint>
+#include <vector>
+
+// Frames-in-flight pacing between CPU encoding and GPU execution. Each frame
+// owns one of MAX_FRAMES slots; beginFrame() only blocks when framesInFlight
+// frames are still running on the GPU, and then waits on the oldest frame's
+// submission index rather than draining the device. So the CPU builds frame
+// N+1's UI and command buffers while the GPU executes frame N.
+//
+// Completion is tracked with OnSubmittedWorkDone callbacks. Per-frame
+// transient objects handed to defer() are released when their slot is
+// reused, i.e. after the GPU is done with that frame. Per-frame readback
+// buffers can be indexed by slot().
+//
+// Per frame: beginFrame() -> record -> submit(commands) -> present.
+class FramePacer {
+public:
+    static constexpr int MAX_FRAMES = 3;
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown(); // waits for every frame in flight
+
+    int beginFrame(); // returns this frame's slot
+    void submit(WGPUCommandBuffer commands);
+    void defer(WGPUBindGroup group); // released once this frame's GPU work is done
+    void waitIdle(); // e.g. before destroying resources frames in flight may use
+
+    int framesInFlight = 2; // 1..MAX_FRAMES; 1 = CPU and GPU take turns
+    int slot() const { return m_slot; }
+    int inFlight() const;
+    float waitMs() const { return m_waitMs; } // CPU time blocked in beginFrame (avg)
+    void onGui(); // one line for the stats overlay
+
+private:
+    struct Frame {
+        uint64_t submission = 0; // WGPUSubmissionIndex
+        bool pending = false;    // submitted, work-done callback not fired yet
+        std::vector<WGPUBindGroup> transient;
+    };
+
+    void wait(Frame& frame);
+    void retire(Frame& frame);
+
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    Frame m_frames[MAX_FRAMES];
+    uint64_t m_frame = 0;
+    int m_slot = 0;
+    float m_waitMs = 0.0f;
+};
@@ -1,4 +1,7 @@
 #include "gpu_context.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "cpu_trace.h"
 #include <glfw3webgpu.h>
 #include <cstdio>
 #include <cstdlib>
@@ -40,9 +43,21 @@ bool GpuContext::init(uint32_t w, uint32_t h, const char* title) {
     surface = glfwGetWGPUSurface(instance, window);
     if (!surface) { fprintf(stderr, "Failed to get WebGPU surface\n"); return false; }
 
+    if (!requestDevice(surface, false)) return false;
+
+    // Surface format — use preferred format API
+    surfaceFormat = wgpuSurfaceGetPreferredFormat(surface, adapter);
+
+    configureSurface();
+    return true;
+}
+
+// Request adapter + device. compatibleSurface may be null for offscreen use.
+bool GpuContext::requestDevice(WGPUSurface compatibleSurface, bool forceFallback) {
     // Adapter (synchronous request via callback)
     WGPURequestAdapterOptions adapterOpts = {};
-    adapterOpts.compatibleSurface = surface;
+    adapterOpts.compatibleSurface = compatibleSurface;
+    adapterOpts.forceFallbackAdapter = forceFallback;
     adapterOpts.powerPreference = WGPUPowerPreference_HighPerformance;
 
     struct AdapterData { WGPUAdapter adapter = nullptr; bool done = false; };
@@ -61,10 +76,25 @@ bool GpuContext::init(uint32_t w, uint32_t h, const char* title) {
     adapter = adapterData.adapter;
     if (!adapter) return false;
 
+    WGPUAdapterProperties props = {};
+    wgpuAdapterGetProperties(adapter, &props);
+    static const char* backendNames[] = {"Undefined", "Null", "WebGPU", "D3D11", "D3D12",
+                                         "Metal", "Vulkan", "OpenGL", "OpenGLES"};
+    const char* backend = (uint32_t)props.backendType < 9 ? backendNames[props.backendType] : "Unknown";
+    adapterName = std::string(props.name ? props.name : "unknown") + " (" + backend + ")";
+    printf("Adapter: %s\n", adapterName.c_str());
+
     // Device (synchronous request via callback)
     WGPUDeviceDescriptor deviceDesc = {};
     deviceDesc.label = "nature-of-nature device";
 
+    // Timestamp queries for the GPU profiler, when the adapter supports them
+    WGPUFeatureName features[1];
+    if (wgpuAdapterHasFeature(adapter, WGPUFeatureName_TimestampQuery)) {
+        features[deviceDesc.requiredFeatureCount++] = WGPUFeatureName_TimestampQuery;
+        deviceDesc.requiredFeatures = features;
+    }
+
     // Use default device limits (no explicit required limits)
     // Setting requiredLimits with zero-initialized "min" fields causes validation
     // errors because 0 is stricter than what the GPU supports.
@@ -86,12 +116,20 @@ bool GpuContext::init(uint32_t w, uint32_t h, const char* title) {
 
     wgpuDeviceSetUncapturedErrorCallback(device, onDeviceError, nullptr);
     queue = wgpuDeviceGetQueue(device);
+    gpuPool().init(device, queue);
+    return true;
+}
 
-    // Surface format — use preferred format API
-    surfaceFormat = wgpuSurfaceGetPreferredFormat(surface, adapter);
+bool GpuContext::initHeadless(uint32_t w, uint32_t h, bool forceFallback) {
+    width = w;
+    height = h;
 
-    configureSurface();
-    return true;
+    WGPUInstanceDescriptor instanceDesc = {};
+    instance = wgpuCreateInstance(&instanceDesc);
+    if (!instance) { fprintf(stderr, "Failed to create WebGPU instance\n"); return false; }
+
+    // No window or surface: any adapter will do, including the software fallback
+    return requestDevice(nullptr, forceFallback);
 }
 
 void GpuContext::configureSurface() {
@@ -116,6 +154,7 @@ void GpuContext::updateSize() {
 }
 
 WGPUTextureView GpuContext::getNextSurfaceTextureView() {
+    TRACE_SCOPE("getNextSurfaceTextureView");
     WGPUSurfaceTexture surfTex;
     wgpuSurfaceGetCurrentTexture(surface, &surfTex);
     if (surfTex.status != WGPUSurfaceGetCurrentTextureStatus_Success) return nullptr;
@@ -125,19 +164,23 @@ WGPUTextureView GpuContext::getNextSurfaceTextureView() {
     viewDesc.dimension = WGPUTextureViewDimension_2D;
     viewDesc.mipLevelCount = 1;
     viewDesc.arrayLayerCount = 1;
-    return wgpuTextureCreateView(surfTex.texture, &viewDesc);
+    return gpuCreateTextureView(surfTex.texture, &viewDesc, "Surface");
 }
 
 void GpuContext::present() {
+    TRACE_SCOPE("present");
     wgpuSurfacePresent(surface);
 }
 
 void GpuContext::shutdown() {
+    gpuPool().shutdown(); // no-op if the app already shut it down
     if (queue) wgpuQueueRelease(queue);
     if (device) wgpuDeviceRelease(device);
     if (adapter) wgpuAdapterRelease(adapter);
     if (surface) wgpuSurfaceRelease(surface);
     if (instance) wgpuInstanceRelease(instance);
-    if (window) glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <webgpu/webgpu.h>
 #include <GLFW/glfw3.h>
+#include <string>
 
 struct GpuContext {
     GLFWwindow* window = nullptr;
@@ -12,11 +13,17 @@ struct GpuContext {
     WGPUTextureFormat surfaceFormat = WGPUTextureFormat_BGRA8Unorm;
     uint32_t width = 1280;
     uint32_t height = 720;
+    std::string adapterName; // e.g. "NVIDIA GeForce RTX 3080 (Vulkan)"
 
     bool init(uint32_t w, uint32_t h, const char* title);
+    // Offscreen: no window, no surface. Used by the headless runner.
+    bool initHeadless(uint32_t w, uint32_t h, bool forceFallback = false);
     void configureSurface();
     void updateSize();
     WGPUTextureView getNextSurfaceTextureView();
     void present();
     void shutdown();
+
+private:
+    bool requestDevice(WGPUSurface compatibleSurface, bool forceFallback);
 };
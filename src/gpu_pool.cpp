@@ -0,0 +1,174 @@
+#include "gpu_pool.h"
+#include "gpu_tracker.h"
+#include <webgpu/wgpu.h>
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+
+GpuPool& gpuPool() {
+    static GpuPool pool;
+    return pool;
+}
+
+static uint32_t texelBytes(WGPUTextureFormat format) {
+    switch (format) {
+    case WGPUTextureFormat_RGBA16Float: return 8;
+    case WGPUTextureFormat_RGBA32Float: return 16;
+    default: return 4;
+    }
+}
+
+uint64_t GpuPool::bucketSize(uint64_t size) {
+    if (size <= 4096) return 4096;
+    uint64_t p = 1;
+    while (p * 2 <= size) p *= 2;
+    uint64_t step = p / 4;
+    return (size + step - 1) / step * step;
+}
+
+void GpuPool::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+    m_queue = queue;
+}
+
+void GpuPool::onWorkDone(WGPUQueueWorkDoneStatus, void* userdata) {
+    // Callbacks fire in submission order; userdata carries the ticket
+    GpuPool& pool = gpuPool();
+    pool.m_doneTicket = std::max(pool.m_doneTicket, (uint64_t)(uintptr_t)userdata);
+}
+
+void* GpuPool::take(const Key& key) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool pending = false;
+        for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+            if (!(it->key == key)) continue;
+            if (!ready(*it)) { pending = true; continue; }
+            Entry e = *it;
+            m_free.erase(it);
+            m_pooledBytes -= e.bytes;
+            void* handle = e.buffer ? (void*)e.buffer : (void*)e.texture;
+            m_out[handle] = e;
+            m_hits++;
+            return handle;
+        }
+        if (!pending) break;
+        wgpuDevicePoll(m_device, false, nullptr); // a match may have finished since the last poll
+    }
+    m_misses++;
+    return nullptr;
+}
+
+WGPUBuffer GpuPool::acquireBuffer(uint64_t size, WGPUBufferUsageFlags usage, const char* label, const char* owner) {
+    Key key;
+    key.size = bucketSize(size);
+    key.usage = (uint32_t)usage;
+    if (void* handle = take(key)) return (WGPUBuffer)handle;
+
+    WGPUBufferDescriptor desc = {};
+    desc.size = key.size;
+    desc.usage = usage;
+    desc.label = label;
+    WGPUBuffer buffer = gpuCreateBuffer(m_device, &desc, owner);
+    if (!buffer) return nullptr;
+    Entry e;
+    e.key = key;
+    e.bytes = key.size;
+    e.buffer = buffer;
+    m_out[buffer] = e;
+    return buffer;
+}
+
+WGPUTexture GpuPool::acquireTexture(const WGPUTextureDescriptor* desc, const char* owner) {
+    Key key;
+    key.texture = true;
+    key.width = desc->size.width;
+    key.height = desc->size.height;
+    key.format = desc->format;
+    key.usage = (uint32_t)desc->usage;
+    if (void* handle = take(key)) return (WGPUTexture)handle;
+
+    WGPUTexture texture = gpuCreateTexture(m_device, desc, owner);
+    if (!texture) return nullptr;
+    Entry e;
+    e.key = key;
+    e.bytes = (uint64_t)key.width * key.height * texelBytes(key.format);
+    e.texture = texture;
+    m_out[texture] = e;
+    return texture;
+}
+
+void GpuPool::put(const void* handle, WGPUBuffer buffer, WGPUTexture texture) {
+    auto it = m_out.find(handle);
+    if (it == m_out.end() || !m_queue) {
+        // Not ours (or no queue to fence with): plain destroy
+        if (buffer) { wgpuBufferDestroy(buffer); gpuRelease(buffer); }
+        if (texture) { wgpuTextureDestroy(texture); gpuRelease(texture); }
+        if (it != m_out.end()) m_out.erase(it);
+        return;
+    }
+    Entry e = it->second;
+    m_out.erase(it);
+    e.ticket = ++m_tickets;
+    e.idleFrom = m_frame;
+    wgpuQueueOnSubmittedWorkDone(m_queue, onWorkDone, (void*)(uintptr_t)e.ticket);
+    m_pooledBytes += e.bytes;
+    m_free.push_back(e);
+}
+
+void GpuPool::recycle(WGPUBuffer buffer) {
+    if (buffer) put(buffer, buffer, nullptr);
+}
+
+void GpuPool::recycle(WGPUTexture texture) {
+    if (texture) put(texture, nullptr, texture);
+}
+
+void GpuPool::destroy(Entry& e) {
+    if (e.buffer) { wgpuBufferDestroy(e.buffer); gpuRelease(e.buffer); }
+    if (e.texture) { wgpuTextureDestroy(e.texture); gpuRelease(e.texture); }
+    m_pooledBytes -= e.bytes;
+}
+
+// Drops ready entries: idle past TRIM_FRAMES (or all), then oldest first while over the cap
+void GpuPool::evict(bool all) {
+    for (auto it = m_free.begin(); it != m_free.end();) {
+        bool stale = all || m_frame - it->idleFrom > TRIM_FRAMES;
+        if (!stale || !ready(*it)) { ++it; continue; }
+        destroy(*it);
+        it = m_free.erase(it);
+    }
+    for (auto it = m_free.begin(); it != m_free.end() && m_pooledBytes > maxPooledBytes;) {
+        if (!ready(*it)) { ++it; continue; }
+        destroy(*it);
+        it = m_free.erase(it);
+    }
+}
+
+void GpuPool::endFrame() {
+    m_frame++;
+    m_lastHits = m_hits;
+    m_lastMisses = m_misses;
+    m_hits = m_misses = 0;
+    evict(false);
+}
+
+void GpuPool::trim() {
+    if (m_device) wgpuDevicePoll(m_device, false, nullptr);
+    evict(true);
+}
+
+void GpuPool::onGui() {
+    ImGui::Text("GPU pool: %zu idle (%.1f MB), %zu in use, %u hits / %u allocs last frame",
+                m_free.size(), m_pooledBytes / (1024.0 * 1024.0), m_out.size(), m_lastHits, m_lastMisses);
+}
+
+void GpuPool::shutdown() {
+    if (!m_device) return;
+    while (m_doneTicket < m_tickets) wgpuDevicePoll(m_device, true, nullptr);
+    evict(true);
+    if (!m_out.empty())
+        fprintf(stderr, "GpuPool: %zu objects still handed out at shutdown\n", m_out.size());
+    m_out.clear();
+    m_device = nullptr;
+    m_queue = nullptr;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+// Recycles buffers and textures that would otherwise be created and destroyed
+// over and over at the same sizes: readback buffers, the hi-res export target,
+// frame graph transients, sim textures and agent buffers on resize/reset.
+//
+// Buffers are bucketed by usage and size (rounded up to a quarter of the next
+// power of two, so at most 25% slack; bind with an explicit size). Textures
+// match on size, format and usage. recycle() hands an object back; it becomes
+// available once the GPU has finished the work submitted before that point
+// (OnSubmittedWorkDone). Entries idle for TRIM_FRAMES frames, or beyond
+// maxPooledBytes, are destroyed. Main thread only.
+class GpuPool {
+public:
+    static constexpr uint64_t TRIM_FRAMES = 120;
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown(); // waits for pending recycles, destroys everything pooled
+
+    // owner is the GpuTracker subsystem charged for a newly created object
+    WGPUBuffer acquireBuffer(uint64_t size, WGPUBufferUsageFlags usage, const char* label, const char* owner);
+    WGPUTexture acquireTexture(const WGPUTextureDescriptor* desc, const char* owner);
+    // Buffers must be unmapped; views of textures released by the caller.
+    // Objects the pool didn't hand out are destroyed.
+    void recycle(WGPUBuffer buffer);
+    void recycle(WGPUTexture texture);
+
+    void endFrame(); // ages and trims idle entries
+    void trim();     // destroys every idle entry the GPU is done with
+
+    uint64_t maxPooledBytes = 1024ull << 20;
+    uint64_t pooledBytes() const { return m_pooledBytes; }
+    void onGui(); // one line for the stats overlay
+
+    static uint64_t bucketSize(uint64_t size);
+
+private:
+    struct Key {
+        bool texture = false;
+        uint64_t size = 0; // buffers: bucket size
+        uint32_t width = 0, height = 0;
+        WGPUTextureFormat format = WGPUTextureFormat_Undefined;
+        uint32_t usage = 0;
+        bool operator==(const Key& o) const {
+            return texture == o.texture && size == o.size && width == o.width && height == o.height &&
+                   format == o.format && usage == o.usage;
+        }
+    };
+    struct Entry {
+        Key key;
+        uint64_t bytes = 0;
+        WGPUBuffer buffer = nullptr;
+        WGPUTexture texture = nullptr;
+        uint64_t ticket = 0;   // ready once m_doneTicket reaches it
+        uint64_t idleFrom = 0; // frame it was recycled
+    };
+
+    bool ready(const Entry& e) const { return e.ticket <= m_doneTicket; }
+    void* take(const Key& key);
+    void put(const void* handle, WGPUBuffer buffer, WGPUTexture texture);
+    void destroy(Entry& e);
+    void evict(bool all);
+    static void onWorkDone(WGPUQueueWorkDoneStatus status, void* userdata);
+
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    std::list<Entry> m_free; // oldest first
+    std::unordered_map<const void*, Entry> m_out; // handed out, keyed by handle
+    uint64_t m_pooledBytes = 0;
+    uint64_t m_frame = 0;
+    uint64_t m_tickets = 0, m_doneTicket = 0;
+
+    // Last frame, for onGui
+    uint32_t m_hits = 0, m_misses = 0, m_lastHits = 0, m_lastMisses = 0;
+};
+
+GpuPool& gpuPool();
@@ -0,0 +1,288 @@
+#include "gpu_profiler.h"
+#include "gpu_tracker.h"
+#include <webgpu/wgpu.h>
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+GpuProfiler& gpuProfiler() {
+    static GpuProfiler profiler;
+    return profiler;
+}
+
+WGPUComputePassEncoder profiledComputePass(WGPUCommandEncoder encoder, const char* name) {
+    return gpuProfiler().beginComputePass(encoder, name);
+}
+
+ProfiledCpuScope::ProfiledCpuScope(const char* name) : m_name(name), m_start(nowMs()) {}
+
+ProfiledCpuScope::~ProfiledCpuScope() {
+    gpuProfiler().addCpuTime(m_name, nowMs() - m_start);
+}
+
+void GpuProfiler::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+    m_queue = queue;
+
+    if (!wgpuDeviceHasFeature(device, WGPUFeatureName_TimestampQuery)) {
+        printf("GpuProfiler: timestamp queries unavailable, using CPU frame timing\n");
+        return;
+    }
+
+    WGPUQuerySetDescriptor qsDesc = {};
+    qsDesc.label = "profiler_timestamps";
+    qsDesc.type = WGPUQueryType_Timestamp;
+    qsDesc.count = MAX_PASSES * 2;
+    m_querySet = wgpuDeviceCreateQuerySet(device, &qsDesc);
+
+    WGPUBufferDescriptor desc = {};
+    desc.label = "profiler_resolve";
+    desc.size = (uint64_t)MAX_PASSES * 2 * sizeof(uint64_t);
+    desc.usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc;
+    m_resolveBuffer = gpuCreateBuffer(device, &desc, "Profiler");
+
+    desc.label = "profiler_readback";
+    desc.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+    for (auto& slot : m_slots)
+        slot.readback = gpuCreateBuffer(device, &desc, "Profiler");
+}
+
+int GpuProfiler::allocQuery(const char* name) {
+    if (!m_current || !m_querySet) return -1;
+    if (m_current->names.size() >= MAX_PASSES) return -1;
+    m_current->names.push_back(name);
+    return (int)(m_current->names.size() - 1) * 2;
+}
+
+void GpuProfiler::beginFrame() {
+    m_current = nullptr;
+    if (!m_device) return;
+
+    // Fire any completed map / work-done callbacks, then harvest finished slots
+    wgpuDevicePoll(m_device, false, nullptr);
+    for (auto& slot : m_slots) {
+        if (slot.state == SlotState::Ready) harvest(slot);
+        else if (slot.state == SlotState::Failed) slot.state = SlotState::Free;
+    }
+
+    Slot& slot = m_slots[m_frame % RING_SIZE];
+    if (slot.state != SlotState::Free) return; // readback still in flight: skip this frame
+    slot.state = SlotState::Recording;
+    slot.frame = m_frame;
+    slot.names.clear();
+    m_current = &slot;
+}
+
+void GpuProfiler::flush() {
+    m_current = nullptr;
+    if (!m_device) return;
+    wgpuDevicePoll(m_device, true, nullptr);
+    for (auto& slot : m_slots) {
+        if (slot.state == SlotState::Ready) harvest(slot);
+        else if (slot.state != SlotState::Pending) slot.state = SlotState::Free;
+    }
+}
+
+void GpuProfiler::resetTotals() {
+    for (auto& s : m_stats) {
+        s.sumMs = 0.0;
+        s.samples = 0;
+    }
+}
+
+void GpuProfiler::addCpuTime(const char* name, double ms) {
+    if (!m_device) return;
+    std::string row = std::string(name) + " (CPU)";
+    auto it = std::find_if(m_cpuRows.begin(), m_cpuRows.end(), [&](auto& r) { return r.first == row; });
+    if (it == m_cpuRows.end()) m_cpuRows.push_back({row, {1, ms}});
+    else { it->second.first++; it->second.second += ms; }
+}
+
+WGPUComputePassEncoder GpuProfiler::beginComputePass(WGPUCommandEncoder encoder, const char* name) {
+    m_passes++;
+    WGPUComputePassDescriptor desc = {};
+    desc.label = name;
+    int q = allocQuery(name);
+    if (q >= 0) {
+        m_computeWrites.querySet = m_querySet;
+        m_computeWrites.beginningOfPassWriteIndex = (uint32_t)q;
+        m_computeWrites.endOfPassWriteIndex = (uint32_t)q + 1;
+        desc.timestampWrites = &m_computeWrites;
+    }
+    return wgpuCommandEncoderBeginComputePass(encoder, &desc);
+}
+
+const WGPURenderPassTimestampWrites* GpuProfiler::renderPassTimestamps(const char* name) {
+    int q = allocQuery(name);
+    if (q < 0) return nullptr;
+    m_renderWrites.querySet = m_querySet;
+    m_renderWrites.beginningOfPassWriteIndex = (uint32_t)q;
+    m_renderWrites.endOfPassWriteIndex = (uint32_t)q + 1;
+    return &m_renderWrites;
+}
+
+void GpuProfiler::resolve(WGPUCommandEncoder encoder) {
+    if (!m_current || !m_querySet || m_current->names.empty()) return;
+    uint32_t count = (uint32_t)m_current->names.size() * 2;
+    wgpuCommandEncoderResolveQuerySet(encoder, m_querySet, 0, count, m_resolveBuffer, 0);
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, m_resolveBuffer, 0, m_current->readback, 0,
+                                         count * sizeof(uint64_t));
+}
+
+void GpuProfiler::endFrame() {
+    // CPU rows are known now; GPU rows arrive when the slot is harvested
+    for (auto& st : m_stats)
+        if (st.cpu) st.calls = 0;
+    for (auto& [name, v] : m_cpuRows)
+        record(m_frame, name, v.first, (float)v.second, true);
+    m_cpuRows.clear();
+    m_lastPasses = m_passes;
+    m_passes = 0;
+
+    m_frame++;
+    if (!m_current) return;
+    Slot& slot = *m_current;
+    m_current = nullptr;
+
+    if (m_querySet) {
+        if (slot.names.empty()) { slot.state = SlotState::Free; return; }
+        slot.state = SlotState::Pending;
+        wgpuBufferMapAsync(slot.readback, WGPUMapMode_Read, 0,
+                           slot.names.size() * 2 * sizeof(uint64_t),
+            [](WGPUBufferMapAsyncStatus status, void* ud) {
+                auto* s = (Slot*)ud;
+                s->state = (status == WGPUBufferMapAsyncStatus_Success) ? SlotState::Ready : SlotState::Failed;
+            }, &slot);
+    } else {
+        // CPU fallback: time from submit until the queue reports the work done
+        slot.state = SlotState::Pending;
+        slot.submitTime = nowMs();
+        wgpuQueueOnSubmittedWorkDone(m_queue,
+            [](WGPUQueueWorkDoneStatus status, void* ud) {
+                auto* s = (Slot*)ud;
+                s->doneTime = nowMs();
+                s->state = (status == WGPUQueueWorkDoneStatus_Success) ? SlotState::Ready : SlotState::Failed;
+            }, &slot);
+    }
+}
+
+void GpuProfiler::harvest(Slot& slot) {
+    for (auto& st : m_stats)
+        if (!st.cpu) st.calls = 0;
+
+    if (!m_querySet) {
+        record(slot.frame, "Frame (CPU submit->done)", 1, (float)(slot.doneTime - slot.submitTime));
+        slot.state = SlotState::Free;
+        return;
+    }
+
+    size_t size = slot.names.size() * 2 * sizeof(uint64_t);
+    const uint64_t* ts = (const uint64_t*)wgpuBufferGetConstMappedRange(slot.readback, 0, size);
+
+    // Sum repeated passes (e.g. one move_agents per substep) into one row.
+    // WebGPU timestamps are in nanoseconds.
+    std::vector<std::pair<std::string, std::pair<uint32_t, double>>> frameRows;
+    double totalMs = 0.0;
+    for (size_t i = 0; i < slot.names.size(); i++) {
+        uint64_t begin = ts[i * 2], end = ts[i * 2 + 1];
+        double ms = end > begin ? (double)(end - begin) / 1.0e6 : 0.0;
+        totalMs += ms;
+        auto it = std::find_if(frameRows.begin(), frameRows.end(),
+                               [&](auto& r) { return r.first == slot.names[i]; });
+        if (it == frameRows.end()) frameRows.push_back({slot.names[i], {1, ms}});
+        else { it->second.first++; it->second.second += ms; }
+    }
+    wgpuBufferUnmap(slot.readback);
+
+    for (auto& [name, v] : frameRows)
+        record(slot.frame, name, v.first, (float)v.second);
+    record(slot.frame, "Total", (uint32_t)slot.names.size(), (float)totalMs);
+    slot.state = SlotState::Free;
+}
+
+void GpuProfiler::record(uint64_t frame, const std::string& name, uint32_t calls, float ms, bool cpu) {
+    auto it = std::find_if(m_stats.begin(), m_stats.end(),
+                           [&](const PassStat& s) { return s.name == name; });
+    if (it == m_stats.end()) {
+        PassStat s;
+        s.name = name;
+        s.avgMs = ms;
+        s.cpu = cpu;
+        m_stats.push_back(s);
+        it = m_stats.end() - 1;
+    }
+    it->calls = calls;
+    it->lastMs = ms;
+    it->avgMs += (ms - it->avgMs) * 0.05f;
+    it->maxMs = std::max(it->maxMs, ms);
+    it->sumMs += ms;
+    it->samples++;
+
+    if (m_csv) fprintf(m_csv, "%llu,%s,%u,%.4f\n", (unsigned long long)frame, name.c_str(), calls, ms);
+}
+
+void GpuProfiler::onGui() {
+    if (!m_device) return;
+    ImGui::Text("GPU (%s), %u compute passes/frame%s", m_querySet ? "timestamps" : "CPU fallback",
+                m_lastPasses, splitPasses ? " (split)" : "");
+    if (m_stats.empty()) { ImGui::TextDisabled("waiting for results..."); return; }
+
+    if (ImGui::BeginTable("##gpuprof", 4, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Pass");
+        ImGui::TableSetupColumn("n");
+        ImGui::TableSetupColumn("avg ms");
+        ImGui::TableSetupColumn("max ms");
+        ImGui::TableHeadersRow();
+        for (auto& s : m_stats) {
+            if (s.calls == 0) continue; // not run in the last timed frame
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (s.cpu) ImGui::TextDisabled("%s", s.name.c_str());
+            else ImGui::TextUnformatted(s.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%u", s.calls);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", s.avgMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", s.maxMs);
+        }
+        ImGui::EndTable();
+    }
+}
+
+bool GpuProfiler::startCsv(const std::string& path) {
+    stopCsv();
+    m_csv = fopen(path.c_str(), "w");
+    if (!m_csv) { fprintf(stderr, "Failed to open profiler CSV: %s\n", path.c_str()); return false; }
+    fprintf(m_csv, "frame,pass,calls,gpu_ms\n");
+    printf("Profiling to %s\n", path.c_str());
+    return true;
+}
+
+void GpuProfiler::stopCsv() {
+    if (m_csv) fclose(m_csv);
+    m_csv = nullptr;
+}
+
+void GpuProfiler::shutdown() {
+    stopCsv();
+    for (auto& slot : m_slots) {
+        if (slot.readback) {
+            if (slot.state == SlotState::Ready) wgpuBufferUnmap(slot.readback);
+            wgpuBufferDestroy(slot.readback);
+            gpuRelease(slot.readback);
+        }
+        slot = Slot();
+    }
+    if (m_resolveBuffer) { wgpuBufferDestroy(m_resolveBuffer); gpuRelease(m_resolveBuffer); }
+    if (m_querySet) { wgpuQuerySetDestroy(m_querySet); wgpuQuerySetRelease(m_querySet); }
+    m_resolveBuffer = nullptr;
+    m_querySet = nullptr;
+    m_current = nullptr;
+    m_device = nullptr;
+    m_queue = nullptr;
+    m_stats.clear();
+    m_cpuRows.clear();
+}
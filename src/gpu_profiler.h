@@ -0,0 +1,111 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Per-pass GPU timing. Uses timestamp queries when the device has
+// WGPUFeatureName_TimestampQuery, otherwise falls back to timing the whole
+// frame on the CPU (submit -> OnSubmittedWorkDone).
+//
+// Per frame: beginFrame() -> passes via profiledComputePass() /
+// renderPassTimestamps() -> resolve(encoder) -> submit -> endFrame().
+// Results arrive a few frames later through async buffer maps. CPU-side
+// command recording time (ProfiledCpuScope) is listed alongside as
+// "<name> (CPU)" rows, together with the compute pass count per frame.
+class GpuProfiler {
+public:
+    static constexpr uint32_t MAX_PASSES = 256; // timed passes per frame
+    static constexpr int RING_SIZE = 3;         // frames of readback in flight
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown();
+    bool active() const { return m_device != nullptr; }
+    bool hasTimestamps() const { return m_querySet != nullptr; }
+
+    void beginFrame();
+    WGPUComputePassEncoder beginComputePass(WGPUCommandEncoder encoder, const char* name);
+    // Returns null when the frame isn't being timed
+    const WGPURenderPassTimestampWrites* renderPassTimestamps(const char* name);
+    void resolve(WGPUCommandEncoder encoder);
+    void endFrame();
+    void flush(); // wait for the GPU and harvest everything in flight (no new frame)
+
+    // CPU time spent encoding, summed per name and recorded at endFrame()
+    void addCpuTime(const char* name, double ms);
+    uint32_t framePasses() const { return m_lastPasses; } // compute passes begun last frame
+
+    // Sims batch their kernels into as few compute passes as possible (ComputeBatch).
+    // Split gives every kernel its own pass, and so its own timing row.
+    bool splitPasses = false;
+
+    void onGui(); // per-pass table
+    bool startCsv(const std::string& path);
+    void stopCsv();
+    bool csvActive() const { return m_csv != nullptr; }
+
+    struct PassStat {
+        std::string name;
+        uint32_t calls = 0;  // passes with this name in the last frame
+        float lastMs = 0.0f;
+        float avgMs = 0.0f;  // exponential moving average
+        float maxMs = 0.0f;
+        double sumMs = 0.0;   // since resetTotals()
+        uint32_t samples = 0; // frames recorded since resetTotals()
+        bool cpu = false;     // CPU encode time, not a GPU pass
+    };
+    const std::vector<PassStat>& stats() const { return m_stats; }
+    void resetTotals();
+
+private:
+    enum class SlotState { Free, Recording, Pending, Ready, Failed };
+    struct Slot {
+        WGPUBuffer readback = nullptr;
+        std::vector<std::string> names; // pass i -> queries 2i, 2i+1
+        uint64_t frame = 0;
+        SlotState state = SlotState::Free;
+        double submitTime = 0.0, doneTime = 0.0; // CPU fallback
+    };
+
+    int allocQuery(const char* name); // query index of pass begin, or -1
+    void harvest(Slot& slot);
+    void record(uint64_t frame, const std::string& name, uint32_t calls, float ms, bool cpu = false);
+
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    WGPUQuerySet m_querySet = nullptr;
+    WGPUBuffer m_resolveBuffer = nullptr;
+    Slot m_slots[RING_SIZE];
+    Slot* m_current = nullptr; // slot recording this frame, null if none free
+    uint64_t m_frame = 0;
+
+    WGPUComputePassTimestampWrites m_computeWrites = {};
+    WGPURenderPassTimestampWrites m_renderWrites = {};
+
+    std::vector<PassStat> m_stats;
+    FILE* m_csv = nullptr;
+
+    std::vector<std::pair<std::string, std::pair<uint32_t, double>>> m_cpuRows; // this frame
+    uint32_t m_passes = 0, m_lastPasses = 0;
+};
+
+// Global profiler used by the sims, compositor and post effects
+GpuProfiler& gpuProfiler();
+
+// Drop-in for wgpuCommandEncoderBeginComputePass(encoder, nullptr).
+// name is "<Owner>/<kernel>", e.g. "Physarum/move_agents".
+WGPUComputePassEncoder profiledComputePass(WGPUCommandEncoder encoder, const char* name);
+
+// Adds the CPU time of the enclosing scope to the profiler as "<name> (CPU)"
+class ProfiledCpuScope {
+public:
+    explicit ProfiledCpuScope(const char* name);
+    ~ProfiledCpuScope();
+    ProfiledCpuScope(const ProfiledCpuScope&) = delete;
+    ProfiledCpuScope& operator=(const ProfiledCpuScope&) = delete;
+
+private:
+    const char* m_name;
+    double m_start;
+};
@@ -0,0 +1,253 @@
+#include "gpu_tracker.h"
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char* TYPE_NAMES[GpuTracker::TYPE_COUNT] = {
+    "Buffer", "Texture", "TextureView", "BindGroup", "BindGroupLayout", "Sampler",
+    "ComputePipeline", "RenderPipeline",
+};
+
+GpuTracker& gpuTracker() {
+    static GpuTracker tracker;
+    return tracker;
+}
+
+const char* gpuObjectTypeName(GpuObjectType type) {
+    return TYPE_NAMES[(int)type];
+}
+
+int GpuTracker::ownerIndex(const char* owner) {
+    for (size_t i = 0; i < m_owners.size(); i++)
+        if (m_owners[i].name == owner) return (int)i;
+    m_owners.emplace_back();
+    m_owners.back().name = owner;
+    return (int)m_owners.size() - 1;
+}
+
+void GpuTracker::onCreate(GpuObjectType type, const char* owner, const void* handle, uint64_t bytes) {
+    if (!handle) return;
+    int o = ownerIndex(owner);
+    int t = (int)type;
+    OwnerStats& s = m_owners[o];
+    s.live[t]++;
+    s.created[t]++;
+    s.totalCreated[t]++;
+    s.bytes += bytes;
+    s.peakBytes = std::max(s.peakBytes, s.bytes);
+    m_liveBytes += bytes;
+    m_peakBytes = std::max(m_peakBytes, m_liveBytes);
+    if (type == GpuObjectType::Texture) m_textureBytes += bytes;
+    m_live[handle] = { type, o, bytes };
+}
+
+void GpuTracker::onRelease(GpuObjectType type, const void* handle) {
+    auto it = m_live.find(handle);
+    if (it == m_live.end() || it->second.type != type) return; // created untracked
+    OwnerStats& s = m_owners[it->second.owner];
+    s.live[(int)type]--;
+    s.released[(int)type]++;
+    s.bytes -= it->second.bytes;
+    m_liveBytes -= it->second.bytes;
+    if (type == GpuObjectType::Texture) m_textureBytes -= it->second.bytes;
+    m_live.erase(it);
+}
+
+void GpuTracker::endFrame() {
+    m_lastCreates = 0;
+    for (auto& s : m_owners) {
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            s.lastCreated[t] = s.created[t];
+            s.lastReleased[t] = s.released[t];
+            m_lastCreates += s.created[t];
+            s.created[t] = 0;
+            s.released[t] = 0;
+        }
+    }
+}
+
+void GpuTracker::onGui() {
+    ImGui::Text("GPU objects: %zu live, %u created last frame", m_live.size(), m_lastCreates);
+    if (ImGui::BeginTable("##gpu_objects", 5, ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Owner");
+        ImGui::TableSetupColumn("Type");
+        ImGui::TableSetupColumn("Live");
+        ImGui::TableSetupColumn("+/frame");
+        ImGui::TableSetupColumn("-/frame");
+        ImGui::TableHeadersRow();
+        for (auto& s : m_owners) {
+            for (int t = 0; t < TYPE_COUNT; t++) {
+                if (s.live[t] == 0 && s.lastCreated[t] == 0 && s.lastReleased[t] == 0) continue;
+                bool churn = s.lastCreated[t] > 0 || s.lastReleased[t] > 0;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(s.name.c_str());
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(TYPE_NAMES[t]);
+                ImGui::TableNextColumn(); ImGui::Text("%u", s.live[t]);
+                ImGui::TableNextColumn();
+                if (churn) ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%u", s.lastCreated[t]);
+                else ImGui::TextDisabled("0");
+                ImGui::TableNextColumn();
+                if (churn) ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%u", s.lastReleased[t]);
+                else ImGui::TextDisabled("0");
+            }
+        }
+        ImGui::EndTable();
+    }
+}
+
+bool GpuTracker::reportLeaks() const {
+    if (m_live.empty()) return true;
+    fprintf(stderr, "GpuTracker: %zu objects not released at shutdown\n", m_live.size());
+    for (auto& s : m_owners)
+        for (int t = 0; t < TYPE_COUNT; t++)
+            if (s.live[t] > 0)
+                fprintf(stderr, "  %-16s %-16s %u (of %llu created)\n", s.name.c_str(), TYPE_NAMES[t],
+                        s.live[t], (unsigned long long)s.totalCreated[t]);
+    return false;
+}
+
+uint64_t GpuTracker::projectResize(double pixelScale) const {
+    return m_liveBytes - m_textureBytes + (uint64_t)(m_textureBytes * pixelScale);
+}
+
+static double toMB(uint64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+void GpuTracker::onMemoryGui() {
+    ImGui::Text("Live %.1f MB, peak %.1f MB", toMB(m_liveBytes), toMB(m_peakBytes));
+    int budgetMB = (int)(m_budget / (1024 * 1024));
+    if (ImGui::DragInt("Budget MB", &budgetMB, 16.0f, 0, 65536))
+        m_budget = (uint64_t)std::max(budgetMB, 0) * 1024 * 1024;
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Resizes that would exceed this are refused (0 = off)");
+    if (ImGui::BeginTable("##gpu_memory", 3, ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Owner");
+        ImGui::TableSetupColumn("Live MB");
+        ImGui::TableSetupColumn("Peak MB");
+        ImGui::TableHeadersRow();
+        for (auto& s : m_owners) {
+            if (s.peakBytes == 0) continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(s.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", toMB(s.bytes));
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", toMB(s.peakBytes));
+        }
+        ImGui::EndTable();
+    }
+}
+
+void GpuTracker::printMemory() const {
+    printf("GPU memory: %.1f MB live, %.1f MB peak\n", toMB(m_liveBytes), toMB(m_peakBytes));
+    for (auto& s : m_owners)
+        if (s.peakBytes > 0)
+            printf("  %-16s %9.1f MB live %9.1f MB peak\n", s.name.c_str(), toMB(s.bytes), toMB(s.peakBytes));
+}
+
+// ---- Wrappers ----
+
+static uint64_t bytesPerTexel(WGPUTextureFormat format) {
+    switch (format) {
+        case WGPUTextureFormat_RGBA8Unorm:
+        case WGPUTextureFormat_BGRA8Unorm:
+        case WGPUTextureFormat_R32Float:
+        case WGPUTextureFormat_R32Uint: return 4;
+        case WGPUTextureFormat_RGBA16Float: return 8;
+        case WGPUTextureFormat_RGBA32Float: return 16;
+        default: return 4;
+    }
+}
+
+static uint64_t textureBytes(const WGPUTextureDescriptor* desc) {
+    uint64_t bytes = (uint64_t)desc->size.width * desc->size.height *
+                     std::max(desc->size.depthOrArrayLayers, 1u) * bytesPerTexel(desc->format) *
+                     std::max(desc->sampleCount, 1u);
+    if (desc->mipLevelCount > 1) bytes = bytes * 4 / 3; // full mip chain
+    return bytes;
+}
+
+WGPUBuffer gpuCreateBuffer(WGPUDevice device, const WGPUBufferDescriptor* desc, const char* owner) {
+    WGPUBuffer h = wgpuDeviceCreateBuffer(device, desc);
+    gpuTracker().onCreate(GpuObjectType::Buffer, owner, h, desc->size);
+    return h;
+}
+
+WGPUTexture gpuCreateTexture(WGPUDevice device, const WGPUTextureDescriptor* desc, const char* owner) {
+    WGPUTexture h = wgpuDeviceCreateTexture(device, desc);
+    gpuTracker().onCreate(GpuObjectType::Texture, owner, h, textureBytes(desc));
+    return h;
+}
+
+WGPUTextureView gpuCreateTextureView(WGPUTexture texture, const WGPUTextureViewDescriptor* desc, const char* owner) {
+    WGPUTextureView h = wgpuTextureCreateView(texture, desc);
+    gpuTracker().onCreate(GpuObjectType::TextureView, owner, h);
+    return h;
+}
+
+WGPUBindGroup gpuCreateBindGroup(WGPUDevice device, const WGPUBindGroupDescriptor* desc, const char* owner) {
+    WGPUBindGroup h = wgpuDeviceCreateBindGroup(device, desc);
+    gpuTracker().onCreate(GpuObjectType::BindGroup, owner, h);
+    return h;
+}
+
+WGPUBindGroupLayout gpuCreateBindGroupLayout(WGPUDevice device, const WGPUBindGroupLayoutDescriptor* desc, const char* owner) {
+    WGPUBindGroupLayout h = wgpuDeviceCreateBindGroupLayout(device, desc);
+    gpuTracker().onCreate(GpuObjectType::BindGroupLayout, owner, h);
+    return h;
+}
+
+WGPUSampler gpuCreateSampler(WGPUDevice device, const WGPUSamplerDescriptor* desc, const char* owner) {
+    WGPUSampler h = wgpuDeviceCreateSampler(device, desc);
+    gpuTracker().onCreate(GpuObjectType::Sampler, owner, h);
+    return h;
+}
+
+WGPUComputePipeline gpuCreateComputePipeline(WGPUDevice device, const WGPUComputePipelineDescriptor* desc, const char* owner) {
+    WGPUComputePipeline h = wgpuDeviceCreateComputePipeline(device, desc);
+    gpuTracker().onCreate(GpuObjectType::ComputePipeline, owner, h);
+    return h;
+}
+
+WGPURenderPipeline gpuCreateRenderPipeline(WGPUDevice device, const WGPURenderPipelineDescriptor* desc, const char* owner) {
+    WGPURenderPipeline h = wgpuDeviceCreateRenderPipeline(device, desc);
+    gpuTracker().onCreate(GpuObjectType::RenderPipeline, owner, h);
+    return h;
+}
+
+void gpuRelease(WGPUBuffer h) {
+    gpuTracker().onRelease(GpuObjectType::Buffer, h);
+    wgpuBufferRelease(h);
+}
+
+void gpuRelease(WGPUTexture h) {
+    gpuTracker().onRelease(GpuObjectType::Texture, h);
+    wgpuTextureRelease(h);
+}
+
+void gpuRelease(WGPUTextureView h) {
+    gpuTracker().onRelease(GpuObjectType::TextureView, h);
+    wgpuTextureViewRelease(h);
+}
+
+void gpuRelease(WGPUBindGroup h) {
+    gpuTracker().onRelease(GpuObjectType::BindGroup, h);
+    wgpuBindGroupRelease(h);
+}
+
+void gpuRelease(WGPUBindGroupLayout h) {
+    gpuTracker().onRelease(GpuObjectType::BindGroupLayout, h);
+    wgpuBindGroupLayoutRelease(h);
+}
+
+void gpuRelease(WGPUSampler h) {
+    gpuTracker().onRelease(GpuObjectType::Sampler, h);
+    wgpuSamplerRelease(h);
+}
+
+void gpuRelease(WGPUComputePipeline h) {
+    gpuTracker().onRelease(GpuObjectType::ComputePipeline, h);
+    wgpuComputePipelineRelease(h);
+}
+
+void gpuRelease(WGPURenderPipeline h) {
+    gpuTracker().onRelease(GpuObjectType::RenderPipeline, h);
+    wgpuRenderPipelineRelease(h);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Counts WebGPU object creations and releases per type, per owner and per
+// frame, so per-frame API churn shows up in the stats overlay and objects
+// still alive at shutdown are reported as leaks. Buffers and textures also
+// carry their size, giving live/peak GPU memory per owner and an optional
+// budget that callers check before large allocations (e.g. a resize).
+//
+// Create/release through the gpuCreate*() / gpuRelease() wrappers below
+// instead of the raw wgpu calls. Main thread only.
+enum class GpuObjectType {
+    Buffer, Texture, TextureView, BindGroup, BindGroupLayout, Sampler,
+    ComputePipeline, RenderPipeline, Count
+};
+
+class GpuTracker {
+public:
+    static constexpr int TYPE_COUNT = (int)GpuObjectType::Count;
+
+    void onCreate(GpuObjectType type, const char* owner, const void* handle, uint64_t bytes = 0);
+    void onRelease(GpuObjectType type, const void* handle);
+    void endFrame(); // latch this frame's counters for display
+
+    void onGui(); // churn table for the stats overlay
+    // Prints objects still alive (per owner/type); returns false if any
+    bool reportLeaks() const;
+
+    uint32_t frameCreates() const { return m_lastCreates; } // all types, last frame
+
+    // Memory (buffers + textures)
+    uint64_t liveBytes() const { return m_liveBytes; }
+    uint64_t peakBytes() const { return m_peakBytes; }
+    // Live bytes if every texture grew by pixelScale (buffers unchanged)
+    uint64_t projectResize(double pixelScale) const;
+    void setBudget(uint64_t bytes) { m_budget = bytes; } // 0 = unlimited
+    uint64_t budget() const { return m_budget; }
+    bool fitsBudget(uint64_t projectedBytes) const { return m_budget == 0 || projectedBytes <= m_budget; }
+    void onMemoryGui(); // per-owner live/peak table + budget control
+    void printMemory() const;
+
+private:
+    struct OwnerStats {
+        std::string name;
+        uint32_t live[TYPE_COUNT] = {};
+        uint32_t created[TYPE_COUNT] = {};  // this frame
+        uint32_t released[TYPE_COUNT] = {};
+        uint32_t lastCreated[TYPE_COUNT] = {};  // previous frame
+        uint32_t lastReleased[TYPE_COUNT] = {};
+        uint64_t totalCreated[TYPE_COUNT] = {};
+        uint64_t bytes = 0, peakBytes = 0;
+    };
+    struct LiveObject {
+        GpuObjectType type;
+        int owner;
+        uint64_t bytes;
+    };
+
+    int ownerIndex(const char* owner);
+
+    std::vector<OwnerStats> m_owners;
+    std::unordered_map<const void*, LiveObject> m_live;
+    uint32_t m_lastCreates = 0;
+    uint64_t m_liveBytes = 0, m_peakBytes = 0, m_textureBytes = 0;
+    uint64_t m_budget = 0;
+};
+
+GpuTracker& gpuTracker();
+const char* gpuObjectTypeName(GpuObjectType type);
+
+// Tracked drop-ins for the wgpu create/release calls. owner is the subsystem
+// ("Physarum", "Compositor", ...) and must be a string literal.
+WGPUBuffer gpuCreateBuffer(WGPUDevice device, const WGPUBufferDescriptor* desc, const char* owner);
+WGPUTexture gpuCreateTexture(WGPUDevice device, const WGPUTextureDescriptor* desc, const char* owner);
+WGPUTextureView gpuCreateTextureView(WGPUTexture texture, const WGPUTextureViewDescriptor* desc, const char* owner);
+WGPUBindGroup gpuCreateBindGroup(WGPUDevice device, const WGPUBindGroupDescriptor* desc, const char* owner);
+WGPUBindGroupLayout gpuCreateBindGroupLayout(WGPUDevice device, const WGPUBindGroupLayoutDescriptor* desc, const char* owner);
+WGPUSampler gpuCreateSampler(WGPUDevice device, const WGPUSamplerDescriptor* desc, const char* owner);
+WGPUComputePipeline gpuCreateComputePipeline(WGPUDevice device, const WGPUComputePipelineDescriptor* desc, const char* owner);
+WGPURenderPipeline gpuCreateRenderPipeline(WGPUDevice device, const WGPURenderPipelineDescriptor* desc, const char* owner);
+
+void gpuRelease(WGPUBuffer buffer);
+void gpuRelease(WGPUTexture texture);
+void gpuRelease(WGPUTextureView view);
+void gpuRelease(WGPUBindGroup group);
+void gpuRelease(WGPUBindGroupLayout layout);
+void gpuRelease(WGPUSampler sampler);
+void gpuRelease(WGPUComputePipeline pipeline);
+void gpuRelease(WGPURenderPipeline pipeline);
@@ -0,0 +1,245 @@
+#include "hires_export.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "compute_pass.h"
+#include "gpu_profiler.h"
+#include "png_stream.h"
+#include "cpu_trace.h"
+#include <webgpu/wgpu.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t PARAMS_SIZE = 32; // upscale.wgsl Params
+
+void HiresExporter::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+    m_queue = queue;
+
+    WGPUBindGroupLayoutEntry entries[4] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = WGPUShaderStage_Compute;
+    entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+    entries[0].buffer.hasDynamicOffset = true;
+    entries[0].buffer.minBindingSize = PARAMS_SIZE;
+    entries[1].binding = 1;
+    entries[1].visibility = WGPUShaderStage_Compute;
+    entries[1].texture.sampleType = WGPUTextureSampleType_Float;
+    entries[1].texture.viewDimension = WGPUTextureViewDimension_2D;
+    entries[2].binding = 2;
+    entries[2].visibility = WGPUShaderStage_Compute;
+    entries[2].sampler.type = WGPUSamplerBindingType_Filtering;
+    entries[3].binding = 3;
+    entries[3].visibility = WGPUShaderStage_Compute;
+    entries[3].storageTexture.access = WGPUStorageTextureAccess_WriteOnly;
+    entries[3].storageTexture.format = WGPUTextureFormat_RGBA8Unorm;
+    entries[3].storageTexture.viewDimension = WGPUTextureViewDimension_2D;
+
+    WGPUBindGroupLayoutDescriptor bglDesc = {};
+    bglDesc.entryCount = 4;
+    bglDesc.entries = entries;
+    m_layout = gpuCreateBindGroupLayout(device, &bglDesc, "Export");
+
+    compileComputePipeline(device, "shaders/upscale.wgsl", "main", m_layout, m_pipelines, &m_pipeline, "Export");
+
+    WGPUSamplerDescriptor sampDesc = {};
+    sampDesc.magFilter = WGPUFilterMode_Linear;
+    sampDesc.minFilter = WGPUFilterMode_Linear;
+    sampDesc.addressModeU = WGPUAddressMode_ClampToEdge;
+    sampDesc.addressModeV = WGPUAddressMode_ClampToEdge;
+    sampDesc.maxAnisotropy = 1;
+    m_sampler = gpuCreateSampler(device, &sampDesc, "Export");
+
+    // A submit holds at most one upscale per layer (frame graph export) or one tile
+    m_uniforms.init(device, queue, PARAMS_SIZE, 16, "Export");
+
+    WGPUSupportedLimits limits = {};
+    if (wgpuDeviceGetLimits(device, &limits)) {
+        m_maxTextureDim = limits.limits.maxTextureDimension2D;
+        m_maxBufferSize = limits.limits.maxBufferSize;
+    }
+}
+
+bool HiresExporter::fitsSingleTexture(uint32_t outW, uint32_t outH) const {
+    if (outW > m_maxTextureDim || outH > m_maxTextureDim) return false;
+    uint64_t readback = (uint64_t)((outW * 4 + 255) / 256 * 256) * outH; // as readbackTexture
+    return readback <= m_maxBufferSize && readback <= MAX_SINGLE_BYTES;
+}
+
+WGPUBindGroup HiresExporter::createBindGroup(WGPUTextureView src, WGPUTextureView dst) {
+    WGPUBindGroupEntry e[4] = {};
+    e[0].binding = 0;
+    e[0].buffer = m_uniforms.buffer();
+    e[0].size = PARAMS_SIZE;
+    e[1].binding = 1;
+    e[1].textureView = src;
+    e[2].binding = 2;
+    e[2].sampler = m_sampler;
+    e[3].binding = 3;
+    e[3].textureView = dst;
+
+    WGPUBindGroupDescriptor bgDesc = {};
+    bgDesc.layout = m_layout;
+    bgDesc.entryCount = 4;
+    bgDesc.entries = e;
+    return gpuCreateBindGroup(m_device, &bgDesc, "Export");
+}
+
+void HiresExporter::dispatch(WGPUCommandEncoder encoder, WGPUBindGroup bg, uint32_t srcW, uint32_t srcH,
+                             uint32_t outW, uint32_t outH, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    uint32_t params[8] = { srcW, srcH, outW, outH, x, y, w, h };
+    uint32_t offset = m_uniforms.write(params);
+
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, "Export/upscale");
+    wgpuComputePassEncoderSetPipeline(pass, m_pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 1, &offset);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, (w + 7) / 8, (h + 7) / 8, 1);
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+}
+
+void HiresExporter::encodeUpscale(WGPUCommandEncoder encoder, WGPUTextureView src, uint32_t srcW, uint32_t srcH,
+                                  WGPUTextureView dst, uint32_t outW, uint32_t outH,
+                                  uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    m_pipelines.wait(); // no-op once compiled
+    if (!m_pipeline) return;
+
+    // Released here, kept alive by the encoded commands
+    WGPUBindGroup bg = createBindGroup(src, dst);
+    dispatch(encoder, bg, srcW, srcH, outW, outH, x, y, w, h);
+    gpuRelease(bg);
+}
+
+bool HiresExporter::exportTiledPNG(WGPUTextureView src, uint32_t srcW, uint32_t srcH,
+                                   uint32_t outW, uint32_t outH, const std::string& filename) {
+    TRACE_SCOPE("HiresExporter::exportTiledPNG");
+    m_pipelines.wait(); // no-op once compiled
+    if (!m_pipeline) return false;
+    PngStreamWriter png;
+    if (!png.open(filename, outW, outH)) return false;
+
+    WGPUTextureDescriptor texDesc = {};
+    texDesc.label = "export_tile";
+    texDesc.size = { TILE_W, TILE_H, 1 };
+    texDesc.format = WGPUTextureFormat_RGBA8Unorm;
+    texDesc.usage = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_CopySrc;
+    texDesc.mipLevelCount = 1;
+    texDesc.sampleCount = 1;
+    texDesc.dimension = WGPUTextureDimension_2D;
+    WGPUTexture tile = gpuPool().acquireTexture(&texDesc, "Export");
+    WGPUTextureView tileView = gpuCreateTextureView(tile, nullptr, "Export");
+    WGPUBindGroup tileGroup = createBindGroup(src, tileView); // every tile renders src into the same texture
+
+    const uint32_t bytesPerRow = TILE_W * 4; // already 256-byte aligned
+    const uint64_t stagingSize = (uint64_t)bytesPerRow * TILE_H;
+
+    struct Tile {
+        WGPUBuffer staging = nullptr;
+        uint32_t x = 0, w = 0, h = 0;
+        bool mapped = false;
+        WGPUBufferMapAsyncStatus status = WGPUBufferMapAsyncStatus_Unknown;
+    };
+    std::deque<std::unique_ptr<Tile>> inFlight;
+
+    // Strip being assembled, and the one the writer thread is compressing
+    std::vector<uint8_t> strip((size_t)outW * TILE_H * 4), writing(strip.size());
+    std::thread writer;
+    bool writeOk = true, readOk = true;
+
+    auto handOff = [&](uint32_t rows) {
+        if (writer.joinable()) writer.join();
+        std::swap(strip, writing);
+        writer = std::thread([&png, &writing, &writeOk, rows, outW] {
+            traceSetThreadName("PNG stream");
+            if (!png.writeRows(writing.data(), rows, (size_t)outW * 4)) writeOk = false;
+        });
+    };
+
+    // Copies the oldest tile into the strip once mapped; the last tile of a row of tiles completes the strip
+    auto retire = [&] {
+        Tile& t = *inFlight.front();
+        {
+            TRACE_SCOPE("wait tile");
+            while (!t.mapped) wgpuDevicePoll(m_device, true, nullptr);
+        }
+        if (t.status == WGPUBufferMapAsyncStatus_Success) {
+            const uint8_t* mapped = (const uint8_t*)wgpuBufferGetConstMappedRange(t.staging, 0, stagingSize);
+            for (uint32_t r = 0; r < t.h; r++)
+                memcpy(&strip[((size_t)r * outW + t.x) * 4], mapped + (size_t)r * bytesPerRow, (size_t)t.w * 4);
+            wgpuBufferUnmap(t.staging);
+        } else {
+            fprintf(stderr, "Tile readback failed (status %d)\n", (int)t.status);
+            readOk = false;
+        }
+        gpuPool().recycle(t.staging);
+        if (t.x + t.w == outW) handOff(t.h);
+        inFlight.pop_front();
+    };
+
+    uint32_t strips = (outH + TILE_H - 1) / TILE_H;
+    uint32_t columns = (outW + TILE_W - 1) / TILE_W;
+    for (uint32_t sy = 0; sy < strips && readOk; sy++) {
+        for (uint32_t tx = 0; tx < columns && readOk; tx++) {
+            if ((int)inFlight.size() >= TILES_IN_FLIGHT) retire();
+
+            auto t = std::make_unique<Tile>();
+            t->x = tx * TILE_W;
+            t->w = std::min(TILE_W, outW - t->x);
+            t->h = std::min(TILE_H, outH - sy * TILE_H);
+            t->staging = gpuPool().acquireBuffer(stagingSize, WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
+                                                 "export_tile_readback", "Export");
+
+            WGPUCommandEncoderDescriptor encDesc = {};
+            WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(m_device, &encDesc);
+            dispatch(encoder, tileGroup, srcW, srcH, outW, outH, t->x, sy * TILE_H, t->w, t->h);
+
+            WGPUImageCopyTexture copySrc = {};
+            copySrc.texture = tile;
+            WGPUImageCopyBuffer copyDst = {};
+            copyDst.buffer = t->staging;
+            copyDst.layout.bytesPerRow = bytesPerRow;
+            copyDst.layout.rowsPerImage = TILE_H;
+            WGPUExtent3D extent = { t->w, t->h, 1 };
+            wgpuCommandEncoderCopyTextureToBuffer(encoder, &copySrc, &copyDst, &extent);
+
+            WGPUCommandBufferDescriptor cbDesc = {};
+            WGPUCommandBuffer cmd = wgpuCommandEncoderFinish(encoder, &cbDesc);
+            wgpuQueueSubmit(m_queue, 1, &cmd);
+            wgpuCommandBufferRelease(cmd);
+            wgpuCommandEncoderRelease(encoder);
+
+            wgpuBufferMapAsync(t->staging, WGPUMapMode_Read, 0, stagingSize,
+                [](WGPUBufferMapAsyncStatus status, void* ud) {
+                    auto* tile = (Tile*)ud;
+                    tile->status = status;
+                    tile->mapped = true;
+                }, t.get());
+            inFlight.push_back(std::move(t));
+        }
+    }
+    while (!inFlight.empty()) retire();
+    if (writer.joinable()) writer.join();
+
+    gpuRelease(tileGroup);
+    gpuRelease(tileView);
+    gpuPool().recycle(tile);
+
+    bool ok = png.close() && writeOk && readOk;
+    if (ok) printf("Exported: %s (%u tiles)\n", filename.c_str(), strips * columns);
+    return ok;
+}
+
+void HiresExporter::shutdown() {
+    m_pipelines.wait(); // jobs still use the module and layout
+    if (m_pipeline) gpuRelease(m_pipeline);
+    if (m_layout) gpuRelease(m_layout);
+    if (m_sampler) gpuRelease(m_sampler);
+    m_uniforms.destroy();
+    m_pipeline = nullptr;
+    m_layout = nullptr;
+    m_sampler = nullptr;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include "pipeline_compiler.h"
+#include "uniform_ring.h"
+#include <cstdint>
+#include <string>
+
+// Hi-res export: bilinear upscale of the post-processed output
+// (shaders/upscale.wgsl), either into one texture (frame graph path, while
+// fitsSingleTexture()) or tile by tile for prints beyond the device's texture
+// and buffer limits.
+//
+// The tiled path renders TILE_W x TILE_H tiles into a single pooled texture
+// and copies each into a staging buffer; up to TILES_IN_FLIGHT tiles are
+// rendering/mapping while the oldest one is copied into a strip of full rows.
+// Finished strips are compressed by a writer thread into a PngStreamWriter,
+// so memory is one tile + staging buffers on the GPU and two strips on the
+// host, whatever the output size.
+class HiresExporter {
+public:
+    static constexpr uint32_t TILE_W = 2048;
+    static constexpr uint32_t TILE_H = 512;
+    static constexpr int TILES_IN_FLIGHT = 3;
+    // Single-texture exports are read back and encoded whole on the host; cap that too
+    static constexpr uint64_t MAX_SINGLE_BYTES = 512ull << 20;
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown();
+
+    // An outW x outH image fits one texture, its readback buffer and the host copy
+    bool fitsSingleTexture(uint32_t outW, uint32_t outH) const;
+
+    // Writes the (x, y, w, h) region of src stretched to outW x outH into dst
+    // (dst holds just the region)
+    void encodeUpscale(WGPUCommandEncoder encoder, WGPUTextureView src, uint32_t srcW, uint32_t srcH,
+                       WGPUTextureView dst, uint32_t outW, uint32_t outH,
+                       uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+    // Blocking, like exportTextureToPNG; any output size
+    bool exportTiledPNG(WGPUTextureView src, uint32_t srcW, uint32_t srcH,
+                        uint32_t outW, uint32_t outH, const std::string& filename);
+
+private:
+    WGPUBindGroup createBindGroup(WGPUTextureView src, WGPUTextureView dst);
+    void dispatch(WGPUCommandEncoder encoder, WGPUBindGroup bg, uint32_t srcW, uint32_t srcH,
+                  uint32_t outW, uint32_t outH, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    WGPUBindGroupLayout m_layout = nullptr;
+    WGPUComputePipeline m_pipeline = nullptr;
+    PipelineBatch m_pipelines; // compiled alongside the sims; the first export waits
+    WGPUSampler m_sampler = nullptr;
+    UniformRing m_uniforms; // params, one block per upscale
+    uint32_t m_maxTextureDim = 8192; // device limits, queried at init
+    uint64_t m_maxBufferSize = 256ull << 20;
+};
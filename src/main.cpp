@@ -1,16 +1,24 @@
 #include "gpu_context.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
 #include <webgpu/wgpu.h>
 #include "render_pass.h"
 #include "compositor.h"
 #include "post_effects.h"
 #include "ui.h"
 #include "export.h"
-#include "algorithms/game_of_life.h"
-#include "algorithms/physarum.h"
-#include "algorithms/boids.h"
-#include "algorithms/termites.h"
+#include "gpu_profiler.h"
+#include "cpu_trace.h"
+#include "sim_factory.h"
+#include "state_hash.h"
+#include "sim_stats.h"
+#include "frame_pacer.h"
+#include "frame_graph.h"
+#include "video_writer.h"
+#include "hires_export.h"
 #include <imgui.h>
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <cstdio>
 #include <ctime>
 #include <cstring>
@@ -30,6 +38,9 @@ struct AppUserData {
 };
 
 int main() {
+    traceSetThreadName("main");
+    auto appStart = std::chrono::steady_clock::now();
+
     GpuContext gpu;
     if (!gpu.init(1280, 1280, "nature of nature")) {
         fprintf(stderr, "Failed to initialize GPU context\n");
@@ -42,23 +53,33 @@ int main() {
     UI ui;
     ui.init(gpu);
 
+    gpuProfiler().init(gpu.device, gpu.queue);
+
+    FramePacer pacer;
+    pacer.init(gpu.device, gpu.queue);
+
     RenderPass renderPass;
     renderPass.init(gpu.device, gpu.surfaceFormat);
 
     // Simulations
-    std::unique_ptr<Simulation> sims[] = {
-        std::make_unique<GameOfLife>(),
-        std::make_unique<PhysarumSim>(),
-        std::make_unique<BoidsSim>(),
-        std::make_unique<TermitesSim>(),
-    };
-    constexpr int simCount = 4;
+    auto sims = createAllSimulations();
+    const int simCount = (int)sims.size();
 
     int rezX = 1536, rezY = 1536;
 
-    // Init all sims upfront
+    // Run seed: shared by all sims so a session can be replayed exactly
+    uint64_t runSeed = (uint64_t)time(nullptr);
     for (int i = 0; i < simCount; i++)
-        sims[i]->init(gpu.device, gpu.queue, rezX, rezY);
+        sims[i]->params.seed = runSeed;
+
+    StateHasher hasher;
+    hasher.init(gpu.device, gpu.queue);
+    int hashEvery = 0; // frames between state hashes, 0 = off
+    SimStats simStats;
+    simStats.init(gpu.device, gpu.queue);
+    int statsEvery = 0; // frames between stats reductions, 0 = off
+    uint64_t appFrame = 0;
+    bool firstFrameLogged = false, layersReadyLogged = false;
 
     // Compositor
     Compositor compositor;
@@ -71,81 +92,35 @@ int main() {
         l.blendMode = BlendMode::Additive;
         compositor.layers.push_back(l);
     }
+    compositor.updateLayers(); // sims are initialized when their layer is first enabled
 
     PostEffects postFx;
     postFx.init(gpu.device, gpu.queue, rezX, rezY);
 
-    // Upscale pipeline for hi-res export
-    WGPUBindGroupLayout upscaleBGL = nullptr;
-    WGPUPipelineLayout upscalePL = nullptr;
-    WGPUComputePipeline upscalePipeline = nullptr;
-    WGPUShaderModule upscaleSM = nullptr;
-    {
-        std::string code = loadShaderFile("shaders/upscale.wgsl");
-        WGPUShaderModuleWGSLDescriptor wgslDesc = {};
-        wgslDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
-        wgslDesc.code = code.c_str();
-        WGPUShaderModuleDescriptor smDesc = {};
-        smDesc.nextInChain = &wgslDesc.chain;
-        upscaleSM = wgpuDeviceCreateShaderModule(gpu.device, &smDesc);
-
-        WGPUBindGroupLayoutEntry entries[4] = {};
-        entries[0].binding = 0;
-        entries[0].visibility = WGPUShaderStage_Compute;
-        entries[0].buffer.type = WGPUBufferBindingType_Uniform;
-        entries[0].buffer.minBindingSize = 16;
-        entries[1].binding = 1;
-        entries[1].visibility = WGPUShaderStage_Compute;
-        entries[1].texture.sampleType = WGPUTextureSampleType_Float;
-        entries[1].texture.viewDimension = WGPUTextureViewDimension_2D;
-        entries[2].binding = 2;
-        entries[2].visibility = WGPUShaderStage_Compute;
-        entries[2].sampler.type = WGPUSamplerBindingType_Filtering;
-        entries[3].binding = 3;
-        entries[3].visibility = WGPUShaderStage_Compute;
-        entries[3].storageTexture.access = WGPUStorageTextureAccess_WriteOnly;
-        entries[3].storageTexture.format = WGPUTextureFormat_RGBA8Unorm;
-        entries[3].storageTexture.viewDimension = WGPUTextureViewDimension_2D;
-
-        WGPUBindGroupLayoutDescriptor bglDesc = {};
-        bglDesc.entryCount = 4;
-        bglDesc.entries = entries;
-        upscaleBGL = wgpuDeviceCreateBindGroupLayout(gpu.device, &bglDesc);
-
-        WGPUPipelineLayoutDescriptor plDesc = {};
-        plDesc.bindGroupLayoutCount = 1;
-        plDesc.bindGroupLayouts = &upscaleBGL;
-        upscalePL = wgpuDeviceCreatePipelineLayout(gpu.device, &plDesc);
-
-        WGPUComputePipelineDescriptor cpDesc = {};
-        cpDesc.layout = upscalePL;
-        cpDesc.compute.module = upscaleSM;
-        cpDesc.compute.entryPoint = "main";
-        upscalePipeline = wgpuDeviceCreateComputePipeline(gpu.device, &cpDesc);
-    }
+    // Compositor/post/export passes, rebuilt every frame
+    FrameGraph frameGraph;
+    frameGraph.init(gpu.device);
 
-    // Upscale sampler
-    WGPUSamplerDescriptor upSampDesc = {};
-    upSampDesc.magFilter = WGPUFilterMode_Linear;
-    upSampDesc.minFilter = WGPUFilterMode_Linear;
-    upSampDesc.addressModeU = WGPUAddressMode_ClampToEdge;
-    upSampDesc.addressModeV = WGPUAddressMode_ClampToEdge;
-    upSampDesc.maxAnisotropy = 1;
-    WGPUSampler upscaleSampler = wgpuDeviceCreateSampler(gpu.device, &upSampDesc);
-
-    // Upscale uniform buffer
-    WGPUBufferDescriptor upUniDesc = {};
-    upUniDesc.size = 16;
-    upUniDesc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
-    WGPUBuffer upscaleUniform = wgpuDeviceCreateBuffer(gpu.device, &upUniDesc);
+    // Upscale for hi-res export (single texture within the device limits, tiled beyond)
+    HiresExporter hiresExporter;
+    hiresExporter.init(gpu.device, gpu.queue);
 
     bool shouldExport = false;
     bool recording = false;
     int seqFrame = 0;
     int seqInterval = 1;
     int exportScale = 1;
+    bool exportRerender = false; // agent sims re-rendered at the export size (single textures)
     std::string seqDir; // subdirectory for current sequence
     AsyncExporter asyncExporter;
+    int exportThreads = 0;       // 0 = auto
+    int exportQueueMB = 512;
+    ReadbackRing readbackRing; // sequence frames, copied in the frame's own encoder
+    readbackRing.init(gpu.device, &asyncExporter);
+    int recordFormat = 0; // 0 = PNG sequence, 1 = Y4M, 2 = raw RGBA
+    VideoWriter videoWriter;
+    YuvConverter yuvConverter;
+    yuvConverter.init(gpu.device, gpu.queue);
     double lastTime = glfwGetTime();
     float fps = 0.0f;
     int frameCount = 0;
@@ -181,7 +156,11 @@ int main() {
     });
 
     while (!glfwWindowShouldClose(gpu.window)) {
-        glfwPollEvents();
+        TRACE_SCOPE("frame");
+        {
+            TRACE_SCOPE("glfwPollEvents");
+            glfwPollEvents();
+        }
 
         // FPS counter
         frameCount++;
@@ -256,19 +235,28 @@ int main() {
         float aspectRatio = windowAspect / texAspect;
         renderPass.setTransform(gpu.queue, view.offsetX, view.offsetY, view.zoom, aspectRatio);
 
-        // Begin frame
+        // Begin frame: waits only if the GPU is framesInFlight frames behind
+        pacer.beginFrame();
         WGPUTextureView surfaceView = gpu.getNextSurfaceTextureView();
-        if (!surfaceView) continue;
+        if (!surfaceView) {
+            // No surface (e.g. minimized): still close the frame so pool aging and
+            // per-frame churn counters keep counting frames
+            gpuPool().endFrame();
+            gpuTracker().endFrame();
+            continue;
+        }
 
         WGPUCommandEncoderDescriptor encDesc = {};
         WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(gpu.device, &encDesc);
+        gpuProfiler().beginFrame();
 
         // ImGui — process UI first so sim/resolution changes happen before compute
+        TRACE_BEGIN("ImGui build");
         ui.beginFrame();
 
         // Stats overlay (hold Tab)
         if (glfwGetKey(gpu.window, GLFW_KEY_TAB) == GLFW_PRESS) {
-            ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 160, 10));
+            ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 10, 10), 0, ImVec2(1.0f, 0.0f));
             ImGui::SetNextWindowBgAlpha(0.6f);
             ImGui::Begin("##stats", nullptr,
                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs |
@@ -276,6 +264,19 @@ int main() {
             ImGui::Text("FPS: %.0f", fps);
             ImGui::Text("Res: %ux%u", (uint32_t)rezX, (uint32_t)rezY);
             ImGui::Text("Zoom: %.1fx", view.zoom);
+            ImGui::Text("GPU mem: %.0f MB (peak %.0f MB)", gpuTracker().liveBytes() / (1024.0 * 1024.0),
+                        gpuTracker().peakBytes() / (1024.0 * 1024.0));
+            pacer.onGui();
+            frameGraph.onGui();
+            gpuPool().onGui();
+            ImGui::Separator();
+            gpuProfiler().onGui();
+            ImGui::Separator();
+            gpuTracker().onGui();
+            if (!simStats.lastResults().empty()) {
+                ImGui::Separator();
+                simStats.onGui();
+            }
             ImGui::End();
         }
 
@@ -288,30 +289,61 @@ int main() {
         ImGui::DragInt("RezX", &rezX, 8.0f, 64, 4096);
         ImGui::DragInt("RezY", &rezY, 8.0f, 64, 4096);
         if (rezX != prevRezX || rezY != prevRezY) {
-            for (int i = 0; i < simCount; i++) {
-                sims[i]->shutdown();
-                sims[i]->init(gpu.device, gpu.queue, rezX, rezY);
+            // Refuse resizes the memory budget can't hold (textures scale with pixel count)
+            double scale = ((double)rezX * rezY) / ((double)prevRezX * prevRezY);
+            uint64_t projected = gpuTracker().projectResize(scale);
+            if (!gpuTracker().fitsBudget(projected)) {
+                fprintf(stderr, "Resize to %dx%d refused: needs ~%.0f MB, budget %.0f MB\n", rezX, rezY,
+                        projected / (1024.0 * 1024.0), gpuTracker().budget() / (1024.0 * 1024.0));
+                rezX = prevRezX;
+                rezY = prevRezY;
             }
-            compositor.resize(rezX, rezY);
+        }
+        if (rezX != prevRezX || rezY != prevRezY) {
+            pacer.waitIdle(); // frames in flight still use the old textures
+            compositor.resize(rezX, rezY); // re-creates only the enabled layers' sims
             postFx.resize(rezX, rezY);
+            gpuPool().trim(); // old-size sim textures would otherwise sit idle
         }
 
         if (ImGui::Button("Export PNG")) shouldExport = true;
         ImGui::SameLine();
-        ImGui::DragInt("Scale", &exportScale, 0.1f, 1, 4);
+        ImGui::DragInt("Scale", &exportScale, 0.1f, 1, 16);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Exports beyond the device's texture/buffer limits are rendered and compressed in tiles");
+        ImGui::Checkbox("Re-render agents", &exportRerender);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("Agent sims deposit their agents into a trail field at the export size and\n"
+                              "colorize it there, composite + post effects run at that size: crisp\n"
+                              "instead of upsampled. Beyond the device limits or the memory\n"
+                              "budget the export falls back to the tiled upsample");
         ImGui::Separator();
         if (recording) {
             ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.1f, 0.1f, 1.0f));
             if (ImGui::Button("Stop Recording")) {
                 recording = false;
                 seqFrame = 0;
+                readbackRing.flush();
                 asyncExporter.stop();
+                videoWriter.close();
             }
             ImGui::PopStyleColor();
             ImGui::SameLine();
             ImGui::Text("Frame %d", seqFrame);
-            int pend = asyncExporter.pending();
-            if (pend > 0) { ImGui::SameLine(); ImGui::Text("(%d queued)", pend); }
+            if (videoWriter.isOpen()) {
+                ImGui::Text("%.0f MB/s, %d frames (%.0f MB), %d reading back, %d queued",
+                            videoWriter.megabytesPerSecond(), videoWriter.framesWritten(),
+                            videoWriter.bytesWritten() / (1024.0 * 1024.0),
+                            readbackRing.inFlight() - videoWriter.pending(), videoWriter.pending());
+            } else {
+                ImGui::Text("%.1f files/s on %d encoders, %d reading back, %d queued (%.0f / %d MB)",
+                            asyncExporter.framesPerSecond(), asyncExporter.threadCount(),
+                            readbackRing.inFlight(), asyncExporter.pending(),
+                            asyncExporter.queuedBytes() / (1024.0 * 1024.0), exportQueueMB);
+                if (asyncExporter.dropped() > 0) ImGui::Text("Dropped %d frames", asyncExporter.dropped());
+                if (asyncExporter.captureStride() > 1)
+                    ImGui::Text("Capturing every %d frames", seqInterval * asyncExporter.captureStride());
+            }
         } else {
             if (ImGui::Button("Record Sequence")) {
                 mkdir("exports", 0755);
@@ -319,15 +351,114 @@ int main() {
                 struct tm* tm_info = localtime(&t);
                 char ts[32];
                 strftime(ts, sizeof(ts), "%Y%m%d_%H%M%S", tm_info);
-                seqDir = std::string("exports/seq_") + ts;
-                mkdir(seqDir.c_str(), 0755);
-                recording = true;
+                if (recordFormat == 0) {
+                    seqDir = std::string("exports/seq_") + ts;
+                    mkdir(seqDir.c_str(), 0755);
+                    asyncExporter.maxQueuedBytes = (uint64_t)exportQueueMB << 20;
+                    asyncExporter.start(exportThreads);
+                    readbackRing.setSink(&asyncExporter);
+                    // Frames are copied out of the slot on admission; enough slots to
+                    // keep every encoder fed while the GPU is a couple of frames behind
+                    readbackRing.setSlotCount(asyncExporter.threadCount() + 2);
+                    recording = true;
+                } else {
+                    auto format = recordFormat == 1 ? VideoWriter::Format::Y4M : VideoWriter::Format::RawRGBA;
+                    seqDir = std::string("exports/rec_") + ts + (recordFormat == 1 ? ".y4m" : ".rgba");
+                    recording = videoWriter.open(seqDir, format, rezX, rezY, 30);
+                    readbackRing.setSink(&videoWriter);
+                    readbackRing.setSlotCount(4);
+                }
                 seqFrame = 0;
-                asyncExporter.start();
             }
         }
         ImGui::DragInt("Interval", &seqInterval, 0.1f, 1, 60);
-        ImGui::TextDisabled("ffmpeg -framerate 30 -i exports/seq_%%06d.png -c:v libx264 out.mp4");
+        if (!recording) {
+            const char* formatNames[] = { "PNG sequence", "Y4M (YUV 4:2:0)", "Raw RGBA" };
+            ImGui::SetNextItemWidth(140);
+            ImGui::Combo("Format", &recordFormat, formatNames, 3);
+        }
+        if (!recording && recordFormat == 0) {
+            const char* policyNames[] = { "Block", "Drop", "Lower rate" };
+            int policy = (int)asyncExporter.policy;
+            ImGui::SetNextItemWidth(100);
+            if (ImGui::Combo("When full", &policy, policyNames, 3))
+                asyncExporter.policy = (AsyncExporter::Policy)policy;
+            ImGui::SetNextItemWidth(100);
+            ImGui::DragInt("Queue MB", &exportQueueMB, 8.0f, 64, 8192);
+            ImGui::SetNextItemWidth(100);
+            ImGui::DragInt("Encoders", &exportThreads, 0.1f, 0, 16, exportThreads == 0 ? "auto" : "%d");
+        }
+        if (recordFormat == 0)
+            ImGui::TextDisabled("ffmpeg -framerate 30 -i exports/seq_%%06d.png -c:v libx264 out.mp4");
+        else if (recordFormat == 1)
+            ImGui::TextDisabled("ffmpeg -i exports/rec_<time>.y4m -c:v libx264 out.mp4");
+        else
+            ImGui::TextDisabled("ffmpeg -f rawvideo -pix_fmt rgba -s %dx%d -r 30 -i exports/rec_<time>.rgba -c:v libx264 out.mp4",
+                                rezX, rezY);
+        ImGui::Separator();
+        bool profiling = gpuProfiler().csvActive();
+        if (ImGui::Checkbox("Profile CSV", &profiling)) {
+            if (profiling) {
+                mkdir("exports", 0755);
+                time_t t = time(nullptr);
+                char ts[32];
+                strftime(ts, sizeof(ts), "%Y%m%d_%H%M%S", localtime(&t));
+                gpuProfiler().startCsv(std::string("exports/profile_") + ts + ".csv");
+            } else {
+                gpuProfiler().stopCsv();
+            }
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("(hold Tab for pass timings)");
+        ImGui::Checkbox("Split Passes", &gpuProfiler().splitPasses);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("One compute pass per kernel (per-kernel GPU times) instead of batching");
+        ImGui::SliderInt("Frames in Flight", &pacer.framesInFlight, 1, FramePacer::MAX_FRAMES);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("How far the CPU may run ahead of the GPU (1 = take turns)");
+        if (ImGui::Button("Dump CPU Trace")) {
+            mkdir("exports", 0755);
+            time_t t = time(nullptr);
+            char ts[32];
+            strftime(ts, sizeof(ts), "%Y%m%d_%H%M%S", localtime(&t));
+            traceDump(std::string("exports/trace_") + ts + ".json");
+        }
+        ImGui::SameLine();
+        ImGui::TextDisabled("chrome://tracing / Perfetto");
+        ImGui::Separator();
+        bool reseed = ImGui::InputScalar("Seed", ImGuiDataType_U64, &runSeed);
+        ImGui::SameLine();
+        if (ImGui::Button("Randomize")) {
+            runSeed = ((uint64_t)time(nullptr) << 20) ^ (uint64_t)(glfwGetTime() * 1e6);
+            reseed = true;
+        }
+        if (reseed) {
+            for (auto& layer : compositor.layers) {
+                layer.sim->params.seed = runSeed;
+                if (layer.live) layer.sim->reset(); // the rest pick the seed up at init
+            }
+        }
+        ImGui::DragInt("Hash Every", &hashEvery, 0.1f, 0, 600);
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Hash sim state every N frames (0 = off), logged to stdout");
+        for (auto& r : hasher.lastResults())
+            ImGui::TextDisabled("%s @%llu: %016llx", r.label.c_str(),
+                                (unsigned long long)r.step, (unsigned long long)r.combined);
+        ImGui::DragInt("Stats Every", &statsEvery, 0.1f, 0, 600);
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Reduce sim stats on the GPU every N frames (0 = off), shown in the Tab overlay");
+        ImGui::SameLine();
+        bool statsCsv = simStats.csvActive();
+        if (ImGui::Checkbox("CSV##stats", &statsCsv)) {
+            if (statsCsv) {
+                mkdir("exports", 0755);
+                time_t t = time(nullptr);
+                char ts[32];
+                strftime(ts, sizeof(ts), "%Y%m%d_%H%M%S", localtime(&t));
+                simStats.startCsv(std::string("exports/stats_") + ts + ".csv");
+            } else {
+                simStats.stopCsv();
+            }
+        }
+        if (ImGui::CollapsingHeader("GPU Memory")) gpuTracker().onMemoryGui();
         ImGui::End();
 
         // Layers window
@@ -359,17 +490,53 @@ int main() {
         ImGui::Begin("Post Effects");
         postFx.onGui();
         ImGui::End();
+        TRACE_END();
 
         // Compute step: step all enabled sims, then composite
+        TRACE_BEGIN("encode compute");
+        compositor.updateLayers();
         for (auto& layer : compositor.layers) {
-            if (layer.enabled && layer.sim) {
+            if (layer.enabled && layer.sim && layer.sim->ready()) {
                 layer.sim->step(encoder);
             }
         }
-        compositor.composite(encoder);
-
-        // Post-processing
-        postFx.apply(encoder, compositor.getOutputView());
+        // Composite + post-processing, once their pipelines are compiled (black until then)
+        frameGraph.reset();
+        if (compositor.ready() && postFx.ready())
+            postFx.addPasses(frameGraph, compositor.addPasses(frameGraph));
+        frameGraph.execute(encoder);
+
+        // State hashes of the stepped sims (after all of this frame's steps)
+        bool hashing = hashEvery > 0 && appFrame % hashEvery == 0;
+        if (hashing) {
+            for (auto& layer : compositor.layers)
+                if (layer.enabled && layer.sim && layer.sim->ready())
+                    hasher.encode(encoder, layer.sim->stateViews(), simKey(*layer.sim));
+        }
+        bool reducing = statsEvery > 0 && appFrame % statsEvery == 0;
+        if (reducing) {
+            for (auto& layer : compositor.layers)
+                if (layer.enabled && layer.sim && layer.sim->ready())
+                    simStats.encode(encoder, layer.sim->stateViews(), simKey(*layer.sim));
+        }
+        // Sequence recording: copy to a staging slot here, PNG encode on the worker thread
+        int captureStride = videoWriter.isOpen() ? 1 : asyncExporter.captureStride();
+        bool capturing = recording && seqFrame % (seqInterval * captureStride) == 0;
+        if (capturing && videoWriter.isOpen() && videoWriter.format() == VideoWriter::Format::Y4M) {
+            // Converted on the GPU: 1.5 bytes per pixel to read back
+            capturing = yuvConverter.encode(encoder, postFx.getOutputView(), rezX, rezY);
+            if (capturing)
+                readbackRing.encode(encoder, yuvConverter.buffer(), YuvConverter::frameBytes(rezX, rezY),
+                                    rezX, rezY, rezX, seqDir);
+        } else if (capturing) {
+            char seqFilename[256];
+            snprintf(seqFilename, sizeof(seqFilename), "%s/%06d.png", seqDir.c_str(), seqFrame);
+            readbackRing.encode(encoder, postFx.getOutputTexture(), rezX, rezY,
+                                videoWriter.isOpen() ? seqDir : std::string(seqFilename));
+        }
+        if (recording) seqFrame++;
+        appFrame++;
+        TRACE_END();
 
         // Render post-processed output to screen
         WGPUBindGroup quadBG = renderPass.createBindGroup(gpu.device, postFx.getOutputView());
@@ -384,6 +551,7 @@ int main() {
         WGPURenderPassDescriptor rpDesc = {};
         rpDesc.colorAttachmentCount = 1;
         rpDesc.colorAttachments = &colorAtt;
+        rpDesc.timestampWrites = gpuProfiler().renderPassTimestamps("Display");
 
         WGPURenderPassEncoder rpass = wgpuCommandEncoderBeginRenderPass(encoder, &rpDesc);
 
@@ -398,19 +566,44 @@ int main() {
         wgpuRenderPassEncoderRelease(rpass);
 
         // Submit
+        gpuProfiler().resolve(encoder);
         WGPUCommandBufferDescriptor cbDesc = {};
         WGPUCommandBuffer cmdBuf = wgpuCommandEncoderFinish(encoder, &cbDesc);
-        wgpuQueueSubmit(gpu.queue, 1, &cmdBuf);
+        {
+            TRACE_SCOPE("wgpuQueueSubmit");
+            pacer.submit(cmdBuf);
+        }
         wgpuCommandBufferRelease(cmdBuf);
         wgpuCommandEncoderRelease(encoder);
+        gpuProfiler().endFrame();
+        if (hashing) hasher.afterSubmit();
+        hasher.poll();
+        if (reducing) simStats.afterSubmit();
+        simStats.poll();
+        if (capturing) readbackRing.afterSubmit();
+        readbackRing.poll();
 
-        wgpuBindGroupRelease(quadBG);
+        pacer.defer(quadBG);
 
         gpu.present();
-        wgpuTextureViewRelease(surfaceView);
+        gpuRelease(surfaceView);
+
+        // Startup latency: first presented frame, then first frame with every enabled sim stepping
+        if (!firstFrameLogged || !layersReadyLogged) {
+            float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - appStart).count();
+            if (!firstFrameLogged) {
+                printf("Time to first frame: %.0f ms\n", ms);
+                firstFrameLogged = true;
+            }
+            if (!layersReadyLogged && compositor.layersReady() && compositor.ready() && postFx.ready()) {
+                printf("Time to first simulated frame: %.0f ms\n", ms);
+                layersReadyLogged = true;
+            }
+        }
 
         // Export after frame
         if (shouldExport) {
+            TRACE_SCOPE("export");
             shouldExport = false;
             mkdir("exports", 0755);
 
@@ -435,52 +628,78 @@ int main() {
             snprintf(filename, sizeof(filename), "exports/%s_%ux%u_%s.png",
                      name.c_str(), outW, outH, timestamp);
 
+            bool tiled = !hiresExporter.fitsSingleTexture(outW, outH);
+            bool rerender = false;
+            if (exportRerender && exportScale > 1) {
+                // Export-size textures: the trail field (8 B/px), an output and a composite per
+                // layer, bloom A/B and the post output (4 B/px each), plus the readback
+                uint64_t layerCount = 0;
+                for (auto& l : compositor.layers)
+                    if (l.enabled && l.sim && l.sim->ready()) layerCount++;
+                uint64_t pixels = (uint64_t)outW * outH;
+                uint64_t projected = gpuTracker().liveBytes() + pixels * (8 + 8 * layerCount + 12 + 4);
+                if (tiled) {
+                    fprintf(stderr, "Re-render at %ux%u exceeds the device limits: upsampling in tiles\n", outW, outH);
+                } else if (!gpuTracker().fitsBudget(projected)) {
+                    fprintf(stderr, "Re-render at %ux%u needs ~%.0f MB, budget %.0f MB: upsampling in tiles\n",
+                            outW, outH, projected / (1024.0 * 1024.0), gpuTracker().budget() / (1024.0 * 1024.0));
+                    tiled = true;
+                } else {
+                    rerender = true;
+                }
+            }
+
             if (exportScale == 1) {
                 exportTextureToPNG(gpu.device, gpu.queue, postFx.getOutputTexture(),
                                    rezX, rezY, filename);
-            } else {
-                // Create hi-res temp texture
-                WGPUTextureDescriptor hiDesc = {};
-                hiDesc.size = { outW, outH, 1 };
-                hiDesc.format = WGPUTextureFormat_RGBA8Unorm;
-                hiDesc.usage = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopySrc;
-                hiDesc.mipLevelCount = 1;
-                hiDesc.sampleCount = 1;
-                hiDesc.dimension = WGPUTextureDimension_2D;
-                WGPUTexture hiTex = wgpuDeviceCreateTexture(gpu.device, &hiDesc);
-                WGPUTextureView hiView = wgpuTextureCreateView(hiTex, nullptr);
-
-                // Upload upscale params
-                uint32_t upParams[4] = { (uint32_t)rezX, (uint32_t)rezY, outW, outH };
-                wgpuQueueWriteBuffer(gpu.queue, upscaleUniform, 0, upParams, 16);
-
-                // Build bind group
-                WGPUBindGroupEntry bgEntries[4] = {};
-                bgEntries[0].binding = 0;
-                bgEntries[0].buffer = upscaleUniform;
-                bgEntries[0].size = 16;
-                bgEntries[1].binding = 1;
-                bgEntries[1].textureView = postFx.getOutputView();
-                bgEntries[2].binding = 2;
-                bgEntries[2].sampler = upscaleSampler;
-                bgEntries[3].binding = 3;
-                bgEntries[3].textureView = hiView;
-
-                WGPUBindGroupDescriptor bgDesc = {};
-                bgDesc.layout = upscaleBGL;
-                bgDesc.entryCount = 4;
-                bgDesc.entries = bgEntries;
-                WGPUBindGroup bg = wgpuDeviceCreateBindGroup(gpu.device, &bgDesc);
+            } else if (rerender) {
+                // Layers at the export size: agent sims re-rendered from their state, the
+                // others upsampled; then composite and post effects at that size
+                frameGraph.reset();
+                FgTextureDesc layerDesc;
+                layerDesc.width = outW;
+                layerDesc.height = outH;
+                FgTextureDesc fieldDesc = layerDesc;
+                fieldDesc.format = WGPUTextureFormat_RGBA16Float;
+                fieldDesc.usage = WGPUTextureUsage_StorageBinding | WGPUTextureUsage_TextureBinding;
+
+                std::vector<FrameGraph::Handle> sources(compositor.layers.size(), -1);
+                for (size_t i = 0; i < compositor.layers.size(); i++) {
+                    Simulation* sim = compositor.layers[i].sim;
+                    if (!compositor.layers[i].enabled || !sim || !sim->ready()) continue;
+                    std::string label = std::string("export_") + sim->name();
+                    FrameGraph::Handle out = frameGraph.createTexture(label.c_str(), layerDesc);
+                    if (sim->canRenderScaled()) {
+                        FrameGraph::Handle field = frameGraph.createTexture((label + "_field").c_str(),
+                                                                            fieldDesc);
+                        frameGraph.addPass("Export/render_scaled", {}, { field, out },
+                                           [&, sim, field, out](WGPUCommandEncoder enc) {
+                            sim->renderScaled(enc, (uint32_t)exportScale, frameGraph.view(field),
+                                              frameGraph.view(out));
+                        });
+                    } else {
+                        FrameGraph::Handle src = frameGraph.importTexture(sim->name(), nullptr,
+                                                                          sim->getOutputView());
+                        frameGraph.addPass("Export/upscale", { src }, { out },
+                                           [&, src, out](WGPUCommandEncoder enc) {
+                            hiresExporter.encodeUpscale(enc, frameGraph.view(src), rezX, rezY, frameGraph.view(out),
+                                                        outW, outH, 0, 0, outW, outH);
+                        });
+                    }
+                    sources[i] = out;
+                }
+
+                // Post effects at the export size; bloom radius is in pixels
+                float bloomRadius = postFx.bloomRadius;
+                postFx.bloomRadius *= (float)exportScale;
+                pacer.waitIdle(); // frames in flight still use the post output
+                postFx.resize(outW, outH);
+                postFx.addPasses(frameGraph, compositor.addPasses(frameGraph, sources, outW, outH));
+                postFx.bloomRadius = bloomRadius;
 
-                // Dispatch upscale
                 WGPUCommandEncoderDescriptor eDesc = {};
                 WGPUCommandEncoder enc2 = wgpuDeviceCreateCommandEncoder(gpu.device, &eDesc);
-                WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(enc2, nullptr);
-                wgpuComputePassEncoderSetPipeline(pass, upscalePipeline);
-                wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
-                wgpuComputePassEncoderDispatchWorkgroups(pass, (outW + 7) / 8, (outH + 7) / 8, 1);
-                wgpuComputePassEncoderEnd(pass);
-                wgpuComputePassEncoderRelease(pass);
+                frameGraph.execute(enc2);
 
                 WGPUCommandBufferDescriptor cb2Desc = {};
                 WGPUCommandBuffer cmd2 = wgpuCommandEncoderFinish(enc2, &cb2Desc);
@@ -488,86 +707,62 @@ int main() {
                 wgpuCommandBufferRelease(cmd2);
                 wgpuCommandEncoderRelease(enc2);
 
-                exportTextureToPNG(gpu.device, gpu.queue, hiTex, outW, outH, filename);
-
-                wgpuBindGroupRelease(bg);
-                wgpuTextureViewRelease(hiView);
-                wgpuTextureDestroy(hiTex);
-                wgpuTextureRelease(hiTex);
-            }
-        }
-
-        // Sequence recording — GPU readback here, PNG encode on worker thread
-        if (recording) {
-            if (seqFrame % seqInterval == 0) {
-                char seqFilename[256];
-                snprintf(seqFilename, sizeof(seqFilename), "%s/%06d.png", seqDir.c_str(), seqFrame);
+                exportTextureToPNG(gpu.device, gpu.queue, postFx.getOutputTexture(), outW, outH, filename);
+                postFx.resize(rezX, rezY);
+            } else if (tiled) {
+                // Beyond texture/buffer limits: tiles streamed into the PNG, bounded memory
+                hiresExporter.exportTiledPNG(postFx.getOutputView(), rezX, rezY, outW, outH, filename);
+            } else {
+                // Hi-res target is a graph output, pooled across exports
+                frameGraph.reset();
+                FgTextureDesc hiDesc;
+                hiDesc.width = outW;
+                hiDesc.height = outH;
+                FrameGraph::Handle src = frameGraph.importTexture("post_output", postFx.getOutputTexture(),
+                                                                  postFx.getOutputView());
+                FrameGraph::Handle hi = frameGraph.createTexture("export_hires", hiDesc);
+                frameGraph.markOutput(hi);
+
+                frameGraph.addPass("Export/upscale", { src }, { hi }, [&](WGPUCommandEncoder enc) {
+                    hiresExporter.encodeUpscale(enc, frameGraph.view(src), rezX, rezY, frameGraph.view(hi),
+                                                outW, outH, 0, 0, outW, outH);
+                });
 
-                WGPUTexture tex = postFx.getOutputTexture();
-                uint32_t w = rezX, h = rezY;
-                uint32_t bytesPerRow = ((w * 4 + 255) / 256) * 256;
-                uint64_t bufferSize = (uint64_t)bytesPerRow * h;
+                // Dispatch upscale
+                WGPUCommandEncoderDescriptor eDesc = {};
+                WGPUCommandEncoder enc2 = wgpuDeviceCreateCommandEncoder(gpu.device, &eDesc);
+                frameGraph.execute(enc2);
 
-                WGPUBufferDescriptor bufDesc = {};
-                bufDesc.size = bufferSize;
-                bufDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead;
-                WGPUBuffer readbackBuf = wgpuDeviceCreateBuffer(gpu.device, &bufDesc);
+                WGPUCommandBufferDescriptor cb2Desc = {};
+                WGPUCommandBuffer cmd2 = wgpuCommandEncoderFinish(enc2, &cb2Desc);
+                wgpuQueueSubmit(gpu.queue, 1, &cmd2);
+                wgpuCommandBufferRelease(cmd2);
+                wgpuCommandEncoderRelease(enc2);
 
-                WGPUCommandEncoderDescriptor eDesc = {};
-                WGPUCommandEncoder enc = wgpuDeviceCreateCommandEncoder(gpu.device, &eDesc);
-                WGPUImageCopyTexture src = {};
-                src.texture = tex;
-                WGPUImageCopyBuffer dst = {};
-                dst.buffer = readbackBuf;
-                dst.layout.bytesPerRow = bytesPerRow;
-                dst.layout.rowsPerImage = h;
-                WGPUExtent3D extent = { w, h, 1 };
-                wgpuCommandEncoderCopyTextureToBuffer(enc, &src, &dst, &extent);
-                WGPUCommandBufferDescriptor cbDesc2 = {};
-                WGPUCommandBuffer cmd = wgpuCommandEncoderFinish(enc, &cbDesc2);
-                wgpuQueueSubmit(gpu.queue, 1, &cmd);
-                wgpuCommandBufferRelease(cmd);
-                wgpuCommandEncoderRelease(enc);
-
-                struct MapData { bool done = false; WGPUBufferMapAsyncStatus status; };
-                MapData mapData;
-                wgpuBufferMapAsync(readbackBuf, WGPUMapMode_Read, 0, bufferSize,
-                    [](WGPUBufferMapAsyncStatus status, void* ud) {
-                        auto* d = (MapData*)ud;
-                        d->status = status;
-                        d->done = true;
-                    }, &mapData);
-                while (!mapData.done)
-                    wgpuDevicePoll(gpu.device, true, nullptr);
-
-                if (mapData.status == WGPUBufferMapAsyncStatus_Success) {
-                    const uint8_t* mapped = (const uint8_t*)wgpuBufferGetConstMappedRange(readbackBuf, 0, bufferSize);
-                    std::vector<uint8_t> pixels(w * h * 4);
-                    for (uint32_t y = 0; y < h; y++)
-                        memcpy(&pixels[y * w * 4], &mapped[y * bytesPerRow], w * 4);
-                    wgpuBufferUnmap(readbackBuf);
-                    asyncExporter.enqueue(std::move(pixels), w, h, seqFilename);
-                }
-                wgpuBufferRelease(readbackBuf);
+                exportTextureToPNG(gpu.device, gpu.queue, frameGraph.texture(hi), outW, outH, filename);
             }
-            seqFrame++;
         }
+        gpuPool().endFrame();
+        gpuTracker().endFrame();
     }
 
+    pacer.shutdown();
+    readbackRing.shutdown();
     asyncExporter.stop();
-    for (int i = 0; i < simCount; i++)
-        sims[i]->shutdown();
+    videoWriter.close();
+    yuvConverter.shutdown();
+    hasher.shutdown();
+    simStats.shutdown();
+    compositor.releaseLayers();
+    frameGraph.shutdown();
     compositor.shutdown();
     postFx.shutdown();
-    wgpuComputePipelineRelease(upscalePipeline);
-    wgpuPipelineLayoutRelease(upscalePL);
-    wgpuBindGroupLayoutRelease(upscaleBGL);
-    wgpuShaderModuleRelease(upscaleSM);
-    wgpuSamplerRelease(upscaleSampler);
-    wgpuBufferDestroy(upscaleUniform);
-    wgpuBufferRelease(upscaleUniform);
+    hiresExporter.shutdown();
+    gpuProfiler().shutdown();
     renderPass.shutdown();
     ui.shutdown();
+    gpuPool().shutdown();
+    gpuTracker().reportLeaks();
     gpu.shutdown();
     return 0;
 }
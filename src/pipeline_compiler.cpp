@@ -0,0 +1,175 @@
+#include "pipeline_compiler.h"
+#include "gpu_tracker.h"
+#include "cpu_trace.h"
+#include "compute_pass.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct PipelineShader {
+    std::string path;
+    std::once_flag created;
+    WGPUShaderModule module = nullptr; // null until a job created it, or when the file is invalid
+};
+
+struct PipelineJob {
+    WGPUDevice device = nullptr;
+    std::shared_ptr<PipelineShader> shader;
+    WGPUPipelineLayout layout = nullptr;
+    std::string entryPoint;
+    const char* owner = nullptr;
+    WGPUComputePipeline* out = nullptr;
+    WGPUComputePipeline result = nullptr;
+    std::atomic<bool> done{false};
+};
+
+namespace {
+
+// Worker threads shared by every batch, started on first use
+class CompilePool {
+public:
+    ~CompilePool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_cv.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+
+    void submit(std::shared_ptr<PipelineJob> job) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_threads.empty()) {
+                unsigned n = std::clamp(std::thread::hardware_concurrency(), 2u, 8u) - 1;
+                for (unsigned i = 0; i < n; i++) m_threads.emplace_back(&CompilePool::workerLoop, this, i);
+            }
+            m_queue.push_back(std::move(job));
+        }
+        m_cv.notify_one();
+    }
+
+    // Blocks until job is done
+    void wait(const PipelineJob& job) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [&] { return job.done.load(); });
+    }
+
+private:
+    void workerLoop(unsigned index) {
+        std::string name = "PipelineCompiler " + std::to_string(index);
+        traceSetThreadName(name.c_str());
+        while (true) {
+            std::shared_ptr<PipelineJob> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [&] { return !m_queue.empty() || !m_running; });
+                if (m_queue.empty()) break;
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            // Jobs of the same shader wait here for the one creating its module
+            PipelineShader& shader = *job->shader;
+            std::call_once(shader.created, [&] {
+                TRACE_SCOPE("create shader module");
+                std::string code = loadShaderFile(shader.path.c_str());
+                if (code.empty()) return;
+                WGPUShaderModuleWGSLDescriptor wgslDesc = {};
+                wgslDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
+                wgslDesc.code = code.c_str();
+                WGPUShaderModuleDescriptor smDesc = {};
+                smDesc.nextInChain = &wgslDesc.chain;
+                smDesc.label = shader.path.c_str();
+                shader.module = wgpuDeviceCreateShaderModule(job->device, &smDesc);
+            });
+
+            if (shader.module) {
+                TRACE_SCOPE("compile pipeline");
+                WGPUComputePipelineDescriptor desc = {};
+                desc.label = job->entryPoint.c_str();
+                desc.layout = job->layout;
+                desc.compute.module = shader.module;
+                desc.compute.entryPoint = job->entryPoint.c_str();
+                job->result = wgpuDeviceCreateComputePipeline(job->device, &desc);
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                job->done = true;
+            }
+            m_doneCv.notify_all();
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_cv, m_doneCv;
+    std::deque<std::shared_ptr<PipelineJob>> m_queue;
+    bool m_running = true;
+};
+
+CompilePool& compilePool() {
+    static CompilePool pool;
+    return pool;
+}
+
+} // namespace
+
+std::shared_ptr<PipelineShader> PipelineBatch::shader(const char* path) {
+    for (auto& s : m_shaders)
+        if (s->path == path) return s;
+    auto s = std::make_shared<PipelineShader>();
+    s->path = path;
+    m_shaders.push_back(s);
+    return s;
+}
+
+void PipelineBatch::add(WGPUDevice device, const std::shared_ptr<PipelineShader>& shader, const char* entryPoint,
+                        WGPUPipelineLayout layout, WGPUComputePipeline* out, const char* owner) {
+    auto job = std::make_shared<PipelineJob>();
+    job->device = device;
+    job->shader = shader;
+    job->layout = layout;
+    job->entryPoint = entryPoint;
+    job->owner = owner;
+    job->out = out;
+    m_jobs.push_back(job);
+    compilePool().submit(job);
+}
+
+void PipelineBatch::own(WGPUPipelineLayout layout) {
+    if (layout) m_layouts.push_back(layout);
+}
+
+void PipelineBatch::publish() {
+    for (auto& job : m_jobs) {
+        *job->out = job->result;
+        gpuTracker().onCreate(GpuObjectType::ComputePipeline, job->owner, job->result);
+        if (!job->result) fprintf(stderr, "[%s] Failed to compile pipeline '%s'\n", job->owner, job->entryPoint.c_str());
+    }
+    m_jobs.clear();
+    for (auto& s : m_shaders)
+        if (s->module) wgpuShaderModuleRelease(s->module);
+    for (auto l : m_layouts) wgpuPipelineLayoutRelease(l);
+    m_shaders.clear();
+    m_layouts.clear();
+}
+
+bool PipelineBatch::ready() {
+    for (auto& job : m_jobs)
+        if (!job->done) return false;
+    publish();
+    return true;
+}
+
+void PipelineBatch::wait() {
+    if (m_jobs.empty() && m_shaders.empty() && m_layouts.empty()) return;
+    TRACE_SCOPE("PipelineBatch::wait");
+    for (auto& job : m_jobs) compilePool().wait(*job);
+    publish();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <memory>
+#include <vector>
+
+// Compute pipelines compiled on a shared pool of worker threads, so every
+// sim's pipelines build concurrently while the main thread keeps drawing
+// frames. wgpu-native 0.19 leaves wgpuDeviceCreateComputePipelineAsync
+// unimplemented, but its device is thread-safe, so the blocking create calls
+// simply run on the workers.
+//
+// A PipelineBatch collects one owner's pipelines. The outputs are written
+// (and registered with the GpuTracker) on the main thread by ready()/wait()
+// once every job of the batch finished, so callers never see a partial set.
+// Shader modules are created on the workers too: the first job of a shader
+// file reads and parses it, the others of the batch reuse that module.
+// Layouts passed to add() must stay alive until ready(); own() hands them to
+// the batch, which releases them after compiling.
+struct PipelineJob;
+struct PipelineShader;
+
+class PipelineBatch {
+public:
+    PipelineBatch() = default;
+    ~PipelineBatch() { wait(); }
+    PipelineBatch(const PipelineBatch&) = delete;
+    PipelineBatch& operator=(const PipelineBatch&) = delete;
+
+    // WGSL file, one per path within the batch; released once the batch is ready
+    std::shared_ptr<PipelineShader> shader(const char* path);
+    // owner: GpuTracker subsystem, string literal
+    void add(WGPUDevice device, const std::shared_ptr<PipelineShader>& shader, const char* entryPoint,
+             WGPUPipelineLayout layout, WGPUComputePipeline* out, const char* owner);
+    void own(WGPUPipelineLayout layout);
+
+    bool ready(); // non-blocking: publishes the outputs once all jobs are done
+    void wait();  // blocks until ready (e.g. first step in the headless tools, shutdown)
+
+private:
+    void publish();
+
+    std::vector<std::shared_ptr<PipelineJob>> m_jobs;
+    std::vector<std::shared_ptr<PipelineShader>> m_shaders;
+    std::vector<WGPUPipelineLayout> m_layouts;
+};
@@ -0,0 +1,319 @@
+#include "png_stream.h"
+#include "cpu_trace.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+static constexpr int WINDOW = 32768;
+static constexpr int HASH_BITS = 15;
+static constexpr int MAX_CHAIN = 32; // candidates per position, ~zlib level 5
+static constexpr int MAX_MATCH = 258;
+static constexpr int STORED_MAX = 65535; // bytes per stored block
+
+static const uint16_t LEN_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                       35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LEN_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                        8193, 12289, 16385, 24577 };
+static const uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static uint32_t reverseBits(uint32_t code, int len) {
+    uint32_t r = 0;
+    for (int i = 0; i < len; i++) {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+static uint32_t crcUpdate(uint32_t crc, const uint8_t* data, size_t n) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    for (size_t i = 0; i < n; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static void putBE32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint32_t hash3(const uint8_t* p) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+PngStreamWriter::~PngStreamWriter() {
+    if (m_file) close();
+}
+
+bool PngStreamWriter::open(const std::string& path, uint32_t width, uint32_t height) {
+    if (m_file) close();
+    m_file = fopen(path.c_str(), "wb");
+    if (!m_file) {
+        fprintf(stderr, "Failed to open PNG for writing: %s\n", path.c_str());
+        return false;
+    }
+    m_path = path;
+    m_width = width;
+    m_height = height;
+    m_rows = 0;
+    m_ok = true;
+    m_bitBuf = 0;
+    m_bitCount = 0;
+    m_adlerA = 1;
+    m_adlerB = 0;
+
+    size_t rowBytes = (size_t)width * 4;
+    m_prevRow.assign(rowBytes, 0);
+    m_filtered.resize(rowBytes * 5);
+    m_band.clear();
+    m_band.reserve(BAND_BYTES + rowBytes + 1);
+    m_head.resize(1 << HASH_BITS);
+    m_prev.resize(WINDOW);
+    m_out.clear();
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    if (fwrite(signature, 1, 8, m_file) != 8) m_ok = false;
+
+    uint8_t ihdr[13] = {};
+    putBE32(ihdr, width);
+    putBE32(ihdr + 4, height);
+    ihdr[8] = 8;  // bit depth
+    ihdr[9] = 6;  // RGBA
+    writeChunk("IHDR", ihdr, sizeof(ihdr));
+
+    m_out.push_back(0x78); // zlib header: deflate, 32 KB window
+    m_out.push_back(0x01);
+    return m_ok;
+}
+
+void PngStreamWriter::filterRow(const uint8_t* row) {
+    size_t n = (size_t)m_width * 4;
+    const uint8_t* up = m_prevRow.data();
+    uint8_t* f = m_filtered.data();
+    uint64_t cost[5] = {};
+    for (size_t i = 0; i < n; i++) {
+        int x = row[i], a = i >= 4 ? row[i - 4] : 0, b = up[i], c = i >= 4 ? up[i - 4] : 0;
+        uint8_t v[5] = { (uint8_t)x, (uint8_t)(x - a), (uint8_t)(x - b),
+                         (uint8_t)(x - ((a + b) >> 1)), (uint8_t)(x - paeth(a, b, c)) };
+        for (int k = 0; k < 5; k++) {
+            f[k * n + i] = v[k];
+            cost[k] += (uint64_t)abs((int8_t)v[k]);
+        }
+    }
+    int best = (int)(std::min_element(cost, cost + 5) - cost);
+    m_band.push_back((uint8_t)best);
+    m_band.insert(m_band.end(), f + best * n, f + (best + 1) * n);
+    memcpy(m_prevRow.data(), row, n);
+}
+
+bool PngStreamWriter::writeRows(const uint8_t* rows, uint32_t count, size_t stride) {
+    if (!m_file) return false;
+    if (m_rows + count > m_height) {
+        fprintf(stderr, "PngStreamWriter: more rows than the image height (%u)\n", m_height);
+        m_ok = false;
+        count = m_height - m_rows;
+    }
+    TRACE_SCOPE("PngStreamWriter::writeRows");
+    for (uint32_t y = 0; y < count; y++) {
+        filterRow(rows + y * stride);
+        m_rows++;
+        if (m_band.size() >= BAND_BYTES) {
+            deflateBand(false);
+            flushIdat(false);
+        }
+    }
+    return m_ok;
+}
+
+void PngStreamWriter::putBits(uint32_t value, int count) {
+    m_bitBuf |= (uint64_t)value << m_bitCount;
+    m_bitCount += count;
+    while (m_bitCount >= 8) {
+        m_out.push_back((uint8_t)m_bitBuf);
+        m_bitBuf >>= 8;
+        m_bitCount -= 8;
+    }
+}
+
+void PngStreamWriter::alignToByte() {
+    if (m_bitCount > 0) putBits(0, 8 - m_bitCount);
+}
+
+void PngStreamWriter::putSymbol(uint32_t symbol) {
+    // Fixed Huffman table (RFC 1951 3.2.6); codes are sent MSB first
+    if (symbol < 144)      putBits(reverseBits(0x30 + symbol, 8), 8);
+    else if (symbol < 256) putBits(reverseBits(0x190 + symbol - 144, 9), 9);
+    else if (symbol < 280) putBits(reverseBits(symbol - 256, 7), 7);
+    else                   putBits(reverseBits(0xc0 + symbol - 280, 8), 8);
+}
+
+void PngStreamWriter::putMatch(uint32_t length, uint32_t distance) {
+    int l = 28; // 258 has its own code
+    if (length < 258) {
+        l = 27;
+        while (LEN_BASE[l] > length) l--;
+    }
+    putSymbol(257 + l);
+    if (LEN_EXTRA[l]) putBits(length - LEN_BASE[l], LEN_EXTRA[l]);
+
+    int d = 29;
+    while (DIST_BASE[d] > distance) d--;
+    putBits(reverseBits(d, 5), 5);
+    if (DIST_EXTRA[d]) putBits(distance - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+void PngStreamWriter::deflateBand(bool final) {
+    TRACE_SCOPE("PngStreamWriter::deflate");
+    const uint8_t* d = m_band.data();
+    int n = (int)m_band.size();
+
+    // Adler-32 of the uncompressed stream, reduced every 5552 bytes as zlib does
+    for (int i = 0; i < n;) {
+        int end = std::min(n, i + 5552);
+        for (; i < end; i++) {
+            m_adlerA += d[i];
+            m_adlerB += m_adlerA;
+        }
+        m_adlerA %= 65521;
+        m_adlerB %= 65521;
+    }
+
+    // Rolled back to stored blocks if the band doesn't compress (e.g. noise)
+    size_t savedOut = m_out.size();
+    uint64_t savedBitBuf = m_bitBuf;
+    int savedBitCount = m_bitCount;
+
+    putBits(final ? 1 : 0, 1);
+    putBits(1, 2); // fixed Huffman block
+
+    std::fill(m_head.begin(), m_head.end(), -1);
+    auto insert = [&](int p) {
+        uint32_t h = hash3(d + p);
+        m_prev[p & (WINDOW - 1)] = m_head[h];
+        m_head[h] = p;
+    };
+
+    for (int i = 0; i < n;) {
+        int bestLen = 0, bestDist = 0;
+        if (i + 3 <= n) {
+            int limit = std::min(MAX_MATCH, n - i);
+            int cand = m_head[hash3(d + i)];
+            for (int chain = 0; cand >= 0 && i - cand < WINDOW && chain < MAX_CHAIN; chain++) {
+                if (d[cand + bestLen] == d[i + bestLen]) {
+                    int len = 0;
+                    while (len < limit && d[cand + len] == d[i + len]) len++;
+                    if (len > bestLen) {
+                        bestLen = len;
+                        bestDist = i - cand;
+                        if (len == limit) break;
+                    }
+                }
+                cand = m_prev[cand & (WINDOW - 1)];
+            }
+            insert(i);
+        }
+        if (bestLen >= 3) {
+            putMatch(bestLen, bestDist);
+            for (int k = 1; k < bestLen; k++)
+                if (i + k + 3 <= n) insert(i + k);
+            i += bestLen;
+        } else {
+            putSymbol(d[i]);
+            i++;
+        }
+    }
+    putSymbol(256); // end of block
+
+    uint64_t packedBits = (m_out.size() - savedOut) * 8 + m_bitCount - savedBitCount;
+    int blocks = std::max(1, (n + STORED_MAX - 1) / STORED_MAX);
+    uint64_t storedBits = (uint64_t)blocks * (3 + 7 + 32) + (uint64_t)n * 8; // header, worst-case align, LEN/NLEN
+    if (packedBits > storedBits) {
+        m_out.resize(savedOut);
+        m_bitBuf = savedBitBuf;
+        m_bitCount = savedBitCount;
+        for (int b = 0, i = 0; b < blocks; b++) {
+            int len = std::min(STORED_MAX, n - i);
+            putBits(final && b + 1 == blocks ? 1 : 0, 1);
+            putBits(0, 2); // stored block
+            alignToByte();
+            putBits((uint32_t)len, 16);
+            putBits((uint32_t)len ^ 0xffffu, 16);
+            m_out.insert(m_out.end(), d + i, d + i + len);
+            i += len;
+        }
+    }
+    m_band.clear();
+}
+
+bool PngStreamWriter::writeChunk(const char type[4], const uint8_t* data, size_t size) {
+    uint8_t header[8];
+    putBE32(header, (uint32_t)size);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = crcUpdate(0xffffffffu, header + 4, 4);
+    if (size) crc = crcUpdate(crc, data, size);
+    uint8_t trailer[4];
+    putBE32(trailer, ~crc);
+
+    if (fwrite(header, 1, 8, m_file) != 8 ||
+        (size && fwrite(data, 1, size, m_file) != size) ||
+        fwrite(trailer, 1, 4, m_file) != 4)
+        m_ok = false;
+    return m_ok;
+}
+
+bool PngStreamWriter::flushIdat(bool all) {
+    if (m_out.size() >= CHUNK_BYTES || (all && !m_out.empty())) {
+        writeChunk("IDAT", m_out.data(), m_out.size());
+        m_out.clear();
+    }
+    return m_ok;
+}
+
+bool PngStreamWriter::close() {
+    if (!m_file) return false;
+    if (m_rows != m_height) {
+        fprintf(stderr, "PngStreamWriter: %u of %u rows written\n", m_rows, m_height);
+        m_ok = false;
+    }
+    deflateBand(true); // the last band (possibly empty) ends the stream
+    alignToByte();
+    uint8_t adler[4];
+    putBE32(adler, (m_adlerB << 16) | m_adlerA);
+    m_out.insert(m_out.end(), adler, adler + 4);
+    flushIdat(true);
+    writeChunk("IEND", nullptr, 0);
+
+    if (fclose(m_file) != 0) m_ok = false;
+    m_file = nullptr;
+    if (!m_ok) fprintf(stderr, "Failed to write PNG: %s\n", m_path.c_str());
+
+    m_prevRow = {};
+    m_filtered = {};
+    m_band = {};
+    m_head = {};
+    m_prev = {};
+    m_out = {};
+    return m_ok;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Streaming RGBA8 PNG writer for images too large to hold in memory (tiled
+// hi-res export). Rows are filtered (per-row best of the 5 PNG filters, as
+// stb does) and deflated as they arrive, and written out in IDAT chunks, so
+// memory stays at one band of rows whatever the image height.
+//
+// The deflater is a small LZ77 + fixed-Huffman coder: hash chains over a
+// 32 KB window, one block per band of BAND_BYTES, no matches across bands.
+// Bands that would grow (noise) are sent as stored blocks instead.
+// Compression is in the range of stbi_write_png.
+class PngStreamWriter {
+public:
+    static constexpr size_t BAND_BYTES = 4u << 20;  // filtered bytes per deflate block
+    static constexpr size_t CHUNK_BYTES = 1u << 20; // compressed bytes per IDAT chunk
+
+    ~PngStreamWriter();
+
+    bool open(const std::string& path, uint32_t width, uint32_t height);
+    // count rows of width RGBA8 pixels, stride bytes apart
+    bool writeRows(const uint8_t* rows, uint32_t count, size_t stride);
+    bool close(); // false if fewer rows than the height were written or a write failed
+
+private:
+    void filterRow(const uint8_t* row);
+    void deflateBand(bool final);
+    void putBits(uint32_t value, int count);
+    void putSymbol(uint32_t symbol); // fixed-Huffman literal/length code
+    void putMatch(uint32_t length, uint32_t distance);
+    void alignToByte();
+    bool writeChunk(const char type[4], const uint8_t* data, size_t size);
+    bool flushIdat(bool all);
+
+    FILE* m_file = nullptr;
+    std::string m_path;
+    uint32_t m_width = 0, m_height = 0, m_rows = 0;
+    bool m_ok = true;
+
+    std::vector<uint8_t> m_prevRow;  // unfiltered previous row (zeros before the first)
+    std::vector<uint8_t> m_filtered; // scratch: the 5 candidate filterings of a row
+    std::vector<uint8_t> m_band;     // filtered rows waiting to be deflated
+    std::vector<int32_t> m_head, m_prev; // LZ77 hash chains
+
+    std::vector<uint8_t> m_out; // compressed bytes not yet in an IDAT chunk
+    uint64_t m_bitBuf = 0;
+    int m_bitCount = 0;
+    uint32_t m_adlerA = 1, m_adlerB = 0;
+};
@@ -1,4 +1,7 @@
 #include "post_effects.h"
+#include "gpu_tracker.h"
+#include "gpu_profiler.h"
+#include "cpu_trace.h"
 #include <imgui.h>
 #include <cstring>
 #include <cmath>
@@ -90,7 +93,7 @@ void PostEffects::init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t
         desc.size = sizeof(GpuParams);
         desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
         desc.label = "post_effects_params";
-        m_uniformBuffer = wgpuDeviceCreateBuffer(m_device, &desc);
+        m_uniformBuffer = gpuCreateBuffer(m_device, &desc, "Post");
     }
 
     createTextures();
@@ -108,29 +111,21 @@ void PostEffects::createTextures() {
         desc.sampleCount = 1;
         desc.dimension = WGPUTextureDimension_2D;
         desc.label = label;
-        return wgpuDeviceCreateTexture(m_device, &desc);
+        return gpuCreateTexture(m_device, &desc, "Post");
     };
     auto makeView = [](WGPUTexture tex) -> WGPUTextureView {
-        return wgpuTextureCreateView(tex, nullptr);
+        return gpuCreateTextureView(tex, nullptr, "Post");
     };
 
-    m_bloomATex = makeTex("post_bloomA");
-    m_bloomBTex = makeTex("post_bloomB");
     m_outputTex = makeTex("post_output");
-    m_bloomAView = makeView(m_bloomATex);
-    m_bloomBView = makeView(m_bloomBTex);
     m_outputView = makeView(m_outputTex);
 }
 
 void PostEffects::destroyTextures() {
-    if (m_bloomAView) wgpuTextureViewRelease(m_bloomAView);
-    if (m_bloomBView) wgpuTextureViewRelease(m_bloomBView);
-    if (m_outputView) wgpuTextureViewRelease(m_outputView);
-    if (m_bloomATex) { wgpuTextureDestroy(m_bloomATex); wgpuTextureRelease(m_bloomATex); }
-    if (m_bloomBTex) { wgpuTextureDestroy(m_bloomBTex); wgpuTextureRelease(m_bloomBTex); }
-    if (m_outputTex) { wgpuTextureDestroy(m_outputTex); wgpuTextureRelease(m_outputTex); }
-    m_bloomAView = m_bloomBView = m_outputView = nullptr;
-    m_bloomATex = m_bloomBTex = m_outputTex = nullptr;
+    if (m_outputView) gpuRelease(m_outputView);
+    if (m_outputTex) { wgpuTextureDestroy(m_outputTex); gpuRelease(m_outputTex); }
+    m_outputView = nullptr;
+    m_outputTex = nullptr;
 }
 
 void PostEffects::createLutTexture() {
@@ -146,8 +141,8 @@ void PostEffects::createLutTexture() {
     desc.sampleCount = 1;
     desc.dimension = WGPUTextureDimension_2D;
     desc.label = "lut_texture";
-    m_lutTex = wgpuDeviceCreateTexture(m_device, &desc);
-    m_lutView = wgpuTextureCreateView(m_lutTex, nullptr);
+    m_lutTex = gpuCreateTexture(m_device, &desc, "Post");
+    m_lutView = gpuCreateTextureView(m_lutTex, nullptr, "Post");
 
     // Upload data
     WGPUImageCopyTexture dst = {};
@@ -166,7 +161,7 @@ void PostEffects::createLutTexture() {
     sampDesc.addressModeU = WGPUAddressMode_ClampToEdge;
     sampDesc.addressModeV = WGPUAddressMode_ClampToEdge;
     sampDesc.maxAnisotropy = 1;
-    m_lutSampler = wgpuDeviceCreateSampler(m_device, &sampDesc);
+    m_lutSampler = gpuCreateSampler(m_device, &sampDesc, "Post");
 }
 
 void PostEffects::resize(uint32_t w, uint32_t h) {
@@ -178,16 +173,6 @@ void PostEffects::resize(uint32_t w, uint32_t h) {
 }
 
 void PostEffects::createPipelines() {
-    std::string code = loadShaderFile("shaders/post_effects.wgsl");
-    if (code.empty()) return;
-
-    WGPUShaderModuleWGSLDescriptor wgslDesc = {};
-    wgslDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
-    wgslDesc.code = code.c_str();
-    WGPUShaderModuleDescriptor smDesc = {};
-    smDesc.nextInChain = &wgslDesc.chain;
-    m_shaderModule = wgpuDeviceCreateShaderModule(m_device, &smDesc);
-
     // Bind group layout: uniform, inputTex, bloomTex (read), outputTex (write), lutSampler, lutTex
     {
         WGPUBindGroupLayoutEntry entries[6] = {};
@@ -231,31 +216,54 @@ void PostEffects::createPipelines() {
         WGPUBindGroupLayoutDescriptor desc = {};
         desc.entryCount = 6;
         desc.entries = entries;
-        m_bindGroupLayout = wgpuDeviceCreateBindGroupLayout(m_device, &desc);
+        m_bindGroupLayout = gpuCreateBindGroupLayout(m_device, &desc, "Post");
     }
 
-    // Pipeline layout
-    {
-        WGPUPipelineLayoutDescriptor desc = {};
-        desc.bindGroupLayoutCount = 1;
-        desc.bindGroupLayouts = &m_bindGroupLayout;
-        m_pipelineLayout = wgpuDeviceCreatePipelineLayout(m_device, &desc);
-    }
-
-    auto makePipeline = [&](const char* entry) -> WGPUComputePipeline {
-        WGPUComputePipelineDescriptor desc = {};
-        desc.layout = m_pipelineLayout;
-        desc.compute.module = m_shaderModule;
-        desc.compute.entryPoint = entry;
-        return wgpuDeviceCreateComputePipeline(m_device, &desc);
+    auto makePipeline = [&](const char* entry, WGPUComputePipeline* out) {
+        compileComputePipeline(m_device, "shaders/post_effects.wgsl", entry, m_bindGroupLayout, m_pipelines,
+                               out, "Post");
     };
 
-    m_bloomHPipeline = makePipeline("bloom_h");
-    m_bloomVPipeline = makePipeline("bloom_v");
-    m_compositePipeline = makePipeline("composite");
+    makePipeline("bloom_h", &m_bloomHPipeline);
+    makePipeline("bloom_v", &m_bloomVPipeline);
+    makePipeline("composite", &m_compositePipeline);
+}
+
+void PostEffects::dispatch(WGPUCommandEncoder encoder, const char* name, WGPUComputePipeline pipeline,
+                           WGPUTextureView input, WGPUTextureView secondary, WGPUTextureView output) {
+    WGPUBindGroupEntry entries[6] = {};
+    entries[0].binding = 0;
+    entries[0].buffer = m_uniformBuffer;
+    entries[0].size = sizeof(GpuParams);
+    entries[1].binding = 1;
+    entries[1].textureView = input;
+    entries[2].binding = 2;
+    entries[2].textureView = secondary;
+    entries[3].binding = 3;
+    entries[3].textureView = output;
+    entries[4].binding = 4;
+    entries[4].sampler = m_lutSampler;
+    entries[5].binding = 5;
+    entries[5].textureView = m_lutView;
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout = m_bindGroupLayout;
+    desc.entryCount = 6;
+    desc.entries = entries;
+    WGPUBindGroup bg = gpuCreateBindGroup(m_device, &desc, "Post");
+
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, name);
+    wgpuComputePassEncoderSetPipeline(pass, pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, (m_width + 7) / 8, (m_height + 7) / 8, 1);
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+    gpuRelease(bg);
 }
 
-void PostEffects::apply(WGPUCommandEncoder encoder, WGPUTextureView simOutput) {
+void PostEffects::addPasses(FrameGraph& fg, FrameGraph::Handle input) {
+    TRACE_SCOPE("PostEffects::addPasses");
+    m_pipelines.wait(); // no-op once compiled
     // Re-upload LUT if colormap changed
     {
         static int lastColormapIndex = -1;
@@ -288,69 +296,31 @@ void PostEffects::apply(WGPUCommandEncoder encoder, WGPUTextureView simOutput) {
     gp.useLut = useColormap ? 1u : 0u;
     wgpuQueueWriteBuffer(m_queue, m_uniformBuffer, 0, &gp, sizeof(gp));
 
-    uint32_t wg = (m_width + 7) / 8;
-    uint32_t hg = (m_height + 7) / 8;
+    FgTextureDesc texDesc;
+    texDesc.width = m_width;
+    texDesc.height = m_height;
+    FrameGraph::Handle bloomA = fg.createTexture("post_bloomA", texDesc);
+    FrameGraph::Handle bloomB = fg.createTexture("post_bloomB", texDesc);
+    FrameGraph::Handle output = fg.importTexture("post_output", m_outputTex, m_outputView);
 
-    // Helper to build bind group
-    auto buildBG = [&](WGPUTextureView input, WGPUTextureView secondary, WGPUTextureView output) -> WGPUBindGroup {
-        WGPUBindGroupEntry entries[6] = {};
-        entries[0].binding = 0;
-        entries[0].buffer = m_uniformBuffer;
-        entries[0].size = sizeof(GpuParams);
-        entries[1].binding = 1;
-        entries[1].textureView = input;
-        entries[2].binding = 2;
-        entries[2].textureView = secondary;
-        entries[3].binding = 3;
-        entries[3].textureView = output;
-        entries[4].binding = 4;
-        entries[4].sampler = m_lutSampler;
-        entries[5].binding = 5;
-        entries[5].textureView = m_lutView;
-
-        WGPUBindGroupDescriptor desc = {};
-        desc.layout = m_bindGroupLayout;
-        desc.entryCount = 6;
-        desc.entries = entries;
-        return wgpuDeviceCreateBindGroup(m_device, &desc);
-    };
-
-    // Pass 1: Horizontal bloom blur (simOutput -> bloomA)
+    // Pass 1: Horizontal bloom blur (input -> bloomA)
     // secondary is unused but we need a valid view
-    {
-        WGPUBindGroup bg = buildBG(simOutput, simOutput, m_bloomAView);
-        WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-        wgpuComputePassEncoderSetPipeline(pass, m_bloomHPipeline);
-        wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
-        wgpuComputePassEncoderDispatchWorkgroups(pass, wg, hg, 1);
-        wgpuComputePassEncoderEnd(pass);
-        wgpuComputePassEncoderRelease(pass);
-        wgpuBindGroupRelease(bg);
-    }
+    fg.addPass("Post/bloom_h", { input }, { bloomA }, [this, &fg, input, bloomA](WGPUCommandEncoder encoder) {
+        dispatch(encoder, "Post/bloom_h", m_bloomHPipeline, fg.view(input), fg.view(input), fg.view(bloomA));
+    });
 
     // Pass 2: Vertical bloom blur (bloomA -> bloomB)
-    {
-        WGPUBindGroup bg = buildBG(m_bloomAView, m_bloomAView, m_bloomBView);
-        WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-        wgpuComputePassEncoderSetPipeline(pass, m_bloomVPipeline);
-        wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
-        wgpuComputePassEncoderDispatchWorkgroups(pass, wg, hg, 1);
-        wgpuComputePassEncoderEnd(pass);
-        wgpuComputePassEncoderRelease(pass);
-        wgpuBindGroupRelease(bg);
-    }
-
-    // Pass 3: Composite (simOutput + bloomB -> output)
-    {
-        WGPUBindGroup bg = buildBG(simOutput, m_bloomBView, m_outputView);
-        WGPUComputePassEncoder pass = wgpuCommandEncoderBeginComputePass(encoder, nullptr);
-        wgpuComputePassEncoderSetPipeline(pass, m_compositePipeline);
-        wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
-        wgpuComputePassEncoderDispatchWorkgroups(pass, wg, hg, 1);
-        wgpuComputePassEncoderEnd(pass);
-        wgpuComputePassEncoderRelease(pass);
-        wgpuBindGroupRelease(bg);
-    }
+    fg.addPass("Post/bloom_v", { bloomA }, { bloomB }, [this, &fg, bloomA, bloomB](WGPUCommandEncoder encoder) {
+        dispatch(encoder, "Post/bloom_v", m_bloomVPipeline, fg.view(bloomA), fg.view(bloomA), fg.view(bloomB));
+    });
+
+    // Pass 3: Composite (input + bloomB -> output). Without bloom the input
+    // stands in as secondary (scaled by 0), so nothing reads the blur and the
+    // graph culls both bloom passes.
+    FrameGraph::Handle bloom = bloomIntensity > 0.0f ? bloomB : input;
+    fg.addPass("Post/composite", { input, bloom }, { output }, [this, &fg, input, bloom, output](WGPUCommandEncoder encoder) {
+        dispatch(encoder, "Post/composite", m_compositePipeline, fg.view(input), fg.view(bloom), fg.view(output));
+    });
 }
 
 WGPUTextureView PostEffects::getOutputView() const {
@@ -383,16 +353,15 @@ void PostEffects::onGui() {
 }
 
 void PostEffects::shutdown() {
+    m_pipelines.wait(); // jobs still use the layout
     destroyTextures();
-    if (m_lutView) wgpuTextureViewRelease(m_lutView);
-    if (m_lutTex) { wgpuTextureDestroy(m_lutTex); wgpuTextureRelease(m_lutTex); }
-    if (m_lutSampler) wgpuSamplerRelease(m_lutSampler);
+    if (m_lutView) gpuRelease(m_lutView);
+    if (m_lutTex) { wgpuTextureDestroy(m_lutTex); gpuRelease(m_lutTex); }
+    if (m_lutSampler) gpuRelease(m_lutSampler);
     m_lutView = nullptr; m_lutTex = nullptr; m_lutSampler = nullptr;
-    if (m_uniformBuffer) { wgpuBufferDestroy(m_uniformBuffer); wgpuBufferRelease(m_uniformBuffer); }
-    if (m_bloomHPipeline) wgpuComputePipelineRelease(m_bloomHPipeline);
-    if (m_bloomVPipeline) wgpuComputePipelineRelease(m_bloomVPipeline);
-    if (m_compositePipeline) wgpuComputePipelineRelease(m_compositePipeline);
-    if (m_bindGroupLayout) wgpuBindGroupLayoutRelease(m_bindGroupLayout);
-    if (m_pipelineLayout) wgpuPipelineLayoutRelease(m_pipelineLayout);
-    if (m_shaderModule) wgpuShaderModuleRelease(m_shaderModule);
+    if (m_uniformBuffer) { wgpuBufferDestroy(m_uniformBuffer); gpuRelease(m_uniformBuffer); }
+    if (m_bloomHPipeline) gpuRelease(m_bloomHPipeline);
+    if (m_bloomVPipeline) gpuRelease(m_bloomVPipeline);
+    if (m_compositePipeline) gpuRelease(m_compositePipeline);
+    if (m_bindGroupLayout) gpuRelease(m_bindGroupLayout);
 }
@@ -1,13 +1,18 @@
 #pragma once
 #include <webgpu/webgpu.h>
 #include "compute_pass.h"
+#include "frame_graph.h"
 #include <cstdint>
 
 class PostEffects {
 public:
     void init(WGPUDevice device, WGPUQueue queue, uint32_t w, uint32_t h);
     void resize(uint32_t w, uint32_t h);
-    void apply(WGPUCommandEncoder encoder, WGPUTextureView simOutput);
+    // Bloom (transient, culled at zero intensity) + composite into the output texture
+    void addPasses(FrameGraph& fg, FrameGraph::Handle input);
+    // False while the pipelines still compile in the background; addPasses()
+    // blocks until they are done, so the app checks this first
+    bool ready() { return m_pipelines.ready(); }
     WGPUTextureView getOutputView() const;
     WGPUTexture getOutputTexture() const { return m_outputTex; }
     void onGui();
@@ -28,14 +33,16 @@ private:
     void createTextures();
     void createPipelines();
     void destroyTextures();
+    void dispatch(WGPUCommandEncoder encoder, const char* name, WGPUComputePipeline pipeline,
+                  WGPUTextureView input, WGPUTextureView secondary, WGPUTextureView output);
 
     WGPUDevice m_device = nullptr;
     WGPUQueue m_queue = nullptr;
     uint32_t m_width = 0, m_height = 0;
 
-    // Textures: bloomA (h-blur result), bloomB (v-blur result), output (final)
-    WGPUTexture m_bloomATex = nullptr, m_bloomBTex = nullptr, m_outputTex = nullptr;
-    WGPUTextureView m_bloomAView = nullptr, m_bloomBView = nullptr, m_outputView = nullptr;
+    // Final output; the bloom blur targets are frame graph transients
+    WGPUTexture m_outputTex = nullptr;
+    WGPUTextureView m_outputView = nullptr;
 
     // LUT
     WGPUTexture m_lutTex = nullptr;
@@ -44,12 +51,11 @@ private:
     void createLutTexture();
 
     // Pipelines
-    WGPUShaderModule m_shaderModule = nullptr;
-    WGPUPipelineLayout m_pipelineLayout = nullptr;
     WGPUBindGroupLayout m_bindGroupLayout = nullptr;
     WGPUComputePipeline m_bloomHPipeline = nullptr;
     WGPUComputePipeline m_bloomVPipeline = nullptr;
     WGPUComputePipeline m_compositePipeline = nullptr;
+    PipelineBatch m_pipelines;
 
     // Uniform buffer
     WGPUBuffer m_uniformBuffer = nullptr;
@@ -7,8 +7,10 @@
 #include <cstdio>
 #include <sys/stat.h>
 
-inline void savePreset(const std::string& filename,
-                       const std::map<std::string, std::vector<float>>& data) {
+// Preset contents: key -> one or more float values (one line per key on disk)
+using PresetData = std::map<std::string, std::vector<float>>;
+
+inline void savePreset(const std::string& filename, const PresetData& data) {
     std::string dir = "presets";
     mkdir(dir.c_str(), 0755);
     std::string path = dir + "/" + filename + ".txt";
@@ -20,9 +22,9 @@ inline void savePreset(const std::string& filename,
     }
 }
 
-inline std::map<std::string, std::vector<float>> loadPreset(const std::string& filename) {
-    std::map<std::string, std::vector<float>> data;
-    std::string path = "presets/" + filename + ".txt";
+// Load a preset from an explicit file path (e.g. "presets/physarum_bacteria.txt")
+inline PresetData loadPresetFile(const std::string& path) {
+    PresetData data;
     std::ifstream f(path);
     if (!f.is_open()) return data;
     std::string line;
@@ -37,3 +39,15 @@ inline std::map<std::string, std::vector<float>> loadPreset(const std::string& f
     }
     return data;
 }
+
+inline PresetData loadPreset(const std::string& filename) {
+    return loadPresetFile("presets/" + filename + ".txt");
+}
+
+// Copy up to n values stored under key into dst. Returns false if the key is absent.
+inline bool presetGet(const PresetData& data, const char* key, float* dst, size_t n) {
+    auto it = data.find(key);
+    if (it == data.end() || it->second.empty()) return false;
+    for (size_t i = 0; i < n && i < it->second.size(); i++) dst[i] = it->second[i];
+    return true;
+}
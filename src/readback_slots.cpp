@@ -0,0 +1,135 @@
+#include "readback_slots.h"
+#include "gpu_tracker.h"
+#include <webgpu/wgpu.h>
+#include <algorithm>
+#include <cstring>
+
+void ReadbackSlots::init(WGPUDevice device, WGPUQueue queue, uint64_t resultSize, uint32_t maxDispatches,
+                         const char* name, const char* owner) {
+    m_device = device;
+    m_queue = queue;
+    m_resultSize = resultSize;
+    m_maxDispatches = maxDispatches;
+    m_name = name;
+    m_owner = owner;
+}
+
+uint32_t ReadbackSlots::begin(WGPUCommandEncoder encoder) {
+    uint32_t index = 0;
+    while (index < m_slots.size() && m_slots[index]->state != SlotState::Free) index++;
+
+    if (index == m_slots.size()) {
+        auto slot = std::make_unique<Slot>();
+        std::string label = m_name + "_result";
+        WGPUBufferDescriptor desc = {};
+        desc.label = label.c_str();
+        desc.size = m_resultSize;
+        desc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst;
+        slot->result = gpuCreateBuffer(m_device, &desc, m_owner);
+
+        label = m_name + "_readback";
+        desc.label = label.c_str();
+        desc.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+        slot->readback = gpuCreateBuffer(m_device, &desc, m_owner);
+
+        label = m_name + "_params";
+        desc.label = label.c_str();
+        desc.size = UNIFORM_STRIDE * m_maxDispatches;
+        desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+        slot->uniforms = gpuCreateBuffer(m_device, &desc, m_owner);
+
+        slot->params.resize(UNIFORM_STRIDE * m_maxDispatches);
+        m_slots.push_back(std::move(slot));
+    }
+
+    Slot& slot = *m_slots[index];
+    slot.dispatches = 0;
+    slot.state = SlotState::Encoding;
+    wgpuCommandEncoderClearBuffer(encoder, slot.result, 0, m_resultSize);
+    return index;
+}
+
+WGPUBindGroup ReadbackSlots::bindGroup(uint32_t index, WGPUBindGroupLayout layout, const void* params,
+                                       uint32_t size, const WGPUBindGroupEntry* entries, uint32_t count) {
+    Slot& slot = *m_slots[index];
+    if (slot.dispatches >= m_maxDispatches || size > UNIFORM_STRIDE) return nullptr;
+
+    uint64_t offset = slot.dispatches * UNIFORM_STRIDE;
+    memcpy(&slot.params[offset], params, size);
+
+    std::vector<WGPUBindGroupEntry> e(count + 1);
+    e[0].binding = 0;
+    e[0].buffer = slot.uniforms;
+    e[0].offset = offset;
+    e[0].size = size;
+    for (uint32_t i = 0; i < count; i++) e[i + 1] = entries[i];
+
+    WGPUBindGroupDescriptor desc = {};
+    desc.layout = layout;
+    desc.entryCount = count + 1;
+    desc.entries = e.data();
+    WGPUBindGroup bg = gpuCreateBindGroup(m_device, &desc, m_owner);
+    slot.bindGroups.push_back(bg);
+    slot.dispatches++;
+    return bg;
+}
+
+void ReadbackSlots::finish(WGPUCommandEncoder encoder, uint32_t index) {
+    Slot& slot = *m_slots[index];
+    for (auto bg : slot.bindGroups) gpuRelease(bg);
+    slot.bindGroups.clear();
+
+    if (slot.dispatches)
+        wgpuQueueWriteBuffer(m_queue, slot.uniforms, 0, slot.params.data(), slot.dispatches * UNIFORM_STRIDE);
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, slot.result, 0, slot.readback, 0, m_resultSize);
+
+    slot.seq = m_nextSeq++;
+    slot.state = SlotState::Encoded;
+}
+
+void ReadbackSlots::afterSubmit() {
+    for (auto& s : m_slots) {
+        if (s->state != SlotState::Encoded) continue;
+        s->state = SlotState::Pending;
+        wgpuBufferMapAsync(s->readback, WGPUMapMode_Read, 0, m_resultSize,
+            [](WGPUBufferMapAsyncStatus status, void* ud) {
+                auto* slot = (Slot*)ud;
+                slot->state = (status == WGPUBufferMapAsyncStatus_Success) ? SlotState::Ready : SlotState::Failed;
+            }, s.get());
+    }
+}
+
+void ReadbackSlots::poll(const std::function<void(uint32_t, const void*)>& fn) {
+    if (!m_device) return;
+    wgpuDevicePoll(m_device, false, nullptr);
+
+    // Deliver in encode order; slots are reused out of order
+    std::vector<uint32_t> ready;
+    for (uint32_t i = 0; i < m_slots.size(); i++) {
+        Slot& s = *m_slots[i];
+        if (s.state == SlotState::Failed) s.state = SlotState::Free;
+        if (s.state == SlotState::Ready) ready.push_back(i);
+    }
+    std::sort(ready.begin(), ready.end(),
+              [&](uint32_t a, uint32_t b) { return m_slots[a]->seq < m_slots[b]->seq; });
+
+    for (uint32_t i : ready) {
+        Slot& s = *m_slots[i];
+        fn(i, wgpuBufferGetConstMappedRange(s.readback, 0, m_resultSize));
+        wgpuBufferUnmap(s.readback);
+        s.state = SlotState::Free;
+    }
+}
+
+void ReadbackSlots::shutdown() {
+    for (auto& s : m_slots) {
+        if (s->state == SlotState::Ready) wgpuBufferUnmap(s->readback);
+        for (auto bg : s->bindGroups) gpuRelease(bg);
+        if (s->result) { wgpuBufferDestroy(s->result); gpuRelease(s->result); }
+        if (s->readback) { wgpuBufferDestroy(s->readback); gpuRelease(s->readback); }
+        if (s->uniforms) { wgpuBufferDestroy(s->uniforms); gpuRelease(s->uniforms); }
+    }
+    m_slots.clear();
+    m_nextSeq = 0;
+    m_device = nullptr;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Small GPU results read back asynchronously, shared by StateHasher and
+// SimStats. Each encode takes a free slot: a result buffer the kernels write,
+// a mappable copy of it and a uniform buffer with one params block per
+// dispatch. Slots are mapped after submit and handed back in encode order,
+// a frame or two later.
+//
+// Per encode: begin() -> bindGroup() per dispatch -> end the pass -> finish().
+// Per frame: submit -> afterSubmit(); poll() each frame.
+class ReadbackSlots {
+public:
+    static constexpr uint64_t UNIFORM_STRIDE = 256; // minUniformBufferOffsetAlignment
+
+    // name prefixes the buffer labels ("<name>_result", ...), owner tags them in gpuTracker()
+    void init(WGPUDevice device, WGPUQueue queue, uint64_t resultSize, uint32_t maxDispatches,
+              const char* name, const char* owner);
+    void shutdown();
+
+    // Takes a free slot (new buffers when all are in flight) and clears its result
+    uint32_t begin(WGPUCommandEncoder encoder);
+    WGPUBuffer result(uint32_t slot) const { return m_slots[slot]->result; }
+    uint32_t dispatches(uint32_t slot) const { return m_slots[slot]->dispatches; }
+    uint32_t maxDispatches() const { return m_maxDispatches; }
+
+    // Bind group for the slot's next dispatch: params at binding 0, then
+    // entries. Null once maxDispatches() are used. Released by finish().
+    WGPUBindGroup bindGroup(uint32_t slot, WGPUBindGroupLayout layout, const void* params, uint32_t size,
+                            const WGPUBindGroupEntry* entries, uint32_t count);
+
+    // After the pass ends: uploads the params and copies the result to the readback buffer
+    void finish(WGPUCommandEncoder encoder, uint32_t slot);
+    void afterSubmit();
+    // fn(slot, mapped result) for every finished slot in encode order; the slot is free afterwards
+    void poll(const std::function<void(uint32_t, const void*)>& fn);
+
+private:
+    enum class SlotState { Free, Encoding, Encoded, Pending, Ready, Failed };
+    struct Slot {
+        WGPUBuffer result = nullptr;
+        WGPUBuffer readback = nullptr;
+        WGPUBuffer uniforms = nullptr;
+        std::vector<uint8_t> params; // staged uniforms, UNIFORM_STRIDE per dispatch
+        std::vector<WGPUBindGroup> bindGroups;
+        uint32_t dispatches = 0;
+        uint64_t seq = 0;
+        SlotState state = SlotState::Free;
+    };
+
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    uint64_t m_resultSize = 0;
+    uint32_t m_maxDispatches = 0;
+    std::string m_name;
+    const char* m_owner = "";
+
+    std::vector<std::unique_ptr<Slot>> m_slots; // stable addresses for the map callbacks
+    uint64_t m_nextSeq = 0;
+};
@@ -1,4 +1,6 @@
 #include "render_pass.h"
+#include "gpu_tracker.h"
+#include "gpu_profiler.h"
 #include "compute_pass.h" // for loadShaderFile
 #include <cstdio>
 
@@ -22,7 +24,7 @@ void RenderPass::init(WGPUDevice device, WGPUTextureFormat surfaceFormat) {
     WGPUBindGroupLayoutDescriptor bglDesc = {};
     bglDesc.entryCount = 3;
     bglDesc.entries = entries;
-    bindGroupLayout = wgpuDeviceCreateBindGroupLayout(device, &bglDesc);
+    bindGroupLayout = gpuCreateBindGroupLayout(device, &bglDesc, "Display");
 
     // Sampler — nearest neighbor for crisp pixels when zoomed
     WGPUSamplerDescriptor samplerDesc = {};
@@ -33,7 +35,7 @@ void RenderPass::init(WGPUDevice device, WGPUTextureFormat surfaceFormat) {
     samplerDesc.addressModeW = WGPUAddressMode_ClampToEdge;
     samplerDesc.mipmapFilter = WGPUMipmapFilterMode_Nearest;
     samplerDesc.maxAnisotropy = 1;
-    sampler = wgpuDeviceCreateSampler(device, &samplerDesc);
+    sampler = gpuCreateSampler(device, &samplerDesc, "Display");
 
     // Uniform buffer for transform (vec4f: xy=offset, z=zoom, w=unused)
     {
@@ -41,7 +43,7 @@ void RenderPass::init(WGPUDevice device, WGPUTextureFormat surfaceFormat) {
         desc.size = 16;
         desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
         desc.label = "render_transform";
-        uniformBuffer = wgpuDeviceCreateBuffer(device, &desc);
+        uniformBuffer = gpuCreateBuffer(device, &desc, "Display");
 
         // Default: no offset, zoom=1
         float data[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
@@ -85,7 +87,7 @@ void RenderPass::init(WGPUDevice device, WGPUTextureFormat surfaceFormat) {
     rpDesc.multisample.mask = 0xFFFFFFFF;
     rpDesc.fragment = &fragState;
 
-    pipeline = wgpuDeviceCreateRenderPipeline(device, &rpDesc);
+    pipeline = gpuCreateRenderPipeline(device, &rpDesc, "Display");
 
     wgpuPipelineLayoutRelease(layout);
     wgpuShaderModuleRelease(module);
@@ -105,7 +107,7 @@ WGPUBindGroup RenderPass::createBindGroup(WGPUDevice device, WGPUTextureView tex
     desc.layout = bindGroupLayout;
     desc.entryCount = 3;
     desc.entries = entries;
-    return wgpuDeviceCreateBindGroup(device, &desc);
+    return gpuCreateBindGroup(device, &desc, "Display");
 }
 
 void RenderPass::setTransform(WGPUQueue queue, float offsetX, float offsetY, float zoom, float aspectRatio) {
@@ -124,6 +126,7 @@ void RenderPass::draw(WGPUCommandEncoder encoder, WGPUTextureView targetView,
     WGPURenderPassDescriptor rpDesc = {};
     rpDesc.colorAttachmentCount = 1;
     rpDesc.colorAttachments = &colorAtt;
+    rpDesc.timestampWrites = gpuProfiler().renderPassTimestamps("Display");
 
     WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(encoder, &rpDesc);
     wgpuRenderPassEncoderSetPipeline(pass, pipeline);
@@ -134,8 +137,8 @@ void RenderPass::draw(WGPUCommandEncoder encoder, WGPUTextureView targetView,
 }
 
 void RenderPass::shutdown() {
-    if (uniformBuffer) { wgpuBufferDestroy(uniformBuffer); wgpuBufferRelease(uniformBuffer); }
-    if (sampler) wgpuSamplerRelease(sampler);
-    if (bindGroupLayout) wgpuBindGroupLayoutRelease(bindGroupLayout);
-    if (pipeline) wgpuRenderPipelineRelease(pipeline);
+    if (uniformBuffer) { wgpuBufferDestroy(uniformBuffer); gpuRelease(uniformBuffer); }
+    if (sampler) gpuRelease(sampler);
+    if (bindGroupLayout) gpuRelease(bindGroupLayout);
+    if (pipeline) gpuRelease(pipeline);
 }
@@ -0,0 +1,133 @@
+#include "scaled_trail.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "compute_pass.h"
+#include "cpu_trace.h"
+#include <algorithm>
+#include <vector>
+
+void ScaledTrail::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+    m_queue = queue;
+
+    // uniform, trail, agents, stamps, field
+    WGPUBindGroupLayoutEntry entries[5] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = WGPUShaderStage_Compute;
+    entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+    entries[0].buffer.hasDynamicOffset = true;
+    entries[0].buffer.minBindingSize = sizeof(GpuParams);
+    entries[1].binding = 1;
+    entries[1].visibility = WGPUShaderStage_Compute;
+    entries[1].texture.sampleType = WGPUTextureSampleType_Float;
+    entries[1].texture.viewDimension = WGPUTextureViewDimension_2D;
+    entries[2].binding = 2;
+    entries[2].visibility = WGPUShaderStage_Compute;
+    entries[2].buffer.type = WGPUBufferBindingType_ReadOnlyStorage;
+    entries[2].buffer.minBindingSize = 8;
+    entries[3].binding = 3;
+    entries[3].visibility = WGPUShaderStage_Compute;
+    entries[3].buffer.type = WGPUBufferBindingType_Storage;
+    entries[3].buffer.minBindingSize = 16;
+    entries[4].binding = 4;
+    entries[4].visibility = WGPUShaderStage_Compute;
+    entries[4].storageTexture.access = WGPUStorageTextureAccess_WriteOnly;
+    entries[4].storageTexture.format = WGPUTextureFormat_RGBA16Float;
+    entries[4].storageTexture.viewDimension = WGPUTextureViewDimension_2D;
+
+    WGPUBindGroupLayoutDescriptor desc = {};
+    desc.entryCount = 5;
+    desc.entries = entries;
+    m_layout = gpuCreateBindGroupLayout(device, &desc, "Export");
+
+    compileComputePipeline(device, "shaders/scaled_trail.wgsl", "clear_stamps", m_layout, m_pipelines,
+                           &m_clearPipeline, "Export");
+    compileComputePipeline(device, "shaders/scaled_trail.wgsl", "stamp_agents", m_layout, m_pipelines,
+                           &m_stampPipeline, "Export");
+    compileComputePipeline(device, "shaders/scaled_trail.wgsl", "resolve", m_layout, m_pipelines,
+                           &m_resolvePipeline, "Export");
+
+    m_uniforms.init(device, queue, sizeof(GpuParams), 8, "Export");
+}
+
+void ScaledTrail::encode(WGPUCommandEncoder encoder, const SimStateViews& state, WGPUTextureView trail,
+                         uint32_t scale, WGPUTextureView field) {
+    TRACE_SCOPE("ScaledTrail::encode");
+    m_pipelines.wait(); // no-op once compiled
+    if (!m_clearPipeline || !m_stampPipeline || !m_resolvePipeline || !state.agents || !state.agentStride) return;
+
+    uint32_t w = state.width * scale, h = state.height * scale;
+    uint32_t bandRows = (uint32_t)std::clamp<uint64_t>(STAMP_BYTES / ((uint64_t)w * 16), 1, h);
+    uint32_t bands = (h + bandRows - 1) / bandRows;
+    uint64_t size = (uint64_t)w * bandRows * 16;
+    if (size > m_stampsSize) {
+        if (m_stamps) gpuPool().recycle(m_stamps);
+        m_stamps = gpuPool().acquireBuffer(size, WGPUBufferUsage_Storage, "export_stamps", "Export");
+        m_stampsSize = size;
+    }
+
+    GpuParams gp = {};
+    gp.rezX = w;
+    gp.rezY = h;
+    gp.agents = (uint32_t)(state.agentBytes / state.agentStride);
+    gp.stride = state.agentStride / 4;
+    gp.typeWord = state.typeOffset >= 0 ? state.typeOffset / 4 : -1;
+    gp.scale = (float)scale;
+    for (int i = 0; i < 4; i++) gp.typeRatios[i] = state.typeRatios[i];
+
+    m_uniforms.reserve(bands);
+    std::vector<uint32_t> offsets(bands);
+    for (uint32_t b = 0; b < bands; b++) {
+        gp.bandY = b * bandRows;
+        gp.bandRows = std::min(bandRows, h - gp.bandY);
+        offsets[b] = m_uniforms.push(&gp);
+    }
+    m_uniforms.upload();
+
+    WGPUBindGroupEntry e[5] = {};
+    e[0].binding = 0;
+    e[0].buffer = m_uniforms.buffer();
+    e[0].size = sizeof(GpuParams);
+    e[1].binding = 1;
+    e[1].textureView = trail;
+    e[2].binding = 2;
+    e[2].buffer = state.agents;
+    e[2].size = state.agentBytes;
+    e[3].binding = 3;
+    e[3].buffer = m_stamps;
+    e[3].size = size;
+    e[4].binding = 4;
+    e[4].textureView = field;
+    WGPUBindGroupDescriptor bgDesc = {};
+    bgDesc.layout = m_layout;
+    bgDesc.entryCount = 5;
+    bgDesc.entries = e;
+    WGPUBindGroup bg = gpuCreateBindGroup(m_device, &bgDesc, "Export");
+
+    // Dispatches within the pass are ordered, so bands reuse the one stamps buffer
+    ComputeBatch batch(encoder, "Export/scaled_trail");
+    for (uint32_t b = 0; b < bands; b++) {
+        uint32_t rows = std::min(bandRows, h - b * bandRows);
+        batch.setBindGroup(0, bg, 1, &offsets[b]);
+        batch.dispatch("Export/clear_stamps", m_clearPipeline, (w + 7) / 8, (rows + 7) / 8);
+        batch.dispatch("Export/stamp_agents", m_stampPipeline, (gp.agents + 255) / 256);
+        batch.dispatch("Export/resolve", m_resolvePipeline, (w + 7) / 8, (rows + 7) / 8);
+    }
+    batch.end();
+    gpuRelease(bg);
+}
+
+void ScaledTrail::shutdown() {
+    m_pipelines.wait(); // jobs still use the module and layout
+    if (m_clearPipeline) gpuRelease(m_clearPipeline);
+    if (m_stampPipeline) gpuRelease(m_stampPipeline);
+    if (m_resolvePipeline) gpuRelease(m_resolvePipeline);
+    if (m_layout) gpuRelease(m_layout);
+    if (m_stamps) gpuPool().recycle(m_stamps);
+    m_uniforms.destroy();
+    m_clearPipeline = m_stampPipeline = m_resolvePipeline = nullptr;
+    m_layout = nullptr;
+    m_stamps = nullptr;
+    m_stampsSize = 0;
+    m_device = nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include "simulation.h"
+#include "pipeline_compiler.h"
+#include "uniform_ring.h"
+#include <cstdint>
+
+// Builds the export-size trail field of an agent sim for renderScaled()
+// (shaders/scaled_trail.wgsl): the trail upsampled, every agent stamped over
+// it from the agent buffer, described by SimStateViews. Stamps go through a
+// fixed-size atomics buffer one band of rows at a time, so memory doesn't
+// grow with the export size and overlapping agents resolve deterministically.
+class ScaledTrail {
+public:
+    static constexpr uint64_t STAMP_BYTES = 32ull << 20; // 16 bytes per band pixel
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown();
+
+    // field: rgba16float storage, scale x the size of trail (the sim's current trail)
+    void encode(WGPUCommandEncoder encoder, const SimStateViews& state, WGPUTextureView trail,
+                uint32_t scale, WGPUTextureView field);
+
+private:
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    WGPUBindGroupLayout m_layout = nullptr;
+    WGPUComputePipeline m_clearPipeline = nullptr;
+    WGPUComputePipeline m_stampPipeline = nullptr;
+    WGPUComputePipeline m_resolvePipeline = nullptr;
+    PipelineBatch m_pipelines;
+    UniformRing m_uniforms; // GpuParams, one block per band
+    WGPUBuffer m_stamps = nullptr; // pooled on first export, kept for the next
+    uint64_t m_stampsSize = 0;
+
+    struct GpuParams {
+        uint32_t rezX, rezY, bandY, bandRows;
+        uint32_t agents, stride;
+        int32_t typeWord;
+        float scale;
+        float typeRatios[4];
+    };
+    static_assert(sizeof(GpuParams) == 48, "ScaledTrail GpuParams must be 48 bytes");
+};
@@ -0,0 +1,27 @@
+#include "sim_factory.h"
+#include "algorithms/game_of_life.h"
+#include "algorithms/physarum.h"
+#include "algorithms/boids.h"
+#include "algorithms/termites.h"
+#include <cctype>
+
+std::vector<std::unique_ptr<Simulation>> createAllSimulations() {
+    std::vector<std::unique_ptr<Simulation>> sims;
+    sims.push_back(std::make_unique<GameOfLife>());
+    sims.push_back(std::make_unique<PhysarumSim>());
+    sims.push_back(std::make_unique<BoidsSim>());
+    sims.push_back(std::make_unique<TermitesSim>());
+    return sims;
+}
+
+std::unique_ptr<Simulation> createSimulation(const std::string& key) {
+    for (auto& sim : createAllSimulations())
+        if (simKey(*sim) == key) return std::move(sim);
+    return nullptr;
+}
+
+std::string simKey(const Simulation& sim) {
+    std::string key = sim.name();
+    for (auto& c : key) c = (c == ' ') ? '_' : (char)tolower((unsigned char)c);
+    return key;
+}
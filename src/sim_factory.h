@@ -0,0 +1,15 @@
+#pragma once
+#include "simulation.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// All simulations in layer order (Game of Life, Physarum, Boids, Termites)
+std::vector<std::unique_ptr<Simulation>> createAllSimulations();
+
+// Single simulation by key ("physarum", "boids", ...). Returns null if unknown.
+std::unique_ptr<Simulation> createSimulation(const std::string& key);
+
+// Lowercase name with spaces as underscores, e.g. "Game of Life" -> "game_of_life".
+// Matches the preset file prefix ("physarum_bacteria.txt" -> "physarum").
+std::string simKey(const Simulation& sim);
@@ -0,0 +1,318 @@
+#include "sim_stats.h"
+#include "gpu_tracker.h"
+#include "compute_pass.h"
+#include "gpu_profiler.h"
+#include "cpu_trace.h"
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+
+static constexpr uint32_t REDUCE_GROUPS = 256; // must match reduce.wgsl
+static constexpr uint32_t NONE = 0xffffffffu;
+static constexpr uint64_t CHUNK_BYTES = 64ull << 20; // under maxStorageBufferBindingSize
+
+struct Stat {
+    float sum[4];
+    float peak[4];
+    uint32_t count[4];
+};
+static_assert(sizeof(Stat) == 48, "Stat must match reduce.wgsl");
+
+static constexpr uint64_t RESULT_SIZE = SimStats::MAX_STATS * sizeof(Stat);
+static constexpr uint64_t PARTIALS_SIZE = REDUCE_GROUPS * sizeof(Stat);
+
+struct ReduceParams {
+    uint32_t count, height, base, slot;
+    uint32_t strideWords, velocityWord, typeWord, total;
+    float typeRatios[4];
+    float threshold;
+    float _pad[3];
+};
+static_assert(sizeof(ReduceParams) == 64, "ReduceParams must match reduce.wgsl");
+
+static WGPUBindGroupLayout createLayout(WGPUDevice device, const WGPUBindGroupLayoutEntry& data) {
+    // Shared entries: params uniform + partials
+    WGPUBindGroupLayoutEntry entries[3] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = WGPUShaderStage_Compute;
+    entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+    entries[0].buffer.minBindingSize = sizeof(ReduceParams);
+    entries[1].binding = 1;
+    entries[1].visibility = WGPUShaderStage_Compute;
+    entries[1].buffer.type = WGPUBufferBindingType_Storage;
+    entries[1].buffer.minBindingSize = PARTIALS_SIZE;
+    entries[2] = data;
+
+    WGPUBindGroupLayoutDescriptor desc = {};
+    desc.entryCount = 3;
+    desc.entries = entries;
+    return gpuCreateBindGroupLayout(device, &desc, "Stats");
+}
+
+void SimStats::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+
+    WGPUBindGroupLayoutEntry data = {};
+    data.visibility = WGPUShaderStage_Compute;
+
+    // reduce_agents: + read-only agent words
+    data.binding = 3;
+    data.buffer.type = WGPUBufferBindingType_ReadOnlyStorage;
+    data.buffer.minBindingSize = 4;
+    m_agentLayout = createLayout(device, data);
+
+    // reduce_partials: + results
+    data.binding = 2;
+    data.buffer.type = WGPUBufferBindingType_Storage;
+    data.buffer.minBindingSize = RESULT_SIZE;
+    m_foldLayout = createLayout(device, data);
+
+    // reduce_texture: + sampled texture (textureLoad only)
+    data = {};
+    data.binding = 4;
+    data.visibility = WGPUShaderStage_Compute;
+    data.texture.sampleType = WGPUTextureSampleType_UnfilterableFloat;
+    data.texture.viewDimension = WGPUTextureViewDimension_2D;
+    m_textureLayout = createLayout(device, data);
+
+    compileComputePipeline(device, "shaders/reduce.wgsl", "reduce_agents", m_agentLayout, m_pipelines,
+                           &m_agentPipeline, "Stats");
+    compileComputePipeline(device, "shaders/reduce.wgsl", "reduce_texture", m_textureLayout, m_pipelines,
+                           &m_texturePipeline, "Stats");
+    compileComputePipeline(device, "shaders/reduce.wgsl", "reduce_partials", m_foldLayout, m_pipelines,
+                           &m_foldPipeline, "Stats");
+
+    WGPUBufferDescriptor desc = {};
+    desc.label = "stats_partials";
+    desc.size = PARTIALS_SIZE;
+    desc.usage = WGPUBufferUsage_Storage;
+    m_partials = gpuCreateBuffer(device, &desc, "Stats");
+
+    m_readback.init(device, queue, RESULT_SIZE, MAX_DISPATCHES, "stats", "Stats");
+}
+
+void SimStats::encode(WGPUCommandEncoder encoder, const SimStateViews& views, const std::string& label) {
+    m_pipelines.wait(); // no-op once compiled
+    if (!m_device || !m_agentPipeline || !m_texturePipeline || !m_foldPipeline) return;
+    TRACE_SCOPE("SimStats::encode");
+
+    uint32_t slot = m_readback.begin(encoder);
+    if (slot >= m_pending.size()) m_pending.resize(slot + 1);
+    Result& info = m_pending[slot].info;
+    info = Result();
+    info.label = label;
+    info.step = views.step;
+    m_pending[slot].texels = (uint64_t)views.width * views.height;
+    uint32_t stat = 0;
+
+    auto makeBindGroup = [&](WGPUBindGroupLayout layout, const ReduceParams& rp,
+                             const WGPUBindGroupEntry& data) -> WGPUBindGroup {
+        WGPUBindGroupEntry e[2] = {};
+        e[0].binding = 1;
+        e[0].buffer = m_partials;
+        e[0].size = PARTIALS_SIZE;
+        e[1] = data;
+        return m_readback.bindGroup(slot, layout, &rp, sizeof(rp), e, 2);
+    };
+
+    // Room for a reduction and its fold
+    auto room = [&]() { return m_readback.dispatches(slot) + 2 <= MAX_DISPATCHES; };
+
+    // Fold the partials just written into results[stat]
+    auto fold = [&](WGPUComputePassEncoder pass) {
+        ReduceParams rp = {};
+        rp.slot = stat;
+        WGPUBindGroupEntry data = {};
+        data.binding = 2;
+        data.buffer = m_readback.result(slot);
+        data.size = RESULT_SIZE;
+        wgpuComputePassEncoderSetPipeline(pass, m_foldPipeline);
+        wgpuComputePassEncoderSetBindGroup(pass, 0, makeBindGroup(m_foldLayout, rp, data), 0, nullptr);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, 1, 1, 1);
+    };
+
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, "Stats/reduce");
+
+    // 1. Agent buffer, in chunks of whole agents
+    uint32_t stride = views.agentStride;
+    if (views.agents && stride >= 4 && views.agentBytes >= stride) {
+        uint64_t total = views.agentBytes / stride;
+        uint64_t chunkAgents = CHUNK_BYTES / stride / 256 * 256; // keeps chunk offsets 256-byte aligned
+        for (uint64_t base = 0; base < total && room(); base += chunkAgents) {
+            uint64_t n = std::min(chunkAgents, total - base);
+            ReduceParams rp = {};
+            rp.count = (uint32_t)n;
+            rp.base = (uint32_t)base;
+            rp.strideWords = stride / 4;
+            rp.velocityWord = views.velocityOffset >= 0 ? (uint32_t)views.velocityOffset / 4 : NONE;
+            rp.typeWord = views.typeOffset >= 0 ? (uint32_t)views.typeOffset / 4 : NONE;
+            rp.total = (uint32_t)total;
+            memcpy(rp.typeRatios, views.typeRatios, sizeof(rp.typeRatios));
+            WGPUBindGroupEntry data = {};
+            data.binding = 3;
+            data.buffer = views.agents;
+            data.offset = base * stride;
+            data.size = n * stride;
+            wgpuComputePassEncoderSetPipeline(pass, m_agentPipeline);
+            wgpuComputePassEncoderSetBindGroup(pass, 0, makeBindGroup(m_agentLayout, rp, data), 0, nullptr);
+            wgpuComputePassEncoderDispatchWorkgroups(pass, REDUCE_GROUPS, 1, 1);
+            fold(pass);
+        }
+        info.hasAgents = true;
+        info.hasSpeed = views.velocityOffset >= 0;
+        stat++;
+    }
+
+    // 2. State textures
+    for (uint32_t i = 0; i < views.textureCount && stat < MAX_STATS && room(); i++) {
+        ReduceParams rp = {};
+        rp.count = views.width;
+        rp.height = views.height;
+        rp.threshold = threshold;
+        WGPUBindGroupEntry data = {};
+        data.binding = 4;
+        data.textureView = views.textures[i];
+        wgpuComputePassEncoderSetPipeline(pass, m_texturePipeline);
+        wgpuComputePassEncoderSetBindGroup(pass, 0, makeBindGroup(m_textureLayout, rp, data), 0, nullptr);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, REDUCE_GROUPS, 1, 1);
+        fold(pass);
+        info.textures[info.textureCount++].name = views.textureNames[i] ? views.textureNames[i] : "texture";
+        stat++;
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+    m_readback.finish(encoder, slot);
+}
+
+void SimStats::afterSubmit() {
+    m_readback.afterSubmit();
+}
+
+void SimStats::poll() {
+    m_readback.poll([&](uint32_t slot, const void* data) {
+        const Stat* stats = (const Stat*)data;
+        Result& r = m_pending[slot].info;
+        uint32_t stat = 0;
+        if (r.hasAgents) {
+            const Stat& a = stats[stat++];
+            for (int t = 0; t < 4; t++) {
+                r.population[t] = a.count[t];
+                r.speedMean[t] = a.count[t] ? a.sum[t] / a.count[t] : 0.0f;
+                r.speedMax[t] = a.peak[t];
+            }
+        }
+        double texels = m_pending[slot].texels ? (double)m_pending[slot].texels : 1.0;
+        for (uint32_t i = 0; i < r.textureCount; i++) {
+            const Stat& t = stats[stat++];
+            for (int c = 0; c < 4; c++) {
+                r.textures[i].mean[c] = (float)(t.sum[c] / texels);
+                r.textures[i].max[c] = t.peak[c];
+            }
+            r.textures[i].occupied = (float)(t.count[0] / texels);
+        }
+        deliver(r);
+    });
+}
+
+void SimStats::deliver(const Result& r) {
+    auto it = std::find_if(m_last.begin(), m_last.end(),
+                           [&](const Result& x) { return x.label == r.label; });
+    if (it == m_last.end()) m_last.push_back(r);
+    else *it = r;
+
+    if (!m_csv) return;
+    const char* sim = r.label.c_str();
+    unsigned long long step = (unsigned long long)r.step;
+    if (r.hasAgents) {
+        for (int t = 0; t < 4; t++) {
+            fprintf(m_csv, "%s,%llu,type%d.population,%u\n", sim, step, t, r.population[t]);
+            if (!r.hasSpeed || r.population[t] == 0) continue;
+            fprintf(m_csv, "%s,%llu,type%d.speed_mean,%.6g\n", sim, step, t, r.speedMean[t]);
+            fprintf(m_csv, "%s,%llu,type%d.speed_max,%.6g\n", sim, step, t, r.speedMax[t]);
+        }
+    }
+    static const char CHANNELS[4] = { 'r', 'g', 'b', 'a' };
+    for (uint32_t i = 0; i < r.textureCount; i++) {
+        const TextureStats& t = r.textures[i];
+        for (int c = 0; c < 4; c++) {
+            fprintf(m_csv, "%s,%llu,%s.mean.%c,%.6g\n", sim, step, t.name, CHANNELS[c], t.mean[c]);
+            fprintf(m_csv, "%s,%llu,%s.max.%c,%.6g\n", sim, step, t.name, CHANNELS[c], t.max[c]);
+        }
+        fprintf(m_csv, "%s,%llu,%s.occupied,%.6g\n", sim, step, t.name, t.occupied);
+    }
+}
+
+void SimStats::print(const Result& r, FILE* out) const {
+    fprintf(out, "%s step=%llu\n", r.label.c_str(), (unsigned long long)r.step);
+    if (r.hasAgents) {
+        fprintf(out, "  agents   %u %u %u %u", r.population[0], r.population[1], r.population[2], r.population[3]);
+        if (r.hasSpeed)
+            fprintf(out, "  speed mean %.3g %.3g %.3g %.3g max %.3g %.3g %.3g %.3g",
+                    r.speedMean[0], r.speedMean[1], r.speedMean[2], r.speedMean[3],
+                    r.speedMax[0], r.speedMax[1], r.speedMax[2], r.speedMax[3]);
+        fprintf(out, "\n");
+    }
+    for (uint32_t i = 0; i < r.textureCount; i++) {
+        const TextureStats& t = r.textures[i];
+        fprintf(out, "  %-8s mean %.4f %.4f %.4f %.4f max %.3f %.3f %.3f %.3f occupied %.1f%%\n", t.name,
+                t.mean[0], t.mean[1], t.mean[2], t.mean[3], t.max[0], t.max[1], t.max[2], t.max[3],
+                t.occupied * 100.0f);
+    }
+}
+
+void SimStats::onGui() {
+    for (auto& r : m_last) {
+        ImGui::Text("%s @%llu", r.label.c_str(), (unsigned long long)r.step);
+        if (r.hasAgents) {
+            ImGui::Text("  agents %u / %u / %u / %u", r.population[0], r.population[1],
+                        r.population[2], r.population[3]);
+            if (r.hasSpeed) {
+                uint32_t n = 0;
+                float sum = 0.0f, peak = 0.0f;
+                for (int t = 0; t < 4; t++) {
+                    n += r.population[t];
+                    sum += r.speedMean[t] * r.population[t];
+                    peak = std::max(peak, r.speedMax[t]);
+                }
+                ImGui::Text("  speed avg %.3f max %.3f", n ? sum / n : 0.0f, peak);
+            }
+        }
+        for (uint32_t i = 0; i < r.textureCount; i++) {
+            const TextureStats& t = r.textures[i];
+            ImGui::Text("  %-6s %.1f%% occ, mean %.3f %.3f %.3f, max %.2f %.2f %.2f", t.name,
+                        t.occupied * 100.0f, t.mean[0], t.mean[1], t.mean[2], t.max[0], t.max[1], t.max[2]);
+        }
+    }
+}
+
+bool SimStats::startCsv(const std::string& path) {
+    stopCsv();
+    m_csv = fopen(path.c_str(), "w");
+    if (!m_csv) { fprintf(stderr, "Failed to open stats CSV: %s\n", path.c_str()); return false; }
+    fprintf(m_csv, "sim,step,metric,value\n");
+    return true;
+}
+
+void SimStats::stopCsv() {
+    if (m_csv) fclose(m_csv);
+    m_csv = nullptr;
+}
+
+void SimStats::shutdown() {
+    m_pipelines.wait(); // jobs still use the layouts
+    stopCsv();
+    m_readback.shutdown();
+    m_pending.clear();
+    if (m_partials) { wgpuBufferDestroy(m_partials); gpuRelease(m_partials); }
+    if (m_agentPipeline) gpuRelease(m_agentPipeline);
+    if (m_texturePipeline) gpuRelease(m_texturePipeline);
+    if (m_foldPipeline) gpuRelease(m_foldPipeline);
+    if (m_agentLayout) gpuRelease(m_agentLayout);
+    if (m_textureLayout) gpuRelease(m_textureLayout);
+    if (m_foldLayout) gpuRelease(m_foldLayout);
+    m_partials = nullptr;
+    m_agentPipeline = m_texturePipeline = m_foldPipeline = nullptr;
+    m_agentLayout = m_textureLayout = m_foldLayout = nullptr;
+    m_device = nullptr;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include "simulation.h"
+#include "readback_slots.h"
+#include "pipeline_compiler.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Live simulation statistics computed on the GPU with parallel reductions
+// (shaders/reduce.wgsl): per-type population and speed over the agent buffer,
+// per-channel mean/max and occupied fraction over each state texture. Only a
+// few hundred bytes are read back through ReadbackSlots, a frame or two later.
+//
+// Per frame: encode() for each sim -> submit -> afterSubmit(); poll() each frame.
+class SimStats {
+public:
+    static constexpr uint32_t MAX_STATS = 4;       // agents + up to 3 textures
+    static constexpr uint32_t MAX_DISPATCHES = 16; // agent buffers are reduced in chunks
+
+    struct TextureStats {
+        const char* name = "";
+        float mean[4] = {};
+        float max[4] = {};
+        float occupied = 0.0f; // fraction of texels with any of r,g,b above threshold
+    };
+    struct Result {
+        std::string label;
+        uint64_t step = 0;
+        bool hasAgents = false, hasSpeed = false;
+        uint32_t population[4] = {};
+        float speedMean[4] = {}, speedMax[4] = {};
+        TextureStats textures[3];
+        uint32_t textureCount = 0;
+    };
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown();
+
+    void encode(WGPUCommandEncoder encoder, const SimStateViews& views, const std::string& label);
+    void afterSubmit();
+    void poll(); // deliver finished stats to the CSV and lastResults()
+
+    // Long-format CSV: sim,step,metric,value
+    bool startCsv(const std::string& path);
+    void stopCsv();
+    bool csvActive() const { return m_csv != nullptr; }
+
+    const std::vector<Result>& lastResults() const { return m_last; }
+    void onGui(); // compact per-sim summary for the stats overlay
+    void print(const Result& r, FILE* out) const;
+
+    float threshold = 1.0f / 255.0f; // occupancy threshold
+
+private:
+    struct Pending {
+        Result info;
+        uint64_t texels = 0;
+    };
+
+    void deliver(const Result& r);
+
+    WGPUDevice m_device = nullptr;
+    WGPUBindGroupLayout m_agentLayout = nullptr;
+    WGPUBindGroupLayout m_textureLayout = nullptr;
+    WGPUBindGroupLayout m_foldLayout = nullptr;
+    WGPUComputePipeline m_agentPipeline = nullptr;
+    WGPUComputePipeline m_texturePipeline = nullptr;
+    WGPUComputePipeline m_foldPipeline = nullptr;
+    PipelineBatch m_pipelines; // compiled in the background; the first encode() waits
+    WGPUBuffer m_partials = nullptr; // one Stat per workgroup, reused by every reduction
+
+    ReadbackSlots m_readback;       // one Stat per source
+    std::vector<Pending> m_pending; // per readback slot
+    std::vector<Result> m_last; // latest result per label
+    FILE* m_csv = nullptr;
+};
@@ -1,14 +1,57 @@
 #pragma once
 #include <webgpu/webgpu.h>
+#include <cmath>
 #include <string>
+#include "preset.h"
 
 struct SimParams {
     uint32_t width = 512;
     uint32_t height = 512;
     bool paused = false;
     float speed = 1.0f; // steps per frame
+    uint64_t seed = 0;  // run seed: all randomness in reset/step derives from it
 };
 
+// GPU resources holding a sim's evolving state (hashed by StateHasher,
+// reduced by SimStats)
+struct SimStateViews {
+    WGPUBuffer agents = nullptr;
+    uint64_t agentBytes = 0;
+    // Agent layout, for SimStats. Types come from a u32 field when typeOffset
+    // >= 0, otherwise from the cumulative typeRatios by agent index.
+    uint32_t agentStride = 0;    // bytes per agent
+    int32_t velocityOffset = -1; // byte offset of a vec2f velocity, -1 = none
+    int32_t typeOffset = -1;     // byte offset of a u32 type id, -1 = none
+    float typeRatios[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    WGPUTextureView textures[3] = {};
+    const char* textureNames[3] = {};
+    uint32_t textureCount = 0;
+    uint32_t width = 0, height = 0;
+    uint64_t step = 0; // steps since the last reset
+};
+
+// Cumulative thresholds from per-type weights (agent index fraction -> type)
+inline void cumulativeTypeRatios(const float weights[4], float ratios[4]) {
+    float total = weights[0] + weights[1] + weights[2] + weights[3];
+    if (total < 0.001f) total = 1.0f;
+    float cumul = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        cumul += weights[i] / total;
+        ratios[i] = cumul;
+    }
+    ratios[3] = 1.0f; // ensure no rounding gaps
+}
+
+// Temporal fade of an agent sim's render kernel, out = out * a + fresh * b per
+// render. Rendering once after n substeps instead of every substep uses
+// a^n and b * (1 + a + ... + a^(n-1)): the same as n renders of an unchanged
+// fresh image, so trails keep fading at the same rate per substep.
+inline void substepFade(float a, float b, int substeps, float fade[2]) { // a < 1
+    float an = std::pow(a, (float)(substeps > 1 ? substeps : 1));
+    fade[0] = an;
+    fade[1] = b * (1.0f - an) / (1.0f - a);
+}
+
 class Simulation {
 public:
     virtual ~Simulation() = default;
@@ -20,6 +63,22 @@ public:
     virtual WGPUTexture getOutputTexture() = 0;
     virtual void onGui() = 0; // ImGui controls
     virtual void shutdown() = 0;
+    // False while pipelines still compile in the background; step() blocks
+    // until they are done, so the GUI checks this first
+    virtual bool ready() { return true; }
+
+    // Preset round-trip (see preset.h). Used by the GUI and the headless runner.
+    virtual void applyPreset(const PresetData&) {}
+    virtual PresetData capturePreset() const { return {}; }
+
+    virtual SimStateViews stateViews() { return {}; }
+
+    // Hi-res export from state: the sim re-renders at scale x its size into
+    // output (rgba8unorm) instead of its output being upsampled. field is an
+    // rgba16float scratch texture of the same size (the scaled trail).
+    virtual bool canRenderScaled() const { return false; }
+    virtual void renderScaled(WGPUCommandEncoder, uint32_t /*scale*/, WGPUTextureView /*field*/,
+                              WGPUTextureView /*output*/) {}
 
     SimParams params;
 };
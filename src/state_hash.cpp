@@ -0,0 +1,179 @@
+#include "state_hash.h"
+#include "gpu_tracker.h"
+#include "compute_pass.h"
+#include "gpu_profiler.h"
+#include "cpu_trace.h"
+#include <algorithm>
+
+static constexpr uint64_t RESULT_SIZE = StateHasher::MAX_COMPONENTS * 2 * sizeof(uint32_t);
+static constexpr uint64_t CHUNK_BYTES = 64ull << 20; // under maxStorageBufferBindingSize
+
+struct HashParams {
+    uint32_t count, height, base, lane;
+};
+static_assert(sizeof(HashParams) == 16, "HashParams must be 16 bytes");
+
+void StateHasher::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+
+    // Shared entries: params uniform + result lanes
+    WGPUBindGroupLayoutEntry entries[3] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = WGPUShaderStage_Compute;
+    entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+    entries[0].buffer.minBindingSize = sizeof(HashParams);
+    entries[1].binding = 1;
+    entries[1].visibility = WGPUShaderStage_Compute;
+    entries[1].buffer.type = WGPUBufferBindingType_Storage;
+    entries[1].buffer.minBindingSize = RESULT_SIZE;
+
+    // hash_buffer: + read-only words
+    entries[2].binding = 2;
+    entries[2].visibility = WGPUShaderStage_Compute;
+    entries[2].buffer.type = WGPUBufferBindingType_ReadOnlyStorage;
+    entries[2].buffer.minBindingSize = 4;
+
+    WGPUBindGroupLayoutDescriptor desc = {};
+    desc.entryCount = 3;
+    desc.entries = entries;
+    m_bufferLayout = gpuCreateBindGroupLayout(device, &desc, "StateHash");
+
+    // hash_texture: + sampled texture (textureLoad only)
+    entries[2] = {};
+    entries[2].binding = 3;
+    entries[2].visibility = WGPUShaderStage_Compute;
+    entries[2].texture.sampleType = WGPUTextureSampleType_UnfilterableFloat;
+    entries[2].texture.viewDimension = WGPUTextureViewDimension_2D;
+    m_textureLayout = gpuCreateBindGroupLayout(device, &desc, "StateHash");
+
+    compileComputePipeline(device, "shaders/state_hash.wgsl", "hash_buffer", m_bufferLayout, m_pipelines,
+                           &m_bufferPipeline, "StateHash");
+    compileComputePipeline(device, "shaders/state_hash.wgsl", "hash_texture", m_textureLayout, m_pipelines,
+                           &m_texturePipeline, "StateHash");
+
+    m_readback.init(device, queue, RESULT_SIZE, MAX_DISPATCHES, "state_hash", "StateHash");
+}
+
+void StateHasher::encode(WGPUCommandEncoder encoder, const SimStateViews& views, const std::string& label) {
+    m_pipelines.wait(); // no-op once compiled
+    if (!m_device || !m_bufferPipeline || !m_texturePipeline) return;
+    TRACE_SCOPE("StateHasher::encode");
+
+    uint32_t slot = m_readback.begin(encoder);
+    if (slot >= m_pending.size()) m_pending.resize(slot + 1);
+    Result& info = m_pending[slot];
+    info = Result();
+    info.label = label;
+    info.step = views.step;
+    uint32_t component = 0;
+
+    auto makeBindGroup = [&](WGPUBindGroupLayout layout, const HashParams& hp,
+                             const WGPUBindGroupEntry& data) -> WGPUBindGroup {
+        WGPUBindGroupEntry e[2] = {};
+        e[0].binding = 1;
+        e[0].buffer = m_readback.result(slot);
+        e[0].size = RESULT_SIZE;
+        e[1] = data;
+        return m_readback.bindGroup(slot, layout, &hp, sizeof(hp), e, 2);
+    };
+
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, "StateHash/hash");
+
+    // 1. Agent buffer, as raw u32 words in chunks
+    if (views.agents && views.agentBytes >= 4) {
+        uint64_t words = views.agentBytes / 4;
+        uint64_t chunkWords = CHUNK_BYTES / 4;
+        wgpuComputePassEncoderSetPipeline(pass, m_bufferPipeline);
+        for (uint64_t base = 0; base < words && m_readback.dispatches(slot) < MAX_DISPATCHES; base += chunkWords) {
+            uint64_t n = std::min(chunkWords, words - base);
+            HashParams hp = { (uint32_t)n, 0, (uint32_t)base, component * 2 };
+            WGPUBindGroupEntry data = {};
+            data.binding = 2;
+            data.buffer = views.agents;
+            data.offset = base * 4;
+            data.size = n * 4;
+            wgpuComputePassEncoderSetBindGroup(pass, 0, makeBindGroup(m_bufferLayout, hp, data), 0, nullptr);
+            wgpuComputePassEncoderDispatchWorkgroups(pass, 1024, 1, 1);
+        }
+        component++;
+    }
+
+    // 2. State textures
+    wgpuComputePassEncoderSetPipeline(pass, m_texturePipeline);
+    for (uint32_t i = 0; i < views.textureCount && component < MAX_COMPONENTS &&
+                         m_readback.dispatches(slot) < MAX_DISPATCHES; i++) {
+        HashParams hp = { views.width, views.height, 0, component * 2 };
+        WGPUBindGroupEntry data = {};
+        data.binding = 3;
+        data.textureView = views.textures[i];
+        wgpuComputePassEncoderSetBindGroup(pass, 0, makeBindGroup(m_textureLayout, hp, data), 0, nullptr);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, (views.width + 7) / 8, (views.height + 7) / 8, 1);
+        component++;
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+    m_readback.finish(encoder, slot);
+    info.partCount = component;
+}
+
+void StateHasher::afterSubmit() {
+    m_readback.afterSubmit();
+}
+
+void StateHasher::poll() {
+    m_readback.poll([&](uint32_t slot, const void* data) {
+        const uint32_t* lanes = (const uint32_t*)data;
+        Result& r = m_pending[slot];
+        uint64_t combined = 0xcbf29ce484222325ull; // FNV-1a over the parts
+        for (uint32_t c = 0; c < r.partCount; c++) {
+            r.parts[c] = ((uint64_t)lanes[c * 2 + 1] << 32) | lanes[c * 2];
+            for (int b = 0; b < 8; b++) {
+                combined ^= (r.parts[c] >> (b * 8)) & 0xff;
+                combined *= 0x100000001b3ull;
+            }
+        }
+        r.combined = combined;
+        deliver(r);
+    });
+}
+
+void StateHasher::deliver(const Result& r) {
+    auto it = std::find_if(m_last.begin(), m_last.end(),
+                           [&](const Result& x) { return x.label == r.label; });
+    if (it == m_last.end()) m_last.push_back(r);
+    else *it = r;
+
+    FILE* out = m_log ? m_log : stdout;
+    fprintf(out, "%s step=%llu hash=%016llx parts=", r.label.c_str(),
+            (unsigned long long)r.step, (unsigned long long)r.combined);
+    for (uint32_t c = 0; c < r.partCount; c++)
+        fprintf(out, "%s%016llx", c ? "," : "", (unsigned long long)r.parts[c]);
+    fprintf(out, "\n");
+}
+
+bool StateHasher::openLog(const std::string& path) {
+    closeLog();
+    m_log = fopen(path.c_str(), "w");
+    if (!m_log) { fprintf(stderr, "Failed to open hash log: %s\n", path.c_str()); return false; }
+    return true;
+}
+
+void StateHasher::closeLog() {
+    if (m_log) fclose(m_log);
+    m_log = nullptr;
+}
+
+void StateHasher::shutdown() {
+    m_pipelines.wait(); // jobs still use the layouts
+    closeLog();
+    m_readback.shutdown();
+    m_pending.clear();
+    if (m_bufferPipeline) gpuRelease(m_bufferPipeline);
+    if (m_texturePipeline) gpuRelease(m_texturePipeline);
+    if (m_bufferLayout) gpuRelease(m_bufferLayout);
+    if (m_textureLayout) gpuRelease(m_textureLayout);
+    m_bufferPipeline = m_texturePipeline = nullptr;
+    m_bufferLayout = m_textureLayout = nullptr;
+    m_device = nullptr;
+}
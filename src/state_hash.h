@@ -0,0 +1,56 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include "simulation.h"
+#include "readback_slots.h"
+#include "pipeline_compiler.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// GPU hash of a simulation's state (agent buffer + state textures) for
+// comparing runs, builds and adapters without reading back full textures.
+// Each component gets an order-independent 64-bit hash (shaders/state_hash.wgsl);
+// results are read back through ReadbackSlots and arrive a frame or two later.
+//
+// Per frame: encode() for each sim -> submit -> afterSubmit(); poll() each frame.
+class StateHasher {
+public:
+    static constexpr uint32_t MAX_COMPONENTS = 4;   // agents + up to 3 textures
+    static constexpr uint32_t MAX_DISPATCHES = 16;  // agent buffers are hashed in chunks
+
+    struct Result {
+        std::string label;
+        uint64_t step = 0;
+        uint64_t combined = 0;
+        uint64_t parts[MAX_COMPONENTS] = {};
+        uint32_t partCount = 0;
+    };
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown();
+
+    void encode(WGPUCommandEncoder encoder, const SimStateViews& views, const std::string& label);
+    void afterSubmit();
+    void poll(); // deliver finished hashes to the log and lastResults()
+
+    // Log lines: "<label> step=<n> hash=<combined> parts=<a>,<b>,..."; stdout when no file is open
+    bool openLog(const std::string& path);
+    void closeLog();
+    const std::vector<Result>& lastResults() const { return m_last; }
+
+private:
+    void deliver(const Result& r);
+
+    WGPUDevice m_device = nullptr;
+    WGPUBindGroupLayout m_bufferLayout = nullptr;
+    WGPUBindGroupLayout m_textureLayout = nullptr;
+    WGPUComputePipeline m_bufferPipeline = nullptr;
+    WGPUComputePipeline m_texturePipeline = nullptr;
+    PipelineBatch m_pipelines; // compiled in the background; the first encode() waits
+
+    ReadbackSlots m_readback;   // 2 u32 lanes per component
+    std::vector<Result> m_pending; // per readback slot
+    std::vector<Result> m_last; // latest result per label
+    FILE* m_log = nullptr;
+};
@@ -1,4 +1,5 @@
 #include "ui.h"
+#include "cpu_trace.h"
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_wgpu.h>
@@ -25,6 +26,7 @@ void UI::beginFrame() {
 }
 
 void UI::endFrame(WGPURenderPassEncoder renderPass) {
+    TRACE_SCOPE("ImGui render");
     ImGui::Render();
     ImGui_ImplWGPU_RenderDrawData(ImGui::GetDrawData(), renderPass);
 }
@@ -0,0 +1,71 @@
+#include "uniform_ring.h"
+#include "gpu_tracker.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+void UniformRing::init(WGPUDevice device, WGPUQueue queue, uint32_t blockSize, uint32_t capacity,
+                       const char* owner) {
+    m_device = device;
+    m_queue = queue;
+    m_owner = owner;
+    m_blockSize = blockSize;
+    m_stride = (blockSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    m_capacity = capacity > 0 ? capacity : 1;
+    m_count = 0;
+    createBuffer();
+}
+
+void UniformRing::createBuffer() {
+    WGPUBufferDescriptor desc = {};
+    desc.size = (uint64_t)m_stride * m_capacity;
+    desc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+    desc.label = "uniform_ring";
+    m_buffer = gpuCreateBuffer(m_device, &desc, m_owner);
+    m_staging.assign((size_t)m_stride * m_capacity, 0);
+}
+
+bool UniformRing::reserve(uint32_t blocks) {
+    if (m_count + blocks <= m_capacity) return false;
+    // Flush blocks already bound this frame; release (not destroy) the old
+    // buffer since commands encoded against it have not been submitted yet
+    if (m_count > 0) upload();
+    if (m_buffer) gpuRelease(m_buffer);
+    // Never shrink, and grow geometrically so alternating callers settle on one buffer
+    m_capacity = std::max(m_capacity, 1u);
+    while (m_capacity < blocks) m_capacity *= 2;
+    createBuffer();
+    return true;
+}
+
+uint32_t UniformRing::push(const void* data) {
+    if (m_count >= m_capacity) {
+        // Caller under-reserved: reuse the last block rather than overflow
+        fprintf(stderr, "UniformRing(%s): more than %u blocks this frame\n", m_owner, m_capacity);
+        m_count = m_capacity - 1;
+    }
+    uint32_t offset = m_count * m_stride;
+    memcpy(&m_staging[offset], data, m_blockSize);
+    m_count++;
+    return offset;
+}
+
+void UniformRing::upload() {
+    if (m_count == 0) return;
+    wgpuQueueWriteBuffer(m_queue, m_buffer, 0, m_staging.data(), (uint64_t)(m_count - 1) * m_stride + m_blockSize);
+    m_count = 0;
+}
+
+uint32_t UniformRing::write(const void* data) {
+    if (m_count >= m_capacity) m_count = 0;
+    uint32_t offset = push(data);
+    wgpuQueueWriteBuffer(m_queue, m_buffer, offset, &m_staging[offset], m_blockSize);
+    return offset;
+}
+
+void UniformRing::destroy() {
+    if (m_buffer) { wgpuBufferDestroy(m_buffer); gpuRelease(m_buffer); }
+    m_buffer = nullptr;
+    m_staging.clear();
+    m_capacity = m_count = 0;
+}
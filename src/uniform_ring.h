@@ -0,0 +1,48 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include <cstdint>
+#include <vector>
+
+// Uniform blocks for one frame packed into a single buffer, one aligned block
+// per dispatch group (e.g. per substep), bound with a dynamic offset.
+// wgpuQueueWriteBuffer calls all land before the submit, so writing every
+// substep's params to the same buffer would leave each substep seeing the last
+// one; here each gets its own block and the frame costs one upload.
+//
+// Per frame: reserve(n) -> push() per block -> upload(). Callers that encode
+// one dispatch at a time across submits use write() instead.
+class UniformRing {
+public:
+    static constexpr uint32_t ALIGNMENT = 256; // minUniformBufferOffsetAlignment
+
+    void init(WGPUDevice device, WGPUQueue queue, uint32_t blockSize, uint32_t capacity,
+              const char* owner); // owner: GpuTracker subsystem
+    void destroy();
+
+    // Ensures room for n blocks this frame. Returns true when the buffer was
+    // recreated (at least as large, doubling as needed), so bind groups
+    // referencing it must be rebuilt.
+    bool reserve(uint32_t blocks);
+    // Stages one block; returns its dynamic offset
+    uint32_t push(const void* data);
+    // Writes all blocks staged since the last upload and starts a new frame
+    void upload();
+    // Stages one block and writes it right away; returns its dynamic offset.
+    // Wraps around when full, so the last capacity blocks stay intact: enough
+    // as long as no submit uses more than that.
+    uint32_t write(const void* data);
+
+    WGPUBuffer buffer() const { return m_buffer; }
+    uint32_t blockSize() const { return m_blockSize; }
+
+private:
+    void createBuffer();
+
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    const char* m_owner = "UniformRing";
+    WGPUBuffer m_buffer = nullptr;
+    uint32_t m_blockSize = 0, m_stride = 0;
+    uint32_t m_capacity = 0, m_count = 0;
+    std::vector<uint8_t> m_staging;
+};
@@ -0,0 +1,217 @@
+#include "video_writer.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "gpu_profiler.h"
+#include "compute_pass.h"
+#include "cpu_trace.h"
+#include <cstring>
+
+// --- YuvConverter ---
+
+void YuvConverter::init(WGPUDevice device, WGPUQueue queue) {
+    m_device = device;
+    m_queue = queue;
+
+    WGPUBindGroupLayoutEntry entries[3] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = WGPUShaderStage_Compute;
+    entries[0].buffer.type = WGPUBufferBindingType_Uniform;
+    entries[0].buffer.minBindingSize = 8;
+    entries[1].binding = 1;
+    entries[1].visibility = WGPUShaderStage_Compute;
+    entries[1].texture.sampleType = WGPUTextureSampleType_UnfilterableFloat;
+    entries[1].texture.viewDimension = WGPUTextureViewDimension_2D;
+    entries[2].binding = 2;
+    entries[2].visibility = WGPUShaderStage_Compute;
+    entries[2].buffer.type = WGPUBufferBindingType_Storage;
+    entries[2].buffer.minBindingSize = 4;
+
+    WGPUBindGroupLayoutDescriptor desc = {};
+    desc.entryCount = 3;
+    desc.entries = entries;
+    m_layout = gpuCreateBindGroupLayout(device, &desc, "Export");
+
+    compileComputePipeline(device, "shaders/rgb_to_yuv.wgsl", "luma_main", m_layout, m_pipelines,
+                           &m_lumaPipeline, "Export");
+    compileComputePipeline(device, "shaders/rgb_to_yuv.wgsl", "chroma_main", m_layout, m_pipelines,
+                           &m_chromaPipeline, "Export");
+
+    WGPUBufferDescriptor bufDesc = {};
+    bufDesc.label = "yuv_params";
+    bufDesc.size = 16;
+    bufDesc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+    m_params = gpuCreateBuffer(device, &bufDesc, "Export");
+}
+
+bool YuvConverter::encode(WGPUCommandEncoder encoder, WGPUTextureView src, uint32_t w, uint32_t h) {
+    if (!m_device || !supports(w, h)) return false;
+    m_pipelines.wait(); // no-op once compiled
+    if (!m_lumaPipeline || !m_chromaPipeline) return false;
+    TRACE_SCOPE("YuvConverter::encode");
+
+    uint64_t size = frameBytes(w, h);
+    if (m_planesSize != size) {
+        if (m_planes) gpuPool().recycle(m_planes);
+        m_planes = gpuPool().acquireBuffer(size, WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc,
+                                           "yuv_planes", "Export");
+        m_planesSize = size;
+    }
+
+    uint32_t params[4] = { w, h, 0, 0 };
+    wgpuQueueWriteBuffer(m_queue, m_params, 0, params, sizeof(params));
+
+    WGPUBindGroupEntry e[3] = {};
+    e[0].binding = 0;
+    e[0].buffer = m_params;
+    e[0].size = 8;
+    e[1].binding = 1;
+    e[1].textureView = src;
+    e[2].binding = 2;
+    e[2].buffer = m_planes;
+    e[2].size = size;
+    WGPUBindGroupDescriptor bgDesc = {};
+    bgDesc.layout = m_layout;
+    bgDesc.entryCount = 3;
+    bgDesc.entries = e;
+    WGPUBindGroup bg = gpuCreateBindGroup(m_device, &bgDesc, "Export");
+
+    WGPUComputePassEncoder pass = profiledComputePass(encoder, "Export/rgb_to_yuv");
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bg, 0, nullptr);
+    wgpuComputePassEncoderSetPipeline(pass, m_lumaPipeline);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, (w / 4 + 7) / 8, (h + 7) / 8, 1);
+    wgpuComputePassEncoderSetPipeline(pass, m_chromaPipeline);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, (w / 8 + 7) / 8, (h / 2 + 7) / 8, 1);
+    wgpuComputePassEncoderEnd(pass);
+    wgpuComputePassEncoderRelease(pass);
+    gpuRelease(bg);
+    return true;
+}
+
+void YuvConverter::shutdown() {
+    m_pipelines.wait(); // jobs still use the module and layout
+    if (m_lumaPipeline) gpuRelease(m_lumaPipeline);
+    if (m_chromaPipeline) gpuRelease(m_chromaPipeline);
+    if (m_layout) gpuRelease(m_layout);
+    if (m_params) { wgpuBufferDestroy(m_params); gpuRelease(m_params); }
+    if (m_planes) gpuPool().recycle(m_planes);
+    m_lumaPipeline = m_chromaPipeline = nullptr;
+    m_layout = nullptr;
+    m_params = m_planes = nullptr;
+    m_planesSize = 0;
+    m_device = nullptr;
+}
+
+// --- VideoWriter ---
+
+bool VideoWriter::open(const std::string& path, Format format, uint32_t w, uint32_t h, int fps) {
+    close();
+    if (format == Format::Y4M && !YuvConverter::supports(w, h)) {
+        fprintf(stderr, "Y4M needs a width divisible by 8 and an even height (got %ux%u)\n", w, h);
+        return false;
+    }
+    m_file = fopen(path.c_str(), "wb");
+    if (!m_file) {
+        fprintf(stderr, "Failed to open video file: %s\n", path.c_str());
+        return false;
+    }
+    m_fileBuffer.resize(32u << 20);
+    setvbuf(m_file, m_fileBuffer.data(), _IOFBF, m_fileBuffer.size());
+
+    if (format == Format::Y4M)
+        fprintf(m_file, "YUV4MPEG2 W%u H%u F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", w, h, fps);
+
+    m_path = path;
+    m_format = format;
+    m_width = w;
+    m_height = h;
+    m_frames = 0;
+    m_bytes = 0;
+    m_windowBytes = 0;
+    m_windowStart = std::chrono::steady_clock::now();
+    m_mbps = 0.0f;
+    m_running = true;
+    m_thread = std::thread(&VideoWriter::writerLoop, this);
+    return true;
+}
+
+void VideoWriter::close() {
+    if (!m_file) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+
+    bool ok = fclose(m_file) == 0;
+    m_file = nullptr;
+    m_fileBuffer.clear();
+    m_fileBuffer.shrink_to_fit();
+    if (ok) printf("Recorded: %s (%d frames, %.1f MB)\n", m_path.c_str(), m_frames.load(), m_bytes / (1024.0 * 1024.0));
+    else fprintf(stderr, "Failed to write video file: %s\n", m_path.c_str());
+}
+
+bool VideoWriter::enqueue(const uint8_t* data, uint32_t w, uint32_t h, uint32_t stride,
+                          const std::string&, std::function<void()> done) {
+    if (!m_file || w != m_width || h != m_height) {
+        if (m_file) fprintf(stderr, "VideoWriter: dropped a %ux%u frame (recording %ux%u)\n", w, h, m_width, m_height);
+        if (done) done();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Job job;
+        job.data = data;
+        job.stride = stride;
+        job.done = std::move(done);
+        m_jobs.push(std::move(job));
+        m_pending++;
+    }
+    m_cv.notify_one();
+    return true;
+}
+
+float VideoWriter::megabytesPerSecond() {
+    auto now = std::chrono::steady_clock::now();
+    float secs = std::chrono::duration<float>(now - m_windowStart).count();
+    if (secs >= 1.0f) {
+        uint64_t bytes = m_bytes;
+        m_mbps = (bytes - m_windowBytes) / (1024.0f * 1024.0f) / secs;
+        m_windowBytes = bytes;
+        m_windowStart = now;
+    }
+    return m_mbps;
+}
+
+void VideoWriter::writerLoop() {
+    traceSetThreadName("VideoWriter");
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&]{ return !m_jobs.empty() || !m_running; });
+            if (!m_running && m_jobs.empty()) break;
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+
+        TRACE_SCOPE("VideoWriter::write");
+        uint64_t bytes = 0;
+        if (m_format == Format::Y4M) {
+            // Planes are tightly packed: one contiguous write
+            uint64_t size = YuvConverter::frameBytes(m_width, m_height);
+            fwrite("FRAME\n", 1, 6, m_file);
+            fwrite(job.data, 1, size, m_file);
+            bytes = size + 6;
+        } else {
+            uint32_t row = m_width * 4;
+            for (uint32_t y = 0; y < m_height; y++)
+                fwrite(job.data + (size_t)y * job.stride, 1, row, m_file);
+            bytes = (uint64_t)row * m_height;
+        }
+        if (job.done) job.done();
+        m_bytes += bytes;
+        m_frames++;
+        m_pending--;
+    }
+}
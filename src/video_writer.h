@@ -0,0 +1,84 @@
+#pragma once
+#include <webgpu/webgpu.h>
+#include "export.h"
+#include "pipeline_compiler.h"
+#include <cstdio>
+
+// Converts the RGBA8 output into one packed planar YUV 4:2:0 frame on the GPU
+// (shaders/rgb_to_yuv.wgsl), 1.5 bytes per pixel instead of 4, ready to be
+// read back with ReadbackRing::encode(encoder, buffer(), frameBytes(w, h), w, h, w, ...).
+class YuvConverter {
+public:
+    static bool supports(uint32_t w, uint32_t h) { return w % 8 == 0 && h % 2 == 0; }
+    static uint64_t frameBytes(uint32_t w, uint32_t h) { return (uint64_t)w * h * 3 / 2; }
+
+    void init(WGPUDevice device, WGPUQueue queue);
+    void shutdown();
+
+    // Writes the planes of src (w x h) into buffer(); false if the size isn't supported
+    bool encode(WGPUCommandEncoder encoder, WGPUTextureView src, uint32_t w, uint32_t h);
+    WGPUBuffer buffer() const { return m_planes; }
+
+private:
+    WGPUDevice m_device = nullptr;
+    WGPUQueue m_queue = nullptr;
+    WGPUBindGroupLayout m_layout = nullptr;
+    WGPUComputePipeline m_lumaPipeline = nullptr;
+    WGPUComputePipeline m_chromaPipeline = nullptr;
+    PipelineBatch m_pipelines;
+    WGPUBuffer m_params = nullptr;
+    WGPUBuffer m_planes = nullptr; // pooled, bucketed: bind with frameBytes()
+    uint64_t m_planesSize = 0;
+};
+
+// Appends recorded frames to a single stream file on a writer thread, as an
+// alternative to PNG sequences: Y4M (planar YUV 4:2:0 from YuvConverter) or
+// raw RGBA (rows as read back, padding stripped). Frames are written straight
+// from the caller's memory through a large stdio buffer, so recording costs
+// one sequential copy per frame and no compression.
+class VideoWriter : public FrameSink {
+public:
+    enum class Format { Y4M, RawRGBA };
+
+    bool open(const std::string& path, Format format, uint32_t w, uint32_t h, int fps);
+    void close(); // drains the queue, then closes the file
+    bool isOpen() const { return m_file != nullptr; }
+    Format format() const { return m_format; }
+
+    // Frames must match the size passed to open(); others are dropped
+    bool enqueue(const uint8_t* data, uint32_t w, uint32_t h, uint32_t stride,
+                 const std::string& filename, std::function<void()> done) override;
+
+    int pending() const { return m_pending.load(); }
+    int framesWritten() const { return m_frames.load(); }
+    uint64_t bytesWritten() const { return m_bytes.load(); }
+    float megabytesPerSecond(); // averaged over the last second or so
+
+private:
+    void writerLoop();
+
+    struct Job {
+        const uint8_t* data = nullptr;
+        uint32_t stride = 0;
+        std::function<void()> done;
+    };
+
+    FILE* m_file = nullptr;
+    std::vector<char> m_fileBuffer; // setvbuf: few, large sequential writes
+    Format m_format = Format::Y4M;
+    uint32_t m_width = 0, m_height = 0;
+    std::string m_path;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::queue<Job> m_jobs;
+    bool m_running = false;
+
+    std::atomic<int> m_pending{0};
+    std::atomic<int> m_frames{0};
+    std::atomic<uint64_t> m_bytes{0};
+    uint64_t m_windowBytes = 0;
+    std::chrono::steady_clock::time_point m_windowStart;
+    float m_mbps = 0.0f;
+};
@@ -0,0 +1,308 @@
+// Golden-image regression test: runs a simulation (optionally with a shipped
+// preset) headlessly for a fixed number of seeded frames and compares the
+// post-effects output against a reference PNG with perceptual tolerances.
+//
+//   nature-golden --case physarum_bacteria --ref ../tests/golden --presets ../presets
+//   nature-golden --update --fallback     # regenerate every reference
+//
+// Exit codes: 0 pass, 1 fail, 77 skipped (no adapter / no reference yet).
+// A missing reference fails instead with --require-ref or when CI is set.
+#include "gpu_context.h"
+#include <webgpu/wgpu.h>
+#include "compositor.h"
+#include "post_effects.h"
+#include "export.h"
+#include "preset.h"
+#include "sim_factory.h"
+#include "cli.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+static constexpr int EXIT_SKIP = 77;
+
+struct GoldenCase {
+    const char* name;
+    const char* sim;
+    const char* preset; // file in --presets, or null for the sim defaults
+    int frames;
+};
+
+// Keep in sync with the add_test() list in CMakeLists.txt
+static const GoldenCase CASES[] = {
+    { "game_of_life",       "game_of_life", nullptr,                  60 },
+    { "physarum",           "physarum",     nullptr,                  120 },
+    { "boids",              "boids",        nullptr,                  120 },
+    { "termites",           "termites",     nullptr,                  120 },
+    { "physarum_bacteria",  "physarum",     "physarum_bacteria.txt",  120 },
+    { "boids_worm",         "boids",        "boids_worm.txt",         120 },
+    { "termites_spreading", "termites",     "termites_spreading.txt", 120 },
+};
+
+static constexpr uint32_t REZ = 512;
+static constexpr uint64_t SEED = 1234;
+static constexpr float MAX_AGENTS = 200000.0f; // keeps software adapters fast
+
+struct Tolerance {
+    double mean = 2.0;   // mean abs RGB error, 0..255
+    double block = 24.0; // max abs error of any 8x8 block mean, 0..255
+};
+
+struct DiffStats {
+    double meanAbs = 0.0;
+    double maxBlock = 0.0;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "usage: nature-golden [options]\n"
+        "  --case NAME[,NAME...]  cases to run (default: all; --list to show)\n"
+        "  --ref DIR              reference images (default tests/golden)\n"
+        "  --presets DIR          preset directory (default presets)\n"
+        "  --out DIR              write actual/diff images of failing cases here\n"
+        "  --update               write the current output as the new reference\n"
+        "  --tol-mean X           mean abs error tolerance (default 2)\n"
+        "  --tol-block X          8x8 block error tolerance (default 24)\n"
+        "  --fallback             force the software/fallback adapter\n"
+        "  --require-ref          fail cases without a reference (default when CI is set)\n"
+        "  --list                 print case names\n");
+}
+
+// Block means absorb single-pixel agent jitter; the full-res mean catches
+// global shifts (colour, brightness, decay rate).
+static DiffStats compare(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b,
+                         uint32_t w, uint32_t h) {
+    DiffStats d;
+    const uint32_t B = 8;
+    uint32_t bw = (w + B - 1) / B, bh = (h + B - 1) / B;
+    std::vector<double> blockA(bw * bh * 3, 0.0), blockB(bw * bh * 3, 0.0);
+    std::vector<uint32_t> blockN(bw * bh, 0);
+
+    double sum = 0.0;
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            size_t p = ((size_t)y * w + x) * 4;
+            size_t bi = (size_t)(y / B) * bw + x / B;
+            for (int c = 0; c < 3; c++) {
+                sum += std::abs((int)a[p + c] - (int)b[p + c]);
+                blockA[bi * 3 + c] += a[p + c];
+                blockB[bi * 3 + c] += b[p + c];
+            }
+            blockN[bi]++;
+        }
+    }
+    d.meanAbs = sum / ((double)w * h * 3);
+    for (size_t bi = 0; bi < blockN.size(); bi++) {
+        for (int c = 0; c < 3; c++) {
+            double diff = std::abs(blockA[bi * 3 + c] - blockB[bi * 3 + c]) / blockN[bi];
+            d.maxBlock = std::max(d.maxBlock, diff);
+        }
+    }
+    return d;
+}
+
+// Submit one frame and block until the GPU has finished it; returns ms
+static double runFrame(GpuContext& gpu, Compositor& compositor, PostEffects& postFx, FrameGraph& fg) {
+    WGPUCommandEncoderDescriptor encDesc = {};
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(gpu.device, &encDesc);
+    for (auto& layer : compositor.layers)
+        if (layer.enabled && layer.sim) layer.sim->step(encoder);
+    fg.reset();
+    postFx.addPasses(fg, compositor.addPasses(fg));
+    fg.execute(encoder);
+    WGPUCommandBufferDescriptor cbDesc = {};
+    WGPUCommandBuffer cmdBuf = wgpuCommandEncoderFinish(encoder, &cbDesc);
+
+    auto t0 = std::chrono::steady_clock::now();
+    WGPUSubmissionIndex idx = wgpuQueueSubmitForIndex(gpu.queue, 1, &cmdBuf);
+    WGPUWrappedSubmissionIndex wait = { gpu.queue, idx };
+    wgpuDevicePoll(gpu.device, true, &wait);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    wgpuCommandBufferRelease(cmdBuf);
+    wgpuCommandEncoderRelease(encoder);
+    return ms;
+}
+
+// Runs the case and reads back the post-effects output. Returns false on setup errors.
+static bool renderCase(GpuContext& gpu, const GoldenCase& gc, const std::string& presetDir,
+                       std::vector<uint8_t>& pixels, double& gpuMs) {
+    auto sim = createSimulation(gc.sim);
+    if (!sim) { fprintf(stderr, "Unknown sim: %s\n", gc.sim); return false; }
+    sim->params.seed = SEED;
+    sim->init(gpu.device, gpu.queue, REZ, REZ);
+
+    PresetData data;
+    if (gc.preset) {
+        std::string path = presetDir + "/" + gc.preset;
+        data = loadPresetFile(path);
+        if (data.empty()) {
+            fprintf(stderr, "Failed to load preset: %s\n", path.c_str());
+            sim->shutdown();
+            return false;
+        }
+    }
+    float agents = 0.0f;
+    if (presetGet(data, "agentCount", &agents, 1)) data["agentCount"] = { std::min(agents, MAX_AGENTS) };
+    else data["agentCount"] = { MAX_AGENTS };
+    sim->applyPreset(data);
+    sim->reset();
+
+    Compositor compositor;
+    compositor.init(gpu.device, gpu.queue, REZ, REZ);
+    Layer l;
+    l.sim = sim.get();
+    l.enabled = true;
+    l.opacity = 1.0f;
+    l.blendMode = BlendMode::Additive;
+    compositor.layers.push_back(l);
+
+    PostEffects postFx;
+    postFx.init(gpu.device, gpu.queue, REZ, REZ);
+    FrameGraph fg;
+    fg.init(gpu.device);
+
+    gpuMs = 0.0;
+    for (int i = 0; i < gc.frames; i++) gpuMs += runFrame(gpu, compositor, postFx, fg);
+
+    bool ok = readbackTexture(gpu.device, gpu.queue, postFx.getOutputTexture(), REZ, REZ, pixels);
+
+    fg.shutdown();
+    postFx.shutdown();
+    compositor.shutdown();
+    sim->shutdown();
+    return ok;
+}
+
+static bool loadPng(const std::string& path, std::vector<uint8_t>& pixels, uint32_t& w, uint32_t& h) {
+    int iw, ih, n;
+    uint8_t* data = stbi_load(path.c_str(), &iw, &ih, &n, 4);
+    if (!data) return false;
+    pixels.assign(data, data + (size_t)iw * ih * 4);
+    stbi_image_free(data);
+    w = (uint32_t)iw;
+    h = (uint32_t)ih;
+    return true;
+}
+
+static void writeDiff(const std::string& path, const std::vector<uint8_t>& a,
+                      const std::vector<uint8_t>& b, uint32_t w, uint32_t h) {
+    std::vector<uint8_t> diff(a.size());
+    for (size_t i = 0; i < a.size(); i += 4) {
+        for (int c = 0; c < 3; c++)
+            diff[i + c] = (uint8_t)std::min(255, 4 * std::abs((int)a[i + c] - (int)b[i + c]));
+        diff[i + 3] = 255;
+    }
+    stbi_write_png(path.c_str(), w, h, 4, diff.data(), w * 4);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> caseNames;
+    std::string refDir = "tests/golden", presetDir = "presets", outDir;
+    Tolerance tol;
+    bool update = false, fallback = false;
+    bool requireRef = getenv("CI") != nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { fprintf(stderr, "Missing value for %s\n", a.c_str()); exit(2); }
+            return argv[++i];
+        };
+        if (a == "--case") caseNames = splitList(next(), ',');
+        else if (a == "--ref") refDir = next();
+        else if (a == "--presets") presetDir = next();
+        else if (a == "--out") outDir = next();
+        else if (a == "--update") update = true;
+        else if (a == "--tol-mean") tol.mean = atof(next());
+        else if (a == "--tol-block") tol.block = atof(next());
+        else if (a == "--fallback") fallback = true;
+        else if (a == "--require-ref") requireRef = true;
+        else if (a == "--list") {
+            for (auto& gc : CASES) printf("%s\n", gc.name);
+            return 0;
+        }
+        else if (a == "--help" || a == "-h") { usage(); return 0; }
+        else { fprintf(stderr, "Unknown option: %s\n", a.c_str()); usage(); return 2; }
+    }
+
+    std::vector<const GoldenCase*> cases;
+    for (auto& gc : CASES) {
+        bool selected = caseNames.empty();
+        for (auto& n : caseNames) if (n == gc.name) selected = true;
+        if (selected) cases.push_back(&gc);
+    }
+    if (cases.empty()) { fprintf(stderr, "No matching case\n"); return 2; }
+
+    GpuContext gpu;
+    if (!gpu.initHeadless(REZ, REZ, fallback)) {
+        fprintf(stderr, "SKIP: no suitable adapter\n");
+        return EXIT_SKIP;
+    }
+    if (update) mkdir(refDir.c_str(), 0755);
+    if (!outDir.empty()) mkdir(outDir.c_str(), 0755);
+
+    int failed = 0, skipped = 0;
+    for (const GoldenCase* gc : cases) {
+        std::vector<uint8_t> actual;
+        double gpuMs = 0.0;
+        if (!renderCase(gpu, *gc, presetDir, actual, gpuMs)) {
+            printf("FAIL %-20s (setup)\n", gc->name);
+            failed++;
+            continue;
+        }
+
+        std::string refPath = refDir + "/" + gc->name + ".png";
+        if (update) {
+            bool ok = stbi_write_png(refPath.c_str(), REZ, REZ, 4, actual.data(), REZ * 4) != 0;
+            printf("%s %-20s -> %s  gpu %.1f ms (%d frames)\n", ok ? "UPDATE" : "FAIL",
+                   gc->name, refPath.c_str(), gpuMs, gc->frames);
+            if (!ok) failed++;
+            continue;
+        }
+
+        std::vector<uint8_t> ref;
+        uint32_t rw = 0, rh = 0;
+        if (!loadPng(refPath, ref, rw, rh)) {
+            printf("%s %-20s no reference at %s (run with --update)\n", requireRef ? "FAIL" : "SKIP",
+                   gc->name, refPath.c_str());
+            if (requireRef) failed++;
+            else skipped++;
+            continue;
+        }
+        if (rw != REZ || rh != REZ) {
+            printf("FAIL %-20s reference is %ux%u, expected %ux%u\n", gc->name, rw, rh, REZ, REZ);
+            failed++;
+            continue;
+        }
+
+        DiffStats d = compare(actual, ref, REZ, REZ);
+        bool pass = d.meanAbs <= tol.mean && d.maxBlock <= tol.block;
+        printf("%s %-20s mean %.3f (tol %.1f)  block %.2f (tol %.1f)  gpu %.1f ms (%d frames)\n",
+               pass ? "PASS" : "FAIL", gc->name, d.meanAbs, tol.mean, d.maxBlock, tol.block,
+               gpuMs, gc->frames);
+        if (!pass) {
+            failed++;
+            if (!outDir.empty()) {
+                std::string base = outDir + "/" + gc->name;
+                stbi_write_png((base + ".actual.png").c_str(), REZ, REZ, 4, actual.data(), REZ * 4);
+                writeDiff(base + ".diff.png", actual, ref, REZ, REZ);
+            }
+        }
+    }
+    printf("adapter: %s\n", gpu.adapterName.c_str());
+    gpu.shutdown();
+
+    if (failed) return 1;
+    if (skipped == (int)cases.size()) return EXIT_SKIP;
+    return 0;
+}
@@ -0,0 +1,138 @@
+// PngStreamWriter round-trip test: writes images of different content and
+// shape (smooth, noise, multi-band, odd row batches) and decodes them with
+// stb_image, which must give back the exact pixels. Noise must not grow by
+// more than the stored-block overhead.
+//
+//   nature-png-test [--out DIR]
+//
+// Exit codes: 0 pass, 1 fail. No GPU needed.
+#include "png_stream.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+struct PngCase {
+    const char* name;
+    uint32_t width, height;
+    uint32_t batchRows; // rows per writeRows call
+    int pattern;        // 0 gradient, 1 noise, 2 flat, 3 stripes
+};
+
+static const PngCase CASES[] = {
+    { "gradient",     640,  480,  64, 0 },
+    { "noise",        512,  512,  17, 1 },
+    { "flat",         1,    1,    1,  2 },
+    { "odd_width",    333,  77,   5,  3 },
+    { "noise_bands",  1500, 1000, 96, 1 }, // > BAND_BYTES: several deflate blocks
+    { "mixed_bands",  1024, 2100, 33, 3 },
+};
+
+static uint32_t rng(uint32_t& s) { // xorshift32
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+static std::vector<uint8_t> makeImage(const PngCase& c) {
+    std::vector<uint8_t> px((size_t)c.width * c.height * 4);
+    uint32_t seed = 0x9e3779b9u;
+    for (uint32_t y = 0; y < c.height; y++) {
+        for (uint32_t x = 0; x < c.width; x++) {
+            uint8_t* p = &px[((size_t)y * c.width + x) * 4];
+            switch (c.pattern) {
+            case 0:
+                p[0] = (uint8_t)(x * 255 / c.width);
+                p[1] = (uint8_t)(y * 255 / c.height);
+                p[2] = (uint8_t)((x + y) & 0xff);
+                p[3] = 255;
+                break;
+            case 1: {
+                uint32_t r = rng(seed);
+                memcpy(p, &r, 4);
+                break;
+            }
+            case 2:
+                p[0] = 12; p[1] = 34; p[2] = 56; p[3] = 78;
+                break;
+            default: { // noise rows between flat stripes: bands of both kinds
+                uint32_t r = (y / 64) % 2 ? rng(seed) : 0x80402010u ^ (x / 8);
+                memcpy(p, &r, 4);
+                break;
+            }
+            }
+        }
+    }
+    return px;
+}
+
+static bool runCase(const PngCase& c, const std::string& outDir) {
+    std::vector<uint8_t> px = makeImage(c);
+    std::string path = outDir + "/" + c.name + ".png";
+    size_t stride = (size_t)c.width * 4;
+
+    PngStreamWriter writer;
+    bool ok = writer.open(path, c.width, c.height);
+    for (uint32_t y = 0; ok && y < c.height; y += c.batchRows) {
+        uint32_t count = std::min(c.batchRows, c.height - y);
+        ok = writer.writeRows(&px[y * stride], count, stride);
+    }
+    if (!writer.close() || !ok) {
+        fprintf(stderr, "%s: write failed\n", c.name);
+        return false;
+    }
+
+    int w = 0, h = 0, n = 0;
+    uint8_t* decoded = stbi_load(path.c_str(), &w, &h, &n, 4);
+    if (!decoded) {
+        fprintf(stderr, "%s: stb_image can't decode: %s\n", c.name, stbi_failure_reason());
+        return false;
+    }
+    bool same = (uint32_t)w == c.width && (uint32_t)h == c.height &&
+                memcmp(decoded, px.data(), px.size()) == 0;
+    stbi_image_free(decoded);
+    if (!same) {
+        fprintf(stderr, "%s: decoded pixels differ (%dx%d)\n", c.name, w, h);
+        return false;
+    }
+
+    // Incompressible data: filter bytes plus ~5 bytes per 64 KB stored block
+    // and the chunk framing, never fixed-Huffman's ~6% growth
+    struct stat st = {};
+    stat(path.c_str(), &st);
+    uint64_t raw = (uint64_t)(stride + 1) * c.height;
+    if (c.pattern == 1 && (uint64_t)st.st_size > raw + raw / 1000 + 1024) {
+        fprintf(stderr, "%s: %llu bytes for %llu raw, stored-block fallback not taken\n", c.name,
+                (unsigned long long)st.st_size, (unsigned long long)raw);
+        return false;
+    }
+    printf("%-12s %5ux%-5u %10llu bytes (%.1f%% of raw)\n", c.name, c.width, c.height,
+           (unsigned long long)st.st_size, 100.0 * st.st_size / raw);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string outDir = ".";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            outDir = argv[++i];
+        } else {
+            fprintf(stderr, "usage: nature-png-test [--out DIR]\n");
+            return 1;
+        }
+    }
+    mkdir(outDir.c_str(), 0755);
+
+    int failed = 0;
+    for (const PngCase& c : CASES)
+        if (!runCase(c, outDir)) failed++;
+    if (failed) fprintf(stderr, "%d of %zu PNG cases failed\n", failed, sizeof(CASES) / sizeof(CASES[0]));
+    return failed ? 1 : 0;
+}
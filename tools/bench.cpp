@@ -0,0 +1,299 @@
+// Benchmark sweep: runs each simulation headlessly over a grid of agent counts,
+// resolutions, steps/frame and (Boids) cell sizes, and reports per-frame timing.
+//
+//   nature-bench --sim physarum,boids --rez 512,1024,2048 --json bench.json --csv bench.csv
+//   nature-bench --quick --fallback      # small sweep on the software adapter
+//   nature-bench --steps 1,16,64 --split-passes  # one pass per kernel, to compare with batched
+#include "gpu_context.h"
+#include <webgpu/wgpu.h>
+#include "sim_factory.h"
+#include "gpu_profiler.h"
+#include "cli.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct BenchConfig {
+    std::string sim;
+    uint32_t agents = 0; // 0 for Game of Life (cells are reported instead)
+    uint32_t rez = 512;
+    int steps = 1;
+    float cellSize = 0.0f; // Boids only
+};
+
+// One measured repeat (fresh reset + warmup); nature-perf compares these
+struct BenchRun {
+    double meanMs = 0.0;
+    double stepsPerSec = 0.0;
+    std::vector<std::pair<std::string, double>> kernels; // per-pass GPU ms per frame, "(CPU)" = encode ms
+};
+
+struct BenchResult {
+    BenchConfig config;
+    std::vector<BenchRun> runs;
+    uint64_t work = 0;    // agents (or cells) updated per step
+    uint32_t passes = 0;  // compute passes per frame
+    double meanMs = 0.0, p50Ms = 0.0, p90Ms = 0.0, p99Ms = 0.0;
+    double stepsPerSec = 0.0;
+    double agentStepsPerSec = 0.0;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "usage: nature-bench [options]\n"
+        "  --sim NAME[,NAME...]  simulations (default: physarum,boids,termites,game_of_life)\n"
+        "  --agents N[,N...]     agent counts (default per sim, e.g. 10k..5M for physarum)\n"
+        "  --rez N[,N...]        square resolutions (default 512,1024,2048,4096)\n"
+        "  --steps N[,N...]      steps per frame (default 1,4)\n"
+        "  --cell N[,N...]       Boids cell sizes (default 15,30,60)\n"
+        "  --warmup N            unmeasured frames per config (default 10)\n"
+        "  --frames N            measured frames per config (default 60)\n"
+        "  --repeat N            independent measured runs per config (default 1)\n"
+        "  --quick               small sweep (CPU/software adapters)\n"
+        "  --json FILE           write results as JSON\n"
+        "  --csv FILE            write results as CSV\n"
+        "  --fallback            force the software/fallback adapter\n"
+        "  --split-passes        one compute pass per kernel instead of batching\n");
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+// Submit one frame of sim steps and block until the GPU has finished it
+static double runFrame(GpuContext& gpu, Simulation& sim) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    WGPUCommandEncoderDescriptor encDesc = {};
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(gpu.device, &encDesc);
+    gpuProfiler().beginFrame();
+    sim.step(encoder);
+    gpuProfiler().resolve(encoder);
+    WGPUCommandBufferDescriptor cbDesc = {};
+    WGPUCommandBuffer cmdBuf = wgpuCommandEncoderFinish(encoder, &cbDesc);
+    WGPUSubmissionIndex idx = wgpuQueueSubmitForIndex(gpu.queue, 1, &cmdBuf);
+    wgpuCommandBufferRelease(cmdBuf);
+    wgpuCommandEncoderRelease(encoder);
+    gpuProfiler().endFrame();
+
+    WGPUWrappedSubmissionIndex wait = { gpu.queue, idx };
+    wgpuDevicePoll(gpu.device, true, &wait);
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static BenchResult runConfig(GpuContext& gpu, const BenchConfig& cfg, int warmup, int frames, int repeat) {
+    BenchResult r;
+    r.config = cfg;
+
+    auto sim = createSimulation(cfg.sim);
+    sim->init(gpu.device, gpu.queue, cfg.rez, cfg.rez);
+
+    PresetData data;
+    data["stepsPerFrame"] = {(float)cfg.steps};
+    if (cfg.agents > 0) data["agentCount"] = {(float)cfg.agents};
+    if (cfg.cellSize > 0.0f) data["cellSize"] = {cfg.cellSize};
+    sim->applyPreset(data);
+
+    std::vector<double> times;
+    times.reserve((size_t)frames * repeat);
+    for (int rep = 0; rep < repeat; rep++) {
+        sim->reset();
+        // First frame after reset only re-seeds; warmup covers it and pipeline first-use
+        for (int i = 0; i < warmup + 1; i++) runFrame(gpu, *sim);
+        gpuProfiler().flush();
+        gpuProfiler().resetTotals();
+
+        double runTotal = 0.0;
+        for (int i = 0; i < frames; i++) {
+            double t = runFrame(gpu, *sim);
+            times.push_back(t);
+            runTotal += t;
+        }
+        r.passes = gpuProfiler().framePasses();
+        gpuProfiler().flush();
+
+        BenchRun run;
+        run.meanMs = runTotal / frames;
+        if (runTotal > 0.0) run.stepsPerSec = (double)frames * cfg.steps / (runTotal / 1000.0);
+        for (auto& st : gpuProfiler().stats())
+            if (st.samples > 0) run.kernels.push_back({ st.name, st.sumMs / st.samples });
+        r.runs.push_back(run);
+    }
+    sim->shutdown();
+
+    double total = 0.0;
+    for (double t : times) total += t;
+    std::sort(times.begin(), times.end());
+
+    r.work = cfg.agents > 0 ? cfg.agents : (uint64_t)cfg.rez * cfg.rez;
+    r.meanMs = total / times.size();
+    r.p50Ms = percentile(times, 0.50);
+    r.p90Ms = percentile(times, 0.90);
+    r.p99Ms = percentile(times, 0.99);
+    if (total > 0.0) {
+        r.stepsPerSec = (double)times.size() * cfg.steps / (total / 1000.0);
+        r.agentStepsPerSec = r.stepsPerSec * (double)r.work;
+    }
+    return r;
+}
+
+// JSON string body; driver strings may hold quotes, backslashes or control characters
+static void writeEscaped(FILE* f, const char* s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s < 0x20) fprintf(f, "\\u%04x", (unsigned char)*s);
+        else fputc(*s, f);
+    }
+}
+
+static bool writeJson(const char* path, const std::string& adapter,
+                      const std::vector<BenchResult>& results, int warmup, int frames, int repeat) {
+    bool split = gpuProfiler().splitPasses;
+    FILE* f = fopen(path, "w");
+    if (!f) { fprintf(stderr, "Failed to open %s\n", path); return false; }
+    fprintf(f, "{\n  \"adapter\": \"");
+    writeEscaped(f, adapter.c_str());
+    fprintf(f, "\",\n  \"warmup\": %d,\n  \"frames\": %d,\n  \"repeat\": %d,\n"
+               "  \"split_passes\": %s,\n  \"results\": [\n",
+            warmup, frames, repeat, split ? "true" : "false");
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& r = results[i];
+        fprintf(f, "    {\"sim\": \"%s\", \"agents\": %u, \"rez\": %u, \"steps\": %d, \"cell_size\": %g, "
+                   "\"work\": %llu, \"passes\": %u, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, "
+                   "\"steps_per_sec\": %.2f, \"agent_steps_per_sec\": %.6g,\n     \"runs\": [",
+                r.config.sim.c_str(), r.config.agents, r.config.rez, r.config.steps, r.config.cellSize,
+                (unsigned long long)r.work, r.passes, r.meanMs, r.p50Ms, r.p90Ms, r.p99Ms,
+                r.stepsPerSec, r.agentStepsPerSec);
+        for (size_t j = 0; j < r.runs.size(); j++) {
+            auto& run = r.runs[j];
+            fprintf(f, "%s\n      {\"mean_ms\": %.4f, \"steps_per_sec\": %.2f, \"kernels\": {",
+                    j ? "," : "", run.meanMs, run.stepsPerSec);
+            for (size_t k = 0; k < run.kernels.size(); k++) {
+                fprintf(f, "%s\"", k ? ", " : "");
+                writeEscaped(f, run.kernels[k].first.c_str());
+                fprintf(f, "\": %.5f", run.kernels[k].second);
+            }
+            fprintf(f, "}}");
+        }
+        fprintf(f, "]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+static bool writeCsv(const char* path, const std::vector<BenchResult>& results) {
+    FILE* f = fopen(path, "w");
+    if (!f) { fprintf(stderr, "Failed to open %s\n", path); return false; }
+    fprintf(f, "sim,agents,rez,steps,cell_size,work,mean_ms,p50_ms,p90_ms,p99_ms,steps_per_sec,agent_steps_per_sec\n");
+    for (auto& r : results) {
+        fprintf(f, "%s,%u,%u,%d,%g,%llu,%.4f,%.4f,%.4f,%.4f,%.2f,%.6g\n",
+                r.config.sim.c_str(), r.config.agents, r.config.rez, r.config.steps, r.config.cellSize,
+                (unsigned long long)r.work, r.meanMs, r.p50Ms, r.p90Ms, r.p99Ms,
+                r.stepsPerSec, r.agentStepsPerSec);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> simNames = {"physarum", "boids", "termites", "game_of_life"};
+    std::vector<float> agentsOverride, rezList = {512, 1024, 2048, 4096}, stepsList = {1, 4};
+    std::vector<float> cellList = {15, 30, 60};
+    int warmup = 10, frames = 60, repeat = 1;
+    bool quick = false, fallback = false;
+    std::string jsonPath, csvPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { fprintf(stderr, "Missing value for %s\n", a.c_str()); exit(2); }
+            return argv[++i];
+        };
+        if (a == "--sim") simNames = splitList(next(), ',');
+        else if (a == "--agents") agentsOverride = parseFloatList(next());
+        else if (a == "--rez") rezList = parseFloatList(next());
+        else if (a == "--steps") stepsList = parseFloatList(next());
+        else if (a == "--cell") cellList = parseFloatList(next());
+        else if (a == "--warmup") warmup = atoi(next());
+        else if (a == "--frames") frames = atoi(next());
+        else if (a == "--repeat") repeat = atoi(next());
+        else if (a == "--quick") quick = true;
+        else if (a == "--json") jsonPath = next();
+        else if (a == "--csv") csvPath = next();
+        else if (a == "--fallback") fallback = true;
+        else if (a == "--split-passes") gpuProfiler().splitPasses = true;
+        else if (a == "--help" || a == "-h") { usage(); return 0; }
+        else { fprintf(stderr, "Unknown option: %s\n", a.c_str()); usage(); return 2; }
+    }
+    if (quick) {
+        rezList = {512, 1024};
+        stepsList = {1};
+        cellList = {30};
+        if (agentsOverride.empty()) agentsOverride = {10000, 100000};
+        frames = std::min(frames, 30);
+    }
+    if (frames < 1) frames = 1;
+    if (warmup < 0) warmup = 0;
+    if (repeat < 1) repeat = 1;
+
+    // Build the sweep
+    std::vector<BenchConfig> configs;
+    for (auto& name : simNames) {
+        if (!createSimulation(name)) { fprintf(stderr, "Unknown simulation: %s\n", name.c_str()); return 2; }
+
+        std::vector<float> agents = agentsOverride;
+        if (agents.empty()) {
+            if (name == "physarum" || name == "termites") agents = {10000, 100000, 1000000, 5000000};
+            else if (name == "boids") agents = {10000, 100000, 500000};
+        }
+        if (name == "game_of_life") agents = {0};
+        std::vector<float> cells = (name == "boids") ? cellList : std::vector<float>{0};
+
+        for (float rez : rezList)
+            for (float ag : agents)
+                for (float st : stepsList)
+                    for (float cs : cells) {
+                        BenchConfig c;
+                        c.sim = name;
+                        c.agents = (uint32_t)ag;
+                        c.rez = (uint32_t)rez;
+                        c.steps = std::max(1, (int)st);
+                        c.cellSize = cs;
+                        configs.push_back(c);
+                    }
+    }
+
+    GpuContext gpu;
+    if (!gpu.initHeadless(512, 512, fallback)) {
+        fprintf(stderr, "Failed to initialize headless GPU context\n");
+        return 1;
+    }
+    gpuProfiler().init(gpu.device, gpu.queue);
+
+    printf("%-13s %9s %5s %5s %5s %6s %9s %9s %9s %12s %14s\n",
+           "sim", "agents", "rez", "steps", "cell", "passes", "p50 ms", "p90 ms", "p99 ms", "steps/s", "agent*steps/s");
+    std::vector<BenchResult> results;
+    for (auto& cfg : configs) {
+        BenchResult r = runConfig(gpu, cfg, warmup, frames, repeat);
+        printf("%-13s %9u %5u %5d %5g %6u %9.3f %9.3f %9.3f %12.1f %14.4g\n",
+               cfg.sim.c_str(), cfg.agents, cfg.rez, cfg.steps, cfg.cellSize, r.passes,
+               r.p50Ms, r.p90Ms, r.p99Ms, r.stepsPerSec, r.agentStepsPerSec);
+        fflush(stdout);
+        results.push_back(r);
+    }
+
+    int rc = 0;
+    if (!jsonPath.empty() && !writeJson(jsonPath.c_str(), gpu.adapterName, results, warmup, frames, repeat)) rc = 1;
+    if (!csvPath.empty() && !writeCsv(csvPath.c_str(), results)) rc = 1;
+
+    gpuProfiler().shutdown();
+    gpu.shutdown();
+    return rc;
+}
@@ -0,0 +1,36 @@
+#pragma once
+// Small argument helpers shared by the command-line tools
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+inline std::vector<std::string> splitList(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(sep, start);
+        if (end == std::string::npos) end = s.size();
+        if (end > start) out.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+// "10000,100000,1e6" -> {10000, 100000, 1000000}
+inline std::vector<float> parseFloatList(const std::string& s) {
+    std::vector<float> out;
+    for (auto& v : splitList(s, ',')) out.push_back(strtof(v.c_str(), nullptr));
+    return out;
+}
+
+// "sim.key=v0,v1" -> sim, key, values
+inline bool parseSet(const std::string& arg, std::string& sim, std::string& key,
+                     std::vector<float>& vals) {
+    size_t dot = arg.find('.');
+    size_t eq = arg.find('=');
+    if (dot == std::string::npos || eq == std::string::npos || eq < dot) return false;
+    sim = arg.substr(0, dot);
+    key = arg.substr(dot + 1, eq - dot - 1);
+    vals = parseFloatList(arg.substr(eq + 1));
+    return !vals.empty();
+}
@@ -0,0 +1,329 @@
+// Headless offscreen runner: steps simulations, composites, applies post effects
+// and writes PNGs without a window, surface or ImGui.
+//
+//   nature-headless --sim physarum --rez 2048x2048 --frames 600 --out out.png
+//                   --preset presets/physarum_bacteria.txt --seq frames --every 10
+#include "gpu_context.h"
+#include <webgpu/wgpu.h>
+#include "compositor.h"
+#include "post_effects.h"
+#include "export.h"
+#include "video_writer.h"
+#include "gpu_profiler.h"
+#include "gpu_tracker.h"
+#include "gpu_pool.h"
+#include "cpu_trace.h"
+#include "preset.h"
+#include "sim_factory.h"
+#include "state_hash.h"
+#include "sim_stats.h"
+#include "cli.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+static void usage() {
+    fprintf(stderr,
+        "usage: nature-headless [options]\n"
+        "  --sim NAME[,NAME...]    simulations to enable (game_of_life, physarum, boids, termites)\n"
+        "  --rez WxH               simulation resolution (default 1536x1536)\n"
+        "  --preset FILE           preset file; applied to the sim named by its prefix (repeatable)\n"
+        "  --set SIM.KEY=V[,V...]  override a preset value (repeatable)\n"
+        "  --frames N              frames to run (default 600)\n"
+        "  --out FILE.png          write the final frame\n"
+        "  --seq DIR               write a PNG sequence into DIR\n"
+        "  --video FILE            stream frames into FILE.y4m (YUV 4:2:0) or any other name (raw RGBA)\n"
+        "  --every N               sequence/video interval in frames (default 1)\n"
+        "  --profile FILE.csv      write per-pass GPU timings (frame,pass,calls,gpu_ms)\n"
+        "  --trace FILE.json       write a Chrome trace of CPU scopes at exit\n"
+        "  --seed N                run seed; same seed + settings + adapter -> same state (default 0)\n"
+        "  --hash-every N          hash sim state after every N frames\n"
+        "  --hash-log FILE         write state hashes to FILE instead of stdout\n"
+        "  --stats-every N         reduce sim stats on the GPU after every N frames\n"
+        "  --stats-csv FILE        log every stats result to FILE (sim,step,metric,value)\n"
+        "  --budget MB             fail if tracked GPU memory would exceed MB\n"
+        "  --fallback              force the software/fallback adapter\n");
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> simNames = {"physarum"};
+    std::vector<std::string> presetFiles;
+    std::vector<std::string> sets;
+    uint32_t rezX = 1536, rezY = 1536;
+    int frames = 600;
+    int every = 1;
+    std::string outFile, seqDir, videoFile, profileFile, traceFile, hashLog, statsCsv;
+    uint64_t seed = 0;
+    int hashEvery = 0;
+    int statsEvery = 0;
+    double budgetMB = 0.0;
+    bool fallback = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { fprintf(stderr, "Missing value for %s\n", a.c_str()); exit(2); }
+            return argv[++i];
+        };
+        if (a == "--sim") simNames = splitList(next(), ',');
+        else if (a == "--rez") {
+            if (sscanf(next(), "%ux%u", &rezX, &rezY) != 2) { usage(); return 2; }
+        }
+        else if (a == "--preset") presetFiles.push_back(next());
+        else if (a == "--set") sets.push_back(next());
+        else if (a == "--frames") frames = atoi(next());
+        else if (a == "--out") outFile = next();
+        else if (a == "--seq") seqDir = next();
+        else if (a == "--video") videoFile = next();
+        else if (a == "--every") every = atoi(next());
+        else if (a == "--profile") profileFile = next();
+        else if (a == "--trace") traceFile = next();
+        else if (a == "--seed") seed = strtoull(next(), nullptr, 0);
+        else if (a == "--hash-every") hashEvery = atoi(next());
+        else if (a == "--hash-log") hashLog = next();
+        else if (a == "--stats-every") statsEvery = atoi(next());
+        else if (a == "--stats-csv") statsCsv = next();
+        else if (a == "--budget") budgetMB = atof(next());
+        else if (a == "--fallback") fallback = true;
+        else if (a == "--help" || a == "-h") { usage(); return 0; }
+        else { fprintf(stderr, "Unknown option: %s\n", a.c_str()); usage(); return 2; }
+    }
+    if (every < 1) every = 1;
+    if (!seqDir.empty() && !videoFile.empty()) { fprintf(stderr, "--seq and --video are exclusive\n"); return 2; }
+    if (rezX < 1 || rezY < 1) { fprintf(stderr, "Invalid resolution\n"); return 2; }
+
+    // A typo must not quietly run a different workload: every --sim name, preset
+    // and --set has to match an enabled sim
+    for (auto& n : simNames) {
+        if (createSimulation(n)) continue;
+        fprintf(stderr, "Unknown simulation in --sim: %s\n", n.c_str());
+        usage();
+        return 2;
+    }
+    for (auto& file : presetFiles) {
+        size_t slash = file.find_last_of("/\\");
+        std::string base = (slash == std::string::npos) ? file : file.substr(slash + 1);
+        bool matched = false;
+        for (auto& n : simNames) matched |= base.compare(0, n.size() + 1, n + "_") == 0;
+        if (matched) continue;
+        fprintf(stderr, "--preset %s matches no --sim (expected <sim>_<name>)\n", file.c_str());
+        usage();
+        return 2;
+    }
+    for (auto& set : sets) {
+        std::string simName, k;
+        std::vector<float> vals;
+        if (!parseSet(set, simName, k, vals)) { fprintf(stderr, "Bad --set: %s\n", set.c_str()); return 2; }
+        if (std::find(simNames.begin(), simNames.end(), simName) != simNames.end()) continue;
+        fprintf(stderr, "--set %s names a sim not in --sim\n", set.c_str());
+        usage();
+        return 2;
+    }
+
+    traceSetThreadName("main");
+
+    GpuContext gpu;
+    if (!gpu.initHeadless(rezX, rezY, fallback)) {
+        fprintf(stderr, "Failed to initialize headless GPU context\n");
+        return 1;
+    }
+
+    // Simulations: only the requested ones are enabled, and so initialized
+    auto sims = createAllSimulations();
+    Compositor compositor;
+    compositor.init(gpu.device, gpu.queue, rezX, rezY);
+    int enabledCount = 0;
+    for (auto& sim : sims) {
+        std::string key = simKey(*sim);
+        bool enabled = false;
+        for (auto& n : simNames) if (n == key) enabled = true;
+        sim->params.seed = seed;
+        if (enabled) enabledCount++;
+        Layer l;
+        l.sim = sim.get();
+        l.enabled = enabled;
+        l.opacity = 1.0f;
+        l.blendMode = BlendMode::Additive;
+        compositor.layers.push_back(l);
+    }
+    if (enabledCount == 0) {
+        fprintf(stderr, "No known simulation in --sim\n");
+        usage();
+        return 2;
+    }
+    compositor.updateLayers();
+
+    // Presets: "presets/physarum_bacteria.txt" applies to the "physarum" layer
+    for (auto& l : compositor.layers) {
+        if (!l.enabled) continue;
+        std::string key = simKey(*l.sim);
+        PresetData data;
+        for (auto& file : presetFiles) {
+            size_t slash = file.find_last_of("/\\");
+            std::string base = (slash == std::string::npos) ? file : file.substr(slash + 1);
+            if (base.compare(0, key.size() + 1, key + "_") != 0) continue;
+            PresetData loaded = loadPresetFile(file);
+            if (loaded.empty()) { fprintf(stderr, "Failed to load preset: %s\n", file.c_str()); return 1; }
+            for (auto& [k, v] : loaded) data[k] = v;
+        }
+        for (auto& s : sets) {
+            std::string simName, k;
+            std::vector<float> vals;
+            if (!parseSet(s, simName, k, vals)) { fprintf(stderr, "Bad --set: %s\n", s.c_str()); return 2; }
+            if (simName == key) data[k] = vals;
+        }
+        if (!data.empty()) {
+            l.sim->applyPreset(data);
+            l.sim->reset();
+        }
+    }
+
+    PostEffects postFx;
+    postFx.init(gpu.device, gpu.queue, rezX, rezY);
+    FrameGraph frameGraph;
+    frameGraph.init(gpu.device);
+
+    gpuTracker().setBudget((uint64_t)(budgetMB * 1024 * 1024));
+    if (!gpuTracker().fitsBudget(gpuTracker().liveBytes())) {
+        gpuTracker().printMemory();
+        fprintf(stderr, "GPU memory exceeds --budget %.0f MB\n", budgetMB);
+        return 1;
+    }
+
+    if (!profileFile.empty()) {
+        gpuProfiler().init(gpu.device, gpu.queue);
+        if (!gpuProfiler().startCsv(profileFile)) return 1;
+    }
+
+    StateHasher hasher;
+    if (hashEvery > 0) {
+        hasher.init(gpu.device, gpu.queue);
+        if (!hashLog.empty() && !hasher.openLog(hashLog)) return 1;
+    }
+
+    SimStats simStats;
+    if (statsEvery > 0) {
+        simStats.init(gpu.device, gpu.queue);
+        if (!statsCsv.empty() && !simStats.startCsv(statsCsv)) return 1;
+    }
+
+    AsyncExporter asyncExporter;
+    ReadbackRing readbackRing;
+    if (!seqDir.empty()) {
+        mkdir(seqDir.c_str(), 0755);
+        asyncExporter.start();
+        readbackRing.init(gpu.device, &asyncExporter);
+    }
+    VideoWriter videoWriter;
+    YuvConverter yuvConverter;
+    bool y4m = videoFile.size() > 4 && videoFile.compare(videoFile.size() - 4, 4, ".y4m") == 0;
+    if (!videoFile.empty()) {
+        if (!videoWriter.open(videoFile, y4m ? VideoWriter::Format::Y4M : VideoWriter::Format::RawRGBA,
+                              rezX, rezY, 30))
+            return 1;
+        if (y4m) yuvConverter.init(gpu.device, gpu.queue);
+        readbackRing.init(gpu.device, &videoWriter);
+    }
+
+    // Keep at most two frames queued on the GPU so the CPU never runs far ahead
+    WGPUSubmissionIndex inFlight[2] = {};
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < frames; frame++) {
+        TRACE_SCOPE("frame");
+        WGPUCommandEncoderDescriptor encDesc = {};
+        WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(gpu.device, &encDesc);
+        gpuProfiler().beginFrame();
+
+        for (auto& layer : compositor.layers) {
+            if (layer.enabled && layer.sim) layer.sim->step(encoder);
+        }
+        frameGraph.reset();
+        postFx.addPasses(frameGraph, compositor.addPasses(frameGraph));
+        frameGraph.execute(encoder);
+        bool hashing = hashEvery > 0 && (frame + 1) % hashEvery == 0;
+        if (hashing) {
+            for (auto& layer : compositor.layers)
+                if (layer.enabled && layer.sim)
+                    hasher.encode(encoder, layer.sim->stateViews(), simKey(*layer.sim));
+        }
+        bool reducing = statsEvery > 0 && (frame + 1) % statsEvery == 0;
+        if (reducing) {
+            for (auto& layer : compositor.layers)
+                if (layer.enabled && layer.sim)
+                    simStats.encode(encoder, layer.sim->stateViews(), simKey(*layer.sim));
+        }
+        bool capturing = (!seqDir.empty() || videoWriter.isOpen()) && frame % every == 0;
+        if (capturing && y4m) {
+            capturing = yuvConverter.encode(encoder, postFx.getOutputView(), rezX, rezY);
+            if (capturing)
+                readbackRing.encode(encoder, yuvConverter.buffer(), YuvConverter::frameBytes(rezX, rezY),
+                                    rezX, rezY, rezX, videoFile);
+        } else if (capturing) {
+            char seqFilename[512];
+            snprintf(seqFilename, sizeof(seqFilename), "%s/%06d.png", seqDir.c_str(), frame);
+            readbackRing.encode(encoder, postFx.getOutputTexture(), rezX, rezY, seqFilename);
+        }
+        gpuProfiler().resolve(encoder);
+
+        WGPUCommandBufferDescriptor cbDesc = {};
+        WGPUCommandBuffer cmdBuf = wgpuCommandEncoderFinish(encoder, &cbDesc);
+        WGPUSubmissionIndex idx = wgpuQueueSubmitForIndex(gpu.queue, 1, &cmdBuf);
+        wgpuCommandBufferRelease(cmdBuf);
+        wgpuCommandEncoderRelease(encoder);
+        gpuProfiler().endFrame();
+        if (hashing) hasher.afterSubmit();
+        hasher.poll();
+        if (reducing) simStats.afterSubmit();
+        simStats.poll();
+        if (capturing) readbackRing.afterSubmit();
+        readbackRing.poll();
+
+        if (frame >= 2) {
+            TRACE_SCOPE("wait frame N-2");
+            WGPUWrappedSubmissionIndex wait = { gpu.queue, inFlight[frame % 2] };
+            wgpuDevicePoll(gpu.device, true, &wait);
+        }
+        inFlight[frame % 2] = idx;
+        gpuPool().endFrame();
+        gpuTracker().endFrame();
+    }
+    printf("GPU objects created in the last frame: %u\n", gpuTracker().frameCreates());
+    gpuTracker().printMemory();
+    wgpuDevicePoll(gpu.device, true, nullptr);
+    hasher.poll();
+    simStats.poll();
+    for (auto& r : simStats.lastResults()) simStats.print(r, stdout);
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    printf("%d frames in %.2fs (%.1f fps)\n", frames, secs, secs > 0.0 ? frames / secs : 0.0);
+
+    int rc = 0;
+    if (!outFile.empty() &&
+        !exportTextureToPNG(gpu.device, gpu.queue, postFx.getOutputTexture(), rezX, rezY, outFile))
+        rc = 1;
+
+    readbackRing.shutdown();
+    asyncExporter.stop();
+    videoWriter.close();
+    yuvConverter.shutdown();
+    if (!traceFile.empty() && !traceDump(traceFile)) rc = 1;
+    // Collect the last in-flight timings before closing the CSV
+    gpuProfiler().flush();
+    gpuProfiler().shutdown();
+    hasher.shutdown();
+    simStats.shutdown();
+    compositor.releaseLayers();
+    frameGraph.shutdown();
+    compositor.shutdown();
+    postFx.shutdown();
+    gpuPool().shutdown();
+    gpuTracker().reportLeaks();
+    gpu.shutdown();
+    return rc;
+}
@@ -0,0 +1,138 @@
+#pragma once
+// Minimal JSON reader for the tools' own output (nature-bench results,
+// perf baselines). No unicode escapes beyond \uXXXX -> '?'.
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object; // in file order
+
+    // Object member, or null when missing / not an object
+    const JsonValue* get(const char* key) const {
+        for (auto& [k, v] : object)
+            if (k == key) return &v;
+        return nullptr;
+    }
+    double num(const char* key, double fallback = 0.0) const {
+        const JsonValue* v = get(key);
+        return (v && v->type == Type::Number) ? v->number : fallback;
+    }
+    std::string str(const char* key) const {
+        const JsonValue* v = get(key);
+        return (v && v->type == Type::String) ? v->string : std::string();
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : m_s(text) {}
+
+    bool parse(JsonValue& out) {
+        if (!value(out)) return false;
+        skipSpace();
+        return m_pos == m_s.size();
+    }
+    size_t errorOffset() const { return m_pos; }
+
+private:
+    void skipSpace() {
+        while (m_pos < m_s.size() && (m_s[m_pos] == ' ' || m_s[m_pos] == '\n' ||
+                                      m_s[m_pos] == '\r' || m_s[m_pos] == '\t'))
+            m_pos++;
+    }
+    bool literal(const char* word) {
+        size_t n = strlen(word);
+        if (m_s.compare(m_pos, n, word) != 0) return false;
+        m_pos += n;
+        return true;
+    }
+    bool string(std::string& out) {
+        if (m_s[m_pos] != '"') return false;
+        m_pos++;
+        while (m_pos < m_s.size() && m_s[m_pos] != '"') {
+            char c = m_s[m_pos++];
+            if (c == '\\' && m_pos < m_s.size()) {
+                char e = m_s[m_pos++];
+                switch (e) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': out += '?'; m_pos += 4; break;
+                    default: out += e; break;
+                }
+            } else {
+                out += c;
+            }
+        }
+        if (m_pos >= m_s.size()) return false;
+        m_pos++; // closing quote
+        return true;
+    }
+    bool value(JsonValue& v) {
+        skipSpace();
+        if (m_pos >= m_s.size()) return false;
+        char c = m_s[m_pos];
+        if (c == '{') {
+            v.type = JsonValue::Type::Object;
+            m_pos++;
+            skipSpace();
+            if (m_pos < m_s.size() && m_s[m_pos] == '}') { m_pos++; return true; }
+            while (true) {
+                skipSpace();
+                std::string key;
+                if (m_pos >= m_s.size() || !string(key)) return false;
+                skipSpace();
+                if (m_pos >= m_s.size() || m_s[m_pos] != ':') return false;
+                m_pos++;
+                JsonValue member;
+                if (!value(member)) return false;
+                v.object.emplace_back(std::move(key), std::move(member));
+                skipSpace();
+                if (m_pos < m_s.size() && m_s[m_pos] == ',') { m_pos++; continue; }
+                if (m_pos < m_s.size() && m_s[m_pos] == '}') { m_pos++; return true; }
+                return false;
+            }
+        }
+        if (c == '[') {
+            v.type = JsonValue::Type::Array;
+            m_pos++;
+            skipSpace();
+            if (m_pos < m_s.size() && m_s[m_pos] == ']') { m_pos++; return true; }
+            while (true) {
+                JsonValue item;
+                if (!value(item)) return false;
+                v.array.push_back(std::move(item));
+                skipSpace();
+                if (m_pos < m_s.size() && m_s[m_pos] == ',') { m_pos++; continue; }
+                if (m_pos < m_s.size() && m_s[m_pos] == ']') { m_pos++; return true; }
+                return false;
+            }
+        }
+        if (c == '"') { v.type = JsonValue::Type::String; return string(v.string); }
+        if (literal("true")) { v.type = JsonValue::Type::Bool; v.boolean = true; return true; }
+        if (literal("false")) { v.type = JsonValue::Type::Bool; return true; }
+        if (literal("null")) { v.type = JsonValue::Type::Null; return true; }
+
+        const char* start = m_s.c_str() + m_pos;
+        char* end = nullptr;
+        v.number = strtod(start, &end);
+        if (end == start) return false;
+        v.type = JsonValue::Type::Number;
+        m_pos += (size_t)(end - start);
+        return true;
+    }
+
+    const std::string& m_s;
+    size_t m_pos = 0;
+};
@@ -0,0 +1,279 @@
+// Performance baselines: stores nature-bench JSON keyed by adapter and git
+// revision, and compares new runs against a stored baseline.
+//
+//   nature-bench --sim physarum --agents 1e6 --repeat 5 --json bench.json
+//   nature-perf store bench.json                # perf/baselines/<adapter>/<rev>.json
+//   nature-perf compare bench.json              # exit 1 on a significant regression
+//
+// A metric regresses when its median moves the wrong way by more than
+// --threshold (relative) AND by more than --sigma times the combined spread
+// (scaled MAD over repeats), so noisy kernels need a bigger move to fail.
+#include "json.h"
+#include "cli.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+struct Options {
+    std::string dir = "perf/baselines";
+    std::string rev;      // store: revision to file under (default: git HEAD)
+    std::string baseline; // compare: revision to compare against (default: LATEST)
+    double threshold = 0.05;
+    double sigma = 3.0;
+    double minMs = 0.02; // kernels faster than this are too noisy to gate on
+};
+
+// metric name -> samples (one per repeat)
+using MetricSamples = std::map<std::string, std::vector<double>>;
+// config key -> metrics
+using RunMetrics = std::map<std::string, MetricSamples>;
+
+static void usage() {
+    fprintf(stderr,
+        "usage: nature-perf <command> [options]\n"
+        "  store RESULT.json      file RESULT.json under <dir>/<adapter>/<rev>.json\n"
+        "  compare RESULT.json    compare against the stored baseline for RESULT's adapter\n"
+        "  list                   list stored baselines\n"
+        "options:\n"
+        "  --dir DIR              baseline store (default perf/baselines)\n"
+        "  --rev REV              store: revision name (default: git rev-parse --short HEAD)\n"
+        "  --baseline REV         compare: baseline revision (default: last stored)\n"
+        "  --threshold PCT        relative change that counts as a regression (default 5)\n"
+        "  --sigma K              required distance in scaled-MAD units (default 3)\n"
+        "  --min-ms MS            ignore kernels faster than this in the baseline (default 0.02)\n");
+}
+
+static bool readFile(const std::string& path, std::string& out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) return false;
+    std::stringstream ss;
+    ss << f.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+static bool loadJson(const std::string& path, JsonValue& out) {
+    std::string text;
+    if (!readFile(path, text)) { fprintf(stderr, "Failed to read %s\n", path.c_str()); return false; }
+    JsonParser parser(text);
+    if (!parser.parse(out) || out.type != JsonValue::Type::Object) {
+        fprintf(stderr, "Failed to parse %s (offset %zu)\n", path.c_str(), parser.errorOffset());
+        return false;
+    }
+    return true;
+}
+
+static std::string commandOutput(const char* cmd) {
+    std::string out;
+    FILE* p = popen(cmd, "r");
+    if (!p) return out;
+    char buf[256];
+    while (fgets(buf, sizeof(buf), p)) out += buf;
+    pclose(p);
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) out.pop_back();
+    return out;
+}
+
+static std::string gitRevision() {
+    std::string rev = commandOutput("git rev-parse --short HEAD 2>/dev/null");
+    if (rev.empty()) return "unknown";
+    if (!commandOutput("git status --porcelain --untracked-files=no 2>/dev/null").empty()) rev += "-dirty";
+    return rev;
+}
+
+// "Apple M1 Pro (Metal)" -> "Apple_M1_Pro_Metal"
+static std::string adapterSlug(const std::string& name) {
+    std::string out;
+    for (char c : name) {
+        bool keep = isalnum((unsigned char)c) || c == '-' || c == '.';
+        if (keep) out += c;
+        else if (!out.empty() && out.back() != '_') out += '_';
+    }
+    while (!out.empty() && out.back() == '_') out.pop_back();
+    return out.empty() ? "unknown" : out;
+}
+
+static RunMetrics extractMetrics(const JsonValue& root) {
+    RunMetrics metrics;
+    const JsonValue* results = root.get("results");
+    if (!results) return metrics;
+    for (auto& r : results->array) {
+        char key[256];
+        snprintf(key, sizeof(key), "%s agents=%g rez=%g steps=%g cell=%g",
+                 r.str("sim").c_str(), r.num("agents"), r.num("rez"), r.num("steps"), r.num("cell_size"));
+        MetricSamples& m = metrics[key];
+
+        const JsonValue* runs = r.get("runs");
+        if (!runs || runs->array.empty()) {
+            m["steps/s"].push_back(r.num("steps_per_sec")); // single-run results
+            continue;
+        }
+        for (auto& run : runs->array) {
+            m["steps/s"].push_back(run.num("steps_per_sec"));
+            if (const JsonValue* kernels = run.get("kernels"))
+                for (auto& [name, v] : kernels->object)
+                    if (v.type == JsonValue::Type::Number) m[name].push_back(v.number);
+        }
+    }
+    return metrics;
+}
+
+static double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return (n % 2) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+// Median absolute deviation, scaled to estimate a standard deviation
+static double scaledMad(const std::vector<double>& v) {
+    double med = median(v);
+    std::vector<double> dev;
+    for (double x : v) dev.push_back(std::abs(x - med));
+    return 1.4826 * median(dev);
+}
+
+static int cmdStore(const std::string& resultPath, const Options& opt) {
+    JsonValue root;
+    if (!loadJson(resultPath, root)) return 2;
+    std::string rev = opt.rev.empty() ? gitRevision() : opt.rev;
+    std::string dir = opt.dir + "/" + adapterSlug(root.str("adapter"));
+
+    // mkdir -p
+    std::string partial;
+    for (auto& part : splitList(dir, '/')) {
+        partial += (partial.empty() && dir[0] != '/') ? part : "/" + part;
+        mkdir(partial.c_str(), 0755);
+    }
+
+    std::string text;
+    readFile(resultPath, text);
+    std::string dst = dir + "/" + rev + ".json";
+    std::ofstream out(dst, std::ios::binary);
+    if (!out.is_open()) { fprintf(stderr, "Failed to write %s\n", dst.c_str()); return 2; }
+    out << text;
+    std::ofstream latest(dir + "/LATEST");
+    latest << rev << "\n";
+    printf("Stored %s as %s\n", resultPath.c_str(), dst.c_str());
+    return 0;
+}
+
+static int cmdList(const Options& opt) {
+    DIR* top = opendir(opt.dir.c_str());
+    if (!top) { printf("No baselines in %s\n", opt.dir.c_str()); return 0; }
+    while (dirent* a = readdir(top)) {
+        if (a->d_name[0] == '.') continue;
+        std::string sub = opt.dir + "/" + a->d_name;
+        DIR* d = opendir(sub.c_str());
+        if (!d) continue;
+        std::string latest;
+        readFile(sub + "/LATEST", latest);
+        while (!latest.empty() && latest.back() == '\n') latest.pop_back();
+        printf("%s\n", a->d_name);
+        while (dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() < 6 || name.compare(name.size() - 5, 5, ".json") != 0) continue;
+            std::string rev = name.substr(0, name.size() - 5);
+            printf("  %s%s\n", rev.c_str(), rev == latest ? "  (latest)" : "");
+        }
+        closedir(d);
+    }
+    closedir(top);
+    return 0;
+}
+
+static int cmdCompare(const std::string& resultPath, const Options& opt) {
+    JsonValue current;
+    if (!loadJson(resultPath, current)) return 2;
+    std::string dir = opt.dir + "/" + adapterSlug(current.str("adapter"));
+
+    std::string rev = opt.baseline;
+    if (rev.empty()) {
+        readFile(dir + "/LATEST", rev);
+        while (!rev.empty() && (rev.back() == '\n' || rev.back() == '\r')) rev.pop_back();
+    }
+    if (rev.empty()) {
+        printf("No baseline stored for adapter \"%s\" in %s; nothing to compare\n",
+               current.str("adapter").c_str(), opt.dir.c_str());
+        return 0;
+    }
+    JsonValue base;
+    if (!loadJson(dir + "/" + rev + ".json", base)) return 2;
+
+    RunMetrics baseMetrics = extractMetrics(base);
+    RunMetrics newMetrics = extractMetrics(current);
+    printf("Baseline %s vs %s on %s (threshold %.1f%%, %.1f sigma)\n", rev.c_str(), resultPath.c_str(),
+           current.str("adapter").c_str(), opt.threshold * 100.0, opt.sigma);
+
+    int regressions = 0, improvements = 0, compared = 0;
+    for (auto& [config, metrics] : newMetrics) {
+        auto baseIt = baseMetrics.find(config);
+        if (baseIt == baseMetrics.end()) continue;
+        for (auto& [metric, samples] : metrics) {
+            auto mIt = baseIt->second.find(metric);
+            if (mIt == baseIt->second.end() || mIt->second.empty() || samples.empty()) continue;
+
+            bool higherIsBetter = (metric == "steps/s");
+            double b = median(mIt->second), n = median(samples);
+            if (b <= 0.0) continue;
+            if (!higherIsBetter && b < opt.minMs) continue;
+            compared++;
+
+            double worse = higherIsBetter ? (b - n) : (n - b); // > 0 means slower
+            double spread = std::sqrt(std::pow(scaledMad(mIt->second), 2) + std::pow(scaledMad(samples), 2));
+            bool significant = std::abs(worse) / b > opt.threshold && std::abs(worse) > opt.sigma * spread;
+            if (!significant) continue;
+
+            const char* tag = worse > 0.0 ? "REGRESSION" : "improved";
+            if (worse > 0.0) regressions++;
+            else improvements++;
+            printf("%-10s %s  %s: %.4g -> %.4g (%+.1f%%, spread %.3g)\n", tag, config.c_str(),
+                   metric.c_str(), b, n, (n - b) / b * 100.0, spread);
+        }
+    }
+    for (auto& [config, metrics] : baseMetrics)
+        if (!newMetrics.count(config)) printf("missing    %s (in baseline only)\n", config.c_str());
+
+    printf("%d metrics compared: %d regressions, %d improvements\n", compared, regressions, improvements);
+    return regressions > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) { usage(); return 2; }
+    std::string command = argv[1];
+    std::string resultPath;
+    Options opt;
+
+    for (int i = 2; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { fprintf(stderr, "Missing value for %s\n", a.c_str()); exit(2); }
+            return argv[++i];
+        };
+        if (a == "--dir") opt.dir = next();
+        else if (a == "--rev") opt.rev = next();
+        else if (a == "--baseline") opt.baseline = next();
+        else if (a == "--threshold") opt.threshold = atof(next()) / 100.0;
+        else if (a == "--sigma") opt.sigma = atof(next());
+        else if (a == "--min-ms") opt.minMs = atof(next());
+        else if (a == "--help" || a == "-h") { usage(); return 0; }
+        else if (a[0] != '-' && resultPath.empty()) resultPath = a;
+        else { fprintf(stderr, "Unknown option: %s\n", a.c_str()); usage(); return 2; }
+    }
+
+    if (command == "list") return cmdList(opt);
+    if (resultPath.empty()) { usage(); return 2; }
+    if (command == "store") return cmdStore(resultPath, opt);
+    if (command == "compare") return cmdCompare(resultPath, opt);
+    usage();
+    return 2;
+}